@@ -35,10 +35,14 @@
 #include <QApplication>
 #include <QTranslator>
 #include "p2token.h"
+#include "p2util.h"
 
 int main(int argc, char *argv[])
 {
     QApplication a(argc, argv);
+#if !defined(QT_NO_DEBUG)
+    P2Util::selftest();
+#endif
 
     a.setApplicationName(QStringLiteral("Propeller2-Emulator"));
     a.setApplicationVersion(QString("%1.%2.%3").arg(VER_MAJ).arg(VER_MIN).arg(VER_PAT));
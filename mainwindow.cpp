@@ -54,6 +54,8 @@
 #include "textbrowser.h"
 #include "p2hub.h"
 #include "p2cog.h"
+#include "p2rewind.h"
+#include "p2profile.h"
 #include "p2asm.h"
 #include "p2asmmodel.h"
 #include "p2dasm.h"
@@ -66,6 +68,7 @@
 #include "p2symbolsorter.h"
 
 static const int ncogs = 8;
+static const int run_slice_cycles = ncogs * 2 * 100000;
 static const QLatin1String key_windowGeometry("windowGeometry");
 static const QLatin1String key_windowState("windowState");
 static const QLatin1String grp_assembler("assembler");
@@ -106,8 +109,10 @@ MainWindow::MainWindow(QWidget *parent)
     , ui(new Ui::MainWindow)
     , m_vcog()
     , m_hub(new P2Hub(ncogs, this))
+    , m_rewind(new P2Rewind(m_hub))
     , m_asm(new P2Asm(this))
     , m_dasm(new P2Dasm(m_hub->cog(0)))
+    , m_source_name()
     , m_font_asm(QLatin1String("Source Code Pro"), 9)
     , m_font_dasm(QLatin1String("Source Code Pro"), 9)
     , m_source_percent(80)
@@ -147,6 +152,7 @@ MainWindow::MainWindow(QWidget *parent)
 MainWindow::~MainWindow()
 {
     save_settings();
+    delete m_rewind;
     delete ui;
 }
 
@@ -310,7 +316,7 @@ void MainWindow::help_opcodes()
         ui->tabWidget->removeTab(tab);
         tab = -1;
     } else {
-        QStringList html = Doc.html_opcodes();
+        QStringList html = P2Doc::instance().html_opcodes();
         TextBrowser* dlg = new TextBrowser;
         dlg->set_html(html);
         dlg->setWindowTitle(tr("Propeller2 Opcode Table"));
@@ -568,11 +574,123 @@ void MainWindow::header_columns_sym(QPoint pos)
 
 void MainWindow::hub_single_step()
 {
+    m_hub->breakpoints()->resume();
+    m_rewind->record();
     m_hub->execute(ncogs*2);
     for (int id = 0; id < ncogs; id++)
         m_vcog[id]->updateView();
 }
 
+void MainWindow::hub_reverse_step()
+{
+    if (!m_rewind->step_back())
+        return;
+    for (int id = 0; id < ncogs; id++)
+        m_vcog[id]->updateView();
+}
+
+void MainWindow::hub_run(bool on)
+{
+    if (on) {
+        m_hub->breakpoints()->resume();
+        QTimer::singleShot(0, this, SLOT(hub_run_slice()));
+        return;
+    }
+    for (int id = 0; id < ncogs; id++)
+        m_vcog[id]->updateView();
+}
+
+void MainWindow::hub_run_slice()
+{
+    if (!ui->action_Run->isChecked())
+        return;
+    m_rewind->record();
+    m_hub->execute(run_slice_cycles);
+    const p2_BREAK_hit_t& hit = m_hub->breakpoints()->hit();
+    if (p2_BREAK_NONE == hit.kind) {
+        QTimer::singleShot(0, this, SLOT(hub_run_slice()));
+        return;
+    }
+    ui->tvDasm->selectRow(static_cast<int>(hit.pc / 4));
+    ui->action_Run->setChecked(false);
+}
+
+void MainWindow::toggle_breakpoint()
+{
+    const QModelIndex index = ui->tvDasm->currentIndex();
+    if (!index.isValid())
+        return;
+    P2Breakpoints* breakpoints = m_hub->breakpoints();
+    const p2_LONG pc = static_cast<p2_LONG>(index.row()) * 4;
+    breakpoints->set_breakpoint(pc, !breakpoints->breakpoint(pc));
+    m_hub->arm_breakpoints(true);
+
+    QLabel* status = ui->statusBar->findChild<QLabel*>(key_status);
+    if (status)
+        status->setText(breakpoints->breakpoint(pc)
+                        ? tr("Breakpoint set at $%1.").arg(pc, 5, 16, QChar('0'))
+                        : tr("Breakpoint removed at $%1.").arg(pc, 5, 16, QChar('0')));
+}
+
+void MainWindow::clear_breakpoints()
+{
+    m_hub->breakpoints()->clear();
+    m_hub->arm_breakpoints(true);
+}
+
+void MainWindow::hub_profile(bool on)
+{
+    for (int id = 0; id < ncogs; id++)
+        m_hub->cog(id)->set_profiling(on);
+    ui->action_SaveProfile->setEnabled(on);
+}
+
+void MainWindow::save_profile()
+{
+    QString filename = QFileDialog::getSaveFileName(this, tr("Save profile"), QString(),
+                                                    tr("CSV files (*.csv)"));
+    if (filename.isEmpty())
+        return;
+    QFileInfo info(filename);
+    if (info.suffix().isEmpty())
+        filename += QStringLiteral(".csv");
+    const QString folded = QString("%1/%2.folded")
+                           .arg(info.path())
+                           .arg(info.completeBaseName());
+
+    // Attribute the addresses to the lines of the assembled source
+    p2_PROFILE_source_t source;
+    source.filename = m_source_name;
+    source.source = m_asm->source();
+    for (int lineno = 1; lineno <= m_asm->count(); lineno++) {
+        if (!m_asm->has_IR(lineno))
+            continue;
+        const P2Union addr = m_asm->get_addr(lineno);
+        if (ut_Invalid == addr.type())
+            continue;
+        // the first line at an address wins
+        if (addr.hubmode()) {
+            const p2_LONG pc = m_asm->get_hubaddr(lineno);
+            if (!source.hub.contains(pc))
+                source.hub.insert(pc, lineno - 1);
+        } else {
+            const p2_LONG pc = m_asm->get_cogaddr(lineno);
+            if (!source.cog.contains(pc))
+                source.cog.insert(pc, lineno - 1);
+        }
+    }
+
+    QLabel* status = ui->statusBar->findChild<QLabel*>(key_status);
+    if (!P2Profile::write_csv(filename, m_hub, &source) ||
+        !P2Profile::write_collapsed(folded, m_hub, &source)) {
+        if (status)
+            status->setText(tr("Could not save the profile to %1.").arg(filename));
+        return;
+    }
+    if (status)
+        status->setText(tr("Saved the profile to %1 and %2.").arg(filename).arg(folded));
+}
+
 void MainWindow::load_object(const QString& filename)
 {
     P2DasmModel* dmodel = dasm_model();
@@ -584,6 +702,8 @@ void MainWindow::load_object(const QString& filename)
     if (!info.path().startsWith(QChar(':')))
         m_hub->set_pathname(info.path());
     m_hub->load_obj(filename);
+    m_rewind->clear();
+    hub_profile(ui->action_Profile->isChecked());
     dmodel->invalidate();
     update_sizes_dasm();
     ui->tvDasm->update();
@@ -663,6 +783,7 @@ void MainWindow::load_source(const QString& filename)
     if (!info.path().startsWith(QChar(':')))
         m_asm->set_pathname(info.path());
     m_asm->load(filename);
+    m_source_name = info.fileName();
     P2AsmModel* amodel = asm_model();
     if (amodel)
         amodel->invalidate();
@@ -1027,7 +1148,13 @@ void MainWindow::setup_menu()
     connect(ui->action_Open_obj_random, SIGNAL(triggered()), SLOT(load_object_random()));
     connect(ui->action_Go_to_line, SIGNAL(triggered()), SLOT(goto_line_number()));
     connect(ui->action_Assemble, SIGNAL(triggered()), SLOT(assemble()));
+    connect(ui->action_Run, SIGNAL(toggled(bool)), SLOT(hub_run(bool)));
     connect(ui->action_SingleStep, SIGNAL(triggered()), SLOT(hub_single_step()));
+    connect(ui->action_ToggleBreakpoint, SIGNAL(triggered()), SLOT(toggle_breakpoint()));
+    connect(ui->action_ClearBreakpoints, SIGNAL(triggered()), SLOT(clear_breakpoints()));
+    connect(ui->action_ReverseStep, SIGNAL(triggered()), SLOT(hub_reverse_step()));
+    connect(ui->action_Profile, SIGNAL(toggled(bool)), SLOT(hub_profile(bool)));
+    connect(ui->action_SaveProfile, SIGNAL(triggered()), SLOT(save_profile()));
 
     connect(ui->action_Palette_setup, SIGNAL(triggered()), SLOT(palette_setup()));
     connect(ui->action_Preferences, SIGNAL(triggered()), SLOT(preferences()));
@@ -1065,6 +1192,7 @@ void MainWindow::setup_menu()
 void MainWindow::setup_toolbars()
 {
     // HUB toolbar
+    ui->toolbarHub->addAction(ui->action_Run);
     ui->toolbarHub->addAction(ui->action_SingleStep);
 
     // Assembler toolbar
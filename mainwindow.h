@@ -41,6 +41,7 @@ namespace Ui {
 class MainWindow;
 }
 class P2Hub;
+class P2Rewind;
 class P2CogView;
 
 class P2Asm;
@@ -105,6 +106,13 @@ private slots:
     void header_columns_sym(QPoint pos);
 
     void hub_single_step();
+    void hub_reverse_step();
+    void hub_run(bool on);
+    void hub_run_slice();
+    void toggle_breakpoint();
+    void clear_breakpoints();
+    void hub_profile(bool on);
+    void save_profile();
     void load_object(const QString& filename = QString());
     void load_object_random();
 
@@ -125,8 +133,10 @@ private:
     Ui::MainWindow *ui;
     QVector<P2CogView*> m_vcog;
     P2Hub* m_hub;
+    P2Rewind* m_rewind;
     P2Asm* m_asm;
     P2Dasm* m_dasm;
+    QString m_source_name;
 
     QFont m_font_asm;
     QFont m_font_dasm;
@@ -597,14 +597,14 @@ QString P2AsmModel::tokenToolTip(const P2Words& words) const
         e_td = p2_td(doc);
         e_td.setAttribute(attr_style, QString("%1 %2").arg(attr_style_padding).arg(attr_style_nowrap));
         e_tt = p2_tt(doc);
-        e_tt.appendChild(p2_text(doc, Token.enum_name(word.tok())));
+        e_tt.appendChild(p2_text(doc, m_asm->tokens().enum_name(word.tok())));
         e_td.appendChild(e_tt);
         e_tr.appendChild(e_td);
 
         e_td = p2_td(doc);
         e_td.setAttribute(attr_style, QString("%1 %2").arg(attr_style_padding).arg(attr_style_nowrap));
         e_tt = p2_tt(doc);
-        e_tt.appendChild(p2_text(doc, Token.type_names(word.tok()).join(QChar::Space)));
+        e_tt.appendChild(p2_text(doc, m_asm->tokens().type_names(word.tok()).join(QChar::Space)));
         e_td.appendChild(e_tt);
         e_tr.appendChild(e_td);
 
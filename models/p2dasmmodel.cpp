@@ -169,7 +169,7 @@ QVariant P2DasmModel::data(const QModelIndex &index, int role) const
     case Qt::ToolTipRole:
         switch (column) {
         case c_Instruction:
-            result = Doc.html_opcode(IR.opcode()).join(QChar::LineFeed);
+            result = P2Doc::instance().html_opcode(IR.opcode()).join(QChar::LineFeed);
             break;
         default:
             break;
@@ -90,6 +90,7 @@ static const QString p2_prefix_real_const = QStringLiteral("flt");
  */
 P2Asm::P2Asm(QObject *parent)
     : QObject(parent)
+    , m_tokens()
     , m_pnut(true)
     , m_v33mode(false)
     , m_file_errors(false)
@@ -339,6 +340,26 @@ P2Union P2Asm::get_addr(int lineno) const
     return m_hash_address.value(lineno);
 }
 
+/**
+ * @brief Return the COG address (in bytes) for the line
+ * @param lineno line number
+ * @return COG address, or 0 if the line has none
+ */
+p2_LONG P2Asm::get_cogaddr(int lineno) const
+{
+    return m_hash_address.value(lineno).get_addr(p2_cog);
+}
+
+/**
+ * @brief Return the HUB address for the line
+ * @param lineno line number
+ * @return HUB address, or 0 if the line has none
+ */
+p2_LONG P2Asm::get_hubaddr(int lineno) const
+{
+    return m_hash_address.value(lineno).get_addr(p2_hub);
+}
+
 /**
  * @brief Return a const reference to the P2Opcode (opcode, data, equates) hash
  * @return const reference to the instruction register
@@ -407,12 +428,21 @@ const P2SymbolTable& P2Asm::symbols() const
     return m_symbols;
 }
 
+/**
+ * @brief Return the token tables used by this assembler
+ * @return const reference to the P2Token
+ */
+const P2Token& P2Asm::tokens() const
+{
+    return m_tokens;
+}
+
 p2_Cond_e P2Asm::conditional()
 {
     p2_Cond_e result = cc_always;
     p2_TOKEN_e cond = curr_tok();
-    if (Token.is_type(cond, tm_conditional)) {
-        result = Token.conditional(cond, cc_always);
+    if (m_tokens.is_type(cond, tm_conditional)) {
+        result = m_tokens.conditional(cond, cc_always);
         next();
     }
     return result;
@@ -421,8 +451,8 @@ p2_Cond_e P2Asm::conditional()
 p2_Cond_e P2Asm::parse_modcz()
 {
     p2_TOKEN_e cond = curr_tok();
-    if (Token.is_type(cond, tm_modcz_param)) {
-        p2_Cond_e result = Token.modcz_param(cond, cc_clr);
+    if (m_tokens.is_type(cond, tm_modcz_param)) {
+        p2_Cond_e result = m_tokens.modcz_param(cond, cc_clr);
         next();
         return result;
     }
@@ -2223,44 +2253,44 @@ bool P2Asm::assemble_dat_section()
             break;
 
         default:
-            if (Token.is_type(m_instr, tm_mnemonic)) {
+            if (m_tokens.is_type(m_instr, tm_mnemonic)) {
                 // Missing handling of an instruction token
                 m_errors += tr("Missing handling of instruction token '%1'.")
-                      .arg(Token.string(m_instr));
+                      .arg(m_tokens.string(m_instr));
                 emit Error(m_pass, m_lineno, m_errors.last());
                 m_idx = m_cnt;
                 break;
             }
 
-            if (Token.is_type(m_instr, tm_constant)) {
+            if (m_tokens.is_type(m_instr, tm_constant)) {
                 // Unexpected constant token
                 m_errors += tr("Constant '%1' used as an instruction.")
-                          .arg(Token.string(m_instr));
+                          .arg(m_tokens.string(m_instr));
                 emit Error(m_pass, m_lineno, m_errors.last());
                 m_idx = m_cnt;
                 break;
             }
 
-            if (Token.is_type(m_instr, tm_conditional)) {
+            if (m_tokens.is_type(m_instr, tm_conditional)) {
                 // Unexpected conditional token
                 m_errors += tr("Extraneous conditional '%1'.")
-                          .arg(Token.string(m_instr));
+                          .arg(m_tokens.string(m_instr));
                 emit Error(m_pass, m_lineno, m_errors.last());
                 m_idx = m_cnt;
                 break;
             }
 
-            if (Token.is_type(m_instr, tm_modcz_param)) {
+            if (m_tokens.is_type(m_instr, tm_modcz_param)) {
                 // Unexpected MODCZ parameter token
                 m_errors += tr("Extraneous MODCZ parameter '%1'.")
-                          .arg(Token.string(m_instr));
+                          .arg(m_tokens.string(m_instr));
                 emit Error(m_pass, m_lineno, m_errors.last());
                 m_idx = m_cnt;
                 break;
             }
 
             m_errors += tr("Not an instruction token '%1'.")
-                      .arg(Token.string(m_instr));
+                      .arg(m_tokens.string(m_instr));
             emit Error(m_pass, m_lineno, m_errors.last());
             m_idx = m_cnt;
         }
@@ -2420,7 +2450,7 @@ int P2Asm::count_wcz_flags() const
 {
     int flags = 0;
     for (int i = m_idx; i < m_cnt; i++)
-        if (Token.is_type(m_words[i].tok(), tm_wcz_suffix))
+        if (m_tokens.is_type(m_words[i].tok(), tm_wcz_suffix))
             flags++;
     return flags;
 }
@@ -2792,7 +2822,7 @@ bool P2Asm::skip_comments()
 {
     if (m_idx >= m_cnt)
         return false;
-    while (Token.is_type(curr_tok(), tm_comment))
+    while (m_tokens.is_type(curr_tok(), tm_comment))
         m_idx++;
     return m_idx < m_cnt;
 }
@@ -3334,7 +3364,7 @@ bool P2Asm::parse_atom(P2Atom& atom, int level)
         break;
 
     default:
-        DBG_EXPR(" not atomic: %s (%s)", qPrintable(str), qPrintable(Token.type_names(word.tok()).join(QStringLiteral(", "))));
+        DBG_EXPR(" not atomic: %s (%s)", qPrintable(str), qPrintable(m_tokens.type_names(word.tok()).join(QStringLiteral(", "))));
         prev();
         break;
     }
@@ -3358,16 +3388,16 @@ bool P2Asm::parse_primary(P2Atom& atom, int level)
     p2_LONG dec_by = 0;
 
     p2_TOKEN_e op = curr_tok();
-    while (Token.is_type(op, tm_primary)) {
+    while (m_tokens.is_type(op, tm_primary)) {
 
         switch (op) {
         case t_EXPR_INC:    // ++
-            DBG_EXPR(" primary inc: %s", qPrintable(Token.string(op)));
+            DBG_EXPR(" primary inc: %s", qPrintable(m_tokens.string(op)));
             inc_by++;
             break;
 
         case t_EXPR_DEC:    // --
-            DBG_EXPR(" primary dec: %s", qPrintable(Token.string(op)));
+            DBG_EXPR(" primary dec: %s", qPrintable(m_tokens.string(op)));
             dec_by--;
             break;
 
@@ -3407,29 +3437,29 @@ bool P2Asm::parse_unary(P2Atom& atom, int level)
     bool do_complement1 = false;
 
     p2_TOKEN_e op = curr_tok();
-    while (Token.is_type(op, tm_unary)) {
+    while (m_tokens.is_type(op, tm_unary)) {
 
         switch (op) {
         case t_EXPR_NEG:
-            DBG_EXPR(" unary neg: %s", qPrintable(Token.string(op)));
+            DBG_EXPR(" unary neg: %s", qPrintable(m_tokens.string(op)));
             do_logical_not = !do_logical_not;
             next();
             break;
 
         case t_EXPR_NOT:
-            DBG_EXPR(" unary not: %s", qPrintable(Token.string(op)));
+            DBG_EXPR(" unary not: %s", qPrintable(m_tokens.string(op)));
             do_complement1 = !do_complement1;
             next();
             break;
 
         case t_EXPR_MINUS:
-            DBG_EXPR(" unary minus: %s", qPrintable(Token.string(op)));
+            DBG_EXPR(" unary minus: %s", qPrintable(m_tokens.string(op)));
             do_complement2 = !do_complement2;
             next();
             break;
 
         case t_EXPR_PLUS:
-            DBG_EXPR(" unary plus: %s", qPrintable(Token.string(op)));
+            DBG_EXPR(" unary plus: %s", qPrintable(m_tokens.string(op)));
             next();
             break;
 
@@ -3470,7 +3500,7 @@ bool P2Asm::parse_mulops(P2Atom& atom, int level)
     }
 
     p2_TOKEN_e op = curr_tok();
-    while (Token.is_type(op, tm_mulop)) {
+    while (m_tokens.is_type(op, tm_mulop)) {
 
         if (!next()) {
             DBG_EXPR(" missing rvalue (%s)", "mulops");
@@ -3498,17 +3528,17 @@ bool P2Asm::parse_mulops(P2Atom& atom, int level)
 
         switch (op) {
         case t_EXPR_MUL:
-            DBG_EXPR(" mulop MUL: %s %s %s", qPrintable(atom.str()), qPrintable(Token.string(op)), qPrintable(rvalue.str()));
+            DBG_EXPR(" mulop MUL: %s %s %s", qPrintable(atom.str()), qPrintable(m_tokens.string(op)), qPrintable(rvalue.str()));
             atom.arith_mul(rvalue);
             DBG_EXPR(" mulop atom = %s", qPrintable(atom.str()));
             break;
         case t_EXPR_DIV:
-            DBG_EXPR(" mulop DIV: %s %s %s", qPrintable(atom.str()), qPrintable(Token.string(op)), qPrintable(rvalue.str()));
+            DBG_EXPR(" mulop DIV: %s %s %s", qPrintable(atom.str()), qPrintable(m_tokens.string(op)), qPrintable(rvalue.str()));
             atom.arith_div(rvalue);
             DBG_EXPR(" mulop atom = %s", qPrintable(atom.str()));
             break;
         case t_EXPR_MOD:
-            DBG_EXPR(" mulop MOD: %s %s %s", qPrintable(atom.str()), qPrintable(Token.string(op)), qPrintable(rvalue.str()));
+            DBG_EXPR(" mulop MOD: %s %s %s", qPrintable(atom.str()), qPrintable(m_tokens.string(op)), qPrintable(rvalue.str()));
             atom.arith_mod(rvalue);
             DBG_EXPR(" mulop atom = %s", qPrintable(atom.str()));
             break;
@@ -3542,7 +3572,7 @@ bool P2Asm::parse_shiftops(P2Atom& atom, int level)
     }
 
     p2_TOKEN_e op = curr_tok();
-    while (Token.is_type(op, tm_shiftop)) {
+    while (m_tokens.is_type(op, tm_shiftop)) {
 
         if (!next()) {
             DBG_EXPR(" missing rvalue (%s)", "shiftops");
@@ -3570,12 +3600,12 @@ bool P2Asm::parse_shiftops(P2Atom& atom, int level)
 
         switch (op) {
         case t_EXPR_SHL:
-            DBG_EXPR(" shiftop SHL: %s %s %s", qPrintable(atom.str()), qPrintable(Token.string(op)), qPrintable(rvalue.str()));
+            DBG_EXPR(" shiftop SHL: %s %s %s", qPrintable(atom.str()), qPrintable(m_tokens.string(op)), qPrintable(rvalue.str()));
             atom.binary_shl(rvalue);
             DBG_EXPR(" shiftop atom = %s", qPrintable(atom.str()));
             break;
         case t_EXPR_SHR:
-            DBG_EXPR(" shiftop SHR: %s %s %s", qPrintable(atom.str()), qPrintable(Token.string(op)), qPrintable(rvalue.str()));
+            DBG_EXPR(" shiftop SHR: %s %s %s", qPrintable(atom.str()), qPrintable(m_tokens.string(op)), qPrintable(rvalue.str()));
             atom.binary_shr(rvalue);
             DBG_EXPR(" shiftop atom = %s", qPrintable(atom.str()));
             break;
@@ -3609,7 +3639,7 @@ bool P2Asm::parse_addops(P2Atom& atom, int level)
     }
 
     p2_TOKEN_e op = curr_tok();
-    while (Token.is_type(op, tm_addop)) {
+    while (m_tokens.is_type(op, tm_addop)) {
 
         if (!next()) {
             DBG_EXPR(" missing rvalue (%s)", "addops");
@@ -3637,12 +3667,12 @@ bool P2Asm::parse_addops(P2Atom& atom, int level)
 
         switch (op) {
         case t_EXPR_PLUS:
-            DBG_EXPR(" addop ADD: %s %s %s", qPrintable(atom.str()), qPrintable(Token.string(op)), qPrintable(rvalue.str()));
+            DBG_EXPR(" addop ADD: %s %s %s", qPrintable(atom.str()), qPrintable(m_tokens.string(op)), qPrintable(rvalue.str()));
             atom.arith_add(rvalue);
             DBG_EXPR(" addop atom = %s", qPrintable(atom.str()));
             break;
         case t_EXPR_MINUS:
-            DBG_EXPR(" addop SUB: %s %s %s", qPrintable(atom.str()), qPrintable(Token.string(op)), qPrintable(rvalue.str()));
+            DBG_EXPR(" addop SUB: %s %s %s", qPrintable(atom.str()), qPrintable(m_tokens.string(op)), qPrintable(rvalue.str()));
             atom.arith_sub(rvalue);
             DBG_EXPR(" addop atom = %s", qPrintable(atom.str()));
             break;
@@ -3676,7 +3706,7 @@ bool P2Asm::parse_binops(P2Atom& atom, int level)
     }
 
     p2_TOKEN_e op = curr_tok();
-    while (Token.is_type(op, tm_binop)) {
+    while (m_tokens.is_type(op, tm_binop)) {
 
         if (!next()) {
             DBG_EXPR(" missing rvalue (%s)", "binops");
@@ -3704,32 +3734,32 @@ bool P2Asm::parse_binops(P2Atom& atom, int level)
 
         switch (op) {
         case t_EXPR_AND:
-            DBG_EXPR(" binop AND: %s %s %s", qPrintable(atom.str()), qPrintable(Token.string(op)), qPrintable(rvalue.str()));
+            DBG_EXPR(" binop AND: %s %s %s", qPrintable(atom.str()), qPrintable(m_tokens.string(op)), qPrintable(rvalue.str()));
             atom.binary_and(rvalue);
             DBG_EXPR(" binop atom = %s", qPrintable(atom.str()));
             break;
         case t_EXPR_XOR:
-            DBG_EXPR(" binop XOR: %s %s %s", qPrintable(atom.str()), qPrintable(Token.string(op)), qPrintable(rvalue.str()));
+            DBG_EXPR(" binop XOR: %s %s %s", qPrintable(atom.str()), qPrintable(m_tokens.string(op)), qPrintable(rvalue.str()));
             atom.binary_xor(rvalue);
             DBG_EXPR(" binop atom = %s", qPrintable(atom.str()));
             break;
         case t_EXPR_OR:
-            DBG_EXPR(" binop OR: %s %s %s", qPrintable(atom.str()), qPrintable(Token.string(op)), qPrintable(rvalue.str()));
+            DBG_EXPR(" binop OR: %s %s %s", qPrintable(atom.str()), qPrintable(m_tokens.string(op)), qPrintable(rvalue.str()));
             atom.binary_or(rvalue);
             DBG_EXPR(" binop atom = %s", qPrintable(atom.str()));
             break;
         case t_EXPR_REV:
-            DBG_EXPR(" binop REV: %s %s %s", qPrintable(atom.str()), qPrintable(Token.string(op)), qPrintable(rvalue.str()));
+            DBG_EXPR(" binop REV: %s %s %s", qPrintable(atom.str()), qPrintable(m_tokens.string(op)), qPrintable(rvalue.str()));
             atom.reverse(rvalue);
             DBG_EXPR(" binop atom = %s", qPrintable(atom.str()));
             break;
         case t_EXPR_ENCOD:
-            DBG_EXPR(" binop ENCOD: %s %s %s", qPrintable(atom.str()), qPrintable(Token.string(op)), qPrintable(rvalue.str()));
+            DBG_EXPR(" binop ENCOD: %s %s %s", qPrintable(atom.str()), qPrintable(m_tokens.string(op)), qPrintable(rvalue.str()));
             atom.encode(rvalue);
             DBG_EXPR(" binop atom = %s", qPrintable(atom.str()));
             break;
         case t_EXPR_DECOD:
-            DBG_EXPR(" binop DECOD: %s %s %s", qPrintable(atom.str()), qPrintable(Token.string(op)), qPrintable(rvalue.str()));
+            DBG_EXPR(" binop DECOD: %s %s %s", qPrintable(atom.str()), qPrintable(m_tokens.string(op)), qPrintable(rvalue.str()));
             atom.decode(rvalue);
             DBG_EXPR(" binop atom = %s", qPrintable(atom.str()));
             break;
@@ -3755,26 +3785,26 @@ bool P2Asm::parse_binops(P2Atom& atom, int level)
 p2_Traits_e P2Asm::parse_traits()
 {
     P2Traits traits(tr_none);
-    while (Token.is_type(curr_tok(), tm_traits)) {
+    while (m_tokens.is_type(curr_tok(), tm_traits)) {
 
         switch (curr_tok()) {
         case t_IMMEDIATE:
-            DBG_EXPR(" trait immediate: %s", qPrintable(Token.string(tok)));
+            DBG_EXPR(" trait immediate: %s", qPrintable(m_tokens.string(tok)));
             traits.add(tr_IMMEDIATE);
             next();
             break;
         case t_AUGMENTED:
-            DBG_EXPR(" trait force AUGS/AUGD: %s", qPrintable(Token.string(tok)));
+            DBG_EXPR(" trait force AUGS/AUGD: %s", qPrintable(m_tokens.string(tok)));
             traits.add(tr_AUGMENTED);
             next();
             break;
         case t_HUBADDRESS:
-            DBG_EXPR(" trait hubadress: %s", qPrintable(Token.string(tok)));
+            DBG_EXPR(" trait hubadress: %s", qPrintable(m_tokens.string(tok)));
             traits.add(tr_HUBADDRESS);
             next();
             break;
         case t_ABSOLUTE:
-            DBG_EXPR(" trait absolute: %s", qPrintable(Token.string(tok)));
+            DBG_EXPR(" trait absolute: %s", qPrintable(m_tokens.string(tok)));
             traits.add(tr_ABSOLUTE);
             next();
             break;
@@ -3808,7 +3838,7 @@ P2Atom P2Asm::parse_expression(int level)
 
     // Check for subexpression enclosed in parenthesis
     p2_TOKEN_e tok = curr_tok();
-    while (Token.is_type(tok, tm_parens)) {
+    while (m_tokens.is_type(tok, tm_parens)) {
 
         switch (tok) {
         case t_EXPR_LPAREN:
@@ -3828,7 +3858,7 @@ P2Atom P2Asm::parse_expression(int level)
             break;
 
         default:
-            DBG_EXPR(" not parens: %s (%s)", qPrintable(curr_str()), qPrintable(Token.string(tok)));
+            DBG_EXPR(" not parens: %s (%s)", qPrintable(curr_str()), qPrintable(m_tokens.string(tok)));
             prev();
         }
 
@@ -3844,7 +3874,7 @@ P2Atom P2Asm::parse_expression(int level)
 
     // Check for index expression enclosed in square brackets
     tok = curr_tok();
-    while (Token.is_type(tok, tm_brackets)) {
+    while (m_tokens.is_type(tok, tm_brackets)) {
         switch (tok) {
         case t_EXPR_LBRACKET:
             // precedence 0
@@ -3865,7 +3895,7 @@ P2Atom P2Asm::parse_expression(int level)
             break;
 
         default:
-            DBG_EXPR(" expr not bracket: %s (%s)", qPrintable(curr_str()), qPrintable(Token.string(tok)));
+            DBG_EXPR(" expr not bracket: %s (%s)", qPrintable(curr_str()), qPrintable(m_tokens.string(tok)));
             Q_ASSERT_X(false, "not rbracket", "tm_brackets");
             prev();
         }
@@ -3909,7 +3939,7 @@ P2Atom P2Asm::parse_expression(int level)
             break;
         }
 
-        if (!Token.is_type(tok, tm_comment))
+        if (!m_tokens.is_type(tok, tm_comment))
             break;
 
         if (eol())
@@ -4199,15 +4229,15 @@ bool P2Asm::mandatory_COMMA()
 {
     if (eol()) {
         m_errors += tr("Expected %1 but found %2.")
-                  .arg(Token.string(t_COMMA))
+                  .arg(m_tokens.string(t_COMMA))
                   .arg(tr("end of line"));
         emit Error(m_pass, m_lineno, m_errors.last());
         return false;
     }
     if (t_COMMA != curr_tok()) {
         m_errors += tr("Expected %1 but found %2.")
-                  .arg(Token.string(t_COMMA))
-                  .arg(Token.string(m_words.value(m_idx).tok()));
+                  .arg(m_tokens.string(t_COMMA))
+                  .arg(m_tokens.string(m_words.value(m_idx).tok()));
         emit Error(m_pass, m_lineno, m_errors.last());
         return false;
     }
@@ -5320,7 +5350,7 @@ bool P2Asm::asm_ORGF()
 
     if (m_hubmode) {
         m_errors += tr("%1 found in HUB mode.")
-                    .arg(Token.string(t_ORGF));
+                    .arg(m_tokens.string(t_ORGF));
         emit Error(m_pass, m_lineno, m_errors.last());
         m_idx = m_cnt;
         return end_of_line();
@@ -101,6 +101,7 @@ public:
 
     const QStringList& listing() const;
     const P2SymbolTable& symbols() const;
+    const P2Token& tokens() const;
 
     bool assemble(const QStringList& source);
     bool assemble(const QString& filename);
@@ -123,6 +124,7 @@ public slots:
     void set_file_errors(bool on = true);
 
 private:
+    P2Token m_tokens;                       //!< token tables and regular expressions of this assembler
     bool m_pnut;                            //!< use PNut compatible listing mode
     bool m_v33mode;                         //!< use V33 mode in index expressions?
     bool m_file_errors;                     //!< emit an error when a file is not found
@@ -0,0 +1,220 @@
+/****************************************************************************
+ *
+ * P2 emulator breakpoints and watchpoints
+ *
+ * Copyright (C) 2019 Jürgen Buchmüller <pullmoll@t-online.de>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ ****************************************************************************/
+#include "p2break.h"
+
+//! Number of longs in a bitmap of COG or LUT memory
+static constexpr int cog_bitmap_size = static_cast<int>(COG_SIZE / 32);
+
+//! Number of longs in a bitmap of HUB memory
+static constexpr int hub_bitmap_size = static_cast<int>(MEM_SIZE / 32);
+
+P2Breakpoints::P2Breakpoints()
+    : m_bits()
+    , m_count(0)
+    , m_hit()
+    , m_resume(~Q_UINT64_C(0))
+    , m_resume_cog(-1)
+{
+    m_hit.kind = p2_BREAK_NONE;
+}
+
+/**
+ * @brief Return true, if no breakpoint or watchpoint is set
+ * @return true if empty
+ */
+bool P2Breakpoints::isEmpty() const
+{
+    return 0 == m_count;
+}
+
+/**
+ * @brief Remove all breakpoints and watchpoints, and the hit
+ */
+void P2Breakpoints::clear()
+{
+    for (int kind = 0; kind <= p2_BREAK_WRITE; kind++)
+        for (int space = 0; space <= p2_BREAK_HUB; space++)
+            m_bits[kind][space].clear();
+    m_count = 0;
+    m_hit.kind = p2_BREAK_NONE;
+    m_resume = ~Q_UINT64_C(0);
+    m_resume_cog = -1;
+}
+
+/**
+ * @brief Set or remove a breakpoint or watchpoint
+ * @param kind p2_BREAK_EXEC, p2_BREAK_READ, or p2_BREAK_WRITE
+ * @param space memory of the address
+ * @param addr long index in COG or LUT memory, or byte address in HUB memory
+ * @param on true to set, false to remove
+ */
+void P2Breakpoints::set(p2_BREAK_e kind, p2_BREAK_space_e space, p2_LONG addr, bool on)
+{
+    if (p2_BREAK_NONE == kind)
+        return;
+    QVector<p2_LONG>& bits = m_bits[kind][space];
+    if (bits.isEmpty()) {
+        if (!on)
+            return;
+        bits.fill(0, p2_BREAK_HUB == space ? hub_bitmap_size : cog_bitmap_size);
+    }
+    const p2_LONG a = addr & (static_cast<p2_LONG>(bits.count()) * 32 - 1);
+    p2_LONG& word = bits[static_cast<int>(a / 32)];
+    const p2_LONG bit = 1u << (a & 31);
+    if (on == !!(word & bit))
+        return;
+    word ^= bit;
+    m_count += on ? 1 : -1;
+}
+
+/**
+ * @brief Return the addresses set for a kind of access in a memory
+ * @param kind p2_BREAK_EXEC, p2_BREAK_READ, or p2_BREAK_WRITE
+ * @param space memory
+ * @return addresses in ascending order
+ */
+QVector<p2_LONG> P2Breakpoints::list(p2_BREAK_e kind, p2_BREAK_space_e space) const
+{
+    QVector<p2_LONG> result;
+    const QVector<p2_LONG>& bits = m_bits[kind][space];
+    for (int i = 0; i < bits.count(); i++)
+        for (p2_LONG bit = 0; bit < 32; bit++)
+            if (bits[i] & (1u << bit))
+                result += static_cast<p2_LONG>(i) * 32 + bit;
+    return result;
+}
+
+/**
+ * @brief Return the memory a PC executes from
+ * @param pc address as in the COG's PC
+ * @return p2_BREAK_COG, p2_BREAK_LUT, or p2_BREAK_HUB
+ */
+p2_BREAK_space_e P2Breakpoints::space(p2_LONG pc)
+{
+    if (pc < LUT_ADDR0)
+        return p2_BREAK_COG;
+    if (pc < HUB_ADDR0)
+        return p2_BREAK_LUT;
+    return p2_BREAK_HUB;
+}
+
+/**
+ * @brief Return the address of a PC in its memory
+ * @param pc address as in the COG's PC
+ * @return long index in COG or LUT memory, or byte address in HUB memory
+ */
+p2_LONG P2Breakpoints::index(p2_LONG pc)
+{
+    if (pc < LUT_ADDR0)
+        return (pc / sz_LONG) & COG_MASK;
+    if (pc < HUB_ADDR0)
+        return (pc / sz_LONG) & LUT_MASK;
+    return pc & A20MASK;
+}
+
+/**
+ * @brief Set or remove a breakpoint at a PC
+ * @param pc address as in the COG's PC
+ * @param on true to set, false to remove
+ */
+void P2Breakpoints::set_breakpoint(p2_LONG pc, bool on)
+{
+    set(p2_BREAK_EXEC, space(pc), index(pc), on);
+}
+
+/**
+ * @brief Return true, if a breakpoint is set at a PC
+ * @param pc address as in the COG's PC
+ * @return true if set
+ */
+bool P2Breakpoints::breakpoint(p2_LONG pc) const
+{
+    return test(p2_BREAK_EXEC, space(pc), index(pc));
+}
+
+/**
+ * @brief Return the first hit since the last resume()
+ * @return hit; its kind is p2_BREAK_NONE if there was none
+ */
+const p2_BREAK_hit_t& P2Breakpoints::hit() const
+{
+    return m_hit;
+}
+
+/**
+ * @brief Record a hit, unless there is one already
+ * @param kind kind of access
+ * @param space memory accessed
+ * @param addr address accessed in %space
+ * @param cog COG which made the access
+ * @param pc address of the COG's instruction
+ * @param cnt HUB cycle counter
+ */
+void P2Breakpoints::record(p2_BREAK_e kind, p2_BREAK_space_e space, p2_LONG addr, int cog, p2_LONG pc, p2_QUAD cnt)
+{
+    if (p2_BREAK_NONE != m_hit.kind)
+        return;
+    m_hit.kind = kind;
+    m_hit.space = space;
+    m_hit.addr = addr;
+    m_hit.cog = cog;
+    m_hit.pc = pc;
+    m_hit.cnt = cnt;
+}
+
+/**
+ * @brief Forget the hit, so execution continues
+ *
+ * A COG stopped at a breakpoint executes the instruction there when
+ * the HUB runs again, instead of hitting the breakpoint once more.
+ */
+void P2Breakpoints::resume()
+{
+    if (p2_BREAK_EXEC == m_hit.kind) {
+        m_resume = m_hit.cnt;
+        m_resume_cog = m_hit.cog;
+    }
+    m_hit.kind = p2_BREAK_NONE;
+}
+
+/**
+ * @brief Return true, if a COG was resumed from a breakpoint at a HUB cycle
+ * @param cnt HUB cycle counter
+ * @param cog COG index
+ * @return true if the COG's fetch address is not checked in this cycle
+ */
+bool P2Breakpoints::resumed(p2_QUAD cnt, int cog) const
+{
+    return m_resume == cnt && m_resume_cog == cog;
+}
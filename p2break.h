@@ -0,0 +1,123 @@
+/****************************************************************************
+ *
+ * P2 emulator breakpoints and watchpoints
+ *
+ * Copyright (C) 2019 Jürgen Buchmüller <pullmoll@t-online.de>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ ****************************************************************************/
+#pragma once
+#include <QVector>
+#include "p2defs.h"
+
+/**
+ * @file Breakpoints and watchpoints.
+ *
+ * P2Breakpoints keeps a bitmap per kind of access (instruction fetch,
+ * data read, data write) and memory: one bit per long of COG and LUT
+ * memory, and one bit per byte of HUB memory. The bitmaps of the HUB
+ * are allocated when the first address in them is set.
+ *
+ * A P2Hub with armed breakpoints checks the fetch address of every COG
+ * before each cycle and stops before the instruction executes. The HUB
+ * and COG memory paths record watchpoint hits, and the P2Hub stops after
+ * the instruction which made the access. Only the first hit is recorded
+ * until resume() is called. While the breakpoints are not armed, the
+ * P2Hub and COGs only test a null pointer.
+ *
+ * COG and LUT addresses are long indices (0 … 511), HUB addresses are
+ * byte addresses. A read of a COG register is an instruction naming it
+ * as D, or as S unless S is immediate.
+ */
+
+//! Kind of access a breakpoint or watchpoint is hit by
+typedef enum {
+    p2_BREAK_NONE,              //!< not hit
+    p2_BREAK_EXEC,              //!< instruction fetched from the address
+    p2_BREAK_READ,              //!< data read from the address
+    p2_BREAK_WRITE,             //!< data written to the address
+}   p2_BREAK_e;
+
+//! Memory of a breakpoint or watchpoint
+typedef enum {
+    p2_BREAK_COG,               //!< COG memory, by long index
+    p2_BREAK_LUT,               //!< LUT memory, by long index
+    p2_BREAK_HUB,               //!< HUB memory, by byte address
+}   p2_BREAK_space_e;
+
+//! A breakpoint or watchpoint hit
+typedef struct {
+    p2_BREAK_e kind;            //!< kind of access, or p2_BREAK_NONE
+    p2_BREAK_space_e space;     //!< memory accessed
+    p2_LONG addr;               //!< address accessed in %space
+    int cog;                    //!< COG which made the access
+    p2_LONG pc;                 //!< address of the COG's instruction
+    p2_QUAD cnt;                //!< HUB cycle counter at the hit
+}   p2_BREAK_hit_t;
+
+class P2Breakpoints
+{
+public:
+    P2Breakpoints();
+
+    bool isEmpty() const;
+    void clear();
+    void set(p2_BREAK_e kind, p2_BREAK_space_e space, p2_LONG addr, bool on = true);
+    QVector<p2_LONG> list(p2_BREAK_e kind, p2_BREAK_space_e space) const;
+
+    //! return true if any of the %size addresses starting at %addr in %space is set for %kind
+    bool test(p2_BREAK_e kind, p2_BREAK_space_e space, p2_LONG addr, p2_LONG size = 1) const {
+        const QVector<p2_LONG>& bits = m_bits[kind][space];
+        if (bits.isEmpty())
+            return false;
+        const p2_LONG mask = static_cast<p2_LONG>(bits.count()) * 32 - 1;
+        for (p2_LONG i = 0; i < size; i++) {
+            const p2_LONG a = (addr + i) & mask;
+            if (bits[static_cast<int>(a / 32)] & (1u << (a & 31)))
+                return true;
+        }
+        return false;
+    }
+
+    static p2_BREAK_space_e space(p2_LONG pc);
+    static p2_LONG index(p2_LONG pc);
+    void set_breakpoint(p2_LONG pc, bool on = true);
+    bool breakpoint(p2_LONG pc) const;
+
+    const p2_BREAK_hit_t& hit() const;
+    void record(p2_BREAK_e kind, p2_BREAK_space_e space, p2_LONG addr, int cog, p2_LONG pc, p2_QUAD cnt);
+    void resume();
+    bool resumed(p2_QUAD cnt, int cog) const;
+
+private:
+    QVector<p2_LONG> m_bits[p2_BREAK_WRITE + 1][p2_BREAK_HUB + 1];  //!< bitmaps per kind and memory, empty while unused
+    int m_count;                //!< number of addresses set
+    p2_BREAK_hit_t m_hit;       //!< first hit since the last resume()
+    p2_QUAD m_resume;           //!< HUB cycle counter of the last breakpoint hit which was resumed
+    int m_resume_cog;           //!< COG of the last breakpoint hit which was resumed
+};
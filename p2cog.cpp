@@ -34,13 +34,25 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  ****************************************************************************/
 #include "p2cog.h"
+#include "p2cordic.h"
+#include "p2pixel.h"
+#include "p2video.h"
 #include "p2util.h"
 
+#define P2_OP_FUNC(name) &P2Cog::op_##name,
+const P2Cog::p2_opfunc_t P2Cog::opfuncs[OP_COUNT] = { P2_COG_OPS(P2_OP_FUNC) };
+#undef P2_OP_FUNC
+
+bool P2Cog::use_dispatch = true;
+p2_JIT_mode_e P2Cog::use_jit = p2_JIT_OFF;
+
 P2Cog::P2Cog(int cog_id, P2Hub* hub, QObject* parent)
     : QObject(parent)
     , HUB(hub)
     , ID(static_cast<p2_LONG>(cog_id))
     , PC(0xfc000)
+    , ICNT(0)
+    , CNT(0)
     , WAIT()
     , FLAGS()
     , CT1(0)
@@ -48,22 +60,29 @@ P2Cog::P2Cog(int cog_id, P2Hub* hub, QObject* parent)
     , CT3(0)
     , PAT()
     , PIN()
+    , SE()
     , INT()
+    , LOCK()
     , IR()
+    , DEC(nullptr)
     , D(0)
     , S(0)
     , Q(0)
+    , R(0)
     , C(0)
     , Z(0)
     , FIFO()
+    , STREAMER()
+    , PIX()
     , K(0)
     , STACK()
-    , S_next()
-    , S_aug()
-    , D_aug()
-    , R_aug()
-    , IR_aug()
-    , REP_instr()
+    , VALID(0)
+    , S_next(0)
+    , S_aug(0)
+    , D_aug(0)
+    , R_aug(0)
+    , IR_aug(0)
+    , REP_instr(0)
     , REP_offset(0)
     , REP_times(0)
     , SKIP(0)
@@ -72,6 +91,7 @@ P2Cog::P2Cog(int cog_id, P2Hub* hub, QObject* parent)
     , PTRB0(0)
     , HUBOP(0)
     , CORDIC_count(0)
+    , CORDIC()
     , QX_posted(false)
     , QY_posted(false)
     , RW_repeat(false)
@@ -83,9 +103,29 @@ P2Cog::P2Cog(int cog_id, P2Hub* hub, QObject* parent)
     , WRL_flags1(0)
     , COG()
     , LUT()
-    , MEM(hub->mem())
-    , MEMSIZE(hub->memsize())
-{
+    , DEC_COG()
+    , DEC_LUT()
+    , DEC_HUB()
+    , JIT(nullptr)
+    , JIT_ticks(0)
+    , JIT_verify(0)
+    , JIT_PC(0)
+    , JIT_flags()
+    , JIT_COG()
+    , JIT_mismatches(0)
+    , MAP(hub->map())
+    , VIDEO(nullptr)
+    , PROFILE(nullptr)
+    , IR_PC(0)
+    , STATS(nullptr)
+    , BREAK(nullptr)
+{
+    // clear the padding bits, too, so snapshots of equal states are equal
+    memset(&LOCK, 0, sizeof(LOCK));
+    // only COG #0 boots, from the ROM at $FC000
+    if (cog_id)
+        stop();
+    MAP.map_io(COG_ADDR0, HUB_ADDR0 - COG_ADDR0, rd_local, wr_local, this);
 }
 
 p2_LONG P2Cog::rd_cog(p2_LONG addr) const
@@ -96,6 +136,9 @@ p2_LONG P2Cog::rd_cog(p2_LONG addr) const
 void P2Cog::wr_cog(p2_LONG addr, p2_LONG val)
 {
     COG.RAM[addr & COG_MASK] = val;
+    DEC_COG[addr & COG_MASK].valid = false;
+    if (JIT)
+        JIT->invalidate(false, addr);
 }
 
 p2_LONG P2Cog::rd_lut(p2_LONG addr) const
@@ -106,38 +149,76 @@ p2_LONG P2Cog::rd_lut(p2_LONG addr) const
 void P2Cog::wr_lut(p2_LONG addr, p2_LONG val)
 {
     LUT.RAM[addr & LUT_MASK] = val;
+    DEC_LUT[addr & LUT_MASK].valid = false;
+    if (JIT)
+        JIT->invalidate(true, addr);
 }
 
 p2_LONG P2Cog::rd_mem(p2_LONG addr) const
 {
-    p2_LONG result = 0;
-    switch (addr & 0xfff800) {
-    case 0x000000:
-        result = rd_cog(addr/4);
-        break;
-    case 0x000800:
-        result = rd_lut(addr/4);
-        break;
-    default:
-        Q_ASSERT(HUB);
-        result = HUB->rd_LONG(addr);
-    }
-    return result;
+    return MAP.rd_LONG(addr);
 }
 
 void P2Cog::wr_mem(p2_LONG addr, p2_LONG val)
 {
-    switch (addr & 0xfff800) {
-    case 0x000000:
-        wr_cog(addr/4, val);
-        break;
-    case 0x000800:
-        wr_lut(addr/4, val);
-        break;
-    default:
-        Q_ASSERT(HUB);
-        HUB->wr_LONG(addr, val);
+    MAP.wr_LONG(addr, val);
+}
+
+/**
+ * @brief Copy the HUB's mapping of the page containing address %addr
+ *
+ * The HUB calls this when it maps a page differently, e.g. when a
+ * shared page gets a private copy. Page 0 stays mapped to COG and LUT.
+ *
+ * @param addr address inside the page
+ */
+void P2Cog::remap(p2_LONG addr)
+{
+    if (addr >= HUB_ADDR0)
+        MAP.map_page(addr, HUB->map().page(addr));
+}
+
+/**
+ * @brief Read handler for the COG and LUT memory page of the memory map
+ * @param ctx pointer to the P2Cog
+ * @param addr address $00000 … $00fff
+ * @param size number of bytes (1, 2, or 4)
+ * @return value read
+ */
+p2_LONG P2Cog::rd_local(void* ctx, p2_LONG addr, int size)
+{
+    const P2Cog* cog = static_cast<const P2Cog*>(ctx);
+    const p2_LONG data = addr < LUT_ADDR0 ? cog->rd_cog(addr / sz_LONG)
+                                          : cog->rd_lut((addr - LUT_ADDR0) / sz_LONG);
+    const p2_LONG shift = (addr & 3) * 8;
+    switch (size) {
+    case sz_BYTE:
+        return (data >> shift) & 0xffu;
+    case sz_WORD:
+        return (data >> shift) & 0xffffu;
     }
+    return data;
+}
+
+/**
+ * @brief Write handler for the COG and LUT memory page of the memory map
+ * @param ctx pointer to the P2Cog
+ * @param addr address $00000 … $00fff
+ * @param val value to write
+ * @param size number of bytes (1, 2, or 4)
+ */
+void P2Cog::wr_local(void* ctx, p2_LONG addr, p2_LONG val, int size)
+{
+    P2Cog* cog = static_cast<P2Cog*>(ctx);
+    if (size != sz_LONG) {
+        const p2_LONG shift = (addr & 3) * 8;
+        const p2_LONG mask = (sz_BYTE == size ? 0xffu : 0xffffu) << shift;
+        val = (rd_local(ctx, addr, sz_LONG) & ~mask) | ((val << shift) & mask);
+    }
+    if (addr < LUT_ADDR0)
+        cog->wr_cog(addr / sz_LONG, val);
+    else
+        cog->wr_lut((addr - LUT_ADDR0) / sz_LONG, val);
 }
 
 /**
@@ -151,6 +232,24 @@ void P2Cog::wr_PC(p2_LONG addr)
         PC &= ~3u;
 }
 
+/**
+ * @brief Write C flag
+ * @param c new C flag (bit 0)
+ */
+void P2Cog::wr_C(p2_LONG c)
+{
+    C = c & 1u;
+}
+
+/**
+ * @brief Write Z flag
+ * @param z new Z flag (bit 0)
+ */
+void P2Cog::wr_Z(p2_LONG z)
+{
+    Z = z & 1u;
+}
+
 /**
  * @brief Write PTRA address
  * @param addr address to store in PTRA
@@ -184,7 +283,7 @@ void P2Cog::updateC(bool c) {
  */
 void P2Cog::updateZ(bool z) {
     if (IR.op7.wz)
-        C = z & 1u;
+        Z = z & 1u;
 }
 
 /**
@@ -193,7 +292,14 @@ void P2Cog::updateZ(bool z) {
  */
 void P2Cog::updateD(p2_LONG d)
 {
+    if (BREAK && BREAK->test(p2_BREAK_WRITE, p2_BREAK_COG, R))
+        BREAK->record(p2_BREAK_WRITE, p2_BREAK_COG, R & COG_MASK, static_cast<int>(ID), IR_PC, CNT);
     COG.RAM[R] = d;
+    DEC_COG[R & COG_MASK].valid = false;
+    if (JIT)
+        JIT->invalidate(false, R);
+    if (R - offs_DIRA < 4)  // DIRA, DIRB, OUTA, OUTB drive the pins
+        HUB->wr_port(R, d);
 }
 
 /**
@@ -214,7 +320,7 @@ void P2Cog::updatePC(p2_LONG pc)
     // TODO: handle switch between COG, LUT, and HUB ?
     PC = pc;
     // Stop REP, if any
-    REP_instr.clear();
+    VALID &= ~VALID_REP_instr;
 }
 
 /**
@@ -224,7 +330,12 @@ void P2Cog::updatePC(p2_LONG pc)
  */
 void P2Cog::updateLUT(p2_LONG addr, p2_LONG d)
 {
+    if (BREAK && BREAK->test(p2_BREAK_WRITE, p2_BREAK_LUT, addr))
+        BREAK->record(p2_BREAK_WRITE, p2_BREAK_LUT, addr & LUT_MASK, static_cast<int>(ID), IR_PC, CNT);
     LUT.RAM[addr & 0x1ff] = d;
+    DEC_LUT[addr & 0x1ff].valid = false;
+    if (JIT)
+        JIT->invalidate(true, addr);
 }
 
 /**
@@ -245,6 +356,91 @@ void P2Cog::updateSKIPF(p2_LONG d)
     SKIPF = d;
 }
 
+/**
+ * @brief Return the Q value set by a SETQ/SETQ2 preceding the current instruction
+ * @return Q, if the previous instruction was SETQ/SETQ2, or 0 otherwise
+ */
+p2_LONG P2Cog::setq() const
+{
+    return (VALID & VALID_Q) ? Q : 0;
+}
+
+/**
+ * @brief Issue a CORDIC solver command with the results %x and %y
+ *
+ * The command enters the solver in this COG's next issue slot and its
+ * results are posted P2Cordic::latency cycles later. The COG waits for
+ * the issue slot.
+ *
+ * @param x result X of the command
+ * @param y result Y of the command
+ */
+void P2Cog::cordic_issue(p2_LONG x, p2_LONG y)
+{
+    const p2_QUAD slot = P2Cordic::slot(ID, CNT, static_cast<p2_LONG>(HUB->ncogs()));
+
+    if (CORDIC_count == CORDIC_DEPTH) {
+        // the solver can not hold more results: the oldest one is lost
+        CORDIC.head = (CORDIC.head + 1) % CORDIC_DEPTH;
+        CORDIC_count--;
+    }
+
+    auto& result = CORDIC.pipe[(CORDIC.head + CORDIC_count) % CORDIC_DEPTH];
+    result.ready = slot + P2Cordic::latency;
+    result.X = x;
+    result.Y = y;
+    CORDIC_count++;
+
+    if (slot > CNT) {
+        WAIT.flag = static_cast<p2_LONG>(slot - CNT);
+        WAIT.mode = p2_WAIT_CORDIC;
+    }
+}
+
+/**
+ * @brief Post the CORDIC solver results which are due at cycle %cnt
+ * @param cnt cycle counter value
+ */
+void P2Cog::cordic_post(p2_QUAD cnt)
+{
+    while (CORDIC_count > 0 && CORDIC.pipe[CORDIC.head].ready <= cnt) {
+        const auto& result = CORDIC.pipe[CORDIC.head];
+        CORDIC.X = result.X;
+        CORDIC.Y = result.Y;
+        QX_posted = true;
+        QY_posted = true;
+        CORDIC.head = (CORDIC.head + 1) % CORDIC_DEPTH;
+        CORDIC_count--;
+    }
+}
+
+/**
+ * @brief Get the CORDIC solver result X or Y into D (GETQX/GETQY)
+ *
+ * If the result is not yet posted, but a command is in flight, the COG
+ * waits until the oldest result is posted.
+ *
+ * @param y true to get result Y, false to get result X
+ */
+void P2Cog::cordic_get(bool y)
+{
+    cordic_post(CNT);
+
+    bool& posted = y ? QY_posted : QX_posted;
+    if (!posted && CORDIC_count > 0) {
+        const p2_QUAD ready = CORDIC.pipe[CORDIC.head].ready;
+        cordic_post(ready);
+        WAIT.flag = static_cast<p2_LONG>(ready - CNT);
+        WAIT.mode = p2_WAIT_CORDIC;
+    }
+
+    const p2_LONG result = y ? CORDIC.Y : CORDIC.X;
+    posted = false;
+    updateC(result >> 31);
+    updateZ(0 == result);
+    updateD(result);
+}
+
 /**
  * @brief Push value %val to the 8 level stack
  * @param val value to push
@@ -333,20 +529,78 @@ p2_LONG P2Cog::popPTRB()
 void P2Cog::augmentS(bool f)
 {
     if (f) {
-        if (S_aug.isValid()) {
-            S = S_aug.toUInt() | IR.op7.src;
-            S_aug.clear();
+        if (VALID & VALID_S_aug) {
+            S = S_aug | IR.op7.src;
+            VALID &= ~VALID_S_aug;
         } else {
             S = IR.op7.src;
         }
     }
-    if (S_next.isValid()) {
+    if (VALID & VALID_S_next) {
         // set S to next_S
-        S = S_next.toUInt();
-        S_next.clear();
+        S = S_next;
+        VALID &= ~VALID_S_next;
     }
 }
 
+/**
+ * @brief Augment S and return the branch address S**
+ *
+ * An immediate #S is a signed offset in instructions relative to the
+ * PC; ##S and a register S are an absolute address.
+ *
+ * @return branch address
+ */
+p2_LONG P2Cog::branchS()
+{
+    const bool relative = IR.op7.im && !(VALID & (VALID_S_aug | VALID_S_next));
+    augmentS(IR.op7.im);
+    if (!relative)
+        return addr2pc(S);
+    return (PC + 4 * SXn<p2_LONG,9>(S)) & A20MASK;
+}
+
+/**
+ * @brief Return the branch address #A of a JMP, CALL, CALLx, or LOC
+ *
+ * With R set A is a signed offset in bytes relative to the PC, else it
+ * is an absolute address.
+ *
+ * @return branch address
+ */
+p2_LONG P2Cog::branchA() const
+{
+    if (IR.op5.rel)
+        return (PC + IR.op5.address) & A20MASK;
+    return addr2pc(IR.op5.address);
+}
+
+/**
+ * @brief Return the PC for an address as used by a program
+ *
+ * Programs address the COG and LUT registers as $00000 … $003FF, and
+ * HUB bytes from $00400 on. The PC counts bytes, also in COG ($00000 …
+ * $007FF) and LUT ($00800 … $00FFF).
+ *
+ * @param addr branch address, return address, or PC[19:0] of a stack value
+ * @return PC
+ */
+p2_LONG P2Cog::addr2pc(p2_LONG addr)
+{
+    addr &= A20MASK;
+    return addr < 0x400 ? addr * sz_LONG : addr;
+}
+
+/**
+ * @brief Return the address as used by a program for a PC
+ * @param pc PC
+ * @return address, e.g. to push as the return address
+ */
+p2_LONG P2Cog::pc2addr(p2_LONG pc)
+{
+    return pc < HUB_ADDR0 ? pc / sz_LONG : pc;
+}
+
 /**
  * @brief Augment #D or use #D, if the flag bit is set
  * @param f true if immediate mode
@@ -354,9 +608,9 @@ void P2Cog::augmentS(bool f)
 void P2Cog::augmentD(bool f)
 {
     if (f) {
-        if (D_aug.isValid()) {
-            D = D_aug.toUInt() | IR.op7.dst;
-            D_aug.clear();
+        if (VALID & VALID_D_aug) {
+            D = D_aug | IR.op7.dst;
+            VALID &= ~VALID_D_aug;
         } else {
             D = IR.op7.dst;
         }
@@ -403,24 +657,58 @@ void P2Cog::updatePTRB(p2_LONG d)
     COG.REG.PTRB = d;
 }
 
+/**
+ * @brief Return the mask of the pins addressed by D
+ * Pins D[5:0] … D[5:0]+D[10:6] wrap around inside their 32 pin port.
+ * @param pin pin number in D[5:0], number of additional pins in D[10:6]
+ * @return bit mask for DIRA/OUTA resp. DIRB/OUTB
+ */
+p2_LONG P2Cog::pin_mask(p2_LONG pin)
+{
+    const p2_LONG count = (pin >> 6) & 31;
+    const p2_LONG mask = count == 31 ? 0xffffffffu : (2u << count) - 1;
+    const p2_LONG shift = pin & 31;
+    return shift ? (mask << shift) | (mask >> (32 - shift)) : mask;
+}
+
+/**
+ * @brief Update the DIR or OUT bits of a range of pins
+ * @param offs register offset (offs_DIRA … offs_OUTB)
+ * @param mask mask of the pins to update
+ * @param val new values for the pins in mask
+ */
+void P2Cog::updatePins(p2_LONG offs, p2_LONG mask, p2_LONG val)
+{
+    const p2_LONG port = (offs & 1) ? 32 : 0;
+    wr_cog(offs, (COG.RAM[offs] & ~mask) | (val & mask));
+    for (p2_LONG bit = 0; bit < 32; bit++) {
+        if (!(mask & (1u << bit)))
+            continue;
+        if (offs == offs_DIRA || offs == offs_DIRB)
+            HUB->wr_DIR(port + bit, (val >> bit) & 1);
+        else
+            HUB->wr_OUT(port + bit, (val >> bit) & 1);
+    }
+}
+
 /**
  * @brief Update DIR bit
- * @param pin pin number to set direction for
+ * @param pin pin number to set direction for, and the pin range in D[10:6]
  * @param io direction input (true), or output (false)
  */
 void P2Cog::updateDIR(p2_LONG pin, bool io)
 {
-    HUB->wr_DIR(pin, static_cast<p2_LONG>(io) & 1);
+    updatePins((pin & 32) ? offs_DIRB : offs_DIRA, pin_mask(pin), io ? 0xffffffffu : 0);
 }
 
 /**
  * @brief Update OUT bit
- * @param pin pin number to set output for
+ * @param pin pin number to set output for, and the pin range in D[10:6]
  * @param io output value hi (true), or low (false)
  */
 void P2Cog::updateOUT(p2_LONG pin, bool io)
 {
-    HUB->wr_OUT(pin, static_cast<p2_LONG>(io) & 1);
+    updatePins((pin & 32) ? offs_OUTB : offs_OUTA, pin_mask(pin), io ? 0xffffffffu : 0);
 }
 
 /**
@@ -433,9 +721,10 @@ void P2Cog::updateREP(p2_LONG instr, p2_LONG times)
     REP_times = times;
     REP_offset = 0;
     if (!instr) {
-        REP_instr.clear();
+        VALID &= ~VALID_REP_instr;
     } else {
         REP_instr = instr;
+        VALID |= VALID_REP_instr;
     }
 }
 
@@ -495,17 +784,184 @@ bool P2Cog::conditional(unsigned cond)
 
 /**
  * @brief Return the current FIFO level
- * @return FIFO level 0 … 15
+ * @return FIFO level in longs 0 … 16
  */
 p2_LONG P2Cog::fifo_level()
 {
-    return (FIFO.windex - FIFO.rindex) & 15;
+    return (FIFO.windex - FIFO.rindex) / 4;
+}
+
+/**
+ * @brief Start the FIFO reading from (RDFAST) or writing to (WRFAST) the HUB
+ * @param mode p2_FIFO_READ or p2_FIFO_WRITE
+ * @param blocks block size in 64-byte units (0 = max)
+ * @param addr block start address
+ */
+void P2Cog::fifo_start(p2_LONG mode, p2_LONG blocks, p2_LONG addr)
+{
+    fifo_block(blocks, addr);
+    FIFO.mode = mode;
+    FIFO.rindex = 0;
+    FIFO.windex = 0;
+    FIFO.head_addr = FIFO.next_addr;
+    FIFO.head_left = FIFO.next_size;
+    FIFO.tail_addr = FIFO.next_addr;
+    FIFO.tail_left = FIFO.next_size;
+    FIFO.wrap_left = 0;
+}
+
+/**
+ * @brief Set the block at which the FIFO continues when its block wraps (FBLOCK)
+ * @param blocks block size in 64-byte units (0 = max)
+ * @param addr block start address
+ */
+void P2Cog::fifo_block(p2_LONG blocks, p2_LONG addr)
+{
+    blocks &= 0x3fff;
+    FIFO.next_addr = addr & A20MASK;
+    FIFO.next_size = (blocks ? blocks : 0x4000) * FIFO_BLOCK;
+}
+
+/**
+ * @brief Continue the FIFO tail at the next block and set the FBW event flag
+ *
+ * The head follows when it reaches the end of its block.
+ */
+void P2Cog::fifo_wrap()
+{
+    FIFO.tail_addr = FIFO.next_addr;
+    FIFO.tail_left = FIFO.next_size;
+    FIFO.wrap_addr = FIFO.tail_addr;
+    FIFO.wrap_left = FIFO.tail_left;
+    FLAGS.f_FBW = true;
+}
+
+/**
+ * @brief Fill the FIFO buffer from the HUB
+ *
+ * Instead of fetching one long per HUB slot, the free space is copied
+ * at once, in pieces split only at the end of the buffer and of the
+ * tail's block. The hardware fetches ahead, too, so programs can not
+ * depend on when exactly a long is fetched.
+ */
+void P2Cog::fifo_fill()
+{
+    p2_LONG level = FIFO.windex - FIFO.rindex;
+    while (level < FIFO_BLOCK) {
+        if (0 == FIFO.tail_left)
+            fifo_wrap();
+        const p2_LONG offs = FIFO.windex % FIFO_BLOCK;
+        const p2_LONG size = qMin(qMin(FIFO_BLOCK - level, FIFO_BLOCK - offs), FIFO.tail_left);
+        HUB->rd_block(FIFO.tail_addr, FIFO.bytes + offs, size);
+        FIFO.tail_addr = (FIFO.tail_addr + size) & A20MASK;
+        FIFO.tail_left -= size;
+        FIFO.windex += size;
+        level += size;
+    }
+}
+
+/**
+ * @brief Advance the FIFO head by %n bytes
+ * @param n number of bytes
+ */
+void P2Cog::fifo_advance(p2_LONG n)
+{
+    while (n > 0) {
+        const p2_LONG size = qMin(n, FIFO.head_left);
+        FIFO.head_addr = (FIFO.head_addr + size) & A20MASK;
+        FIFO.head_left -= size;
+        n -= size;
+        if (0 == FIFO.head_left) {
+            // the head's block is exhausted: continue where the tail went
+            if (0 == FIFO.wrap_left)
+                fifo_wrap();
+            FIFO.head_addr = FIFO.wrap_addr;
+            FIFO.head_left = FIFO.wrap_left;
+            FIFO.wrap_left = 0;
+        }
+    }
+}
+
+/**
+ * @brief Read %n bytes from the FIFO (RFBYTE/RFWORD/RFLONG)
+ * @param n number of bytes (1, 2, or 4)
+ * @return zero extended value
+ */
+p2_LONG P2Cog::fifo_read(p2_LONG n)
+{
+    if (FIFO.mode != p2_FIFO_READ)
+        return 0;
+
+    if (FIFO.windex - FIFO.rindex < n)
+        fifo_fill();
+
+    p2_LONG result = 0;
+    for (p2_LONG i = 0; i < n; i++, FIFO.rindex++)
+        result |= static_cast<p2_LONG>(FIFO.bytes[FIFO.rindex % FIFO_BLOCK]) << (8 * i);
+    fifo_advance(n);
+    return result;
+}
+
+/**
+ * @brief Read a 1 … 4-byte variable length value from the FIFO (RFVAR/RFVARS)
+ *
+ * Bit #7 of the first three bytes is set if another byte follows, which
+ * supplies the next 7 bits, or all 8 bits if it is the fourth byte.
+ *
+ * @param sign true to sign extend the value
+ * @return zero or sign extended value
+ */
+p2_LONG P2Cog::fifo_read_var(bool sign)
+{
+    p2_LONG result = 0;
+    p2_LONG bits = 0;
+    for (;;) {
+        const p2_LONG val = fifo_read(1);
+        if (bits == 21) {
+            result |= val << bits;
+            bits += 8;
+            break;
+        }
+        result |= (val & 0x7f) << bits;
+        bits += 7;
+        if (!(val & 0x80))
+            break;
+    }
+    if (sign)
+        result = static_cast<p2_LONG>(static_cast<qint32>(result << (32 - bits)) >> (32 - bits));
+    return result;
+}
+
+/**
+ * @brief Write %n bytes of %val to the FIFO (WFBYTE/WFWORD/WFLONG)
+ *
+ * The data is written through to the HUB at once, so other COGs can
+ * read it after the next instruction, as they can do on the hardware.
+ *
+ * @param val value to write
+ * @param n number of bytes (1, 2, or 4)
+ */
+void P2Cog::fifo_write(p2_LONG val, p2_LONG n)
+{
+    if (FIFO.mode != p2_FIFO_WRITE)
+        return;
+
+    p2_BYTE data[sz_LONG];
+    for (p2_LONG i = 0; i < n; i++)
+        data[i] = static_cast<p2_BYTE>(val >> (8 * i));
+
+    for (p2_LONG done = 0; done < n; ) {
+        const p2_LONG size = qMin(n - done, FIFO.head_left);
+        HUB->wr_block(FIFO.head_addr, data + done, size);
+        fifo_advance(size);
+        done += size;
+    }
 }
 
 void P2Cog::check_interrupt_flags()
 {
 
-    p2_LONG count = U32L(HUB->count());
+    p2_LONG count = U32L(CNT);
 
     // Update counter flags
     if (count == CT1)
@@ -515,6 +971,10 @@ void P2Cog::check_interrupt_flags()
     if (count == CT3)
         FLAGS.f_CT3 = true;
 
+    // Finish streamer commands and update the XMT, XFI, XRO, and XRL flags
+    if (STREAMER.left && CNT >= STREAMER.end)
+        streamer_update(CNT);
+
     // Update pattern match/mismatch flag
     switch (PAT.mode) {
     case p2_PAT_PA_EQ: // (PA & mask) == match
@@ -568,6 +1028,10 @@ void P2Cog::check_interrupt_flags()
         }
     }
 
+    // Update SE1 … SE4 smart pin event flags
+    if (se_armed())
+        update_se();
+
     // Update RDLONG state
     if (RDL_mask & RDL_flags1) {
         INT.flags.RDL_active = true;
@@ -603,318 +1067,1295 @@ void P2Cog::check_interrupt_flags()
 }
 
 /**
- * @brief Check and update the interrupt state
+ * @brief Clear a CTx event flag
+ * @param event event number (1 … 3)
  */
-void P2Cog::check_wait_int_state()
+void P2Cog::clear_ct(p2_LONG event)
 {
-    // Check if interrupts disabled or INT1 active
-    if (INT.flags.disabled || INT.flags.INT1_active)
-        return;
-
-    // Check INT1
-    if (INT.flags.INT1_source) {
-        p2_LONG bitmask = 1u << INT.flags.INT1_source;
-        if (INT.bits & bitmask) {
-            INT.flags.disabled = true;
-            return;
-        }
+    switch (event) {
+    case 1:
+        FLAGS.f_CT1 = false;
+        break;
+    case 2:
+        FLAGS.f_CT2 = false;
+        break;
+    case 3:
+        FLAGS.f_CT3 = false;
+        break;
     }
+}
 
-    // Check if interrupts disabled or INT1 or INT2 active
-    if (INT.flags.disabled || INT.flags.INT1_active || INT.flags.INT2_active)
+/**
+ * @brief Wait for a CTx event flag, then clear it
+ *
+ * If the flag is not yet set, the COG sleeps until CNT reaches %ct.
+ * A SETQ timeout is not supported, so C and Z are always cleared.
+ *
+ * @param event event number (1 … 3)
+ * @param ct value of CTx
+ * @param flag current state of the event flag
+ */
+void P2Cog::wait_ct(p2_LONG event, p2_LONG ct, bool flag)
+{
+    updateC(false);
+    updateZ(false);
+    if (flag) {
+        clear_ct(event);
         return;
-
-    // Check INT2
-    if (INT.flags.INT2_source) {
-        p2_LONG bitmask = 1u << INT.flags.INT2_source;
-        if (INT.bits & bitmask) {
-            INT.flags.disabled = true;
-            return;
-        }
     }
+    // check_interrupt_flags() sets the flag in the cycle where CNT == ct,
+    // which is the last cycle of the wait
+    WAIT.flag = ct - U32L(CNT);
+    WAIT.mode = p2_WAIT_FLAG;
+    WAIT.event = event;
+}
 
-    // Check if interrupts disabled or INT1 or INT2 or INT3 active
-    if (INT.flags.disabled || INT.flags.INT1_active || INT.flags.INT2_active || INT.flags.INT3_active)
-        return;
+/**
+ * @brief Return true, if any of the SE1 … SE4 events is configured
+ * @return true if armed
+ */
+bool P2Cog::se_armed() const
+{
+    return ((SE.cfg[0] | SE.cfg[1] | SE.cfg[2] | SE.cfg[3]) & 0x1c0) != 0;
+}
 
-    // Check INT3
-    if (INT.flags.INT3_source) {
-        p2_LONG bitmask = 1u << INT.flags.INT3_source;
-        if (INT.bits & bitmask) {
-            INT.flags.disabled = true;
-            return;
-        }
+/**
+ * @brief Return a SEx event flag
+ * @param event event number (1 … 4)
+ * @return true if set
+ */
+bool P2Cog::se_flag(p2_LONG event) const
+{
+    switch (event) {
+    case 1:
+        return FLAGS.f_SE1;
+    case 2:
+        return FLAGS.f_SE2;
+    case 3:
+        return FLAGS.f_SE3;
+    case 4:
+        return FLAGS.f_SE4;
     }
+    return false;
 }
 
 /**
- * @brief Check and update the WAIT flags
- * @param IR instruction register
- * @param value1 1st value (D)
- * @param value2 2nd value (S)
- * @param streamflag true, if streaming is active
- * @return
+ * @brief Set or clear a SEx event flag
+ * @param event event number (1 … 4)
+ * @param flag new state of the flag
  */
-p2_LONG P2Cog::check_wait_flag(p2_opcode_u IR, p2_LONG value1, p2_LONG value2, bool streamflag)
+void P2Cog::set_se_flag(p2_LONG event, bool flag)
 {
-    p2_LONG hubcycles;
-    const p2_INSTX1_e inst1 = static_cast<p2_INSTX1_e>(IR.opcode & p2_INSTR_MASK1);
-    const p2_INSTX2_e inst2 = static_cast<p2_INSTX2_e>(IR.opcode & p2_INSTR_MASK2);
-    const p2_OPCODE_e opcode = static_cast<p2_OPCODE_e>(IR.op7.inst);
+    switch (event) {
+    case 1:
+        FLAGS.f_SE1 = flag;
+        break;
+    case 2:
+        FLAGS.f_SE2 = flag;
+        break;
+    case 3:
+        FLAGS.f_SE3 = flag;
+        break;
+    case 4:
+        FLAGS.f_SE4 = flag;
+        break;
+    }
+}
 
-    if (WAIT.flag) {
-        switch (WAIT.mode) {
-        case p2_WAIT_CACHE:
-            Q_ASSERT(false && "We should not be here!");
+/**
+ * @brief Update the SE1 … SE4 event flags from the IN bits of their pins
+ *
+ * The configuration D[8:6] is %001 for IN rising, %010 for IN falling,
+ * %011 for IN changing, %10x for IN low, and %11x for IN high, of the
+ * pin D[5:0].
+ */
+void P2Cog::update_se()
+{
+    for (p2_LONG n = 0; n < 4; n++) {
+        const p2_LONG cfg = SE.cfg[n];
+        const p2_LONG mode = (cfg >> 6) & 7;
+        if (!mode)
+            continue;
+        const p2_LONG bit = 1u << n;
+        const bool in = HUB->rd_PIN(cfg);
+        const bool prev = (SE.prev & bit) != 0;
+        bool event = false;
+        switch (mode) {
+        case 1:
+            event = in && !prev;
             break;
-
-        case p2_WAIT_CORDIC:
-            switch (inst1) {
-            case p2_INSTR_GETQX:
-                if (QX_posted)
-                    WAIT.flag = 0;
-                break;
-            case p2_INSTR_GETQY:
-                if (QY_posted)
-                    WAIT.flag = 0;
-                break;
-            default:
-                Q_ASSERT(false && "We should not be here!");
-            }
-            if (0 == WAIT.flag)
-                WAIT.mode = p2_WAIT_NONE;
-            return WAIT.flag;
-
-        case p2_WAIT_FLAG:
+        case 2:
+            event = !in && prev;
+            break;
+        case 3:
+            event = in != prev;
+            break;
+        case 4: case 5:
+            event = !in;
             break;
-
         default:
-            WAIT.flag--;
-            if (0 == WAIT.flag) {
-                if (WAIT.mode == p2_WAIT_HUB && streamflag)
-                    WAIT.flag = 16;
-                else {
-                    WAIT.mode = p2_WAIT_NONE;
-                }
-            }
-            return WAIT.flag;
+            event = in;
         }
+        SE.prev = in ? SE.prev | bit : SE.prev & ~bit;
+        if (event)
+            set_se_flag(n + 1, true);
     }
+}
 
-    if (RW_repeat) {
-        if (!streamflag)
-            return 0;
-        WAIT.flag = 16;
-        WAIT.mode = p2_WAIT_HUB;
-        return WAIT.flag;
+/**
+ * @brief Configure a SEx event, and clear its flag
+ * @param event event number (1 … 4)
+ * @param cfg configuration D[8:0]
+ */
+void P2Cog::setse(p2_LONG event, p2_LONG cfg)
+{
+    const p2_LONG bit = 1u << (event - 1);
+    SE.cfg[event - 1] = cfg & 0x1ff;
+    SE.prev = HUB->rd_PIN(cfg) ? SE.prev | bit : SE.prev & ~bit;
+    set_se_flag(event, false);
+}
+
+/**
+ * @brief Get a SEx event flag into C/Z, then clear it
+ * @param event event number (1 … 4)
+ */
+void P2Cog::pollse(p2_LONG event)
+{
+    const bool flag = se_flag(event);
+    updateC(flag);
+    updateZ(flag);
+    set_se_flag(event, false);
+}
+
+/**
+ * @brief Wait for a SEx event flag, then clear it
+ *
+ * The COG waits until check_interrupt_flags() sets the flag.
+ * A SETQ timeout is not supported, so C and Z are always cleared.
+ *
+ * @param event event number (1 … 4)
+ */
+void P2Cog::waitse(p2_LONG event)
+{
+    updateC(false);
+    updateZ(false);
+    if (se_flag(event)) {
+        set_se_flag(event, false);
+        return;
     }
+    WAIT.flag = 1;
+    WAIT.mode = p2_WAIT_PIN;
+    WAIT.event = event;
+}
 
-    if (0 == HUB->hubslots())
-        hubcycles = 0;
-    else
-        hubcycles = ((ID + (value2 >> 2)) - HUB->cogindex()) & 15u;
+//! cycle of the final NCO rollover while the NCO frequency is 0
+static constexpr p2_QUAD NCO_NEVER = ~Q_UINT64_C(0);
 
-    if (p2_INSTR_GETQX == inst1) {
+/**
+ * @brief Return the NCO phase increment per cycle
+ *
+ * The NCO rolls over when its bit 31 is set, so it rolls over at most
+ * once per cycle.
+ *
+ * @param freq NCO frequency (SETXFRQ)
+ * @return increment
+ */
+static inline p2_QUAD nco_step(p2_LONG freq)
+{
+    return qMin<p2_QUAD>(freq, Q_UINT64_C(0x80000000));
+}
 
-        if (!QX_posted && CORDIC_count > 0) {
-            WAIT.flag = 1;
-            WAIT.mode = p2_WAIT_CORDIC;
+/**
+ * @brief Return a streamer event flag
+ * @param event event number: 1 = XMT, 2 = XFI, 3 = XRO, 4 = XRL
+ * @return true if set
+ */
+bool P2Cog::streamer_flag(p2_LONG event) const
+{
+    switch (event) {
+    case 1:
+        return FLAGS.f_XMT;
+    case 2:
+        return FLAGS.f_XFI;
+    case 3:
+        return FLAGS.f_XRO;
+    case 4:
+        return FLAGS.f_XRL;
+    }
+    return false;
+}
+
+/**
+ * @brief Set or clear a streamer event flag
+ * @param event event number: 1 = XMT, 2 = XFI, 3 = XRO, 4 = XRL
+ * @param flag new state of the flag
+ */
+void P2Cog::set_streamer_flag(p2_LONG event, bool flag)
+{
+    switch (event) {
+    case 1:
+        FLAGS.f_XMT = flag;
+        break;
+    case 2:
+        FLAGS.f_XFI = flag;
+        break;
+    case 3:
+        FLAGS.f_XRO = flag;
+        break;
+    case 4:
+        FLAGS.f_XRL = flag;
+        break;
+    }
+}
+
+/**
+ * @brief Make a streamer command the active one
+ * @param cnt cycle at which the command is issued
+ * @param cmd command D; D[15:0] is the number of NCO rollovers, 0 for 65536
+ * @param data command S
+ * @param phase initial NCO phase
+ */
+void P2Cog::streamer_start(p2_QUAD cnt, p2_LONG cmd, p2_LONG data, p2_LONG phase)
+{
+    const p2_QUAD step = nco_step(STREAMER.freq);
+    STREAMER.cmd = cmd;
+    STREAMER.data = data;
+    STREAMER.left = (cmd & 0xffff) ? (cmd & 0xffff) : 0x10000;
+    STREAMER.phase = phase;
+    STREAMER.start = cnt;
+    STREAMER.end = step ? cnt + ((static_cast<p2_QUAD>(STREAMER.left) << 31) - phase + step - 1) / step
+                        : NCO_NEVER;
+}
+
+/**
+ * @brief Stop the streamer immediately
+ *
+ * The data of the NCO rollovers the active command has done so far is
+ * output, and the buffered command is dropped.
+ */
+void P2Cog::streamer_stop()
+{
+    if (STREAMER.left) {
+        const p2_QUAD step = nco_step(STREAMER.freq);
+        const p2_QUAD elapsed = CNT > STREAMER.start ? CNT - STREAMER.start : 0;
+        const p2_QUAD acc = STREAMER.phase + elapsed * step;
+        const p2_LONG total = (STREAMER.cmd & 0xffff) ? (STREAMER.cmd & 0xffff) : 0x10000;
+        const p2_LONG done = total - STREAMER.left + static_cast<p2_LONG>(acc >> 31);
+        if (done)
+            streamer_output(done);
+        STREAMER.phase = static_cast<p2_LONG>(acc & 0x7fffffff);
+        STREAMER.start = CNT;
+        STREAMER.left = 0;
+    }
+    STREAMER.next = 0;
+}
+
+/**
+ * @brief Finish the streamer commands whose final NCO rollover is due at cycle %cnt
+ *
+ * The buffered command becomes the active one, continuing or zeroing
+ * the phase. XRO is set on each final rollover, XFI when the buffered
+ * command is issued, and XMT when there is none.
+ *
+ * @param cnt cycle counter value
+ */
+void P2Cog::streamer_update(p2_QUAD cnt)
+{
+    while (STREAMER.left && STREAMER.end <= cnt) {
+        const p2_QUAD end = STREAMER.end;
+        const p2_QUAD acc = STREAMER.phase + (end - STREAMER.start) * nco_step(STREAMER.freq);
+        const p2_LONG phase = static_cast<p2_LONG>(acc - (static_cast<p2_QUAD>(STREAMER.left) << 31));
+        streamer_output((STREAMER.cmd & 0xffff) ? (STREAMER.cmd & 0xffff) : 0x10000);
+        FLAGS.f_XRO = true;
+        if (STREAMER.next) {
+            streamer_start(end, STREAMER.next_cmd, STREAMER.next_data, 2 == STREAMER.next ? 0 : phase);
+            STREAMER.next = 0;
+            FLAGS.f_XFI = true;
+        } else {
+            STREAMER.left = 0;
+            STREAMER.phase = phase;
+            STREAMER.start = end;
+            FLAGS.f_XMT = true;
         }
+    }
+}
 
-    } else if (p2_INSTR_GETQY == inst1) {
+/**
+ * @brief Output the data of the active streamer command
+ *
+ * The RFxxx modes read their data from the FIFO, and the LUT modes look
+ * it up in the LUT. The result goes to the video capture, if any. In
+ * the immediate 32 bit mode a value with the sync bit set, bit 1 with
+ * the colorspace converter in composite mode and bit 0 otherwise, is
+ * output as horizontal sync. Modes which are not emulated output black.
+ *
+ * @param count number of NCO rollovers
+ */
+void P2Cog::streamer_output(p2_LONG count)
+{
+    const p2_LONG mode = STREAMER.cmd >> 28;
+    p2_LONG buff[256];
+    p2_LONG n = 0;
+
+    auto flush = [&]() {
+        if (VIDEO && n)
+            VIDEO->pixels(buff, n);
+        n = 0;
+    };
+    auto lookup = [&](p2_LONG index) {
+        if (0x1ff == index)
+            FLAGS.f_XRL = true;
+        buff[n++] = LUT.RAM[index];
+        if (n == 256)
+            flush();
+    };
+
+    switch (mode) {
+    case p2_XMODE_RFBYTE_RGB8:
+        for (p2_LONG i = 0; i < count; i++) {
+            const p2_LONG b = fifo_read(1);
+            const p2_LONG r = ((b >> 5) & 7) * 0x49 >> 1;
+            const p2_LONG g = ((b >> 2) & 7) * 0x49 >> 1;
+            const p2_LONG bl = (b & 3) * 0x55;
+            buff[n++] = (r << 24) | (g << 16) | (bl << 8);
+            if (n == 256)
+                flush();
+        }
+        break;
 
-        if (!QY_posted && CORDIC_count > 0) {
-            WAIT.flag = 1;
-            WAIT.mode = p2_WAIT_CORDIC;
+    case p2_XMODE_RFWORD_RGB16:
+        for (p2_LONG i = 0; i < count; i++) {
+            const p2_LONG w = fifo_read(2);
+            const p2_LONG r = (w >> 11) & 0x1f;
+            const p2_LONG g = (w >> 5) & 0x3f;
+            const p2_LONG b = w & 0x1f;
+            buff[n++] = (((r << 3) | (r >> 2)) << 24) | (((g << 2) | (g >> 4)) << 16) | (((b << 3) | (b >> 2)) << 8);
+            if (n == 256)
+                flush();
         }
+        break;
 
-    } else if (p2_INSTR_WAITXXX == inst2) {
+    case p2_XMODE_RFLONG_RGB24:
+        for (p2_LONG i = 0; i < count; i++) {
+            buff[n++] = fifo_read(4);
+            if (n == 256)
+                flush();
+        }
+        break;
 
-        if (0x02024 == (IR.opcode & 0x3ffff))
-            check_wait_int_state();
+    case p2_XMODE_RFLONG_32X1_LUT:
+    case p2_XMODE_RFLONG_16X2_LUT:
+    case p2_XMODE_RFLONG_8X4_LUT:
+    case p2_XMODE_RFLONG_4X8_LUT:
+        {
+            const p2_LONG bits = 1u << (mode - p2_XMODE_RFLONG_32X1_LUT);
+            const p2_LONG mask = (1u << bits) - 1;
+            p2_LONG data = 0;
+            for (p2_LONG i = 0; i < count; i++) {
+                const p2_LONG shift = (i * bits) & 31;
+                if (!shift)
+                    data = fifo_read(4);
+                lookup((data >> shift) & mask);
+            }
+        }
+        break;
 
-        switch (IR.op7.dst) {
-        case 0x10:
-            WAIT.flag = FLAGS.f_INT ? 0 : 1;
-            WAIT.mode = FLAGS.f_INT ? p2_WAIT_NONE : p2_WAIT_FLAG;
-            break;
-        case 0x11:
-            WAIT.flag = FLAGS.f_CT1 ? 0 : 1;
-            WAIT.mode = FLAGS.f_CT1 ? p2_WAIT_NONE : p2_WAIT_FLAG;
-            break;
-        case 0x12:
-            WAIT.flag = FLAGS.f_CT2 ? 0 : 1;
-            WAIT.mode = FLAGS.f_CT2 ? p2_WAIT_NONE : p2_WAIT_FLAG;
-            break;
-        case 0x13:
-            WAIT.flag = FLAGS.f_CT3 ? 0 : 1;
-            WAIT.mode = FLAGS.f_CT3 ? p2_WAIT_NONE : p2_WAIT_FLAG;
-            break;
-        case 0x14:
-            WAIT.flag = FLAGS.f_SE1 ? 0 : 1;
-            WAIT.mode = FLAGS.f_SE1 ? p2_WAIT_NONE : p2_WAIT_FLAG;
-            break;
-        case 0x15:
-            WAIT.flag = FLAGS.f_SE2 ? 0 : 1;
-            WAIT.mode = FLAGS.f_SE2 ? p2_WAIT_NONE : p2_WAIT_FLAG;
-            break;
-        case 0x16:
-            WAIT.flag = FLAGS.f_SE3 ? 0 : 1;
-            WAIT.mode = FLAGS.f_SE3 ? p2_WAIT_NONE : p2_WAIT_FLAG;
-            break;
-        case 0x17:
-            WAIT.flag = FLAGS.f_SE4 ? 0 : 1;
-            WAIT.mode = FLAGS.f_SE4 ? p2_WAIT_NONE : p2_WAIT_FLAG;
-            break;
-        case 0x18:
-            WAIT.flag = FLAGS.f_PAT ? 0 : 1;
-            WAIT.mode = FLAGS.f_PAT ? p2_WAIT_NONE : p2_WAIT_FLAG;
-            break;
-        case 0x19:
-            WAIT.flag = FLAGS.f_FBW ? 0 : 1;
-            WAIT.mode = FLAGS.f_FBW ? p2_WAIT_NONE : p2_WAIT_FLAG;
-            break;
-        case 0x1a:
-            WAIT.flag = FLAGS.f_XMT ? 0 : 1;
-            WAIT.mode = FLAGS.f_XMT ? p2_WAIT_NONE : p2_WAIT_FLAG;
-            break;
-        case 0x1b:
-            WAIT.flag = FLAGS.f_XFI ? 0 : 1;
-            WAIT.mode = FLAGS.f_XFI ? p2_WAIT_NONE : p2_WAIT_FLAG;
-            break;
-        case 0x1c:
-            WAIT.flag = FLAGS.f_XRO ? 0 : 1;
-            WAIT.mode = FLAGS.f_XRO ? p2_WAIT_NONE : p2_WAIT_FLAG;
-            break;
-        case 0x1d:
-            WAIT.flag = FLAGS.f_XRL ? 0 : 1;
-            WAIT.mode = FLAGS.f_XRL ? p2_WAIT_NONE : p2_WAIT_FLAG;
-            break;
-        case 0x1e:
-            WAIT.flag = FLAGS.f_ATN ? 0 : 1;
-            WAIT.mode = FLAGS.f_ATN ? p2_WAIT_NONE : p2_WAIT_FLAG;
-            break;
+    case p2_XMODE_IMM_32X1_LUT:
+    case p2_XMODE_IMM_16X2_LUT:
+    case p2_XMODE_IMM_8X4_LUT:
+    case p2_XMODE_IMM_4X8_LUT:
+        {
+            const p2_LONG bits = 1u << (mode - p2_XMODE_IMM_32X1_LUT);
+            const p2_LONG mask = (1u << bits) - 1;
+            for (p2_LONG i = 0; i < count; i++)
+                lookup((STREAMER.data >> ((i * bits) & 31)) & mask);
         }
-    } else if (p2_INSTR_WAITX == inst1) {
+        break;
 
-        WAIT.flag = value1;
-        WAIT.mode = p2_WAIT_CNT;
+    case p2_XMODE_IMM_1X32:
+        if (VIDEO) {
+            const p2_LONG sync = (STREAMER.cmod & 0x40) ? 2 : 1;
+            if (STREAMER.data & sync) {
+                const int pin = VIDEO->vsync_pin();
+                VIDEO->hsync(count, pin >= 0 && HUB->rd_OUT(static_cast<p2_LONG>(pin) & 63));
+            } else {
+                VIDEO->fill(STREAMER.data, count);
+            }
+        }
+        break;
 
-    } else if (opcode >= p2_OPCODE_RDBYTE && opcode <= p2_OPCODE_RDLONG) {
+    default:
+        if (VIDEO)
+            VIDEO->fill(0, count);
+    }
+    flush();
+}
 
-        HUBOP = 1;
-        WAIT.flag = hubcycles + 2;
-        WAIT.mode = p2_WAIT_HUB;
+/**
+ * @brief Buffer a streamer command (XZERO/XCONT)
+ *
+ * An idle streamer issues the command at once. If a command is buffered
+ * already, the COG waits for the final NCO rollover of the active one,
+ * when the buffered command is issued and the new one takes its place.
+ *
+ * @param cmd command D
+ * @param data command S
+ * @param zero true to zero the phase (XZERO), false to continue it (XCONT)
+ */
+void P2Cog::streamer_issue(p2_LONG cmd, p2_LONG data, bool zero)
+{
+    if (!STREAMER.left) {
+        streamer_start(CNT, cmd, data, zero ? 0 : STREAMER.phase);
+        FLAGS.f_XFI = true;
+        return;
+    }
+    if (STREAMER.next) {
+        const p2_QUAD end = STREAMER.end;
+        streamer_update(end);
+        WAIT.flag = NCO_NEVER == end ? ~0u : static_cast<p2_LONG>(end - CNT);
+        WAIT.mode = p2_WAIT_STREAMER;
+        WAIT.event = 0;
+    }
+    STREAMER.next = zero ? 2 : 1;
+    STREAMER.next_cmd = cmd;
+    STREAMER.next_data = data;
+}
 
-    } else if ((opcode == p2_OPCODE_WRBYTE) ||
-               (opcode == p2_OPCODE_WRLONG && IR.op7.wc) ||
-               (opcode == p2_OPCODE_WMLONG && IR.op7.wc && IR.op7.wz)) {
+/**
+ * @brief Set the streamer NCO frequency (SETXFRQ)
+ *
+ * The final rollover of the active command is timed again from the
+ * current phase.
+ *
+ * @param freq new frequency
+ */
+void P2Cog::streamer_frequency(p2_LONG freq)
+{
+    if (!STREAMER.left) {
+        STREAMER.freq = freq;
+        return;
+    }
+    const p2_QUAD elapsed = CNT > STREAMER.start ? CNT - STREAMER.start : 0;
+    const p2_QUAD acc = STREAMER.phase + elapsed * nco_step(STREAMER.freq);
+    const p2_QUAD step = nco_step(freq);
+    STREAMER.freq = freq;
+    STREAMER.left -= static_cast<p2_LONG>(acc >> 31);
+    STREAMER.phase = static_cast<p2_LONG>(acc & 0x7fffffff);
+    STREAMER.start = qMax(CNT, STREAMER.start);
+    STREAMER.end = step ? STREAMER.start + ((static_cast<p2_QUAD>(STREAMER.left) << 31) - STREAMER.phase + step - 1) / step
+                        : NCO_NEVER;
+}
 
-        HUBOP = 1;
-        WAIT.flag = hubcycles + 2;
-        WAIT.mode = p2_WAIT_HUB;
+/**
+ * @brief Wait for a streamer event flag, then clear it
+ *
+ * A SETQ timeout is not supported, so C and Z are always cleared.
+ *
+ * @param event event number: 1 = XMT, 2 = XFI, 3 = XRO, 4 = XRL
+ */
+void P2Cog::streamer_wait(p2_LONG event)
+{
+    updateC(false);
+    updateZ(false);
+    if (streamer_flag(event)) {
+        set_streamer_flag(event, false);
+        return;
+    }
+    WAIT.flag = 1;
+    WAIT.mode = p2_WAIT_STREAMER;
+    WAIT.event = event;
+}
 
-    } else if ((opcode >= p2_OPCODE_QMUL && opcode <= p2_OPCODE_QVECTOR) ||
-               (inst1 == p2_INSTR_QLOG) || (inst1 == p2_INSTR_QEXP))
-    {
+/**
+ * @brief Count down one cycle of WAITX or WAITCTx, or check for the WAITSEx or WAITXxx event
+ */
+void P2Cog::count_wait()
+{
+    if (p2_WAIT_PIN == WAIT.mode) {
+        if (!se_flag(WAIT.event))
+            return;
+        set_se_flag(WAIT.event, false);
+        WAIT.flag = 0;
+        WAIT.mode = p2_WAIT_NONE;
+        return;
+    }
+    if (p2_WAIT_STREAMER == WAIT.mode && WAIT.event) {
+        if (!streamer_flag(WAIT.event))
+            return;
+        set_streamer_flag(WAIT.event, false);
+        WAIT.flag = 0;
+        WAIT.mode = p2_WAIT_NONE;
+        return;
+    }
+    if (--WAIT.flag)
+        return;
+    if (p2_WAIT_FLAG == WAIT.mode)
+        clear_ct(WAIT.event);
+    WAIT.mode = p2_WAIT_NONE;
+}
 
-        HUBOP = 1;
-        WAIT.flag = ((ID - HUB->cogindex()) & 15) + 1;
-        WAIT.mode = p2_WAIT_HUB;
+/**
+ * @brief Return the number of cycles the COG will only spend waiting
+ *
+ * The last cycle of a wait is not included, nor is a wait while pattern,
+ * pin edge, lock edge, or smart pin events are armed, because these read
+ * the state of the HUB in every cycle. A halted COG is idle for ever.
+ *
+ * @return number of cycles which fast_forward() may skip
+ */
+p2_LONG P2Cog::idle() const
+{
+    if (p2_WAIT_HALTED == WAIT.mode)
+        return ~0u;
+    if (!WAIT.flag || PAT.mode != p2_PAT_NONE || (PIN.edge & 0xc0) || (LOCK.edge & 0x30) || se_armed())
+        return 0;
+    if (p2_WAIT_STREAMER == WAIT.mode && WAIT.event) {
+        // XMT, XFI and XRO are set no earlier than the final NCO rollover
+        if (WAIT.event > 3 || !STREAMER.left || STREAMER.end == NCO_NEVER || STREAMER.end <= CNT + 1)
+            return 0;
+        return static_cast<p2_LONG>(qMin<p2_QUAD>(STREAMER.end - CNT - 1, 0xffffffffu));
+    }
+    return WAIT.flag - 1;
+}
+
+/**
+ * @brief Skip cycles of waiting as if gox() and get() were called
+ *
+ * CTx event flags are set if CNT passes CTx in the skipped cycles,
+ * and streamer commands ending in them are finished.
+ *
+ * @param ticks number of cycles; at most idle()
+ */
+void P2Cog::fast_forward(p2_LONG ticks)
+{
+    Q_ASSERT(ticks <= idle());
+    if (p2_WAIT_HALTED == WAIT.mode) {
+        if (STATS)
+            STATS->waits[p2_WAIT_HALTED] += ticks;
+        CNT += ticks;
+        return;
+    }
+    const p2_LONG count = U32L(CNT);
+    if (CT1 - count < ticks)
+        FLAGS.f_CT1 = true;
+    if (CT2 - count < ticks)
+        FLAGS.f_CT2 = true;
+    if (CT3 - count < ticks)
+        FLAGS.f_CT3 = true;
+    if (RDL_mask & RDL_flags1)
+        INT.flags.RDL_active = true;
+    if (WRL_mask & WRL_flags1)
+        INT.flags.WRL_active = true;
+    if (STREAMER.left)
+        streamer_update(CNT + ticks - 1);
+    if (STATS)
+        STATS->waits[WAIT.mode] += ticks;
+    if (p2_WAIT_STREAMER != WAIT.mode || !WAIT.event)
+        WAIT.flag -= ticks;
+    if (PROFILE) {
+        p2_PROFILE_t& counters = PROFILE->counters(IR_PC);
+        counters.cycles += static_cast<p2_QUAD>(ticks);
+        counters.waits += static_cast<p2_QUAD>(ticks);
+    }
+    CNT += ticks;
+}
+
+/**
+ * @brief Start the COG at its PC (COGINIT)
+ *
+ * Ends a halt or wait, and drops a translated block being run, pending
+ * SKIP/SKIPF patterns, augments, and REP blocks of the previous program.
+ */
+void P2Cog::start()
+{
+    WAIT.flag = 0;
+    WAIT.mode = p2_WAIT_NONE;
+    WAIT.event = 0;
+    JIT_ticks = 0;
+    SKIP = 0;
+    SKIPF = 0;
+    VALID = 0;
+    DEC = nullptr;      // the first instruction is fetched in the next cycle
+}
+
+/**
+ * @brief Stop the COG (COGSTOP)
+ *
+ * A halted COG does not fetch or execute instructions until the next
+ * COGINIT, and P2Hub::skip_idle() skips over it.
+ */
+void P2Cog::stop()
+{
+    WAIT.flag = 1;
+    WAIT.mode = p2_WAIT_HALTED;
+    WAIT.event = 0;
+}
+
+/**
+ * @brief Return the size of the COG's state in a snapshot
+ * @return number of bytes written by save_state()
+ */
+p2_LONG P2Cog::state_size()
+{
+    return 0 P2_COG_STATE(P2_STATE_SIZE);
+}
+
+/**
+ * @brief Save the COG's state for a snapshot
+ * @param dst buffer of state_size() bytes
+ */
+void P2Cog::save_state(p2_BYTE* dst) const
+{
+    P2_COG_STATE(P2_STATE_SAVE)
+}
+
+/**
+ * @brief Restore the COG's state from a snapshot
+ *
+ * The predecoded instructions and translated blocks are dropped, since
+ * the memory they were built from has changed.
+ *
+ * @param src buffer of state_size() bytes
+ */
+void P2Cog::restore_state(const p2_BYTE* src)
+{
+    P2_COG_STATE(P2_STATE_LOAD)
+    for (p2_LONG addr = 0; addr < COG_SIZE; addr++)
+        DEC_COG[addr].valid = false;
+    for (p2_LONG addr = 0; addr < LUT_SIZE; addr++)
+        DEC_LUT[addr].valid = false;
+    for (p2_LONG addr = 0; addr < DEC_HUB_SIZE; addr++)
+        DEC_HUB[addr].valid = false;
+    DEC = nullptr;
+    if (JIT)
+        JIT->flush();
+    JIT_verify = 0;
+}
+
+/**
+ * @brief Set the video capture of the streamer output
+ * @param video pointer to P2Video, or nullptr to discard the output
+ */
+void P2Cog::set_video(P2Video* video)
+{
+    VIDEO = video;
+}
+
+/**
+ * @brief Start or stop counting instructions and cycles per PC
+ *
+ * Stopping discards the profile. While profiling, the translator is not used.
+ *
+ * @param on true to start profiling with all counters zero, false to stop
+ */
+void P2Cog::set_profiling(bool on)
+{
+    PROFILE.reset(on ? new P2Profile() : nullptr);
+}
 
-    } else if (inst1 >= p2_INSTR_LOCKNEW && inst1 <= p2_INSTR_LOCKSET) {
+/**
+ * @brief Start or stop counting the instruction mix and wait cycles
+ *
+ * Stopping discards the statistics. While counting, the translator is not used.
+ *
+ * @param on true to start counting with all counters zero, false to stop
+ */
+void P2Cog::set_stats(bool on)
+{
+    STATS.reset(on ? new p2_STATS_t() : nullptr);
+}
 
-        HUBOP = 1;
-        WAIT.flag = ((ID - HUB->cogindex()) & 15) + 1;
+/**
+ * @brief Set the breakpoints whose watchpoints the COG checks
+ *
+ * This is called by P2Hub::arm_breakpoints(). While set, the translator is not used.
+ *
+ * @param breakpoints pointer to the armed breakpoints, or nullptr
+ */
+void P2Cog::set_breakpoints(P2Breakpoints* breakpoints)
+{
+    BREAK = breakpoints;
+}
+
+/**
+ * @brief Return the address the COG fetches its next instruction from
+ *
+ * This is the PC which gox() fetches from in the current cycle, after the
+ * instructions to skip by SKIPF.
+ *
+ * @param pc reference to the address to set
+ * @return true if the COG fetches in this cycle, false if it is waiting
+ */
+bool P2Cog::fetch_pc(p2_LONG& pc) const
+{
+    if (WAIT.flag || JIT_ticks > 0)
+        return false;
+    p2_LONG skip = SKIPF;
+    pc = PC;
+    while (skip & 1) {
+        pc += 4;
+        skip >>= 1;
+    }
+    pc &= A20MASK;
+    return true;
+}
+
+/**
+ * @brief Check and update the interrupt state
+ */
+void P2Cog::check_wait_int_state()
+{
+    // Check if interrupts disabled or INT1 active
+    if (INT.flags.disabled || INT.flags.INT1_active)
+        return;
+
+    // Check INT1
+    if (INT.flags.INT1_source) {
+        p2_LONG bitmask = 1u << INT.flags.INT1_source;
+        if (INT.bits & bitmask) {
+            INT.flags.disabled = true;
+            return;
+        }
+    }
+
+    // Check if interrupts disabled or INT1 or INT2 active
+    if (INT.flags.disabled || INT.flags.INT1_active || INT.flags.INT2_active)
+        return;
+
+    // Check INT2
+    if (INT.flags.INT2_source) {
+        p2_LONG bitmask = 1u << INT.flags.INT2_source;
+        if (INT.bits & bitmask) {
+            INT.flags.disabled = true;
+            return;
+        }
+    }
+
+    // Check if interrupts disabled or INT1 or INT2 or INT3 active
+    if (INT.flags.disabled || INT.flags.INT1_active || INT.flags.INT2_active || INT.flags.INT3_active)
+        return;
+
+    // Check INT3
+    if (INT.flags.INT3_source) {
+        p2_LONG bitmask = 1u << INT.flags.INT3_source;
+        if (INT.bits & bitmask) {
+            INT.flags.disabled = true;
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Compute the hub RAM address from the pointer instruction
+ * @param inst instruction field (1SUPIIIII)
+ * @param size size of instruction (0 = byte, 1 = word, 2 = long)
+ * @return computed 20 bit RAM address
+ */
+p2_LONG P2Cog::get_pointer(p2_LONG inst, p2_LONG size)
+{
+    p2_LONG address = 0;
+    p2_LONG offset = static_cast<p2_LONG>((static_cast<qint32>(inst) << 27) >> (27 - size));
+
+    switch ((inst >> 5) & 7) {
+    case 0: // PTRA[offset]
+        address = COG.REG.PTRA + offset;
+        break;
+    case 1: // PTRA
+        address = COG.REG.PTRA;
+        break;
+    case 2: // PTRA[++offset]
+        address = COG.REG.PTRA + offset;
+        PTRA0 = address;
+        break;
+    case 3: // PTRA[offset++]
+        address = COG.REG.PTRA;
+        PTRA0 = COG.REG.PTRA + offset;
+        break;
+    case 4: // PTRB[offset]
+        address = COG.REG.PTRB + offset;
+        break;
+    case 5: // PTRB
+        address = COG.REG.PTRB;
+        break;
+    case 6: // PTRB[++offset]
+        address = COG.REG.PTRB + offset;
+        PTRB0 = address;
+        break;
+    case 7: // PTRB[offset++]
+        address = COG.REG.PTRB;
+        PTRB0 = COG.REG.PTRB + offset;
+        break;
+    }
+    return address & A20MASK;
+}
+
+/**
+ * @brief Save pointer registers PTRA/PTRB
+ */
+void P2Cog::save_regs()
+{
+    PTRA0 = COG.REG.PTRA;
+    PTRB0 = COG.REG.PTRB;
+}
+
+/**
+ * @brief Update pointer registers PTRA/PTRB
+ */
+void P2Cog::update_regs()
+{
+    COG.REG.PTRA = PTRA0;
+    COG.REG.PTRB = PTRB0;
+}
+
+/**
+ * @brief Compute the hub address of RDxxxx/WRxxxx/WMLONG and update PTRx
+ *
+ * For SETQ/SETQ2 blocks the PTRx index only gives the direction and
+ * an updating PTRx moves by the size of the block.
+ *
+ * @param ptr true if #S is a PTRx expression (1SUPNNNNN)
+ * @param size size of instruction (0 = byte, 1 = word, 2 = long)
+ * @param count number of longs in a SETQ/SETQ2 block, or 0
+ * @return computed 20 bit RAM address
+ */
+p2_LONG P2Cog::hub_address(bool ptr, p2_LONG size, p2_LONG count)
+{
+    if (!ptr)
+        return S & A20MASK;
+
+    save_regs();
+    if (0 == count) {
+        const p2_LONG address = get_pointer(S, size);
+        update_regs();
+        return address;
+    }
+
+    const bool ptrb = (S >> 7) & 1;
+    const bool update = (S >> 6) & 1;
+    const bool pre = (S >> 5) & 1;
+    const p2_LONG delta = ((S >> 4) & 1) ? 0u - count * sz_LONG : count * sz_LONG;
+    p2_LONG& ptrx = ptrb ? PTRB0 : PTRA0;
+    p2_LONG address = ptrx;
+    if (update) {
+        ptrx += delta;
+        if (pre)
+            address = ptrx;
+    }
+    update_regs();
+    return address & A20MASK;
+}
+
+/**
+ * @brief Return the number of longs in a SETQ/SETQ2 block transfer
+ * @return Q + 1 (at most the size of COG/LUT RAM), or 0 without SETQ/SETQ2
+ */
+p2_LONG P2Cog::burst_count() const
+{
+    if (!(VALID & VALID_Q))
+        return 0;
+    return Q < COG_SIZE ? Q + 1 : COG_SIZE;
+}
+
+/**
+ * @brief Wait for a HUB access as the HUB timing demands
+ * @param addr HUB address of the first byte
+ * @param count number of longs of a SETQ burst, or 0 for a single access
+ * @param write true for a write, false for a read
+ */
+void P2Cog::hub_stall(p2_LONG addr, p2_LONG count, bool write)
+{
+    const p2_LONG cycles = HUB->hub_cycles(ID, addr, CNT, count, write);
+    if (cycles) {
+        WAIT.flag = cycles;
         WAIT.mode = p2_WAIT_HUB;
+    }
+}
+
+/**
+ * @brief Record the first watchpoint hit in a SETQ/SETQ2 block of registers
+ * @param kind p2_BREAK_READ for WRLONG/WMLONG, p2_BREAK_WRITE for RDLONG
+ * @param lut true for LUT RAM (SETQ2), false for COG RAM (SETQ)
+ * @param reg first register (wraps at the end of the RAM)
+ * @param count number of longs (1 … 512)
+ */
+void P2Cog::burst_watch(p2_BREAK_e kind, bool lut, p2_LONG reg, p2_LONG count)
+{
+    const p2_BREAK_space_e space = lut ? p2_BREAK_LUT : p2_BREAK_COG;
+    for (p2_LONG i = 0; i < count; i++) {
+        const p2_LONG addr = (reg + i) & COG_MASK;
+        if (BREAK->test(kind, space, addr)) {
+            BREAK->record(kind, space, addr, static_cast<int>(ID), IR_PC, CNT);
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Read a SETQ/SETQ2 block of %count longs from hub address %addr
+ *
+ * The longs are copied to COG RAM (SETQ), or LUT RAM (SETQ2), starting at
+ * register D, with one rd_block() per stretch up to the end of the RAM,
+ * where the register address wraps. Watchpoints on the written registers
+ * are checked here, those on the HUB range by P2Hub::rd_block().
+ *
+ * @param addr hub address
+ * @param count number of longs (1 … 512)
+ */
+void P2Cog::burst_read(p2_LONG addr, p2_LONG count)
+{
+    const bool lut = VALID & VALID_Q2;
+    p2_LONG* ram = lut ? LUT.RAM : COG.RAM;
+    p2_DECODED_t* dec = lut ? DEC_LUT : DEC_COG;
+    p2_LONG reg = R & COG_MASK;
+
+    if (BREAK)
+        burst_watch(p2_BREAK_WRITE, lut, reg, count);
+    for (p2_LONG done = 0; done < count; ) {
+        const p2_LONG n = qMin(count - done, COG_SIZE - reg);
+        HUB->rd_block(addr, reinterpret_cast<p2_BYTE*>(ram + reg), n * sz_LONG);
+        for (p2_LONG i = reg; i < reg + n; i++) {
+            dec[i].valid = false;
+            if (JIT)
+                JIT->invalidate(lut, i);
+        }
+        addr += n * sz_LONG;
+        done += n;
+        reg = 0;
+    }
+}
 
-    } else if (inst1 >= p2_INSTR_RFBYTE && inst1 <= p2_INSTR_RFLONG) {
+/**
+ * @brief Write a SETQ/SETQ2 block of %count longs to hub address %addr
+ *
+ * The longs are copied from COG RAM (SETQ), or LUT RAM (SETQ2), starting
+ * at register D, like burst_read(). For WMLONG (%masked) only the non-zero
+ * bytes are written, so the hub longs are read, merged, and written back.
+ * Watchpoints on the read registers are checked here, those on the HUB
+ * range by P2Hub::wr_block().
+ *
+ * @param addr hub address
+ * @param count number of longs (1 … 512)
+ * @param masked true to write only non-zero bytes (WMLONG)
+ */
+void P2Cog::burst_write(p2_LONG addr, p2_LONG count, bool masked)
+{
+    const bool lut = VALID & VALID_Q2;
+    const p2_LONG* ram = lut ? LUT.RAM : COG.RAM;
+    p2_LONG reg = R & COG_MASK;
 
-        if (fifo_level() < 2) {
-            WAIT.flag = 1;
-            WAIT.mode = p2_WAIT_CACHE;
+    if (BREAK)
+        burst_watch(p2_BREAK_READ, lut, reg, count);
+    for (p2_LONG done = 0; done < count; ) {
+        const p2_LONG n = qMin(count - done, COG_SIZE - reg);
+        if (masked) {
+            p2_BYTE data[COG_SIZE * sz_LONG];
+            const p2_BYTE* src = reinterpret_cast<const p2_BYTE*>(ram + reg);
+            HUB->rd_block(addr, data, n * sz_LONG);
+            for (p2_LONG i = 0; i < n * sz_LONG; i++)
+                if (src[i])
+                    data[i] = src[i];
+            HUB->wr_block(addr, data, n * sz_LONG);
         } else {
-            WAIT.flag = 0;
+            HUB->wr_block(addr, reinterpret_cast<const p2_BYTE*>(ram + reg), n * sz_LONG);
         }
+        addr += n * sz_LONG;
+        done += n;
+        reg = 0;
+    }
+}
 
-    } else if (inst1 >= p2_INSTR_WFBYTE && inst1 <= p2_INSTR_WFLONG) {
+/**
+ * @brief Predecode an instruction
+ * @param dec pointer to the predecoded instruction to fill in
+ * @param opcode instruction opcode
+ */
+void P2Cog::predecode(p2_DECODED_t* dec, p2_LONG opcode)
+{
+    p2_opcode_u IR;
+    IR.opcode = opcode;
+    const p2_op_e op = static_cast<p2_op_e>(opindex(opcode));
+    Q_ASSERT(op == decode(IR));
+    dec->func = opfuncs[op];
+    dec->op = static_cast<p2_WORD>(op);
+    dec->opcode = opcode;
+    dec->dst = IR.op7.dst;
+    dec->src = IR.op7.src;
+    dec->cond = static_cast<p2_BYTE>(IR.op7.cond);
+    dec->valid = true;
+}
 
-        if (fifo_level() >= 15) {
-            WAIT.flag = 1;
-            WAIT.mode = p2_WAIT_CACHE;
-        } else {
-            WAIT.flag = 0;
-        }
+/**
+ * @brief Return the predecoded instruction for a hubexec or shadow register opcode
+ * @param addr long address of the instruction
+ * @param opcode instruction opcode
+ * @return pointer to the predecoded instruction
+ */
+const P2Cog::p2_DECODED_t* P2Cog::predecoded(p2_LONG addr, p2_LONG opcode)
+{
+    p2_DECODED_t* dec = &DEC_HUB[addr & (DEC_HUB_SIZE - 1)];
+    if (!dec->valid || dec->opcode != opcode)
+        predecode(dec, opcode);
+    return dec;
+}
 
-    } else {
+/**
+ * @brief Run the translated block at a COG or LUT address, if there is one
+ *
+ * The block's instructions are all executed now, and the COG then
+ * sits out one cycle per instruction, so the timing is the same as
+ * when interpreting them.
+ *
+ * In p2_JIT_VERIFY mode the block runs on a copy of the COG memory,
+ * the interpreter executes the instructions, and jit_compare() checks
+ * the results after the last one.
+ *
+ * @param lut true for LUT, false for COG addresses
+ * @param addr long address of the instruction
+ * @return true if the block was run
+ */
+bool P2Cog::jit_run(bool lut, p2_LONG addr)
+{
+    // The block must start in a plain state, and profiles count single instructions
+    if (JIT_verify || SKIP || SKIPF || VALID || PROFILE || STATS || BREAK)
+        return false;
 
-        WAIT.flag = 0;
+    // the translator is only allocated for COGs which use it
+    if (!JIT)
+        JIT.reset(new P2Jit());
+    const p2_JIT_block_t* blk = JIT->block(lut, addr, lut ? LUT.RAM : COG.RAM);
+    if (!blk)
+        return false;
+
+    p2_JIT_flags_t flags;
+    flags.C = C;
+    flags.Z = Z;
+    flags.failed = 0;
 
+    if (p2_JIT_VERIFY == use_jit) {
+        JIT_COG = COG;
+        blk->code(JIT_COG.RAM, &flags);
+        JIT_flags = flags;
+        JIT_PC = PC;
+        JIT_verify = blk->count;
+        return false;
     }
 
-    return HUBOP;
+    blk->code(COG.RAM, &flags);
+    C = flags.C;
+    Z = flags.Z;
+    for (int i = 0; i < blk->writes.count(); i++) {
+        const p2_LONG dst = blk->writes[i];
+        DEC_COG[dst].valid = false;
+        JIT->invalidate(false, dst);
+    }
+    PC += sz_LONG * blk->count;
+    ICNT += blk->count - flags.failed;
+    JIT_ticks = blk->count;
+    return true;
 }
 
 /**
- * @brief Compute the hub RAM address from the pointer instruction
- * @param inst instruction field (1SUPIIIII)
- * @param size size of instruction (0 = byte, 1 = word, 2 = long)
- * @return computed 20 bit RAM address
+ * @brief Compare the interpreter's state with the result of a translated block
  */
-p2_LONG P2Cog::get_pointer(p2_LONG inst, p2_LONG size)
+void P2Cog::jit_compare()
 {
-    p2_LONG address = 0;
-    p2_LONG offset = static_cast<p2_LONG>((static_cast<qint32>(inst) << 27) >> (27 - size));
-
-    switch ((inst >> 5) & 7) {
-    case 0: // PTRA[offset]
-        address = COG.REG.PTRA + offset;
-        break;
-    case 1: // PTRA
-        address = COG.REG.PTRA;
-        break;
-    case 2: // PTRA[++offset]
-        address = COG.REG.PTRA + offset;
-        PTRA0 = address;
-        break;
-    case 3: // PTRA[offset++]
-        address = COG.REG.PTRA;
-        PTRA0 = COG.REG.PTRA + offset;
-        break;
-    case 4: // PTRB[offset]
-        address = COG.REG.PTRB + offset;
-        break;
-    case 5: // PTRB
-        address = COG.REG.PTRB;
-        break;
-    case 6: // PTRB[++offset]
-        address = COG.REG.PTRB + offset;
-        PTRB0 = address;
-        break;
-    case 7: // PTRB[offset++]
-        address = COG.REG.PTRB;
-        PTRB0 = COG.REG.PTRB + offset;
-        break;
+    if (C == JIT_flags.C && Z == JIT_flags.Z && !memcmp(COG.RAM, JIT_COG.RAM, sizeof(COG.RAM)))
+        return;
+    JIT_mismatches++;
+    qWarning("%s: COG #%u block at $%05x: C=%u/%u Z=%u/%u (interpreter/translated)",
+             __func__, ID, JIT_PC, C, JIT_flags.C, Z, JIT_flags.Z);
+    for (p2_LONG addr = 0; addr < COG_SIZE; addr++) {
+        if (COG.RAM[addr] != JIT_COG.RAM[addr])
+            qWarning("%s:   $%03x: $%08x/$%08x", __func__, addr, COG.RAM[addr], JIT_COG.RAM[addr]);
     }
-    return address & A20MASK;
 }
 
 /**
- * @brief Save pointer registers PTRA/PTRB
+ * @brief Return the translator mode
+ * @return one of p2_JIT_mode_e
  */
-void P2Cog::save_regs()
+p2_JIT_mode_e P2Cog::jit_mode()
 {
-    PTRA0 = COG.REG.PTRA;
-    PTRB0 = COG.REG.PTRB;
+    return use_jit;
 }
 
 /**
- * @brief Update pointer registers PTRA/PTRB
+ * @brief Set the translator mode
+ *
+ * Translation is only available if P2Jit::available() is true.
+ *
+ * @param mode one of p2_JIT_mode_e
  */
-void P2Cog::update_regs()
+void P2Cog::set_jit_mode(p2_JIT_mode_e mode)
 {
-    COG.REG.PTRA = PTRA0;
-    COG.REG.PTRB = PTRB0;
+    use_jit = P2Jit::available() ? mode : p2_JIT_OFF;
+}
+
+/**
+ * @brief Return true, if an instruction reads INA or INB
+ *
+ * The instructions with an address instead of D and S fields, JMP #A
+ * and up, do not read registers, nor does an immediate S. An immediate
+ * D is rare enough to not be told apart.
+ *
+ * @param opcode instruction opcode
+ * @return true if D or S may be INA or INB
+ */
+static inline bool reads_IN(p2_LONG opcode)
+{
+    p2_opcode_u IR;
+    IR.opcode = opcode;
+    if (IR.op7.inst >= p2_JMP_ABS)
+        return false;
+    return IR.op7.dst >= offs_INA || (!IR.op7.im && IR.op7.src >= offs_INA);
+}
+
+/**
+ * @brief Return the state which the next gox() touches
+ *
+ * Fetching an instruction in hubexec reads HUB memory. A halted COG
+ * does not run on a worker thread, because any COGINIT may start it;
+ * P2Hub::execute_parallel() parks it instead.
+ *
+ * @return p2_SHARE_NONE for COG and LUT exec, else p2_SHARE_HUB
+ */
+p2_SHARE_e P2Cog::gox_share() const
+{
+    if (p2_WAIT_HALTED == WAIT.mode)
+        return p2_SHARE_HUB;
+    if (WAIT.flag || JIT_ticks > 0)
+        return p2_SHARE_NONE;
+    p2_LONG pc = PC;
+    for (p2_LONG skipf = SKIPF; skipf & 1; skipf >>= 1)
+        pc += 4;
+    return (pc & A20MASK) < 0x01000 ? p2_SHARE_NONE : p2_SHARE_HUB;
+}
+
+/**
+ * @brief Return the state which the next get() touches
+ *
+ * Besides the instructions accessing HUB memory, pins, or RND, the
+ * pattern, pin edge, and lock edge events read shared state while
+ * they are armed, and so does the streamer when a command ends and
+ * its data is read from the FIFO. This is decided by the instruction
+ * alone; whether its condition is met does not matter. A halted COG
+ * does not run on a worker thread, like in gox_share().
+ *
+ * @return one of p2_SHARE_e
+ */
+p2_SHARE_e P2Cog::get_share() const
+{
+    if (p2_WAIT_HALTED == WAIT.mode)
+        return p2_SHARE_HUB;
+    if (PAT.mode != p2_PAT_NONE || (PIN.edge & 0xc0) || (LOCK.edge & 0x30) || se_armed())
+        return p2_SHARE_HUB;
+    if (STREAMER.left && CNT >= STREAMER.end)
+        return p2_SHARE_HUB;
+    if (WAIT.flag || JIT_ticks > 0 || !DEC)
+        return p2_SHARE_NONE;
+    if (DEC->dst - offs_DIRA < 4)   // may write DIRA, DIRB, OUTA, or OUTB
+        return p2_SHARE_HUB;
+    if (reads_IN(DEC->opcode))
+        return p2_SHARE_HUB;
+    switch (DEC->op) {
+    case OP_COGINIT:
+    case OP_COGSTOP:
+        return p2_SHARE_COGS;
+    case OP_WAITX:      // WC/WZ/WCZ read RND
+        return (DEC->opcode & (3u << 19)) ? p2_SHARE_HUB : p2_SHARE_NONE;
+    case OP_AKPIN:
+    case OP_BITRND:
+    case OP_CALLA:
+    case OP_CALLA_ABS:
+    case OP_CALLB:
+    case OP_CALLB_ABS:
+    case OP_CALLD_ABS_PTRA:
+    case OP_CALLD_ABS_PTRB:
+    case OP_CALLPA:
+    case OP_CALLPB:
+    case OP_DIRC:
+    case OP_DIRH:
+    case OP_DIRL:
+    case OP_DIRNC:
+    case OP_DIRNOT:
+    case OP_DIRNZ:
+    case OP_DIRRND:
+    case OP_DIRZ:
+    case OP_DRVC:
+    case OP_DRVH:
+    case OP_DRVL:
+    case OP_DRVNC:
+    case OP_DRVNOT:
+    case OP_DRVNZ:
+    case OP_DRVRND:
+    case OP_DRVZ:
+    case OP_FLTC:
+    case OP_FLTH:
+    case OP_FLTL:
+    case OP_FLTNC:
+    case OP_FLTNOT:
+    case OP_FLTNZ:
+    case OP_FLTRND:
+    case OP_FLTZ:
+    case OP_GETRND:
+    case OP_GETRND_CZ:
+    case OP_GETSCP:
+    case OP_LOC_PA:
+    case OP_LOC_PB:
+    case OP_OUTC:
+    case OP_OUTH:
+    case OP_OUTL:
+    case OP_OUTNC:
+    case OP_OUTNOT:
+    case OP_OUTNZ:
+    case OP_OUTRND:
+    case OP_OUTZ:
+    case OP_PUSHA:
+    case OP_PUSHB:
+    case OP_RDBYTE:
+    case OP_RDFAST:
+    case OP_RDLONG:
+    case OP_RDLUT:
+    case OP_RDPIN:
+    case OP_RDWORD:
+    case OP_RETA:
+    case OP_RETB:
+    case OP_RFBYTE:
+    case OP_RFLONG:
+    case OP_RFVAR:
+    case OP_RFVARS:
+    case OP_RFWORD:
+    case OP_RQPIN:
+    case OP_SETSCP:
+    case OP_SETSE1:
+    case OP_SETSE2:
+    case OP_SETSE3:
+    case OP_SETSE4:
+    case OP_TESTPN_AND:
+    case OP_TESTPN_OR:
+    case OP_TESTPN_W:
+    case OP_TESTPN_XOR:
+    case OP_TESTP_AND:
+    case OP_TESTP_OR:
+    case OP_TESTP_W:
+    case OP_TESTP_XOR:
+    case OP_WFBYTE:
+    case OP_WFLONG:
+    case OP_WFWORD:
+    case OP_WMLONG:
+    case OP_WRBYTE:
+    case OP_WRLONG:
+    case OP_WRPIN:
+    case OP_WRWORD:
+    case OP_WXPIN:
+    case OP_WYPIN:
+    case OP_XCONT:
+    case OP_XINIT:
+    case OP_XSTOP:
+    case OP_XZERO:
+        return p2_SHARE_HUB;
+    }
+    return p2_SHARE_NONE;
 }
 
 /**
@@ -922,46 +2363,133 @@ void P2Cog::update_regs()
  *
  * If the SKIPF LSB is set, skip the instruction
  *
+ * COG and LUT instructions are predecoded once and reused until the
+ * memory location is written. The shadow registers $1F0…$1FF are
+ * written behind wr_cog()'s back and, like hubexec, go through a small
+ * cache of predecoded instructions, which is validated by the opcode.
+ *
  * @return number of cycles
  */
 int P2Cog::gox()
 {
+    if (WAIT.flag || JIT_ticks > 0) // waiting, or busy running a translated block
+        return 1;
+
+    if (JIT_verify > 0 && 0 == --JIT_verify)
+        jit_compare();
+
     while (SKIPF & 1) {
         PC += 4;    // increment PC
         SKIPF >>= 1;
+        if (STATS)
+            STATS->skipped_fast++;
     }
 
     PC &= A20MASK;
+    IR_PC = PC;
     // rdRAM Ib
-    switch (PC & 0xfff800) {
-    case 0x00000:   // COG exec
-        IR.opcode = COG.RAM[(PC/sz_LONG) & COG_MASK];
-        break;
-    case 0x00800:   // LUT exec
-        IR.opcode = LUT.RAM[(PC/sz_LONG) & LUT_MASK];
-        break;
-    default:        // hubexec
-        IR.opcode = HUB->rd_LONG(PC);
+    if (PC >= HUB_ADDR0) {
+        // hubexec
+        DEC = predecoded(PC/sz_LONG, MAP.rd_LONG(PC));
+    } else if (PC < LUT_ADDR0) {
+        // COG exec
+        const p2_LONG addr = (PC/sz_LONG) & COG_MASK;
+        if (addr >= 0x1f0) {
+            DEC = predecoded(addr, COG.RAM[addr]);
+        } else {
+            if (use_jit && jit_run(false, addr))
+                return 1;
+            if (!DEC_COG[addr].valid)
+                predecode(&DEC_COG[addr], COG.RAM[addr]);
+            DEC = &DEC_COG[addr];
+        }
+    } else {
+        // LUT exec
+        const p2_LONG addr = (PC/sz_LONG) & LUT_MASK;
+        if (use_jit && jit_run(true, addr))
+            return 1;
+        if (!DEC_LUT[addr].valid)
+            predecode(&DEC_LUT[addr], LUT.RAM[addr]);
+        DEC = &DEC_LUT[addr];
     }
+    IR.opcode = DEC->opcode;
     PC += 4;            // increment PC
-    S = IR.op7.src;     // latch Sb
-    D = IR.op7.dst;     // latch Db
-    R = IR.op7.dst;     // preset R = Db
+    S = DEC->src;       // latch Sb
+    D = DEC->dst;       // latch Db
+    R = DEC->dst;       // preset R = Db
     return 1;
 }
 
+/**
+ * @brief Execute the instruction in IR and advance the COG's cycle counter
+ * @return number of cycles
+ */
 int P2Cog::get()
 {
     int cycles = 1;
 
+    if (p2_WAIT_HALTED == WAIT.mode) {  // stopped, or never started
+        if (STATS)
+            STATS->waits[p2_WAIT_HALTED]++;
+        CNT++;
+        return cycles;
+    }
+
     check_interrupt_flags();
 
+    if (WAIT.flag) {        // waiting in WAITX or WAITCTx
+        if (STATS)
+            STATS->waits[WAIT.mode]++;
+        count_wait();
+        if (PROFILE) {
+            p2_PROFILE_t& counters = PROFILE->counters(IR_PC);
+            counters.cycles++;
+            counters.waits++;
+        }
+    } else if (JIT_ticks > 0) { // busy running a translated block
+        JIT_ticks--;
+    } else if (!DEC) {
+        // started by COGINIT in this cycle; the first fetch is in the next one
+    } else if (PROFILE) {
+        const p2_QUAD retired = ICNT;
+        cycles = execute();
+        p2_PROFILE_t& counters = PROFILE->counters(IR_PC);
+        counters.cycles++;
+        counters.instructions += ICNT - retired;
+    } else {
+        cycles = execute();
+    }
+
+    CNT++;
+    return cycles;
+}
+
+/**
+ * @brief Read the D and S registers and execute the instruction in IR
+ * @return number of cycles
+ */
+int P2Cog::execute()
+{
+    int cycles = 1;
+
+    if (reads_IN(IR.opcode)) {  // INA and INB are IN of the pins
+        const p2_QUAD in = HUB->rd_IN();
+        COG.REG.INA = static_cast<p2_LONG>(in);
+        COG.REG.INB = static_cast<p2_LONG>(in >> 32);
+    }
     S = COG.RAM[S];         // rdRAM Sb
     D = COG.RAM[D];         // rdRAM Db
 
+    // a SETQ/SETQ2 value applies to the following instruction only
+    const p2_LONG setq_bits = VALID_Q | VALID_Q_next | VALID_Q2 | VALID_Q2_next;
+    if (VALID & setq_bits)
+        VALID = (VALID & ~setq_bits) | ((VALID & (VALID_Q_next | VALID_Q2_next)) >> 1);
+
     if (SKIP & 1) {
         // cancel this instruction
         SKIP >>= 1;
+        if (STATS)
+            STATS->skipped++;
         return cycles;
     }
 
@@ -969,149 +2497,183 @@ int P2Cog::get()
         SKIP >>= 1;
 
     // check for the condition
-    if (!conditional(IR.op7.cond))
+    if (!conditional(DEC->cond)) {
+        if (STATS)
+            STATS->cond_failed++;
         return cycles;
+    }
+
+    ICNT++;
+
+    if (STATS) {
+        if (!IR.opcode)
+            STATS->nops++;
+        else
+            STATS->ops[DEC->op]++;
+    }
+
+    if (BREAK) {
+        if (BREAK->test(p2_BREAK_READ, p2_BREAK_COG, IR.op7.dst))
+            BREAK->record(p2_BREAK_READ, p2_BREAK_COG, IR.op7.dst, static_cast<int>(ID), IR_PC, CNT);
+        if (!IR.op7.im && BREAK->test(p2_BREAK_READ, p2_BREAK_COG, IR.op7.src))
+            BREAK->record(p2_BREAK_READ, p2_BREAK_COG, IR.op7.src, static_cast<int>(ID), IR_PC, CNT);
+    }
+
+    const p2_LONG pc = PC;
+    const p2_BYTE cond = DEC->cond;     // a COGINIT of this COG drops DEC
+
+    // Dispatch to the predecoded op_xxx() function
+#if P2_THREADED_DISPATCH
+    {
+#define P2_OP_LABEL(name) &&label_##name,
+        static void* const labels[OP_COUNT] = { P2_COG_OPS(P2_OP_LABEL) };
+#undef P2_OP_LABEL
+        goto *labels[DEC->op];
+#define P2_OP_TARGET(name) label_##name: cycles = op_##name(); goto dispatched;
+        P2_COG_OPS(P2_OP_TARGET)
+#undef P2_OP_TARGET
+    }
+dispatched:
+#else
+    cycles = (this->*DEC->func)();
+#endif
+
+    // _RET_ returns unless the instruction branched; $00000000 is NOP
+    if (cc__ret_ == cond && IR.opcode && PC == pc)
+        updatePC(addr2pc(popK()));
+
+    // Handle REP instructions
+    if (IR.op8.inst != p2_REP && (VALID & VALID_REP_instr)) {
+        p2_LONG instr = REP_instr;
+        // qDebug("%s: repeat %u instructions %u times", __func__, instr, REP_times);
+        if (++REP_offset == instr) {
+            if (REP_times == 0 || --REP_times > 0) {
+                PC = PC - 4 * instr;
+                REP_offset = 0;
+            }
+
+        }
+    }
 
-    // Dispatch to op_xxx() functions
+    return cycles;
+}
+
+/**
+ * @brief Decode an instruction to its op_xxx() function
+ *
+ * This is the reference decoder. The flat dispatch table used by lookup()
+ * is generated from it by build_dispatch().
+ *
+ * @param IR instruction register value
+ * @return enumeration value of the op_xxx() function
+ */
+P2Cog::p2_op_e P2Cog::decode(const p2_opcode_u IR)
+{
     switch (IR.op7.inst) {
     case p2_ROR:
-        cycles = op_ROR();
-        break;
+        return OP_ROR;
 
     case p2_ROL:
-        cycles = op_ROL();
-        break;
+        return OP_ROL;
 
     case p2_SHR:
-        cycles = op_SHR();
-        break;
+        return OP_SHR;
 
     case p2_SHL:
-        cycles = op_SHL();
-        break;
+        return OP_SHL;
 
     case p2_RCR:
-        cycles = op_RCR();
-        break;
+        return OP_RCR;
 
     case p2_RCL:
-        cycles = op_RCL();
-        break;
+        return OP_RCL;
 
     case p2_SAR:
-        cycles = op_SAR();
-        break;
+        return OP_SAR;
 
     case p2_SAL:
-        cycles = op_SAL();
-        break;
+        return OP_SAL;
 
     case p2_ADD:
-        cycles = op_ADD();
-        break;
+        return OP_ADD;
 
     case p2_ADDX:
-        cycles = op_ADDX();
-        break;
+        return OP_ADDX;
 
     case p2_ADDS:
-        cycles = op_ADDS();
-        break;
+        return OP_ADDS;
 
     case p2_ADDSX:
-        cycles = op_ADDSX();
-        break;
+        return OP_ADDSX;
 
     case p2_SUB:
-        cycles = op_SUB();
-        break;
+        return OP_SUB;
 
     case p2_SUBX:
-        cycles = op_SUBX();
-        break;
+        return OP_SUBX;
 
     case p2_SUBS:
-        cycles = op_SUBS();
-        break;
+        return OP_SUBS;
 
     case p2_SUBSX:
-        cycles = op_SUBSX();
-        break;
+        return OP_SUBSX;
 
     case p2_CMP:
-        cycles = op_CMP();
-        break;
+        return OP_CMP;
 
     case p2_CMPX:
-        cycles = op_CMPX();
-        break;
+        return OP_CMPX;
 
     case p2_CMPS:
-        cycles = op_CMPS();
-        break;
+        return OP_CMPS;
 
     case p2_CMPSX:
-        cycles = op_CMPSX();
-        break;
+        return OP_CMPSX;
 
     case p2_CMPR:
-        cycles = op_CMPR();
-        break;
+        return OP_CMPR;
 
     case p2_CMPM:
-        cycles = op_CMPM();
-        break;
+        return OP_CMPM;
 
     case p2_SUBR:
-        cycles = op_SUBR();
-        break;
+        return OP_SUBR;
 
     case p2_CMPSUB:
-        cycles = op_CMPSUB();
-        break;
+        return OP_CMPSUB;
 
     case p2_FGE:
-        cycles = op_FGE();
-        break;
+        return OP_FGE;
 
     case p2_FLE:
-        cycles = op_FLE();
-        break;
+        return OP_FLE;
 
     case p2_FGES:
-        cycles = op_FGES();
-        break;
+        return OP_FGES;
 
     case p2_FLES:
-        cycles = op_FLES();
-        break;
+        return OP_FLES;
 
     case p2_SUMC:
-        cycles = op_SUMC();
-        break;
+        return OP_SUMC;
 
     case p2_SUMNC:
-        cycles = op_SUMNC();
-        break;
+        return OP_SUMNC;
 
     case p2_SUMZ:
-        cycles = op_SUMZ();
-        break;
+        return OP_SUMZ;
 
     case p2_SUMNZ:
-        cycles = op_SUMNZ();
-        break;
+        return OP_SUMNZ;
 
     case p2_TESTB_W_BITL:
         switch (IR.op9.inst) {
         case p2_TESTB_WC:
         case p2_TESTB_WZ:
-            cycles = op_TESTB_W();
-            break;
+            return OP_TESTB_W;
         case p2_BITL:
         case p2_BITL_WCZ:
-            cycles = op_BITL();
-            break;
+            return OP_BITL;
         default:
             Q_ASSERT_X(false, "TESTB WC|WZ, BITL {WCZ}", "inst9 error");
         }
@@ -1121,12 +2683,10 @@ int P2Cog::get()
         switch (IR.op9.inst) {
         case p2_TESTBN_WZ:
         case p2_TESTBN_WC:
-            cycles = op_TESTBN_W();
-            break;
+            return OP_TESTBN_W;
         case p2_BITH:
         case p2_BITH_WCZ:
-            cycles = op_BITH();
-            break;
+            return OP_BITH;
         default:
             Q_ASSERT_X(false, "TESTBN WC|WZ, BITH {WCZ}", "inst9 error");
         }
@@ -1135,12 +2695,10 @@ int P2Cog::get()
         switch (IR.op9.inst) {
         case p2_TESTB_ANDZ:
         case p2_TESTB_ANDC:
-            cycles = op_TESTB_AND();
-            break;
+            return OP_TESTB_AND;
         case p2_BITC:
         case p2_BITC_WCZ:
-            cycles = op_BITC();
-            break;
+            return OP_BITC;
         default:
             Q_ASSERT_X(false, "TESTB ANDC|ANDZ, BITC {WCZ}", "inst9 error");
         }
@@ -1149,12 +2707,10 @@ int P2Cog::get()
         switch (IR.op9.inst) {
         case p2_TESTBN_ANDZ:
         case p2_TESTBN_ANDC:
-            cycles = op_TESTBN_AND();
-            break;
+            return OP_TESTBN_AND;
         case p2_BITNC:
         case p2_BITNC_WCZ:
-            cycles = op_BITNC();
-            break;
+            return OP_BITNC;
         default:
             Q_ASSERT_X(false, "TESTBN ANDC|ANDZ, BITNC {WCZ}", "inst9 error");
         }
@@ -1163,12 +2719,10 @@ int P2Cog::get()
         switch (IR.op9.inst) {
         case p2_TESTB_ORC:
         case p2_TESTB_ORZ:
-            cycles = op_TESTB_OR();
-            break;
+            return OP_TESTB_OR;
         case p2_BITZ:
         case p2_BITZ_WCZ:
-            cycles = op_BITZ();
-            break;
+            return OP_BITZ;
         default:
             Q_ASSERT_X(false, "TESTB ORC|ORZ, BITZ {WCZ}", "inst9 error");
         }
@@ -1177,12 +2731,10 @@ int P2Cog::get()
         switch (IR.op9.inst) {
         case p2_TESTBN_ORC:
         case p2_TESTBN_ORZ:
-            cycles = op_TESTBN_OR();
-            break;
+            return OP_TESTBN_OR;
         case p2_BITNZ:
         case p2_BITNZ_WCZ:
-            cycles = op_BITNZ();
-            break;
+            return OP_BITNZ;
         default:
             Q_ASSERT_X(false, "TESTBN ORC|ORZ, BITNZ {WCZ}", "inst9 error");
         }
@@ -1192,12 +2744,10 @@ int P2Cog::get()
         switch (IR.op9.inst) {
         case p2_TESTB_XORC:
         case p2_TESTB_XORZ:
-            cycles = op_TESTB_XOR();
-            break;
+            return OP_TESTB_XOR;
         case p2_BITRND:
         case p2_BITRND_WCZ:
-            cycles = op_BITRND();
-            break;
+            return OP_BITRND;
         default:
             Q_ASSERT_X(false, "TESTB XORC|XORZ, BITRND {WCZ}", "inst9 error");
         }
@@ -1207,154 +2757,118 @@ int P2Cog::get()
         switch (IR.op9.inst) {
         case p2_TESTBN_XORC:
         case p2_TESTBN_XORZ:
-            cycles = op_TESTBN_XOR();
-            break;
+            return OP_TESTBN_XOR;
         case p2_BITNOT:
         case p2_BITNOT_WCZ:
-            cycles = op_BITNOT();
-            break;
+            return OP_BITNOT;
         default:
             Q_ASSERT_X(false, "TESTBN XORC|XORZ, BITNOT {WCZ}", "inst9 error");
         }
         break;
 
     case p2_AND:
-        cycles = op_AND();
-        break;
+        return OP_AND;
 
     case p2_ANDN:
-        cycles = op_ANDN();
-        break;
+        return OP_ANDN;
 
     case p2_OR:
-        cycles = op_OR();
-        break;
+        return OP_OR;
 
     case p2_XOR:
-        cycles = op_XOR();
-        break;
+        return OP_XOR;
 
     case p2_MUXC:
-        cycles = op_MUXC();
-        break;
+        return OP_MUXC;
 
     case p2_MUXNC:
-        cycles = op_MUXNC();
-        break;
+        return OP_MUXNC;
 
     case p2_MUXZ:
-        cycles = op_MUXZ();
-        break;
+        return OP_MUXZ;
 
     case p2_MUXNZ:
-        cycles = op_MUXNZ();
-        break;
+        return OP_MUXNZ;
 
     case p2_MOV:
-        cycles = op_MOV();
-        break;
+        return OP_MOV;
 
     case p2_NOT:
-        cycles = op_NOT();
-        break;
+        return OP_NOT;
 
     case p2_ABS:
-        cycles = op_ABS();
-        break;
+        return OP_ABS;
 
     case p2_NEG:
-        cycles = op_NEG();
-        break;
+        return OP_NEG;
 
     case p2_NEGC:
-        cycles = op_NEGC();
-        break;
+        return OP_NEGC;
 
     case p2_NEGNC:
-        cycles = op_NEGNC();
-        break;
+        return OP_NEGNC;
 
     case p2_NEGZ:
-        cycles = op_NEGZ();
-        break;
+        return OP_NEGZ;
 
     case p2_NEGNZ:
-        cycles = op_NEGNZ();
-        break;
+        return OP_NEGNZ;
 
     case p2_INCMOD:
-        cycles = op_INCMOD();
-        break;
+        return OP_INCMOD;
 
     case p2_DECMOD:
-        cycles = op_DECMOD();
-        break;
+        return OP_DECMOD;
 
     case p2_ZEROX:
-        cycles = op_ZEROX();
-        break;
+        return OP_ZEROX;
 
     case p2_SIGNX:
-        cycles = op_SIGNX();
-        break;
+        return OP_SIGNX;
 
     case p2_ENCOD:
-        cycles = op_ENCOD();
-        break;
+        return OP_ENCOD;
 
     case p2_ONES:
-        cycles = op_ONES();
-        break;
+        return OP_ONES;
 
     case p2_TEST:
-        cycles = op_TEST();
-        break;
+        return OP_TEST;
 
     case p2_TESTN:
-        cycles = op_TESTN();
-        break;
+        return OP_TESTN;
 
     case p2_SETNIB_0_3:
     case p2_SETNIB_4_7:
-        cycles = op_SETNIB();
-        break;
+        return OP_SETNIB;
 
     case p2_GETNIB_0_3:
     case p2_GETNIB_4_7:
-        cycles = op_GETNIB();
-        break;
+        return OP_GETNIB;
 
     case p2_ROLNIB_0_3:
     case p2_ROLNIB_4_7:
-        cycles = op_ROLNIB();
-        break;
+        return OP_ROLNIB;
 
     case p2_SETBYTE_0_3:
-        cycles = op_SETBYTE();
-        break;
+        return OP_SETBYTE;
 
     case p2_GETBYTE_0_3:
-        cycles = op_GETBYTE();
-        break;
+        return OP_GETBYTE;
 
     case p2_ROLBYTE_0_3:
-        cycles = op_ROLBYTE();
-        break;
+        return OP_ROLBYTE;
 
     case p2_SETWORD_GETWORD:
         switch (IR.op9.inst) {
         case p2_SETWORD_ALTSW:
-            cycles = op_SETWORD_ALTSW();
-            break;
+            return OP_SETWORD_ALTSW;
         case p2_SETWORD:
-            cycles = op_SETWORD();
-            break;
+            return OP_SETWORD;
         case p2_GETWORD_ALTGW:
-            cycles = op_GETWORD_ALTGW();
-            break;
+            return OP_GETWORD_ALTGW;
         case p2_GETWORD:
-            cycles = op_GETWORD();
-            break;
+            return OP_GETWORD;
         default:
             Q_ASSERT_X(false, "p2_inst9_e", "SETWORD/GETWORD");
         }
@@ -1364,27 +2878,21 @@ int P2Cog::get()
         switch (IR.op9.inst) {
         case p2_ROLWORD_ALTGW:
             if (0 == IR.op7.src) {
-                cycles = op_ROLWORD_ALTGW();
-                break;
+                return OP_ROLWORD_ALTGW;
             }
             break;
         case p2_ROLWORD:
-            cycles = op_ROLWORD();
-            break;
+            return OP_ROLWORD;
         case p2_ALTSN:
             if (0 == IR.op7.src && true == IR.op7.im) {
-                cycles = op_ALTSN_D();
-                break;
+                return OP_ALTSN_D;
             }
-            cycles = op_ALTSN();
-            break;
+            return OP_ALTSN;
         case p2_ALTGN:
             if (0 == IR.op7.src && true == IR.op7.im) {
-                cycles = op_ALTGN_D();
-                break;
+                return OP_ALTGN_D;
             }
-            cycles = op_ALTGN();
-            break;
+            return OP_ALTGN;
         default:
             Q_ASSERT_X(false, "p2_inst9_e", "ROLWORD/ALTSN/ALTGN");
         }
@@ -1394,32 +2902,24 @@ int P2Cog::get()
         switch (IR.op9.inst) {
         case p2_ALTSB:
             if (0 == IR.op7.src && true == IR.op7.im) {
-                cycles = op_ALTSB_D();
-                break;
+                return OP_ALTSB_D;
             }
-            cycles = op_ALTSB();
-            break;
+            return OP_ALTSB;
         case p2_ALTGB:
             if (0 == IR.op7.src && true == IR.op7.im) {
-                cycles = op_ALTGB_D();
-                break;
+                return OP_ALTGB_D;
             }
-            cycles = op_ALTGB();
-            break;
+            return OP_ALTGB;
         case p2_ALTSW:
             if (0 == IR.op7.src && true == IR.op7.im) {
-                cycles = op_ALTSW_D();
-                break;
+                return OP_ALTSW_D;
             }
-            cycles = op_ALTSW();
-            break;
+            return OP_ALTSW;
         case p2_ALTGW:
             if (0 == IR.op7.src && true == IR.op7.im) {
-                cycles = op_ALTGW_D();
-                break;
+                return OP_ALTGW_D;
             }
-            cycles = op_ALTGW();
-            break;
+            return OP_ALTGW;
         default:
             Q_ASSERT_X(false, "p2_inst9_e", "ALTSB/ALTGB/ALTSW/ALTGW");
         }
@@ -1429,32 +2929,24 @@ int P2Cog::get()
         switch (IR.op9.inst) {
         case p2_ALTR:
             if (0 == IR.op7.src && true == IR.op7.im) {
-                cycles = op_ALTR_D();
-                break;
+                return OP_ALTR_D;
             }
-            cycles = op_ALTR();
-            break;
+            return OP_ALTR;
         case p2_ALTD:
             if (0 == IR.op7.src && true == IR.op7.im) {
-                cycles = op_ALTD_D();
-                break;
+                return OP_ALTD_D;
             }
-            cycles = op_ALTD();
-            break;
+            return OP_ALTD;
         case p2_ALTS:
             if (0 == IR.op7.src && true == IR.op7.im) {
-                cycles = op_ALTS_D();
-                break;
+                return OP_ALTS_D;
             }
-            cycles = op_ALTS();
-            break;
+            return OP_ALTS;
         case p2_ALTB:
             if (0 == IR.op7.src && true == IR.op7.im) {
-                cycles = op_ALTB_D();
-                break;
+                return OP_ALTB_D;
             }
-            cycles = op_ALTB();
-            break;
+            return OP_ALTB;
         default:
             Q_ASSERT_X(false, "p2_inst9_e", "ALTR/ALTD/ALTS/ALTB");
         }
@@ -1464,20 +2956,15 @@ int P2Cog::get()
         switch (IR.op9.inst) {
         case p2_ALTI:
             if (true == IR.op7.im && 0x164 == IR.op7.src /* 101100100 */) {
-                cycles = op_ALTI_D();
-                break;
+                return OP_ALTI_D;
             }
-            cycles = op_ALTI();
-            break;
+            return OP_ALTI;
         case p2_SETR:
-            cycles = op_SETR();
-            break;
+            return OP_SETR;
         case p2_SETD:
-            cycles = op_SETD();
-            break;
+            return OP_SETD;
         case p2_SETS:
-            cycles = op_SETS();
-            break;
+            return OP_SETS;
         default:
             Q_ASSERT_X(false, "p2_inst9_e", "ALTI/SETR/SETD/SETS");
         }
@@ -1487,24 +2974,18 @@ int P2Cog::get()
         switch (IR.op9.inst) {
         case p2_DECOD:
             if (false == IR.op7.im && IR.op7.src == IR.op7.dst) {
-                cycles = op_DECOD_D();
-                break;
+                return OP_DECOD_D;
             }
-            cycles = op_DECOD();
-            break;
+            return OP_DECOD;
         case p2_BMASK:
             if (false == IR.op7.im && IR.op7.src == IR.op7.dst) {
-                cycles = op_BMASK_D();
-                break;
+                return OP_BMASK_D;
             }
-            cycles = op_BMASK();
-            break;
+            return OP_BMASK;
         case p2_CRCBIT:
-            cycles = op_CRCBIT();
-            break;
+            return OP_CRCBIT;
         case p2_CRCNIB:
-            cycles = op_CRCNIB();
-            break;
+            return OP_CRCNIB;
         default:
             Q_ASSERT_X(false, "p2_inst9_e", "DECOD/BMASK/CRCBIT/CRCNIB");
         }
@@ -1513,17 +2994,13 @@ int P2Cog::get()
     case p2_MUX_NITS_NIBS_Q_MOVBYTS:
         switch (IR.op9.inst) {
         case p2_MUXNITS:
-            cycles = op_MUXNITS();
-            break;
+            return OP_MUXNITS;
         case p2_MUXNIBS:
-            cycles = op_MUXNIBS();
-            break;
+            return OP_MUXNIBS;
         case p2_MUXQ:
-            cycles = op_MUXQ();
-            break;
+            return OP_MUXQ;
         case p2_MOVBYTS:
-            cycles = op_MOVBYTS();
-            break;
+            return OP_MOVBYTS;
         default:
             Q_ASSERT_X(false, "p2_inst9_e", "MUXNITS/MUXNIBS/MUXQ/MOVBYTS");
         }
@@ -1532,11 +3009,9 @@ int P2Cog::get()
     case p2_MUL_MULS:
         switch (IR.op8.inst) {
         case p2_MUL:
-            cycles = op_MUL();
-            break;
+            return OP_MUL;
         case p2_MULS:
-            cycles = op_MULS();
-            break;
+            return OP_MULS;
         default:
             Q_ASSERT_X(false, "p2_inst8_e", "MUL/MULS");
         }
@@ -1545,11 +3020,9 @@ int P2Cog::get()
     case p2_SCA_SCAS:
         switch (IR.op8.inst) {
         case p2_SCA:
-            cycles = op_SCA();
-            break;
+            return OP_SCA;
         case p2_SCAS:
-            cycles = op_SCAS();
-            break;
+            return OP_SCAS;
         default:
             Q_ASSERT_X(false, "p2_inst8_e", "SCA/SCAS");
         }
@@ -1558,17 +3031,13 @@ int P2Cog::get()
     case p2_XXXPIX:
         switch (IR.op9.inst) {
         case p2_ADDPIX:
-            cycles = op_ADDPIX();
-            break;
+            return OP_ADDPIX;
         case p2_MULPIX:
-            cycles = op_MULPIX();
-            break;
+            return OP_MULPIX;
         case p2_BLNPIX:
-            cycles = op_BLNPIX();
-            break;
+            return OP_BLNPIX;
         case p2_MIXPIX:
-            cycles = op_MIXPIX();
-            break;
+            return OP_MIXPIX;
         default:
             Q_ASSERT_X(false, "p2_inst9_e", "ADDPIX/MULPIX/BLNPIX/MIXPIX");
         }
@@ -1577,17 +3046,13 @@ int P2Cog::get()
     case p2_WMLONG_ADDCTx:
         switch (IR.op9.inst) {
         case p2_ADDCT1:
-            cycles = op_ADDCT1();
-            break;
+            return OP_ADDCT1;
         case p2_ADDCT2:
-            cycles = op_ADDCT2();
-            break;
+            return OP_ADDCT2;
         case p2_ADDCT3:
-            cycles = op_ADDCT3();
-            break;
+            return OP_ADDCT3;
         case p2_WMLONG:
-            cycles = op_WMLONG();
-            break;
+            return OP_WMLONG;
         default:
             Q_ASSERT_X(false, "p2_inst9_e", "ADDCT1/ADDCT2/ADDCT3/WMLONG");
         }
@@ -1596,44 +3061,35 @@ int P2Cog::get()
     case p2_RQPIN_RDPIN:
         switch (IR.op8.inst) {
         case p2_RQPIN:
-            cycles = op_RQPIN();
-            break;
+            return OP_RQPIN;
         case p2_RDPIN:
-            cycles = op_RDPIN();
-            break;
+            return OP_RDPIN;
         default:
             Q_ASSERT_X(false, "p2_inst8_e", "RQPIN/RDPIN");
         }
         break;
 
     case p2_RDLUT:
-        cycles = op_RDLUT();
-        break;
+        return OP_RDLUT;
 
     case p2_RDBYTE:
-        cycles = op_RDBYTE();
-        break;
+        return OP_RDBYTE;
 
     case p2_RDWORD:
-        cycles = op_RDWORD();
-        break;
+        return OP_RDWORD;
 
     case p2_RDLONG:
-        cycles = op_RDLONG();
-        break;
+        return OP_RDLONG;
 
     case p2_CALLD:
-        cycles = op_CALLD();
-        break;
+        return OP_CALLD;
 
     case p2_CALLPA_CALLPB:
         switch (IR.op8.inst) {
         case p2_CALLPA:
-            cycles = op_CALLPA();
-            break;
+            return OP_CALLPA;
         case p2_CALLPB:
-            cycles = op_CALLPB();
-            break;
+            return OP_CALLPB;
         default:
             Q_ASSERT_X(false, "p2_inst8_e", "CALLPA/CALLPB");
         }
@@ -1642,17 +3098,13 @@ int P2Cog::get()
     case p2_DJZ_DJNZ_DJF_DJNF:
         switch (IR.op9.inst) {
         case p2_DJZ:
-            cycles = op_DJZ();
-            break;
+            return OP_DJZ;
         case p2_DJNZ:
-            cycles = op_DJNZ();
-            break;
+            return OP_DJNZ;
         case p2_DJF:
-            cycles = op_DJF();
-            break;
+            return OP_DJF;
         case p2_DJNF:
-            cycles = op_DJNF();
-            break;
+            return OP_DJNF;
         default:
             Q_ASSERT_X(false, "p2_inst9_e", "DJZ/DJNZ/DJF/DJNF");
         }
@@ -1661,17 +3113,13 @@ int P2Cog::get()
     case p2_IJZ_IJNZ_TJZ_TJNZ:
         switch (IR.op9.inst) {
         case p2_IJZ:
-            cycles = op_IJZ();
-            break;
+            return OP_IJZ;
         case p2_IJNZ:
-            cycles = op_IJNZ();
-            break;
+            return OP_IJNZ;
         case p2_TJZ:
-            cycles = op_TJZ();
-            break;
+            return OP_TJZ;
         case p2_TJNZ:
-            cycles = op_TJNZ();
-            break;
+            return OP_TJNZ;
         default:
             Q_ASSERT_X(false, "p2_inst9_e", "IJZ/IJNZ/TJZ/TJNZ");
         }
@@ -1680,17 +3128,13 @@ int P2Cog::get()
     case p2_TJF_TJNF_TJS_TJNS:
         switch (IR.op9.inst) {
         case p2_TJF:
-            cycles = op_TJF();
-            break;
+            return OP_TJF;
         case p2_TJNF:
-            cycles = op_TJNF();
-            break;
+            return OP_TJNF;
         case p2_TJS:
-            cycles = op_TJS();
-            break;
+            return OP_TJS;
         case p2_TJNS:
-            cycles = op_TJNS();
-            break;
+            return OP_TJNS;
         default:
             Q_ASSERT_X(false, "p2_inst9_e", "TJF/TJNF/TJS/TJNS");
         }
@@ -1699,124 +3143,89 @@ int P2Cog::get()
     case p2_TJV_OPDST_empty:
         if (false == IR.op7.wc) {
             if (false == IR.op7.wz) {
-                cycles = op_TJV();
+                return OP_TJV;
             } else {
                 switch (IR.op7.dst) {
                 case p2_OPDST_JINT:
-                    cycles = op_JINT();
-                    break;
+                    return OP_JINT;
                 case p2_OPDST_JCT1:
-                    cycles = op_JCT1();
-                    break;
+                    return OP_JCT1;
                 case p2_OPDST_JCT2:
-                    cycles = op_JCT2();
-                    break;
+                    return OP_JCT2;
                 case p2_OPDST_JCT3:
-                    cycles = op_JCT3();
-                    break;
+                    return OP_JCT3;
                 case p2_OPDST_JSE1:
-                    cycles = op_JSE1();
-                    break;
+                    return OP_JSE1;
                 case p2_OPDST_JSE2:
-                    cycles = op_JSE2();
-                    break;
+                    return OP_JSE2;
                 case p2_OPDST_JSE3:
-                    cycles = op_JSE3();
-                    break;
+                    return OP_JSE3;
                 case p2_OPDST_JSE4:
-                    cycles = op_JSE4();
-                    break;
+                    return OP_JSE4;
                 case p2_OPDST_JPAT:
-                    cycles = op_JPAT();
-                    break;
+                    return OP_JPAT;
                 case p2_OPDST_JFBW:
-                    cycles = op_JFBW();
-                    break;
+                    return OP_JFBW;
                 case p2_OPDST_JXMT:
-                    cycles = op_JXMT();
-                    break;
+                    return OP_JXMT;
                 case p2_OPDST_JXFI:
-                    cycles = op_JXFI();
-                    break;
+                    return OP_JXFI;
                 case p2_OPDST_JXRO:
-                    cycles = op_JXRO();
-                    break;
+                    return OP_JXRO;
                 case p2_OPDST_JXRL:
-                    cycles = op_JXRL();
-                    break;
+                    return OP_JXRL;
                 case p2_OPDST_JATN:
-                    cycles = op_JATN();
-                    break;
+                    return OP_JATN;
                 case p2_OPDST_JQMT:
-                    cycles = op_JQMT();
-                    break;
+                    return OP_JQMT;
                 case p2_OPDST_JNINT:
-                    cycles = op_JNINT();
-                    break;
+                    return OP_JNINT;
                 case p2_OPDST_JNCT1:
-                    cycles = op_JNCT1();
-                    break;
+                    return OP_JNCT1;
                 case p2_OPDST_JNCT2:
-                    cycles = op_JNCT2();
-                    break;
+                    return OP_JNCT2;
                 case p2_OPDST_JNCT3:
-                    cycles = op_JNCT3();
-                    break;
+                    return OP_JNCT3;
                 case p2_OPDST_JNSE1:
-                    cycles = op_JNSE1();
-                    break;
+                    return OP_JNSE1;
                 case p2_OPDST_JNSE2:
-                    cycles = op_JNSE2();
-                    break;
+                    return OP_JNSE2;
                 case p2_OPDST_JNSE3:
-                    cycles = op_JNSE3();
-                    break;
+                    return OP_JNSE3;
                 case p2_OPDST_JNSE4:
-                    cycles = op_JNSE4();
-                    break;
+                    return OP_JNSE4;
                 case p2_OPDST_JNPAT:
-                    cycles = op_JNPAT();
-                    break;
+                    return OP_JNPAT;
                 case p2_OPDST_JNFBW:
-                    cycles = op_JNFBW();
-                    break;
+                    return OP_JNFBW;
                 case p2_OPDST_JNXMT:
-                    cycles = op_JNXMT();
-                    break;
+                    return OP_JNXMT;
                 case p2_OPDST_JNXFI:
-                    cycles = op_JNXFI();
-                    break;
+                    return OP_JNXFI;
                 case p2_OPDST_JNXRO:
-                    cycles = op_JNXRO();
-                    break;
+                    return OP_JNXRO;
                 case p2_OPDST_JNXRL:
-                    cycles = op_JNXRL();
-                    break;
+                    return OP_JNXRL;
                 case p2_OPDST_JNATN:
-                    cycles = op_JNATN();
-                    break;
+                    return OP_JNATN;
                 case p2_OPDST_JNQMT:
-                    cycles = op_JNQMT();
-                    break;
+                    return OP_JNQMT;
                 default:
                     // TODO: invalid D value
-                    Q_ASSERT_X(false, "p2_opdst_e", "missing enum value");
                     break;
                 }
             }
         } else {
-            cycles = op_1011110_1();
+            return OP_1011110_1;
         }
         break;
 
     case p2_empty_SETPAT:
         switch (IR.op8.inst) {
         case p2_1011111_0:
-            cycles = op_1011111_0();
-            break;
+            return OP_1011111_0;
         case p2_SETPAT:
-            cycles = op_SETPAT();
-            break;
+            return OP_SETPAT;
         default:
             Q_ASSERT_X(false, "p2_inst8_e", "1011111_0/SETPAT");
         }
@@ -1826,14 +3235,11 @@ int P2Cog::get()
         switch (IR.op8.inst) {
         case p2_WRPIN:
             if (IR.op7.wz == 1 && IR.op7.dst == 1) {
-                cycles = op_AKPIN();
-                break;
+                return OP_AKPIN;
             }
-            cycles = op_WRPIN();
-            break;
+            return OP_WRPIN;
         case p2_WXPIN:
-            cycles = op_WXPIN();
-            break;
+            return OP_WXPIN;
         default:
             Q_ASSERT_X(false, "p2_inst8_e", "WRPIN/AKPIN/WXPIN");
         }
@@ -1842,11 +3248,9 @@ int P2Cog::get()
     case p2_WYPIN_WRLUT:
         switch (IR.op8.inst) {
         case p2_WYPIN:
-            cycles = op_WYPIN();
-            break;
+            return OP_WYPIN;
         case p2_WRLUT:
-            cycles = op_WRLUT();
-            break;
+            return OP_WRLUT;
         default:
             Q_ASSERT_X(false, "p2_inst8_e", "WYPIN/WRLUT");
         }
@@ -1855,11 +3259,9 @@ int P2Cog::get()
     case p2_WRBYTE_WRWORD:
         switch (IR.op8.inst) {
         case p2_WRBYTE:
-            cycles = op_WRBYTE();
-            break;
+            return OP_WRBYTE;
         case p2_WRWORD:
-            cycles = op_WRWORD();
-            break;
+            return OP_WRWORD;
         default:
             Q_ASSERT_X(false, "p2_inst8_e", "WRBYTE/WRWORD");
         }
@@ -1868,11 +3270,9 @@ int P2Cog::get()
     case p2_WRLONG_RDFAST:
         switch (IR.op8.inst) {
         case p2_WRLONG:
-            cycles = op_WRLONG();
-            break;
+            return OP_WRLONG;
         case p2_RDFAST:
-            cycles = op_RDFAST();
-            break;
+            return OP_RDFAST;
         default:
             Q_ASSERT_X(false, "p2_inst8_e", "WRLONG/RDFAST");
         }
@@ -1881,11 +3281,9 @@ int P2Cog::get()
     case p2_WRFAST_FBLOCK:
         switch (IR.op8.inst) {
         case p2_WRFAST:
-            cycles = op_WRFAST();
-            break;
+            return OP_WRFAST;
         case p2_FBLOCK:
-            cycles = op_FBLOCK();
-            break;
+            return OP_FBLOCK;
         default:
             Q_ASSERT_X(false, "p2_inst8_e", "WRFAST/FBLOCK");
         }
@@ -1895,14 +3293,11 @@ int P2Cog::get()
         switch (IR.op8.inst) {
         case p2_XINIT:
             if (IR.op7.wz == 1 && true == IR.op7.im && 0 == IR.op7.src && 0 == IR.op7.dst) {
-                cycles = op_XSTOP();
-                break;
+                return OP_XSTOP;
             }
-            cycles = op_XINIT();
-            break;
+            return OP_XINIT;
         case p2_XZERO:
-            cycles = op_XZERO();
-            break;
+            return OP_XZERO;
         default:
             Q_ASSERT_X(false, "p2_inst8_e", "XINIT/XSTOP/XZERO");
         }
@@ -1911,28 +3306,23 @@ int P2Cog::get()
     case p2_XCONT_REP:
         switch (IR.op8.inst) {
         case p2_XCONT:
-            cycles = op_XCONT();
-            break;
+            return OP_XCONT;
         case p2_REP:
-            cycles = op_REP();
-            break;
+            return OP_REP;
         default:
             Q_ASSERT_X(false, "p2_inst8_e", "XCONT/REP");
         }
         break;
 
     case p2_COGINIT:
-        cycles = op_COGINIT();
-        break;
+        return OP_COGINIT;
 
     case p2_QMUL_QDIV:
         switch (IR.op8.inst) {
         case p2_QMUL:
-            cycles = op_QMUL();
-            break;
+            return OP_QMUL;
         case p2_QDIV:
-            cycles = op_QDIV();
-            break;
+            return OP_QDIV;
         default:
             Q_ASSERT_X(false, "p2_inst8_e", "QMUL/QDIV");
         }
@@ -1941,11 +3331,9 @@ int P2Cog::get()
     case p2_QFRAC_QSQRT:
         switch (IR.op8.inst) {
         case p2_QFRAC:
-            cycles = op_QFRAC();
-            break;
+            return OP_QFRAC;
         case p2_QSQRT:
-            cycles = op_QSQRT();
-            break;
+            return OP_QSQRT;
         default:
             Q_ASSERT_X(false, "p2_inst8_e", "QFRAC/QSQRT");
         }
@@ -1954,11 +3342,9 @@ int P2Cog::get()
     case p2_QROTATE_QVECTOR:
         switch (IR.op8.inst) {
         case p2_QROTATE:
-            cycles = op_QROTATE();
-            break;
+            return OP_QROTATE;
         case p2_QVECTOR:
-            cycles = op_QVECTOR();
-            break;
+            return OP_QVECTOR;
         default:
             Q_ASSERT_X(false, "p2_inst8_e", "QROTATE/QVECTOR");
         }
@@ -1967,564 +3353,577 @@ int P2Cog::get()
     case p2_OPSRC:
         switch (IR.op7.src) {
         case p2_OPSRC_HUBSET:
-            cycles = op_HUBSET();
-            break;
+            return OP_HUBSET;
         case p2_OPSRC_COGID:
-            cycles = op_COGID();
-            break;
+            return OP_COGID;
         case p2_OPSRC_COGSTOP:
-            cycles = op_COGSTOP();
-            break;
+            return OP_COGSTOP;
         case p2_OPSRC_LOCKNEW:
-            cycles = op_LOCKNEW();
-            break;
+            return OP_LOCKNEW;
         case p2_OPSRC_LOCKRET:
-            cycles = op_LOCKRET();
-            break;
+            return OP_LOCKRET;
         case p2_OPSRC_LOCKTRY:
-            cycles = op_LOCKTRY();
-            break;
+            return OP_LOCKTRY;
         case p2_OPSRC_LOCKREL:
-            cycles = op_LOCKREL();
-            break;
+            return OP_LOCKREL;
         case p2_OPSRC_QLOG:
-            cycles = op_QLOG();
-            break;
+            return OP_QLOG;
         case p2_OPSRC_QEXP:
-            cycles = op_QEXP();
-            break;
+            return OP_QEXP;
         case p2_OPSRC_RFBYTE:
-            cycles = op_RFBYTE();
-            break;
+            return OP_RFBYTE;
         case p2_OPSRC_RFWORD:
-            cycles = op_RFWORD();
-            break;
+            return OP_RFWORD;
         case p2_OPSRC_RFLONG:
-            cycles = op_RFLONG();
-            break;
+            return OP_RFLONG;
         case p2_OPSRC_RFVAR:
-            cycles = op_RFVAR();
-            break;
+            return OP_RFVAR;
         case p2_OPSRC_RFVARS:
-            cycles = op_RFVARS();
-            break;
+            return OP_RFVARS;
         case p2_OPSRC_WFBYTE:
-            cycles = op_WFBYTE();
-            break;
+            return OP_WFBYTE;
         case p2_OPSRC_WFWORD:
-            cycles = op_WFWORD();
-            break;
+            return OP_WFWORD;
         case p2_OPSRC_WFLONG:
-            cycles = op_WFLONG();
-            break;
+            return OP_WFLONG;
         case p2_OPSRC_GETQX:
-            cycles = op_GETQX();
-            break;
+            return OP_GETQX;
         case p2_OPSRC_GETQY:
-            cycles = op_GETQY();
-            break;
+            return OP_GETQY;
         case p2_OPSRC_GETCT:
-            cycles = op_GETCT();
-            break;
+            return OP_GETCT;
         case p2_OPSRC_GETRND:
             if (0 == IR.op7.dst) {
-                cycles = op_GETRND_CZ();
-                break;
+                return OP_GETRND_CZ;
             }
-            cycles = op_GETRND();
-            break;
+            return OP_GETRND;
         case p2_OPSRC_SETDACS:
-            cycles = op_SETDACS();
-            break;
+            return OP_SETDACS;
         case p2_OPSRC_SETXFRQ:
-            cycles = op_SETXFRQ();
-            break;
+            return OP_SETXFRQ;
         case p2_OPSRC_GETXACC:
-            cycles = op_GETACC();
-            break;
+            return OP_GETACC;
         case p2_OPSRC_WAITX:
-            cycles = op_WAITX();
-            break;
+            return OP_WAITX;
         case p2_OPSRC_SETSE1:
-            cycles = op_SETSE1();
-            break;
+            return OP_SETSE1;
         case p2_OPSRC_SETSE2:
-            cycles = op_SETSE2();
-            break;
+            return OP_SETSE2;
         case p2_OPSRC_SETSE3:
-            cycles = op_SETSE3();
-            break;
+            return OP_SETSE3;
         case p2_OPSRC_SETSE4:
-            cycles = op_SETSE4();
-            break;
+            return OP_SETSE4;
         case p2_OPSRC_X24:
             switch (IR.op7.dst) {
             case p2_OPX24_POLLINT:
-                cycles = op_POLLINT();
-                break;
+                return OP_POLLINT;
             case p2_OPX24_POLLCT1:
-                cycles = op_POLLCT1();
-                break;
+                return OP_POLLCT1;
             case p2_OPX24_POLLCT2:
-                cycles = op_POLLCT2();
-                break;
+                return OP_POLLCT2;
             case p2_OPX24_POLLCT3:
-                cycles = op_POLLCT3();
-                break;
+                return OP_POLLCT3;
             case p2_OPX24_POLLSE1:
-                cycles = op_POLLSE1();
-                break;
+                return OP_POLLSE1;
             case p2_OPX24_POLLSE2:
-                cycles = op_POLLSE2();
-                break;
+                return OP_POLLSE2;
             case p2_OPX24_POLLSE3:
-                cycles = op_POLLSE3();
-                break;
+                return OP_POLLSE3;
             case p2_OPX24_POLLSE4:
-                cycles = op_POLLSE4();
-                break;
+                return OP_POLLSE4;
             case p2_OPX24_POLLPAT:
-                cycles = op_POLLPAT();
-                break;
+                return OP_POLLPAT;
             case p2_OPX24_POLLFBW:
-                cycles = op_POLLFBW();
-                break;
+                return OP_POLLFBW;
             case p2_OPX24_POLLXMT:
-                cycles = op_POLLXMT();
-                break;
+                return OP_POLLXMT;
             case p2_OPX24_POLLXFI:
-                cycles = op_POLLXFI();
-                break;
+                return OP_POLLXFI;
             case p2_OPX24_POLLXRO:
-                cycles = op_POLLXRO();
-                break;
+                return OP_POLLXRO;
             case p2_OPX24_POLLXRL:
-                cycles = op_POLLXRL();
-                break;
+                return OP_POLLXRL;
             case p2_OPX24_POLLATN:
-                cycles = op_POLLATN();
-                break;
+                return OP_POLLATN;
             case p2_OPX24_POLLQMT:
-                cycles = op_POLLQMT();
-                break;
+                return OP_POLLQMT;
             case p2_OPX24_WAITINT:
-                cycles = op_WAITINT();
-                break;
+                return OP_WAITINT;
             case p2_OPX24_WAITCT1:
-                cycles = op_WAITCT1();
-                break;
+                return OP_WAITCT1;
             case p2_OPX24_WAITCT2:
-                cycles = op_WAITCT2();
-                break;
+                return OP_WAITCT2;
             case p2_OPX24_WAITCT3:
-                cycles = op_WAITCT3();
-                break;
+                return OP_WAITCT3;
             case p2_OPX24_WAITSE1:
-                cycles = op_WAITSE1();
-                break;
+                return OP_WAITSE1;
             case p2_OPX24_WAITSE2:
-                cycles = op_WAITSE2();
-                break;
+                return OP_WAITSE2;
             case p2_OPX24_WAITSE3:
-                cycles = op_WAITSE3();
-                break;
+                return OP_WAITSE3;
             case p2_OPX24_WAITSE4:
-                cycles = op_WAITSE4();
-                break;
+                return OP_WAITSE4;
             case p2_OPX24_WAITPAT:
-                cycles = op_WAITPAT();
-                break;
+                return OP_WAITPAT;
             case p2_OPX24_WAITFBW:
-                cycles = op_WAITFBW();
-                break;
+                return OP_WAITFBW;
             case p2_OPX24_WAITXMT:
-                cycles = op_WAITXMT();
-                break;
+                return OP_WAITXMT;
             case p2_OPX24_WAITXFI:
-                cycles = op_WAITXFI();
-                break;
+                return OP_WAITXFI;
             case p2_OPX24_WAITXRO:
-                cycles = op_WAITXRO();
-                break;
+                return OP_WAITXRO;
             case p2_OPX24_WAITXRL:
-                cycles = op_WAITXRL();
-                break;
+                return OP_WAITXRL;
             case p2_OPX24_WAITATN:
-                cycles = op_WAITATN();
-                break;
+                return OP_WAITATN;
             case p2_OPX24_ALLOWI:
-                cycles = op_ALLOWI();
-                break;
+                return OP_ALLOWI;
             case p2_OPX24_STALLI:
-                cycles = op_STALLI();
-                break;
+                return OP_STALLI;
             case p2_OPX24_TRGINT1:
-                cycles = op_TRGINT1();
-                break;
+                return OP_TRGINT1;
             case p2_OPX24_TRGINT2:
-                cycles = op_TRGINT2();
-                break;
+                return OP_TRGINT2;
             case p2_OPX24_TRGINT3:
-                cycles = op_TRGINT3();
-                break;
+                return OP_TRGINT3;
             case p2_OPX24_NIXINT1:
-                cycles = op_NIXINT1();
-                break;
+                return OP_NIXINT1;
             case p2_OPX24_NIXINT2:
-                cycles = op_NIXINT2();
-                break;
+                return OP_NIXINT2;
             case p2_OPX24_NIXINT3:
-                cycles = op_NIXINT3();
-                break;
+                return OP_NIXINT3;
             }
             break;
         case p2_OPSRC_SETINT1:
-            cycles = op_SETINT1();
-            break;
+            return OP_SETINT1;
         case p2_OPSRC_SETINT2:
-            cycles = op_SETINT2();
-            break;
+            return OP_SETINT2;
         case p2_OPSRC_SETINT3:
-            cycles = op_SETINT3();
-            break;
+            return OP_SETINT3;
         case p2_OPSRC_SETQ:
-            cycles = op_SETQ();
-            break;
+            return OP_SETQ;
         case p2_OPSRC_SETQ2:
-            cycles = op_SETQ2();
-            break;
+            return OP_SETQ2;
         case p2_OPSRC_PUSH:
-            cycles = op_PUSH();
-            break;
+            return OP_PUSH;
         case p2_OPSRC_POP:
-            cycles = op_POP();
-            break;
+            return OP_POP;
         case p2_OPSRC_JMP:
-            cycles = op_JMP();
-            break;
+            return OP_JMP;
         case p2_OPSRC_CALL_RET:
             if (false == IR.op7.im) {
-                cycles = op_CALL();
-                break;
+                return OP_CALL;
             }
-            cycles = op_RET();
-            break;
+            return OP_RET;
         case p2_OPSRC_CALLA_RETA:
             if (false == IR.op7.im) {
-                cycles = op_CALLA();
-                break;
+                return OP_CALLA;
             }
-            cycles = op_RETA();
-            break;
+            return OP_RETA;
         case p2_OPSRC_CALLB_RETB:
             if (false == IR.op7.im) {
-                cycles = op_CALLB();
-                break;
+                return OP_CALLB;
             }
-            cycles = op_RETB();
-            break;
+            return OP_RETB;
         case p2_OPSRC_JMPREL:
-            cycles = op_JMPREL();
-            break;
+            return OP_JMPREL;
         case p2_OPSRC_SKIP:
-            cycles = op_SKIP();
-            break;
+            return OP_SKIP;
         case p2_OPSRC_SKIPF:
-            cycles = op_SKIPF();
-            break;
+            return OP_SKIPF;
         case p2_OPSRC_EXECF:
-            cycles = op_EXECF();
-            break;
+            return OP_EXECF;
         case p2_OPSRC_GETPTR:
-            cycles = op_GETPTR();
-            break;
+            return OP_GETPTR;
         case p2_OPSRC_COGBRK:
             switch (IR.op9.inst) {
             case p2_COGBRK:
-                cycles = op_COGBRK();
-                break;
+                return OP_COGBRK;
             case p2_GETBRK_WZ:
             case p2_GETBRK_WC:
             case p2_GETBRK_WCZ:
-                cycles = op_GETBRK();
-                break;
+                return OP_GETBRK;
             default:
                 Q_ASSERT_X(false, "p2_inst9_e", "COGBRK/GETBRK {WZ,WC,WCZ}");
             }
             break;
         case p2_OPSRC_BRK:
-            cycles = op_BRK();
-            break;
+            return OP_BRK;
         case p2_OPSRC_SETLUTS:
-            cycles = op_SETLUTS();
-            break;
+            return OP_SETLUTS;
         case p2_OPSRC_SETCY:
-            cycles = op_SETCY();
-            break;
+            return OP_SETCY;
         case p2_OPSRC_SETCI:
-            cycles = op_SETCI();
-            break;
+            return OP_SETCI;
         case p2_OPSRC_SETCQ:
-            cycles = op_SETCQ();
-            break;
+            return OP_SETCQ;
         case p2_OPSRC_SETCFRQ:
-            cycles = op_SETCFRQ();
-            break;
+            return OP_SETCFRQ;
         case p2_OPSRC_SETCMOD:
-            cycles = op_SETCMOD();
-            break;
+            return OP_SETCMOD;
         case p2_OPSRC_SETPIV:
-            cycles = op_SETPIV();
-            break;
+            return OP_SETPIV;
         case p2_OPSRC_SETPIX:
-            cycles = op_SETPIX();
-            break;
+            return OP_SETPIX;
         case p2_OPSRC_COGATN:
-            cycles = op_COGATN();
-            break;
+            return OP_COGATN;
         case p2_OPSRC_TESTP_W_DIRL:
-            cycles = (IR.op7.wc != IR.op7.wz) ? op_TESTP_W()
-                                            : op_DIRL();
-            break;
+            return (IR.op7.wc != IR.op7.wz) ? OP_TESTP_W
+                                           : OP_DIRL;
         case p2_OPSRC_TESTPN_W_DIRH:
-            cycles = (IR.op7.wc != IR.op7.wz) ? op_TESTPN_W()
-                                            : op_DIRH();
-            break;
+            return (IR.op7.wc != IR.op7.wz) ? OP_TESTPN_W
+                                           : OP_DIRH;
         case p2_OPSRC_TESTP_AND_DIRC:
-            cycles = (IR.op7.wc != IR.op7.wz) ? op_TESTP_AND()
-                                            : op_DIRC();
-            break;
+            return (IR.op7.wc != IR.op7.wz) ? OP_TESTP_AND
+                                           : OP_DIRC;
         case p2_OPSRC_TESTPN_AND_DIRNC:
-            cycles = (IR.op7.wc != IR.op7.wz) ? op_TESTPN_AND()
-                                            : op_DIRNC();
-            break;
+            return (IR.op7.wc != IR.op7.wz) ? OP_TESTPN_AND
+                                           : OP_DIRNC;
         case p2_OPSRC_TESTP_OR_DIRZ:
-            cycles = (IR.op7.wc != IR.op7.wz) ? op_TESTP_OR()
-                                            : op_DIRZ();
-            break;
+            return (IR.op7.wc != IR.op7.wz) ? OP_TESTP_OR
+                                           : OP_DIRZ;
         case p2_OPSRC_TESTPN_OR_DIRNZ:
-            cycles = (IR.op7.wc != IR.op7.wz) ? op_TESTPN_OR()
-                                            : op_DIRNZ();
-            break;
+            return (IR.op7.wc != IR.op7.wz) ? OP_TESTPN_OR
+                                           : OP_DIRNZ;
         case p2_OPSRC_TESTP_XOR_DIRRND:
-            cycles = (IR.op7.wc != IR.op7.wz) ? op_TESTP_XOR()
-                                            : op_DIRRND();
-            break;
+            return (IR.op7.wc != IR.op7.wz) ? OP_TESTP_XOR
+                                           : OP_DIRRND;
         case p2_OPSRC_TESTPN_XOR_DIRNOT:
-            cycles = (IR.op7.wc != IR.op7.wz) ? op_TESTPN_XOR()
-                                            : op_DIRNOT();
-            break;
+            return (IR.op7.wc != IR.op7.wz) ? OP_TESTPN_XOR
+                                           : OP_DIRNOT;
 
         case p2_OPSRC_OUTL:
-            cycles = op_OUTL();
-            break;
+            return OP_OUTL;
         case p2_OPSRC_OUTH:
-            cycles = op_OUTH();
-            break;
+            return OP_OUTH;
         case p2_OPSRC_OUTC:
-            cycles = op_OUTC();
-            break;
+            return OP_OUTC;
         case p2_OPSRC_OUTNC:
-            cycles = op_OUTNC();
-            break;
+            return OP_OUTNC;
         case p2_OPSRC_OUTZ:
-            cycles = op_OUTZ();
-            break;
+            return OP_OUTZ;
         case p2_OPSRC_OUTNZ:
-            cycles = op_OUTNZ();
-            break;
+            return OP_OUTNZ;
         case p2_OPSRC_OUTRND:
-            cycles = op_OUTRND();
-            break;
+            return OP_OUTRND;
         case p2_OPSRC_OUTNOT:
-            cycles = op_OUTNOT();
-            break;
+            return OP_OUTNOT;
 
         case p2_OPSRC_FLTL:
-            cycles = op_FLTL();
-            break;
+            return OP_FLTL;
         case p2_OPSRC_FLTH:
-            cycles = op_FLTH();
-            break;
+            return OP_FLTH;
         case p2_OPSRC_FLTC:
-            cycles = op_FLTC();
-            break;
+            return OP_FLTC;
         case p2_OPSRC_FLTNC:
-            cycles = op_FLTNC();
-            break;
+            return OP_FLTNC;
         case p2_OPSRC_FLTZ:
-            cycles = op_FLTZ();
-            break;
+            return OP_FLTZ;
         case p2_OPSRC_FLTNZ:
-            cycles = op_FLTNZ();
-            break;
+            return OP_FLTNZ;
         case p2_OPSRC_FLTRND:
-            cycles = op_FLTRND();
-            break;
+            return OP_FLTRND;
         case p2_OPSRC_FLTNOT:
-            cycles = op_FLTNOT();
-            break;
+            return OP_FLTNOT;
 
         case p2_OPSRC_DRVL:
-            cycles = op_DRVL();
-            break;
+            return OP_DRVL;
         case p2_OPSRC_DRVH:
-            cycles = op_DRVH();
-            break;
+            return OP_DRVH;
         case p2_OPSRC_DRVC:
-            cycles = op_DRVC();
-            break;
+            return OP_DRVC;
         case p2_OPSRC_DRVNC:
-            cycles = op_DRVNC();
-            break;
+            return OP_DRVNC;
         case p2_OPSRC_DRVZ:
-            cycles = op_DRVZ();
-            break;
+            return OP_DRVZ;
         case p2_OPSRC_DRVNZ:
-            cycles = op_DRVNZ();
-            break;
+            return OP_DRVNZ;
         case p2_OPSRC_DRVRND:
-            cycles = op_DRVRND();
-            break;
+            return OP_DRVRND;
         case p2_OPSRC_DRVNOT:
-            cycles = op_DRVNOT();
-            break;
+            return OP_DRVNOT;
 
         case p2_OPSRC_SPLITB:
-            cycles = op_SPLITB();
-            break;
+            return OP_SPLITB;
         case p2_OPSRC_MERGEB:
-            cycles = op_MERGEB();
-            break;
+            return OP_MERGEB;
         case p2_OPSRC_SPLITW:
-            cycles = op_SPLITW();
-            break;
+            return OP_SPLITW;
         case p2_OPSRC_MERGEW:
-            cycles = op_MERGEW();
-            break;
+            return OP_MERGEW;
         case p2_OPSRC_SEUSSF:
-            cycles = op_SEUSSF();
-            break;
+            return OP_SEUSSF;
         case p2_OPSRC_SEUSSR:
-            cycles = op_SEUSSR();
-            break;
+            return OP_SEUSSR;
         case p2_OPSRC_RGBSQZ:
-            cycles = op_RGBSQZ();
-            break;
+            return OP_RGBSQZ;
         case p2_OPSRC_RGBEXP:
-            cycles = op_RGBEXP();
-            break;
+            return OP_RGBEXP;
         case p2_OPSRC_XORO32:
-            cycles = op_XORO32();
-            break;
+            return OP_XORO32;
         case p2_OPSRC_REV:
-            cycles = op_REV();
-            break;
+            return OP_REV;
         case p2_OPSRC_RCZR:
-            cycles = op_RCZR();
-            break;
+            return OP_RCZR;
         case p2_OPSRC_RCZL:
-            cycles = op_RCZL();
-            break;
+            return OP_RCZL;
         case p2_OPSRC_WRC:
-            cycles = op_WRC();
-            break;
+            return OP_WRC;
         case p2_OPSRC_WRNC:
-            cycles = op_WRNC();
-            break;
+            return OP_WRNC;
         case p2_OPSRC_WRZ:
-            cycles = op_WRZ();
-            break;
+            return OP_WRZ;
         case p2_OPSRC_WRNZ_MODCZ:
-            cycles = (IR.op7.wc || IR.op7.wz) ? op_MODCZ()
-                                            : op_WRNZ();
-            break;
+            return (IR.op7.wc || IR.op7.wz) ? OP_MODCZ
+                                           : OP_WRNZ;
         case p2_OPSRC_SETSCP:
-            cycles = op_SETSCP();
-            break;
+            return OP_SETSCP;
         case p2_OPSRC_GETSCP:
-            cycles = op_GETSCP();
-            break;
+            return OP_GETSCP;
         }
         break;
 
     case p2_JMP_ABS:
-        cycles = op_JMP_ABS();
-        break;
+        return OP_JMP_ABS;
 
     case p2_CALL_ABS:
-        cycles = op_CALL_ABS();
-        break;
+        return OP_CALL_ABS;
 
     case p2_CALLA_ABS:
-        cycles = op_CALLA_ABS();
-        break;
+        return OP_CALLA_ABS;
 
     case p2_CALLB_ABS:
-        cycles = op_CALLB_ABS();
-        break;
+        return OP_CALLB_ABS;
 
     case p2_CALLD_ABS_PA:
-        cycles = op_CALLD_ABS_PA();
-        break;
+        return OP_CALLD_ABS_PA;
 
     case p2_CALLD_ABS_PB:
-        cycles = op_CALLD_ABS_PB();
-        break;
+        return OP_CALLD_ABS_PB;
 
     case p2_CALLD_ABS_PTRA:
-        cycles = op_CALLD_ABS_PTRA();
-        break;
+        return OP_CALLD_ABS_PTRA;
 
     case p2_CALLD_ABS_PTRB:
-        cycles = op_CALLD_ABS_PTRB();
-        break;
+        return OP_CALLD_ABS_PTRB;
 
     case p2_LOC_PA:
-        cycles = op_LOC_PA();
-        break;
+        return OP_LOC_PA;
 
     case p2_LOC_PB:
-        cycles = op_LOC_PB();
-        break;
+        return OP_LOC_PB;
 
     case p2_LOC_PTRA:
-        cycles = op_LOC_PTRA();
-        break;
+        return OP_LOC_PTRA;
 
     case p2_LOC_PTRB:
-        cycles = op_LOC_PTRB();
-        break;
+        return OP_LOC_PTRB;
 
     case p2_AUGS_00:
     case p2_AUGS_01:
     case p2_AUGS_10:
     case p2_AUGS_11:
-        cycles = op_AUGS();
-        break;
+        return OP_AUGS;
 
     case p2_AUGD_00:
     case p2_AUGD_01:
     case p2_AUGD_10:
     case p2_AUGD_11:
-        cycles = op_AUGD();
-        break;
+        return OP_AUGD;
     }
+    return OP_NOP;
+}
+
+//! dispatch table first level entry is a p2_op_e value
+static constexpr p2_WORD DISPATCH_OP = 0x0000;
+//! dispatch table first level entry selects a second level table indexed by S
+static constexpr p2_WORD DISPATCH_SRC = 0x4000;
+//! dispatch table first level entry selects a second level table indexed by D
+static constexpr p2_WORD DISPATCH_DST = 0x8000;
+//! dispatch table entry requires decode()
+static constexpr p2_WORD DISPATCH_DECODE = 0xc000;
+//! dispatch table mask for the entry kind
+static constexpr p2_WORD DISPATCH_KIND = 0xc000;
+//! number of first level dispatch table entries, i.e. instruction bits [27:18]
+static constexpr p2_LONG DISPATCH_SIZE = 1u << 10;
+
+/**
+ * @brief Build the flat dispatch table from decode()
+ *
+ * The first level has one entry per instruction bits [27:18], i.e. the
+ * 7 bit instruction and the C, Z, and I flags. Most entries directly
+ * are the p2_op_e of the instruction. Where decode() also looks at the
+ * S or D field, the entry selects a second level table of 512 entries
+ * indexed by that field, which follow the first level table.
+ * Any combination that depends on both fields, e.g. "DECOD D" being
+ * encoded as "DECOD D,D", is marked DISPATCH_DECODE and left to decode().
+ *
+ * The table is generated from decode() by dispatch() when it is first
+ * used, so it can not get out of sync with decode().
+ *
+ * @return vector of first and second level table entries
+ */
+QVector<p2_WORD> P2Cog::build_dispatch()
+{
+    const int first = static_cast<int>(DISPATCH_SIZE);
+    const int size = static_cast<int>(COG_SIZE);
+    QVector<p2_WORD> table(first, DISPATCH_DECODE);
+    QVector<p2_WORD> grid(size * size);
+    p2_opcode_u IR;
+
+    for (int prefix = 0; prefix < first; prefix++) {
+        IR.opcode = static_cast<p2_LONG>(prefix << 18);
+        const p2_op_e op0 = decode(IR);
+        bool direct = true;
+
+        // Quick check for instructions which ignore S and D
+        for (int n = 0; direct && n < size; n++) {
+            static const int fixed[] = {0x000, 0x001, 0x164, 0x1ff};
+            for (size_t i = 0; i < sizeof(fixed)/sizeof(fixed[0]); i++) {
+                IR.opcode = static_cast<p2_LONG>((prefix << 18) | (fixed[i] << 9) | n);
+                direct = direct && decode(IR) == op0;
+                IR.opcode = static_cast<p2_LONG>((prefix << 18) | (n << 9) | fixed[i]);
+                direct = direct && decode(IR) == op0;
+            }
+            IR.opcode = static_cast<p2_LONG>((prefix << 18) | (n << 9) | n);
+            direct = direct && decode(IR) == op0;
+        }
+        if (direct) {
+            table[prefix] = static_cast<p2_WORD>(DISPATCH_OP | op0);
+            continue;
+        }
 
-    // Handle REP instructions
-    if (IR.op8.inst != p2_REP && REP_instr.isValid()) {
-        p2_LONG instr = REP_instr.toUInt();
-        // qDebug("%s: repeat %u instructions %u times", __func__, instr, REP_times);
-        if (++REP_offset == instr) {
-            if (REP_times == 0 || --REP_times > 0) {
-                PC = PC - (PC < 0x400 ? instr : 4 * instr);
-                REP_offset = 0;
+        // Decode all S and D combinations
+        for (int dst = 0; dst < size; dst++) {
+            for (int src = 0; src < size; src++) {
+                IR.opcode = static_cast<p2_LONG>((prefix << 18) | (dst << 9) | src);
+                grid[dst * size + src] = static_cast<p2_WORD>(decode(IR));
+            }
+        }
+
+        // Second level tables indexed by S and by D
+        QVector<p2_WORD> by_src(size), by_dst(size);
+        int src_missing = 0, dst_missing = 0;
+        for (int n = 0; n < size; n++) {
+            p2_WORD src_op = grid[n];
+            p2_WORD dst_op = grid[n * size];
+            for (int m = 0; m < size; m++) {
+                if (grid[m * size + n] != src_op)
+                    src_op = DISPATCH_DECODE;
+                if (grid[n * size + m] != dst_op)
+                    dst_op = DISPATCH_DECODE;
             }
+            by_src[n] = src_op;
+            by_dst[n] = dst_op;
+            src_missing += DISPATCH_DECODE == src_op;
+            dst_missing += DISPATCH_DECODE == dst_op;
+        }
 
+        const int index = (table.count() - first) / size;
+        if (src_missing <= dst_missing && src_missing < size) {
+            table[prefix] = static_cast<p2_WORD>(DISPATCH_SRC | index);
+            table += by_src;
+        } else if (dst_missing < size) {
+            table[prefix] = static_cast<p2_WORD>(DISPATCH_DST | index);
+            table += by_dst;
         }
     }
+    return table;
+}
 
-    return cycles;
+/**
+ * @brief Return the flat dispatch table, building it on first use
+ *
+ * Building takes a noticeable time, so it is not done at static
+ * initialization, but only once an instruction is decoded through the
+ * table, e.g. not with "--dispatch switch" or in a GUI without a program.
+ *
+ * @return const reference to the dispatch table
+ */
+const QVector<p2_WORD>& P2Cog::dispatch()
+{
+    static const QVector<p2_WORD> table = build_dispatch();
+    return table;
+}
+
+/**
+ * @brief Look up the op_xxx() function for an opcode in the dispatch table
+ * @param opcode instruction opcode
+ * @return enumeration value of the op_xxx() function
+ */
+P2Cog::p2_op_e P2Cog::lookup(p2_LONG opcode)
+{
+    const p2_WORD* table = dispatch().constData();
+    p2_WORD entry = table[(opcode >> 18) & (DISPATCH_SIZE - 1)];
+    switch (entry & DISPATCH_KIND) {
+    case DISPATCH_SRC:
+        entry = table[DISPATCH_SIZE + (entry & ~DISPATCH_KIND) * COG_SIZE + (opcode & COG_MASK)];
+        break;
+    case DISPATCH_DST:
+        entry = table[DISPATCH_SIZE + (entry & ~DISPATCH_KIND) * COG_SIZE + ((opcode >> 9) & COG_MASK)];
+        break;
+    }
+    if (DISPATCH_DECODE == entry) {
+        p2_opcode_u IR;
+        IR.opcode = opcode;
+        return decode(IR);
+    }
+    return static_cast<p2_op_e>(entry);
+}
+
+/**
+ * @brief Return the index of the op_xxx() function for an opcode
+ *
+ * Depending on set_dispatch_table() the opcode is decoded through
+ * the dispatch table or with decode().
+ *
+ * @param opcode instruction opcode
+ * @return index of the op_xxx() function in the P2_COG_OPS() list
+ */
+int P2Cog::opindex(p2_LONG opcode)
+{
+    if (use_dispatch)
+        return lookup(opcode);
+    p2_opcode_u IR;
+    IR.opcode = opcode;
+    return decode(IR);
+}
+
+/**
+ * @brief Return the name of an op_xxx() function
+ * @param index index of the function in the P2_COG_OPS() list, e.g. from opindex()
+ * @return name in upper case, or nullptr if %index is out of range
+ */
+const char* P2Cog::opname(int index)
+{
+#define P2_OP_NAME(name) #name,
+    static const char* const names[OP_COUNT] = { P2_COG_OPS(P2_OP_NAME) };
+#undef P2_OP_NAME
+    if (index < 0 || index >= OP_COUNT)
+        return nullptr;
+    return names[index];
+}
+
+/**
+ * @brief Return true, if instructions are decoded through the dispatch table
+ * @return true if the dispatch table is used, false if decode() is used
+ */
+bool P2Cog::dispatch_table()
+{
+    return use_dispatch;
+}
+
+/**
+ * @brief Select decoding instructions through the dispatch table or decode()
+ *
+ * This is mostly useful to compare the dispatch cost of both methods.
+ *
+ * @param on if true, use the dispatch table
+ */
+void P2Cog::set_dispatch_table(bool on)
+{
+    use_dispatch = on;
 }
 
 /**
@@ -2560,7 +3959,7 @@ int P2Cog::op_ROR()
     const uchar shift = S & 31;
     const p2_QUAD accu = U64(D) << 32 | U64(D);
     const p2_LONG result = U32L(accu >> shift);
-    updateC((D & (LSB << shift)) != 0);
+    updateC(shift ? (D >> (shift - 1)) & 1 : D & 1);
     updateZ(0 == result);
     updateD(result);
     return 1;
@@ -2584,7 +3983,7 @@ int P2Cog::op_ROL()
     const uchar shift = S & 31;
     const p2_QUAD accu = U64(D) << 32 | U64(D);
     const p2_LONG result = U32H(accu << shift);
-    updateC((D & (MSB >> shift)) != 0);
+    updateC(shift ? (D << (shift - 1)) >> 31 : D >> 31);
     updateZ(0 == result);
     updateD(result);
     return 1;
@@ -2608,7 +4007,7 @@ int P2Cog::op_SHR()
     const uchar shift = S & 31;
     const p2_QUAD accu = U64(D);
     const p2_LONG result = U32L(accu >> shift);
-    updateC((D & (LSB << shift)) != 0);
+    updateC(shift ? (D >> (shift - 1)) & 1 : D & 1);
     updateZ(0 == result);
     updateD(result);
     return 1;
@@ -2632,7 +4031,7 @@ int P2Cog::op_SHL()
     const uchar shift = S & 31;
     const p2_QUAD accu = U64(D) << 32;
     const p2_LONG result = U32H(accu << shift);
-    updateC((D & (MSB >> shift)) != 0);
+    updateC(shift ? (D << (shift - 1)) >> 31 : D >> 31);
     updateZ(0 == result);
     updateD(result);
     return 1;
@@ -2654,9 +4053,9 @@ int P2Cog::op_RCR()
 {
     augmentS(IR.op7.im);
     const uchar shift = S & 31;
-    const p2_QUAD accu = U64(D) | C ? HMAX : 0;
+    const p2_QUAD accu = U64(D) | (C ? HMAX : 0);
     const p2_LONG result = U32L(accu >> shift);
-    updateC((D & (LSB << shift)) != 0);
+    updateC(shift ? (D >> (shift - 1)) & 1 : D & 1);
     updateZ(0 == result);
     updateD(result);
     return 1;
@@ -2678,9 +4077,9 @@ int P2Cog::op_RCL()
 {
     augmentS(IR.op7.im);
     const uchar shift = S & 31;
-    const p2_QUAD accu = U64(D) << 32 | C ? LMAX : 0;
+    const p2_QUAD accu = U64(D) << 32 | (C ? LMAX : 0);
     const p2_LONG result = U32H(accu << shift);
-    updateC((D & (MSB >> shift)) != 0);
+    updateC(shift ? (D << (shift - 1)) >> 31 : D >> 31);
     updateZ(0 == result);
     updateD(result);
     return 1;
@@ -2702,9 +4101,9 @@ int P2Cog::op_SAR()
 {
     augmentS(IR.op7.im);
     const uchar shift = S & 31;
-    const p2_QUAD accu = U64(D) | (D & MSB) ? HMAX : 0;
+    const p2_QUAD accu = U64(D) | ((D & MSB) ? HMAX : 0);
     const p2_LONG result = U32L(accu >> shift);
-    updateC((D & (LSB << shift)) != 0);
+    updateC(shift ? (D >> (shift - 1)) & 1 : D & 1);
     updateZ(0 == result);
     updateD(result);
     return 1;
@@ -2726,9 +4125,9 @@ int P2Cog::op_SAL()
 {
     augmentS(IR.op7.im);
     const uchar shift = S & 31;
-    const p2_QUAD accu = U64(D) << 32 | (D & LSB) ? LMAX : 0;
+    const p2_QUAD accu = U64(D) << 32 | ((D & LSB) ? LMAX : 0);
     const p2_LONG result = U32H(accu << shift);
-    updateC((D & (MSB >> shift)) != 0);
+    updateC(shift ? (D << (shift - 1)) >> 31 : D >> 31);
     updateZ(0 == result);
     updateD(result);
     return 1;
@@ -3637,6 +5036,7 @@ int P2Cog::op_AND()
     const p2_LONG result = D & S;
     updateC(P2Util::parity(result));
     updateZ(0 == result);
+    updateD(result);
     return 1;
 }
 
@@ -3658,6 +5058,7 @@ int P2Cog::op_ANDN()
     const p2_LONG result = D & ~S;
     updateC(P2Util::parity(result));
     updateZ(0 == result);
+    updateD(result);
     return 1;
 }
 
@@ -3679,6 +5080,7 @@ int P2Cog::op_OR()
     const p2_LONG result = D | S;
     updateC(P2Util::parity(result));
     updateZ(0 == result);
+    updateD(result);
     return 1;
 }
 
@@ -3700,6 +5102,7 @@ int P2Cog::op_XOR()
     const p2_LONG result = D ^ S;
     updateC(P2Util::parity(result));
     updateZ(0 == result);
+    updateD(result);
     return 1;
 }
 
@@ -5069,6 +6472,7 @@ int P2Cog::op_SCA()
     const p2_LONG result = (U16(D) * U16(S)) >> 16;
     updateZ(0 == result);
     S_next = result;
+    VALID |= VALID_S_next;
     return 1;
 }
 
@@ -5089,6 +6493,7 @@ int P2Cog::op_SCAS()
     const p2_LONG result = static_cast<p2_LONG>((S16(D) * S16(S)) >> 14);
     updateZ(0 == result);
     S_next = result;
+    VALID |= VALID_S_next;
     return 1;
 }
 
@@ -5103,17 +6508,7 @@ int P2Cog::op_SCAS()
 int P2Cog::op_ADDPIX()
 {
     augmentS(IR.op7.im);
-    union {
-        p2_LONG l;
-        p2_BYTE b[4];
-    }   dst, src;
-    dst.l = D;
-    src.l = S;
-    dst.b[0] = qMin<p2_BYTE>(dst.b[0] + src.b[0], 0xff);
-    dst.b[1] = qMin<p2_BYTE>(dst.b[1] + src.b[1], 0xff);
-    dst.b[2] = qMin<p2_BYTE>(dst.b[2] + src.b[2], 0xff);
-    dst.b[3] = qMin<p2_BYTE>(dst.b[3] + src.b[3], 0xff);
-    updateD(dst.l);
+    updateD(P2Pixel::addpix(D, S));
     return 1;
 }
 
@@ -5128,6 +6523,7 @@ int P2Cog::op_ADDPIX()
 int P2Cog::op_MULPIX()
 {
     augmentS(IR.op7.im);
+    updateD(P2Pixel::mulpix(D, S));
     return 1;
 }
 
@@ -5142,6 +6538,7 @@ int P2Cog::op_MULPIX()
 int P2Cog::op_BLNPIX()
 {
     augmentS(IR.op7.im);
+    updateD(P2Pixel::blnpix(D, S, PIX));
     return 1;
 }
 
@@ -5156,6 +6553,7 @@ int P2Cog::op_BLNPIX()
 int P2Cog::op_MIXPIX()
 {
     augmentS(IR.op7.im);
+    updateD(P2Pixel::mixpix(D, S, PIX));
     return 1;
 }
 
@@ -5172,6 +6570,10 @@ int P2Cog::op_MIXPIX()
 int P2Cog::op_ADDCT1()
 {
     augmentS(IR.op7.im);
+    const p2_LONG result = D + S;
+    CT1 = result;
+    FLAGS.f_CT1 = false;
+    updateD(result);
     return 1;
 }
 
@@ -5188,6 +6590,10 @@ int P2Cog::op_ADDCT1()
 int P2Cog::op_ADDCT2()
 {
     augmentS(IR.op7.im);
+    const p2_LONG result = D + S;
+    CT2 = result;
+    FLAGS.f_CT2 = false;
+    updateD(result);
     return 1;
 }
 
@@ -5204,6 +6610,10 @@ int P2Cog::op_ADDCT2()
 int P2Cog::op_ADDCT3()
 {
     augmentS(IR.op7.im);
+    const p2_LONG result = D + S;
+    CT3 = result;
+    FLAGS.f_CT3 = false;
+    updateD(result);
     return 1;
 }
 
@@ -5219,7 +6629,20 @@ int P2Cog::op_ADDCT3()
  */
 int P2Cog::op_WMLONG()
 {
+    const bool ptr = IR.op7.im && !(VALID & VALID_S_aug) && (IR.op7.src & 0x100);
     augmentS(IR.op7.im);
+    const p2_LONG count = burst_count();
+    const p2_LONG address = hub_address(ptr, 2, count);
+    hub_stall(address, count, true);
+    if (count) {
+        burst_write(address, count, true);
+        return 1;
+    }
+    for (p2_LONG i = 0; i < sz_LONG; i++) {
+        const p2_BYTE result = static_cast<p2_BYTE>(D >> (8 * i));
+        if (result)
+            HUB->wr_BYTE(address + i, result);
+    }
     return 1;
 }
 
@@ -5236,6 +6659,10 @@ int P2Cog::op_WMLONG()
 int P2Cog::op_RQPIN()
 {
     augmentS(IR.op7.im);
+    bool c = false;
+    const p2_LONG result = HUB->rdpin(S, c, false);
+    updateC(c);
+    updateD(result);
     return 1;
 }
 
@@ -5252,6 +6679,10 @@ int P2Cog::op_RQPIN()
 int P2Cog::op_RDPIN()
 {
     augmentS(IR.op7.im);
+    bool c = false;
+    const p2_LONG result = HUB->rdpin(S, c, true);
+    updateC(c);
+    updateD(result);
     return 1;
 }
 
@@ -5275,6 +6706,8 @@ int P2Cog::op_RDLUT()
     } else if (S == offs_PTRB) {
         result = HUB->rd_LONG(COG.REG.PTRB);
     } else {
+        if (BREAK && BREAK->test(p2_BREAK_READ, p2_BREAK_LUT, S))
+            BREAK->record(p2_BREAK_READ, p2_BREAK_LUT, S & LUT_MASK, static_cast<int>(ID), IR_PC, CNT);
         result = LUT.RAM[S & 0x1ff];
     }
     updateC((result >> 31) & 1);
@@ -5296,15 +6729,11 @@ int P2Cog::op_RDLUT()
  */
 int P2Cog::op_RDBYTE()
 {
+    const bool ptr = IR.op7.im && !(VALID & VALID_S_aug) && (IR.op7.src & 0x100);
     augmentS(IR.op7.im);
-    p2_BYTE result;
-    if (S == offs_PTRA) {
-        result = HUB->rd_BYTE(COG.REG.PTRA);
-    } else if (S == offs_PTRB) {
-        result = HUB->rd_BYTE(COG.REG.PTRB);
-    } else {
-        result = HUB->rd_BYTE(S);
-    }
+    const p2_LONG address = hub_address(ptr, 0, 0);
+    const p2_BYTE result = HUB->rd_BYTE(address);
+    hub_stall(address, 0, false);
     updateC((result >> 7) & 1);
     updateZ(0 == result);
     updateD(result);
@@ -5324,15 +6753,11 @@ int P2Cog::op_RDBYTE()
  */
 int P2Cog::op_RDWORD()
 {
+    const bool ptr = IR.op7.im && !(VALID & VALID_S_aug) && (IR.op7.src & 0x100);
     augmentS(IR.op7.im);
-    p2_WORD result;
-    if (S == offs_PTRA) {
-        result = HUB->rd_WORD(COG.REG.PTRA);
-    } else if (S == offs_PTRB) {
-        result = HUB->rd_WORD(COG.REG.PTRB);
-    } else {
-        result = HUB->rd_WORD(S);
-    }
+    const p2_LONG address = hub_address(ptr, 1, 0);
+    const p2_WORD result = HUB->rd_WORD(address);
+    hub_stall(address, 0, false);
     updateC((result >> 15) & 1);
     updateZ(0 == result);
     updateD(result);
@@ -5352,16 +6777,17 @@ int P2Cog::op_RDWORD()
  */
 int P2Cog::op_RDLONG()
 {
+    const bool ptr = IR.op7.im && !(VALID & VALID_S_aug) && (IR.op7.src & 0x100);
     augmentS(IR.op7.im);
-    p2_LONG result;
-    if (S == offs_PTRA) {
-        result = HUB->rd_LONG(COG.REG.PTRA);
-    } else if (S == offs_PTRB) {
-        result = HUB->rd_LONG(COG.REG.PTRB);
-    } else {
-        result = HUB->rd_LONG(S);
+    const p2_LONG count = burst_count();
+    const p2_LONG address = hub_address(ptr, 2, count);
+    hub_stall(address, count, false);
+    if (count) {
+        burst_read(address, count);
+        return 1;
     }
-    updateC((result >> 15) & 1);
+    const p2_LONG result = HUB->rd_LONG(address);
+    updateC((result >> 31) & 1);
     updateZ(0 == result);
     updateD(result);
     return 1;
@@ -5411,7 +6837,6 @@ int P2Cog::op_POPB()
  */
 int P2Cog::op_CALLD()
 {
-    augmentS(IR.op7.im);
     if (IR.op7.wc && IR.op7.wz) {
         if (IR.op7.dst == offs_IJMP3 && IR.op7.src == offs_IRET3)
             return op_RESI3();
@@ -5430,11 +6855,12 @@ int P2Cog::op_CALLD()
         if (IR.op7.dst == offs_INB && IR.op7.src == offs_INB)
             return op_RETI0();
     }
-    const p2_LONG result = (U32(C) << 31) | (U32(Z) << 30) | PC;
+    const p2_LONG result = (U32(C) << 31) | (U32(Z) << 30) | pc2addr(PC);
+    const p2_LONG address = branchS();
     updateC((S >> 31) & 1);
     updateZ((S >> 30) & 1);
     updateD(result);
-    updatePC(S & A20MASK);
+    updatePC(address);
     return 1;
 }
 
@@ -5569,10 +6995,9 @@ int P2Cog::op_RETI0()
  */
 int P2Cog::op_CALLPA()
 {
-    augmentS(IR.op7.im);
     augmentD(IR.op7.wz);
-    const p2_LONG stack = (C << 31) | (Z << 30) | PC;
-    const p2_LONG address = S;
+    const p2_LONG stack = (C << 31) | (Z << 30) | pc2addr(PC);
+    const p2_LONG address = branchS();
     const p2_LONG result = D;
     pushK(stack);
     updatePA(result);
@@ -5591,10 +7016,9 @@ int P2Cog::op_CALLPA()
  */
 int P2Cog::op_CALLPB()
 {
-    augmentS(IR.op7.im);
     augmentD(IR.op7.wz);
-    const p2_LONG stack = (C << 31) | (Z << 30) | PC;
-    const p2_LONG address = S;
+    const p2_LONG stack = (C << 31) | (Z << 30) | pc2addr(PC);
+    const p2_LONG address = branchS();
     const p2_LONG result = D;
     pushK(stack);
     updatePB(result);
@@ -5613,9 +7037,9 @@ int P2Cog::op_CALLPB()
  */
 int P2Cog::op_DJZ()
 {
-    augmentS(IR.op7.im);
     const p2_LONG result = D - 1;
-    const p2_LONG address = S;
+    const p2_LONG address = branchS();
+    updateD(result);
     if (result == ZERO)
         updatePC(address);
     return 1;
@@ -5632,9 +7056,9 @@ int P2Cog::op_DJZ()
  */
 int P2Cog::op_DJNZ()
 {
-    augmentS(IR.op7.im);
     const p2_LONG result = D - 1;
-    const p2_LONG address = S;
+    const p2_LONG address = branchS();
+    updateD(result);
     if (result != ZERO)
         updatePC(address);
     return 1;
@@ -5651,9 +7075,9 @@ int P2Cog::op_DJNZ()
  */
 int P2Cog::op_DJF()
 {
-    augmentS(IR.op7.im);
     const p2_LONG result = D - 1;
-    const p2_LONG address = S;
+    const p2_LONG address = branchS();
+    updateD(result);
     if (result == FULL)
         updatePC(address);
     return 1;
@@ -5670,9 +7094,9 @@ int P2Cog::op_DJF()
  */
 int P2Cog::op_DJNF()
 {
-    augmentS(IR.op7.im);
     const p2_LONG result = D - 1;
-    const p2_LONG address = S;
+    const p2_LONG address = branchS();
+    updateD(result);
     if (result != FULL)
         updatePC(address);
     return 1;
@@ -5689,9 +7113,9 @@ int P2Cog::op_DJNF()
  */
 int P2Cog::op_IJZ()
 {
-    augmentS(IR.op7.im);
     const p2_LONG result = D + 1;
-    const p2_LONG address = S;
+    const p2_LONG address = branchS();
+    updateD(result);
     if (result == ZERO)
         updatePC(address);
     return 1;
@@ -5708,9 +7132,9 @@ int P2Cog::op_IJZ()
  */
 int P2Cog::op_IJNZ()
 {
-    augmentS(IR.op7.im);
     const p2_LONG result = D + 1;
-    const p2_LONG address = S;
+    const p2_LONG address = branchS();
+    updateD(result);
     if (result != ZERO)
         updatePC(address);
     return 1;
@@ -5727,9 +7151,8 @@ int P2Cog::op_IJNZ()
  */
 int P2Cog::op_TJZ()
 {
-    augmentS(IR.op7.im);
     const p2_LONG result = D;
-    const p2_LONG address = S;
+    const p2_LONG address = branchS();
     if (result == ZERO)
         updatePC(address);
     return 1;
@@ -5746,9 +7169,8 @@ int P2Cog::op_TJZ()
  */
 int P2Cog::op_TJNZ()
 {
-    augmentS(IR.op7.im);
     const p2_LONG result = D;
-    const p2_LONG address = S;
+    const p2_LONG address = branchS();
     if (result != ZERO)
         updatePC(address);
     return 1;
@@ -5765,9 +7187,8 @@ int P2Cog::op_TJNZ()
  */
 int P2Cog::op_TJF()
 {
-    augmentS(IR.op7.im);
     const p2_LONG result = D;
-    const p2_LONG address = S;
+    const p2_LONG address = branchS();
     if (result == FULL)
         updatePC(address);
     return 1;
@@ -5784,9 +7205,8 @@ int P2Cog::op_TJF()
  */
 int P2Cog::op_TJNF()
 {
-    augmentS(IR.op7.im);
     const p2_LONG result = D;
-    const p2_LONG address = S;
+    const p2_LONG address = branchS();
     if (result != FULL)
         updatePC(address);
     return 1;
@@ -5803,9 +7223,8 @@ int P2Cog::op_TJNF()
  */
 int P2Cog::op_TJS()
 {
-    augmentS(IR.op7.im);
     const p2_LONG result = D & MSB;
-    const p2_LONG address = S;
+    const p2_LONG address = branchS();
     if (result)
         updatePC(address);
     return 1;
@@ -5822,9 +7241,8 @@ int P2Cog::op_TJS()
  */
 int P2Cog::op_TJNS()
 {
-    augmentS(IR.op7.im);
     const p2_LONG result = D & MSB;
-    const p2_LONG address = S;
+    const p2_LONG address = branchS();
     if (!result)
         updatePC(address);
     return 1;
@@ -5841,9 +7259,8 @@ int P2Cog::op_TJNS()
  */
 int P2Cog::op_TJV()
 {
-    augmentS(IR.op7.im);
     const p2_LONG result = (D >> 31) ^ C;
-    const p2_LONG address = S;
+    const p2_LONG address = branchS();
     if (result)
         updatePC(address);
     return 1;
@@ -5860,8 +7277,7 @@ int P2Cog::op_TJV()
  */
 int P2Cog::op_JINT()
 {
-    augmentS(IR.op7.im);
-    const p2_LONG address = S;
+    const p2_LONG address = branchS();
     if (FLAGS.f_INT)
         updatePC(address);
     return 1;
@@ -5878,8 +7294,7 @@ int P2Cog::op_JINT()
  */
 int P2Cog::op_JCT1()
 {
-    augmentS(IR.op7.im);
-    const p2_LONG address = S;
+    const p2_LONG address = branchS();
     if (FLAGS.f_CT1)
         updatePC(address);
     return 1;
@@ -5896,8 +7311,7 @@ int P2Cog::op_JCT1()
  */
 int P2Cog::op_JCT2()
 {
-    augmentS(IR.op7.im);
-    const p2_LONG address = S;
+    const p2_LONG address = branchS();
     if (FLAGS.f_CT2)
         updatePC(address);
     return 1;
@@ -5914,8 +7328,7 @@ int P2Cog::op_JCT2()
  */
 int P2Cog::op_JCT3()
 {
-    augmentS(IR.op7.im);
-    const p2_LONG address = S;
+    const p2_LONG address = branchS();
     if (FLAGS.f_CT3)
         updatePC(address);
     return 1;
@@ -5932,8 +7345,7 @@ int P2Cog::op_JCT3()
  */
 int P2Cog::op_JSE1()
 {
-    augmentS(IR.op7.im);
-    const p2_LONG address = S;
+    const p2_LONG address = branchS();
     if (FLAGS.f_SE1)
         updatePC(address);
     return 1;
@@ -5950,8 +7362,7 @@ int P2Cog::op_JSE1()
  */
 int P2Cog::op_JSE2()
 {
-    augmentS(IR.op7.im);
-    const p2_LONG address = S;
+    const p2_LONG address = branchS();
     if (FLAGS.f_SE2)
         updatePC(address);
     return 1;
@@ -5968,8 +7379,7 @@ int P2Cog::op_JSE2()
  */
 int P2Cog::op_JSE3()
 {
-    augmentS(IR.op7.im);
-    const p2_LONG address = S;
+    const p2_LONG address = branchS();
     if (FLAGS.f_SE3)
         updatePC(address);
     return 1;
@@ -5986,8 +7396,7 @@ int P2Cog::op_JSE3()
  */
 int P2Cog::op_JSE4()
 {
-    augmentS(IR.op7.im);
-    const p2_LONG address = S;
+    const p2_LONG address = branchS();
     if (FLAGS.f_SE4)
         updatePC(address);
     return 1;
@@ -6004,8 +7413,7 @@ int P2Cog::op_JSE4()
  */
 int P2Cog::op_JPAT()
 {
-    augmentS(IR.op7.im);
-    const p2_LONG address = S;
+    const p2_LONG address = branchS();
     if (FLAGS.f_PAT)
         updatePC(address);
     return 1;
@@ -6022,8 +7430,7 @@ int P2Cog::op_JPAT()
  */
 int P2Cog::op_JFBW()
 {
-    augmentS(IR.op7.im);
-    const p2_LONG address = S;
+    const p2_LONG address = branchS();
     if (FLAGS.f_FBW)
         updatePC(address);
     return 1;
@@ -6040,8 +7447,7 @@ int P2Cog::op_JFBW()
  */
 int P2Cog::op_JXMT()
 {
-    augmentS(IR.op7.im);
-    const p2_LONG address = S;
+    const p2_LONG address = branchS();
     if (FLAGS.f_XMT)
         updatePC(address);
     return 1;
@@ -6058,8 +7464,7 @@ int P2Cog::op_JXMT()
  */
 int P2Cog::op_JXFI()
 {
-    augmentS(IR.op7.im);
-    const p2_LONG address = S;
+    const p2_LONG address = branchS();
     if (FLAGS.f_XFI)
         updatePC(address);
     return 1;
@@ -6076,8 +7481,7 @@ int P2Cog::op_JXFI()
  */
 int P2Cog::op_JXRO()
 {
-    augmentS(IR.op7.im);
-    const p2_LONG address = S;
+    const p2_LONG address = branchS();
     if (FLAGS.f_XRO)
         updatePC(address);
     return 1;
@@ -6094,8 +7498,7 @@ int P2Cog::op_JXRO()
  */
 int P2Cog::op_JXRL()
 {
-    augmentS(IR.op7.im);
-    const p2_LONG address = S;
+    const p2_LONG address = branchS();
     if (FLAGS.f_XRL)
         updatePC(address);
     return 1;
@@ -6112,8 +7515,7 @@ int P2Cog::op_JXRL()
  */
 int P2Cog::op_JATN()
 {
-    augmentS(IR.op7.im);
-    const p2_LONG address = S;
+    const p2_LONG address = branchS();
     if (FLAGS.f_ATN)
         updatePC(address);
     return 1;
@@ -6130,8 +7532,7 @@ int P2Cog::op_JATN()
  */
 int P2Cog::op_JQMT()
 {
-    augmentS(IR.op7.im);
-    const p2_LONG address = S;
+    const p2_LONG address = branchS();
     if (FLAGS.f_QMT)
         updatePC(address);
     return 1;
@@ -6148,8 +7549,7 @@ int P2Cog::op_JQMT()
  */
 int P2Cog::op_JNINT()
 {
-    augmentS(IR.op7.im);
-    const p2_LONG address = S;
+    const p2_LONG address = branchS();
     if (!FLAGS.f_INT)
         updatePC(address);
     return 1;
@@ -6166,8 +7566,7 @@ int P2Cog::op_JNINT()
  */
 int P2Cog::op_JNCT1()
 {
-    augmentS(IR.op7.im);
-    const p2_LONG address = S;
+    const p2_LONG address = branchS();
     if (!FLAGS.f_CT1)
         updatePC(address);
     return 1;
@@ -6184,8 +7583,7 @@ int P2Cog::op_JNCT1()
  */
 int P2Cog::op_JNCT2()
 {
-    augmentS(IR.op7.im);
-    const p2_LONG address = S;
+    const p2_LONG address = branchS();
     if (!FLAGS.f_CT2)
         updatePC(address);
     return 1;
@@ -6202,8 +7600,7 @@ int P2Cog::op_JNCT2()
  */
 int P2Cog::op_JNCT3()
 {
-    augmentS(IR.op7.im);
-    const p2_LONG address = S;
+    const p2_LONG address = branchS();
     if (!FLAGS.f_CT3)
         updatePC(address);
     return 1;
@@ -6220,8 +7617,7 @@ int P2Cog::op_JNCT3()
  */
 int P2Cog::op_JNSE1()
 {
-    augmentS(IR.op7.im);
-    const p2_LONG address = S;
+    const p2_LONG address = branchS();
     if (!FLAGS.f_SE1)
         updatePC(address);
     return 1;
@@ -6238,8 +7634,7 @@ int P2Cog::op_JNSE1()
  */
 int P2Cog::op_JNSE2()
 {
-    augmentS(IR.op7.im);
-    const p2_LONG address = S;
+    const p2_LONG address = branchS();
     if (!FLAGS.f_SE2)
         updatePC(address);
     return 1;
@@ -6256,8 +7651,7 @@ int P2Cog::op_JNSE2()
  */
 int P2Cog::op_JNSE3()
 {
-    augmentS(IR.op7.im);
-    const p2_LONG address = S;
+    const p2_LONG address = branchS();
     if (!FLAGS.f_SE3)
         updatePC(address);
     return 1;
@@ -6274,8 +7668,7 @@ int P2Cog::op_JNSE3()
  */
 int P2Cog::op_JNSE4()
 {
-    augmentS(IR.op7.im);
-    const p2_LONG address = S;
+    const p2_LONG address = branchS();
     if (!FLAGS.f_SE4)
         updatePC(address);
     return 1;
@@ -6292,8 +7685,7 @@ int P2Cog::op_JNSE4()
  */
 int P2Cog::op_JNPAT()
 {
-    augmentS(IR.op7.im);
-    const p2_LONG address = S;
+    const p2_LONG address = branchS();
     if (!FLAGS.f_PAT)
         updatePC(address);
     return 1;
@@ -6310,8 +7702,7 @@ int P2Cog::op_JNPAT()
  */
 int P2Cog::op_JNFBW()
 {
-    augmentS(IR.op7.im);
-    const p2_LONG address = S;
+    const p2_LONG address = branchS();
     if (!FLAGS.f_FBW)
         updatePC(address);
     return 1;
@@ -6328,8 +7719,7 @@ int P2Cog::op_JNFBW()
  */
 int P2Cog::op_JNXMT()
 {
-    augmentS(IR.op7.im);
-    const p2_LONG address = S;
+    const p2_LONG address = branchS();
     if (!FLAGS.f_XMT)
         updatePC(address);
     return 1;
@@ -6346,8 +7736,7 @@ int P2Cog::op_JNXMT()
  */
 int P2Cog::op_JNXFI()
 {
-    augmentS(IR.op7.im);
-    const p2_LONG address = S;
+    const p2_LONG address = branchS();
     if (!FLAGS.f_XFI)
         updatePC(address);
     return 1;
@@ -6364,8 +7753,7 @@ int P2Cog::op_JNXFI()
  */
 int P2Cog::op_JNXRO()
 {
-    augmentS(IR.op7.im);
-    const p2_LONG address = S;
+    const p2_LONG address = branchS();
     if (!FLAGS.f_XRO)
         updatePC(address);
     return 1;
@@ -6382,8 +7770,7 @@ int P2Cog::op_JNXRO()
  */
 int P2Cog::op_JNXRL()
 {
-    augmentS(IR.op7.im);
-    const p2_LONG address = S;
+    const p2_LONG address = branchS();
     if (!FLAGS.f_XRL)
         updatePC(address);
     return 1;
@@ -6400,8 +7787,7 @@ int P2Cog::op_JNXRL()
  */
 int P2Cog::op_JNATN()
 {
-    augmentS(IR.op7.im);
-    const p2_LONG address = S;
+    const p2_LONG address = branchS();
     if (!FLAGS.f_ATN)
         updatePC(address);
     return 1;
@@ -6418,8 +7804,7 @@ int P2Cog::op_JNATN()
  */
 int P2Cog::op_JNQMT()
 {
-    augmentS(IR.op7.im);
-    const p2_LONG address = S;
+    const p2_LONG address = branchS();
     if (!FLAGS.f_QMT)
         updatePC(address);
     return 1;
@@ -6491,6 +7876,7 @@ int P2Cog::op_WRPIN()
 {
     augmentS(IR.op7.im);
     augmentD(IR.op7.wz);
+    HUB->wrpin(S, D);
     return 1;
 }
 
@@ -6506,6 +7892,7 @@ int P2Cog::op_WRPIN()
 int P2Cog::op_AKPIN()
 {
     augmentS(IR.op7.im);
+    HUB->akpin(S);
     return 1;
 }
 
@@ -6522,6 +7909,7 @@ int P2Cog::op_WXPIN()
 {
     augmentS(IR.op7.im);
     augmentD(IR.op7.wz);
+    HUB->wxpin(S, D);
     return 1;
 }
 
@@ -6538,6 +7926,7 @@ int P2Cog::op_WYPIN()
 {
     augmentS(IR.op7.im);
     augmentD(IR.op7.wz);
+    HUB->wypin(S, D);
     return 1;
 }
 
@@ -6554,8 +7943,8 @@ int P2Cog::op_WRLUT()
 {
     augmentS(IR.op7.im);
     augmentD(IR.op7.wz);
-    const p2_LONG address = D;
-    const p2_LONG result = S;
+    const p2_LONG address = S;
+    const p2_LONG result = D;
     updateLUT(address, result);
     return 1;
 }
@@ -6571,11 +7960,13 @@ int P2Cog::op_WRLUT()
  */
 int P2Cog::op_WRBYTE()
 {
+    const bool ptr = IR.op7.im && !(VALID & VALID_S_aug) && (IR.op7.src & 0x100);
     augmentS(IR.op7.im);
     augmentD(IR.op7.wz);
-    p2_LONG address = get_pointer(S, 2);
+    const p2_LONG address = hub_address(ptr, 0, 0);
     p2_BYTE result = static_cast<p2_BYTE>(D);
     HUB->wr_BYTE(address, result);
+    hub_stall(address, 0, true);
     return 1;
 }
 
@@ -6590,11 +7981,13 @@ int P2Cog::op_WRBYTE()
  */
 int P2Cog::op_WRWORD()
 {
+    const bool ptr = IR.op7.im && !(VALID & VALID_S_aug) && (IR.op7.src & 0x100);
     augmentS(IR.op7.im);
     augmentD(IR.op7.wz);
-    p2_LONG address = get_pointer(S, 1);
+    const p2_LONG address = hub_address(ptr, 1, 0);
     p2_WORD result = static_cast<p2_WORD>(D);
     HUB->wr_WORD(address, result);
+    hub_stall(address, 0, true);
     return 1;
 }
 
@@ -6610,11 +8003,18 @@ int P2Cog::op_WRWORD()
  */
 int P2Cog::op_WRLONG()
 {
+    const bool ptr = IR.op7.im && !(VALID & VALID_S_aug) && (IR.op7.src & 0x100);
     augmentS(IR.op7.im);
     augmentD(IR.op7.wz);
-    p2_LONG address = get_pointer(S, 0);
-    p2_LONG result = D;
-    HUB->wr_BYTE(address, result);
+    const p2_LONG count = burst_count();
+    const p2_LONG address = hub_address(ptr, 2, count);
+    hub_stall(address, count, true);
+    if (count) {
+        burst_write(address, count, false);
+        return 1;
+    }
+    const p2_LONG result = D;
+    HUB->wr_LONG(address, result);
     return 1;
 }
 
@@ -6666,6 +8066,15 @@ int P2Cog::op_RDFAST()
 {
     augmentS(IR.op7.im);
     augmentD(IR.op7.wz);
+    fifo_start(p2_FIFO_READ, D, S);
+    if (!(D & 0x80000000u)) {
+        fifo_fill();
+        const p2_LONG cycles = HUB->fifo_cycles(ID, S, CNT);
+        if (cycles) {
+            WAIT.flag = cycles;
+            WAIT.mode = p2_WAIT_CACHE;
+        }
+    }
     return 1;
 }
 
@@ -6683,6 +8092,7 @@ int P2Cog::op_WRFAST()
 {
     augmentS(IR.op7.im);
     augmentD(IR.op7.wz);
+    fifo_start(p2_FIFO_WRITE, D, S);
     return 1;
 }
 
@@ -6700,6 +8110,7 @@ int P2Cog::op_FBLOCK()
 {
     augmentS(IR.op7.im);
     augmentD(IR.op7.wz);
+    fifo_block(D, S);
     return 1;
 }
 
@@ -6716,6 +8127,9 @@ int P2Cog::op_XINIT()
 {
     augmentS(IR.op7.im);
     augmentD(IR.op7.wz);
+    streamer_stop();
+    streamer_start(CNT, D, S, 0);
+    FLAGS.f_XFI = true;
     return 1;
 }
 
@@ -6730,6 +8144,7 @@ int P2Cog::op_XINIT()
  */
 int P2Cog::op_XSTOP()
 {
+    streamer_stop();
     return 1;
 }
 
@@ -6746,6 +8161,7 @@ int P2Cog::op_XZERO()
 {
     augmentS(IR.op7.im);
     augmentD(IR.op7.wz);
+    streamer_issue(D, S, true);
     return 1;
 }
 
@@ -6762,6 +8178,7 @@ int P2Cog::op_XCONT()
 {
     augmentS(IR.op7.im);
     augmentD(IR.op7.wz);
+    streamer_issue(D, S, false);
     return 1;
 }
 
@@ -6793,6 +8210,8 @@ int P2Cog::op_REP()
  *
  * S[19:0] sets hub startup address and PTRB of cog.
  * Prior SETQ sets PTRA of cog.
+ * If D is a register and WC, the started cog's number is written to D.
+ * C = 1 if no cog was free.
  *</pre>
  */
 int P2Cog::op_COGINIT()
@@ -6800,7 +8219,10 @@ int P2Cog::op_COGINIT()
     augmentS(IR.op7.im);
     augmentD(IR.op7.wz);
     Q_ASSERT(HUB);
-    HUB->coginit(D, S, Q);
+    const int id = HUB->coginit(D, setq(), S);
+    updateC(id < 0);
+    if (IR.op7.wc && !IR.op7.wz && id >= 0 && id != static_cast<int>(ID))
+        updateD(static_cast<p2_LONG>(id));
     return 1;
 }
 
@@ -6818,6 +8240,9 @@ int P2Cog::op_QMUL()
 {
     augmentS(IR.op7.im);
     augmentD(IR.op7.wz);
+    p2_LONG x, y;
+    P2Cordic::mul(D, S, x, y);
+    cordic_issue(x, y);
     return 1;
 }
 
@@ -6835,6 +8260,10 @@ int P2Cog::op_QDIV()
 {
     augmentS(IR.op7.im);
     augmentD(IR.op7.wz);
+    const p2_QUAD dividend = (static_cast<p2_QUAD>(setq()) << 32) | D;
+    p2_LONG x, y;
+    P2Cordic::div(dividend, S, x, y);
+    cordic_issue(x, y);
     return 1;
 }
 
@@ -6852,6 +8281,10 @@ int P2Cog::op_QFRAC()
 {
     augmentS(IR.op7.im);
     augmentD(IR.op7.wz);
+    const p2_QUAD dividend = (static_cast<p2_QUAD>(D) << 32) | setq();
+    p2_LONG x, y;
+    P2Cordic::div(dividend, S, x, y);
+    cordic_issue(x, y);
     return 1;
 }
 
@@ -6869,6 +8302,9 @@ int P2Cog::op_QSQRT()
 {
     augmentS(IR.op7.im);
     augmentD(IR.op7.wz);
+    p2_LONG x, y;
+    P2Cordic::sqrt((static_cast<p2_QUAD>(S) << 32) | D, x, y);
+    cordic_issue(x, y);
     return 1;
 }
 
@@ -6886,6 +8322,9 @@ int P2Cog::op_QROTATE()
 {
     augmentS(IR.op7.im);
     augmentD(IR.op7.wz);
+    p2_LONG x, y;
+    HUB->cordic().rotate(D, setq(), S, x, y);
+    cordic_issue(x, y);
     return 1;
 }
 
@@ -6903,6 +8342,9 @@ int P2Cog::op_QVECTOR()
 {
     augmentS(IR.op7.im);
     augmentD(IR.op7.wz);
+    p2_LONG x, y;
+    HUB->cordic().vector(D, S, x, y);
+    cordic_issue(x, y);
     return 1;
 }
 
@@ -6934,6 +8376,12 @@ int P2Cog::op_HUBSET()
 int P2Cog::op_COGID()
 {
     augmentD(IR.op7.im);
+    if (IR.op7.wc) {
+        const P2Cog* cog = HUB->cog(static_cast<int>(D & 15));
+        updateC(cog && !cog->halted());
+    } else if (!IR.op7.im) {
+        updateD(ID);
+    }
     return 1;
 }
 
@@ -6949,6 +8397,8 @@ int P2Cog::op_COGID()
 int P2Cog::op_COGSTOP()
 {
     augmentD(IR.op7.im);
+    Q_ASSERT(HUB);
+    HUB->cogstop(D);
     return 1;
 }
 
@@ -7030,6 +8480,7 @@ int P2Cog::op_LOCKREL()
 int P2Cog::op_QLOG()
 {
     augmentD(IR.op7.im);
+    cordic_issue(HUB->cordic().log(D), 0);
     return 1;
 }
 
@@ -7046,6 +8497,7 @@ int P2Cog::op_QLOG()
 int P2Cog::op_QEXP()
 {
     augmentD(IR.op7.im);
+    cordic_issue(HUB->cordic().exp(D), 0);
     return 1;
 }
 
@@ -7062,6 +8514,10 @@ int P2Cog::op_QEXP()
  */
 int P2Cog::op_RFBYTE()
 {
+    const p2_LONG result = fifo_read(sz_BYTE);
+    updateC((result >> 7) & 1);
+    updateZ(0 == result);
+    updateD(result);
     return 1;
 }
 
@@ -7078,6 +8534,10 @@ int P2Cog::op_RFBYTE()
  */
 int P2Cog::op_RFWORD()
 {
+    const p2_LONG result = fifo_read(sz_WORD);
+    updateC((result >> 15) & 1);
+    updateZ(0 == result);
+    updateD(result);
     return 1;
 }
 
@@ -7094,6 +8554,10 @@ int P2Cog::op_RFWORD()
  */
 int P2Cog::op_RFLONG()
 {
+    const p2_LONG result = fifo_read(sz_LONG);
+    updateC((result >> 31) & 1);
+    updateZ(0 == result);
+    updateD(result);
     return 1;
 }
 
@@ -7110,6 +8574,10 @@ int P2Cog::op_RFLONG()
  */
 int P2Cog::op_RFVAR()
 {
+    const p2_LONG result = fifo_read_var(false);
+    updateC(false);
+    updateZ(0 == result);
+    updateD(result);
     return 1;
 }
 
@@ -7126,6 +8594,10 @@ int P2Cog::op_RFVAR()
  */
 int P2Cog::op_RFVARS()
 {
+    const p2_LONG result = fifo_read_var(true);
+    updateC((result >> 31) & 1);
+    updateZ(0 == result);
+    updateD(result);
     return 1;
 }
 
@@ -7140,6 +8612,8 @@ int P2Cog::op_RFVARS()
  */
 int P2Cog::op_WFBYTE()
 {
+    augmentD(IR.op7.im);
+    fifo_write(D, sz_BYTE);
     return 1;
 }
 
@@ -7154,6 +8628,8 @@ int P2Cog::op_WFBYTE()
  */
 int P2Cog::op_WFWORD()
 {
+    augmentD(IR.op7.im);
+    fifo_write(D, sz_WORD);
     return 1;
 }
 
@@ -7168,6 +8644,8 @@ int P2Cog::op_WFWORD()
  */
 int P2Cog::op_WFLONG()
 {
+    augmentD(IR.op7.im);
+    fifo_write(D, sz_LONG);
     return 1;
 }
 
@@ -7187,6 +8665,7 @@ int P2Cog::op_WFLONG()
  */
 int P2Cog::op_GETQX()
 {
+    cordic_get(false);
     return 1;
 }
 
@@ -7206,21 +8685,25 @@ int P2Cog::op_GETQX()
  */
 int P2Cog::op_GETQY()
 {
+    cordic_get(true);
     return 1;
 }
 
 /**
  * @brief Get CT into D.
  *<pre>
- * EEEE 1101011 000 DDDDDDDDD 000011010
+ * EEEE 1101011 C00 DDDDDDDDD 000011010
  *
- * GETCT   D
+ * GETCT   D        {WC}
  *
- * CT is the free-running 32-bit system counter that increments on every clock.
+ * CT is the free-running 64-bit system counter that increments on every clock.
+ * D = CT[31:0], or CT[63:32] if WC.
  *</pre>
  */
 int P2Cog::op_GETCT()
 {
+    const p2_LONG result = IR.op7.wc ? U32H(CNT) : U32L(CNT);
+    updateD(result);
     return 1;
 }
 
@@ -7274,6 +8757,7 @@ int P2Cog::op_GETRND_CZ()
 int P2Cog::op_SETDACS()
 {
     augmentD(IR.op7.im);
+    STREAMER.dacs = D;
     return 1;
 }
 
@@ -7289,6 +8773,7 @@ int P2Cog::op_SETDACS()
 int P2Cog::op_SETXFRQ()
 {
     augmentD(IR.op7.im);
+    streamer_frequency(D);
     return 1;
 }
 
@@ -7303,6 +8788,9 @@ int P2Cog::op_SETXFRQ()
  */
 int P2Cog::op_GETACC()
 {
+    updateD(0);
+    S_next = 0;
+    VALID |= VALID_S_next;
     return 1;
 }
 
@@ -7320,6 +8808,16 @@ int P2Cog::op_GETACC()
 int P2Cog::op_WAITX()
 {
     augmentD(IR.op7.im);
+    p2_LONG ticks = D;
+    if (IR.op7.wc || IR.op7.wz) {
+        ticks &= HUB->random(2*ID);
+        updateC(false);
+        updateZ(false);
+    }
+    if (ticks) {
+        WAIT.flag = ticks;
+        WAIT.mode = p2_WAIT_CNT;
+    }
     return 1;
 }
 
@@ -7335,6 +8833,7 @@ int P2Cog::op_WAITX()
 int P2Cog::op_SETSE1()
 {
     augmentD(IR.op7.im);
+    setse(1, D);
     return 1;
 }
 
@@ -7350,6 +8849,7 @@ int P2Cog::op_SETSE1()
 int P2Cog::op_SETSE2()
 {
     augmentD(IR.op7.im);
+    setse(2, D);
     return 1;
 }
 
@@ -7365,6 +8865,7 @@ int P2Cog::op_SETSE2()
 int P2Cog::op_SETSE3()
 {
     augmentD(IR.op7.im);
+    setse(3, D);
     return 1;
 }
 
@@ -7380,6 +8881,7 @@ int P2Cog::op_SETSE3()
 int P2Cog::op_SETSE4()
 {
     augmentD(IR.op7.im);
+    setse(4, D);
     return 1;
 }
 
@@ -7408,6 +8910,9 @@ int P2Cog::op_POLLINT()
  */
 int P2Cog::op_POLLCT1()
 {
+    updateC(FLAGS.f_CT1);
+    updateZ(FLAGS.f_CT1);
+    FLAGS.f_CT1 = false;
     return 1;
 }
 
@@ -7422,6 +8927,9 @@ int P2Cog::op_POLLCT1()
  */
 int P2Cog::op_POLLCT2()
 {
+    updateC(FLAGS.f_CT2);
+    updateZ(FLAGS.f_CT2);
+    FLAGS.f_CT2 = false;
     return 1;
 }
 
@@ -7436,6 +8944,9 @@ int P2Cog::op_POLLCT2()
  */
 int P2Cog::op_POLLCT3()
 {
+    updateC(FLAGS.f_CT3);
+    updateZ(FLAGS.f_CT3);
+    FLAGS.f_CT3 = false;
     return 1;
 }
 
@@ -7450,6 +8961,7 @@ int P2Cog::op_POLLCT3()
  */
 int P2Cog::op_POLLSE1()
 {
+    pollse(1);
     return 1;
 }
 
@@ -7464,6 +8976,7 @@ int P2Cog::op_POLLSE1()
  */
 int P2Cog::op_POLLSE2()
 {
+    pollse(2);
     return 1;
 }
 
@@ -7478,6 +8991,7 @@ int P2Cog::op_POLLSE2()
  */
 int P2Cog::op_POLLSE3()
 {
+    pollse(3);
     return 1;
 }
 
@@ -7492,6 +9006,7 @@ int P2Cog::op_POLLSE3()
  */
 int P2Cog::op_POLLSE4()
 {
+    pollse(4);
     return 1;
 }
 
@@ -7534,6 +9049,9 @@ int P2Cog::op_POLLFBW()
  */
 int P2Cog::op_POLLXMT()
 {
+    updateC(FLAGS.f_XMT);
+    updateZ(FLAGS.f_XMT);
+    FLAGS.f_XMT = false;
     return 1;
 }
 
@@ -7548,6 +9066,9 @@ int P2Cog::op_POLLXMT()
  */
 int P2Cog::op_POLLXFI()
 {
+    updateC(FLAGS.f_XFI);
+    updateZ(FLAGS.f_XFI);
+    FLAGS.f_XFI = false;
     return 1;
 }
 
@@ -7562,6 +9083,9 @@ int P2Cog::op_POLLXFI()
  */
 int P2Cog::op_POLLXRO()
 {
+    updateC(FLAGS.f_XRO);
+    updateZ(FLAGS.f_XRO);
+    FLAGS.f_XRO = false;
     return 1;
 }
 
@@ -7576,6 +9100,9 @@ int P2Cog::op_POLLXRO()
  */
 int P2Cog::op_POLLXRL()
 {
+    updateC(FLAGS.f_XRL);
+    updateZ(FLAGS.f_XRL);
+    FLAGS.f_XRL = false;
     return 1;
 }
 
@@ -7636,6 +9163,7 @@ int P2Cog::op_WAITINT()
  */
 int P2Cog::op_WAITCT1()
 {
+    wait_ct(1, CT1, FLAGS.f_CT1);
     return 1;
 }
 
@@ -7652,6 +9180,7 @@ int P2Cog::op_WAITCT1()
  */
 int P2Cog::op_WAITCT2()
 {
+    wait_ct(2, CT2, FLAGS.f_CT2);
     return 1;
 }
 
@@ -7668,6 +9197,7 @@ int P2Cog::op_WAITCT2()
  */
 int P2Cog::op_WAITCT3()
 {
+    wait_ct(3, CT3, FLAGS.f_CT3);
     return 1;
 }
 
@@ -7684,6 +9214,7 @@ int P2Cog::op_WAITCT3()
  */
 int P2Cog::op_WAITSE1()
 {
+    waitse(1);
     return 1;
 }
 
@@ -7700,6 +9231,7 @@ int P2Cog::op_WAITSE1()
  */
 int P2Cog::op_WAITSE2()
 {
+    waitse(2);
     return 1;
 }
 
@@ -7716,6 +9248,7 @@ int P2Cog::op_WAITSE2()
  */
 int P2Cog::op_WAITSE3()
 {
+    waitse(3);
     return 1;
 }
 
@@ -7732,6 +9265,7 @@ int P2Cog::op_WAITSE3()
  */
 int P2Cog::op_WAITSE4()
 {
+    waitse(4);
     return 1;
 }
 
@@ -7780,6 +9314,7 @@ int P2Cog::op_WAITFBW()
  */
 int P2Cog::op_WAITXMT()
 {
+    streamer_wait(1);
     return 1;
 }
 
@@ -7796,6 +9331,7 @@ int P2Cog::op_WAITXMT()
  */
 int P2Cog::op_WAITXFI()
 {
+    streamer_wait(2);
     return 1;
 }
 
@@ -7812,6 +9348,7 @@ int P2Cog::op_WAITXFI()
  */
 int P2Cog::op_WAITXRO()
 {
+    streamer_wait(3);
     return 1;
 }
 
@@ -7828,6 +9365,7 @@ int P2Cog::op_WAITXRO()
  */
 int P2Cog::op_WAITXRL()
 {
+    streamer_wait(4);
     return 1;
 }
 
@@ -8018,6 +9556,8 @@ int P2Cog::op_SETINT3()
 int P2Cog::op_SETQ()
 {
     augmentD(IR.op7.im);
+    updateQ(D);
+    VALID |= VALID_Q_next;
     return 1;
 }
 
@@ -8034,6 +9574,8 @@ int P2Cog::op_SETQ()
 int P2Cog::op_SETQ2()
 {
     augmentD(IR.op7.im);
+    updateQ(D);
+    VALID |= VALID_Q_next | VALID_Q2_next;
     return 1;
 }
 
@@ -8049,6 +9591,7 @@ int P2Cog::op_SETQ2()
 int P2Cog::op_PUSH()
 {
     augmentD(IR.op7.im);
+    pushK(D);
     return 1;
 }
 
@@ -8064,6 +9607,10 @@ int P2Cog::op_PUSH()
  */
 int P2Cog::op_POP()
 {
+    const p2_LONG result = popK();
+    updateC((result >> 31) & 1);
+    updateZ((result >> 30) & 1);
+    updateD(result);
     return 1;
 }
 
@@ -8081,7 +9628,7 @@ int P2Cog::op_JMP()
 {
     updateC((D >> 31) & 1);
     updateZ((D >> 30) & 1);
-    updatePC(D);
+    updatePC(addr2pc(D));
     return 1;
 }
 
@@ -8097,12 +9644,12 @@ int P2Cog::op_JMP()
  */
 int P2Cog::op_CALL()
 {
-    const p2_LONG stack = (C << 31) | (Z << 30) | PC;
+    const p2_LONG stack = (C << 31) | (Z << 30) | pc2addr(PC);
     const p2_LONG result = D;
     pushK(stack);
     updateC((result >> 31) & 1);
     updateZ((result >> 30) & 1);
-    updatePC(result);
+    updatePC(addr2pc(result));
     return 1;
 }
 
@@ -8121,7 +9668,7 @@ int P2Cog::op_RET()
     p2_LONG result = popK();
     updateC((result >> 31) & 1);
     updateZ((result >> 30) & 1);
-    updatePC(result);
+    updatePC(addr2pc(result));
     return 1;
 }
 
@@ -8137,12 +9684,12 @@ int P2Cog::op_RET()
  */
 int P2Cog::op_CALLA()
 {
-    const p2_LONG stack = (C << 31) | (Z << 30) | PC;
+    const p2_LONG stack = (C << 31) | (Z << 30) | pc2addr(PC);
     const p2_LONG result = D;
     pushPTRA(stack);
     updateC((result >> 31) & 1);
     updateZ((result >> 30) & 1);
-    updatePC(result);
+    updatePC(addr2pc(result));
     return 1;
 }
 
@@ -8161,7 +9708,7 @@ int P2Cog::op_RETA()
     p2_LONG result = popPTRA();
     updateC((result >> 31) & 1);
     updateZ((result >> 30) & 1);
-    updatePC(result);
+    updatePC(addr2pc(result));
     return 1;
 }
 
@@ -8177,12 +9724,12 @@ int P2Cog::op_RETA()
  */
 int P2Cog::op_CALLB()
 {
-    const p2_LONG stack = (C << 31) | (Z << 30) | PC;
+    const p2_LONG stack = (C << 31) | (Z << 30) | pc2addr(PC);
     const p2_LONG result = D;
     pushPTRB(stack);
     updateC((result >> 31) & 1);
     updateZ((result >> 30) & 1);
-    updatePC(result);
+    updatePC(addr2pc(result));
     return 1;
 }
 
@@ -8201,7 +9748,7 @@ int P2Cog::op_RETB()
     p2_LONG result = popPTRB();
     updateC((result >> 31) & 1);
     updateZ((result >> 30) & 1);
-    updatePC(result);
+    updatePC(addr2pc(result));
     return 1;
 }
 
@@ -8219,7 +9766,7 @@ int P2Cog::op_RETB()
 int P2Cog::op_JMPREL()
 {
     augmentD(IR.op7.im);
-    const p2_LONG result = PC < 0x400 ? PC + D : PC + D * 4;
+    const p2_LONG result = (PC + D * sz_LONG) & A20MASK;
     updatePC(result);
     return 1;
 }
@@ -8365,6 +9912,7 @@ int P2Cog::op_SETLUTS()
 int P2Cog::op_SETCY()
 {
     augmentD(IR.op7.im);
+    STREAMER.cy = D;
     return 1;
 }
 
@@ -8380,6 +9928,7 @@ int P2Cog::op_SETCY()
 int P2Cog::op_SETCI()
 {
     augmentD(IR.op7.im);
+    STREAMER.ci = D;
     return 1;
 }
 
@@ -8395,6 +9944,7 @@ int P2Cog::op_SETCI()
 int P2Cog::op_SETCQ()
 {
     augmentD(IR.op7.im);
+    STREAMER.cq = D;
     return 1;
 }
 
@@ -8410,6 +9960,7 @@ int P2Cog::op_SETCQ()
 int P2Cog::op_SETCFRQ()
 {
     augmentD(IR.op7.im);
+    STREAMER.cfrq = D;
     return 1;
 }
 
@@ -8425,6 +9976,7 @@ int P2Cog::op_SETCFRQ()
 int P2Cog::op_SETCMOD()
 {
     augmentD(IR.op7.im);
+    STREAMER.cmod = D & 0x7f;
     return 1;
 }
 
@@ -8440,6 +9992,7 @@ int P2Cog::op_SETCMOD()
 int P2Cog::op_SETPIV()
 {
     augmentD(IR.op7.im);
+    PIX.piv = static_cast<p2_BYTE>(D);
     return 1;
 }
 
@@ -8455,6 +10008,7 @@ int P2Cog::op_SETPIV()
 int P2Cog::op_SETPIX()
 {
     augmentD(IR.op7.im);
+    PIX.mode = static_cast<p2_BYTE>(D & 0x3f);
     return 1;
 }
 
@@ -8486,6 +10040,9 @@ int P2Cog::op_COGATN()
 int P2Cog::op_TESTP_W()
 {
     augmentD(IR.op7.im);
+    const p2_LONG bit = HUB->rd_PIN(D);
+    updateC(bit);
+    updateZ(bit);
     return 1;
 }
 
@@ -8502,6 +10059,9 @@ int P2Cog::op_TESTP_W()
 int P2Cog::op_TESTPN_W()
 {
     augmentD(IR.op7.im);
+    const p2_LONG bit = !HUB->rd_PIN(D);
+    updateC(bit);
+    updateZ(bit);
     return 1;
 }
 
@@ -8518,6 +10078,9 @@ int P2Cog::op_TESTPN_W()
 int P2Cog::op_TESTP_AND()
 {
     augmentD(IR.op7.im);
+    const p2_LONG bit = HUB->rd_PIN(D);
+    updateC(C & bit);
+    updateZ(Z & bit);
     return 1;
 }
 
@@ -8534,6 +10097,9 @@ int P2Cog::op_TESTP_AND()
 int P2Cog::op_TESTPN_AND()
 {
     augmentD(IR.op7.im);
+    const p2_LONG bit = !HUB->rd_PIN(D);
+    updateC(C & bit);
+    updateZ(Z & bit);
     return 1;
 }
 
@@ -8550,6 +10116,9 @@ int P2Cog::op_TESTPN_AND()
 int P2Cog::op_TESTP_OR()
 {
     augmentD(IR.op7.im);
+    const p2_LONG bit = HUB->rd_PIN(D);
+    updateC(C | bit);
+    updateZ(Z | bit);
     return 1;
 }
 
@@ -8566,6 +10135,9 @@ int P2Cog::op_TESTP_OR()
 int P2Cog::op_TESTPN_OR()
 {
     augmentD(IR.op7.im);
+    const p2_LONG bit = !HUB->rd_PIN(D);
+    updateC(C | bit);
+    updateZ(Z | bit);
     return 1;
 }
 
@@ -8582,6 +10154,9 @@ int P2Cog::op_TESTPN_OR()
 int P2Cog::op_TESTP_XOR()
 {
     augmentD(IR.op7.im);
+    const p2_LONG bit = HUB->rd_PIN(D);
+    updateC(C ^ bit);
+    updateZ(Z ^ bit);
     return 1;
 }
 
@@ -8598,6 +10173,9 @@ int P2Cog::op_TESTP_XOR()
 int P2Cog::op_TESTPN_XOR()
 {
     augmentD(IR.op7.im);
+    const p2_LONG bit = !HUB->rd_PIN(D);
+    updateC(C ^ bit);
+    updateZ(Z ^ bit);
     return 1;
 }
 
@@ -8754,10 +10332,11 @@ int P2Cog::op_DIRRND()
 int P2Cog::op_DIRNOT()
 {
     augmentD(IR.op7.im);
-    const p2_LONG result = HUB->rd_DIR(D) ^ 1;
+    const p2_LONG offs = (D & 32) ? offs_DIRB : offs_DIRA;
+    updatePins(offs, pin_mask(D), ~COG.RAM[offs]);
+    const p2_LONG result = (COG.RAM[offs] >> (D & 31)) & 1;
     updateC(result);
     updateZ(result);
-    updateDIR(D, result);
     return 1;
 }
 
@@ -8914,10 +10493,11 @@ int P2Cog::op_OUTRND()
 int P2Cog::op_OUTNOT()
 {
     augmentD(IR.op7.im);
-    const p2_LONG result = HUB->rd_OUT(D) ^ 1;
+    const p2_LONG offs = (D & 32) ? offs_OUTB : offs_OUTA;
+    updatePins(offs, pin_mask(D), ~COG.RAM[offs]);
+    const p2_LONG result = (COG.RAM[offs] >> (D & 31)) & 1;
     updateC(result);
     updateZ(result);
-    updateDIR(D, result);
     return 1;
 }
 
@@ -9089,11 +10669,12 @@ int P2Cog::op_FLTRND()
 int P2Cog::op_FLTNOT()
 {
     augmentD(IR.op7.im);
-    const p2_LONG result = HUB->rd_OUT(D);
+    const p2_LONG offs = (D & 32) ? offs_OUTB : offs_OUTA;
+    updateDIR(D, 0);
+    updatePins(offs, pin_mask(D), ~COG.RAM[offs]);
+    const p2_LONG result = (COG.RAM[offs] >> (D & 31)) & 1;
     updateC(result);
     updateZ(result);
-    updateDIR(D, 0);
-    updateOUT(D, result);
     return 1;
 }
 
@@ -9265,11 +10846,12 @@ int P2Cog::op_DRVRND()
 int P2Cog::op_DRVNOT()
 {
     augmentD(IR.op7.im);
-    const p2_LONG result = HUB->rd_OUT(D) ^ 1;
+    const p2_LONG offs = (D & 32) ? offs_OUTB : offs_OUTA;
+    updateDIR(D, 1);
+    updatePins(offs, pin_mask(D), ~COG.RAM[offs]);
+    const p2_LONG result = (COG.RAM[offs] >> (D & 31)) & 1;
     updateC(result);
     updateZ(result);
-    updateDIR(D, 1);
-    updateOUT(D, result);
     return 1;
 }
 
@@ -9671,7 +11253,7 @@ int P2Cog::op_GETSCP()
  */
 int P2Cog::op_JMP_ABS()
 {
-    const p2_LONG result = (IR.op5.address + (PC & SXn<p2_LONG,1>(IR.op5.rel))) & A20MASK;
+    const p2_LONG result = branchA();
     updatePC(result);
     return 1;
 }
@@ -9688,8 +11270,8 @@ int P2Cog::op_JMP_ABS()
  */
 int P2Cog::op_CALL_ABS()
 {
-    const p2_LONG stack = (C << 31) | (Z << 30) | PC;
-    const p2_LONG result = (IR.op5.address + (PC & SXn<p2_LONG,1>(IR.op5.rel))) & A20MASK;
+    const p2_LONG stack = (C << 31) | (Z << 30) | pc2addr(PC);
+    const p2_LONG result = branchA();
     pushK(stack);
     updatePC(result);
     return 1;
@@ -9707,8 +11289,8 @@ int P2Cog::op_CALL_ABS()
  */
 int P2Cog::op_CALLA_ABS()
 {
-    const p2_LONG stack = (C << 31) | (Z << 30) | PC;
-    const p2_LONG result = (IR.op5.address + (PC & SXn<p2_LONG,1>(IR.op5.rel))) & A20MASK;
+    const p2_LONG stack = (C << 31) | (Z << 30) | pc2addr(PC);
+    const p2_LONG result = branchA();
     pushPTRA(stack);
     updatePC(result);
     return 1;
@@ -9726,8 +11308,8 @@ int P2Cog::op_CALLA_ABS()
  */
 int P2Cog::op_CALLB_ABS()
 {
-    const p2_LONG stack = (C << 31) | (Z << 30) | PC;
-    const p2_LONG result = (IR.op5.address + (PC & SXn<p2_LONG,1>(IR.op5.rel))) & A20MASK;
+    const p2_LONG stack = (C << 31) | (Z << 30) | pc2addr(PC);
+    const p2_LONG result = branchA();
     pushPTRB(stack);
     updatePC(result);
     return 1;
@@ -9745,8 +11327,8 @@ int P2Cog::op_CALLB_ABS()
  */
 int P2Cog::op_CALLD_ABS_PA()
 {
-    const p2_LONG stack = (C << 31) | (Z << 30) | PC;
-    const p2_LONG result = (IR.op5.address + (PC & SXn<p2_LONG,1>(IR.op5.rel))) & A20MASK;
+    const p2_LONG stack = (C << 31) | (Z << 30) | pc2addr(PC);
+    const p2_LONG result = branchA();
     pushPA(stack);
     updatePC(result);
     return 1;
@@ -9764,8 +11346,8 @@ int P2Cog::op_CALLD_ABS_PA()
  */
 int P2Cog::op_CALLD_ABS_PB()
 {
-    const p2_LONG stack = (C << 31) | (Z << 30) | PC;
-    const p2_LONG result = (IR.op5.address + (PC & SXn<p2_LONG,1>(IR.op5.rel))) & A20MASK;
+    const p2_LONG stack = (C << 31) | (Z << 30) | pc2addr(PC);
+    const p2_LONG result = branchA();
     pushPB(stack);
     updatePC(result);
     return 1;
@@ -9783,8 +11365,8 @@ int P2Cog::op_CALLD_ABS_PB()
  */
 int P2Cog::op_CALLD_ABS_PTRA()
 {
-    const p2_LONG stack = (C << 31) | (Z << 30) | PC;
-    const p2_LONG result = (IR.op5.address + (PC & SXn<p2_LONG,1>(IR.op5.rel))) & A20MASK;
+    const p2_LONG stack = (C << 31) | (Z << 30) | pc2addr(PC);
+    const p2_LONG result = branchA();
     pushPTRA(stack);
     updatePC(result);
     return 1;
@@ -9802,8 +11384,8 @@ int P2Cog::op_CALLD_ABS_PTRA()
  */
 int P2Cog::op_CALLD_ABS_PTRB()
 {
-    const p2_LONG stack = (C << 31) | (Z << 30) | PC;
-    const p2_LONG result = (IR.op5.address + (PC & SXn<p2_LONG,1>(IR.op5.rel))) & A20MASK;
+    const p2_LONG stack = (C << 31) | (Z << 30) | pc2addr(PC);
+    const p2_LONG result = branchA();
     pushPTRB(stack);
     updatePC(result);
     return 1;
@@ -9821,7 +11403,7 @@ int P2Cog::op_CALLD_ABS_PTRB()
  */
 int P2Cog::op_LOC_PA()
 {
-    const p2_LONG result = (IR.op5.address + (PC & SXn<p2_LONG,1>(IR.op5.rel))) & A20MASK;
+    const p2_LONG result = IR.op5.rel ? pc2addr(branchA()) : IR.op5.address;
     updatePA(result);
     return 1;
 }
@@ -9838,7 +11420,7 @@ int P2Cog::op_LOC_PA()
  */
 int P2Cog::op_LOC_PB()
 {
-    const p2_LONG result = (IR.op5.address + (PC & SXn<p2_LONG,1>(IR.op5.rel))) & A20MASK;
+    const p2_LONG result = IR.op5.rel ? pc2addr(branchA()) : IR.op5.address;
     updatePB(result);
     return 1;
 }
@@ -9855,7 +11437,7 @@ int P2Cog::op_LOC_PB()
  */
 int P2Cog::op_LOC_PTRA()
 {
-    const p2_LONG result = (IR.op5.address + (PC & SXn<p2_LONG,1>(IR.op5.rel))) & A20MASK;
+    const p2_LONG result = IR.op5.rel ? pc2addr(branchA()) : IR.op5.address;
     updatePTRA(result);
     return 1;
 }
@@ -9872,7 +11454,7 @@ int P2Cog::op_LOC_PTRA()
  */
 int P2Cog::op_LOC_PTRB()
 {
-    const p2_LONG result = (IR.op5.address + (PC & SXn<p2_LONG,1>(IR.op5.rel))) & A20MASK;
+    const p2_LONG result = IR.op5.rel ? pc2addr(branchA()) : IR.op5.address;
     updatePTRB(result);
     return 1;
 }
@@ -9889,6 +11471,7 @@ int P2Cog::op_LOC_PTRB()
 int P2Cog::op_AUGS()
 {
     S_aug = (IR.opcode << AUG_SHIFT) & AUG_MASK;
+    VALID |= VALID_S_aug;
     return 1;
 }
 
@@ -9904,5 +11487,6 @@ int P2Cog::op_AUGS()
 int P2Cog::op_AUGD()
 {
     D_aug = (IR.opcode << AUG_SHIFT) & AUG_MASK;
+    VALID |= VALID_D_aug;
     return 1;
 }
@@ -33,9 +33,64 @@
  ****************************************************************************/
 #pragma once
 #include <QObject>
+#include <QScopedPointer>
 #include <QVariant>
+#include <QVector>
 #include "p2defs.h"
 #include "p2hub.h"
+#include "p2cogops.h"
+#include "p2break.h"
+#include "p2jit.h"
+#include "p2profile.h"
+#include "p2snapshot.h"
+
+class P2Video;
+
+/**
+ * @brief Threaded dispatch of the op_xxx() functions
+ *
+ * With P2_THREADED_DISPATCH=1 P2Cog::get() jumps to the call of the
+ * predecoded op_xxx() function through a table of labels (labels as
+ * values), which lets the compiler call or inline the functions directly.
+ * This requires GCC or Clang. The default is an indirect call through
+ * a member function pointer.
+ */
+#ifndef P2_THREADED_DISPATCH
+#define P2_THREADED_DISPATCH 0
+#endif
+
+/**
+ * @brief State touched by the next gox() or get() of a COG
+ *
+ * P2Hub's parallel mode runs the COGs on threads of their own as long
+ * as they only touch their own state, and executes the other steps one
+ * at a time in the order the serial mode would.
+ */
+typedef enum {
+    p2_SHARE_NONE,              //!< only the COG's own state
+    p2_SHARE_HUB,               //!< HUB memory, pins, locks, or RND
+    p2_SHARE_COGS,              //!< the state of other COGs (COGINIT)
+}   p2_SHARE_e;
+
+/**
+ * @brief Members of P2Cog saved in a snapshot, in file order
+ *
+ * The predecoded instructions and translated blocks are derived from
+ * COG, LUT, and HUB memory and are rebuilt after a restore.
+ */
+#define P2_COG_STATE(_) \
+    _(PC) _(ICNT) _(CNT) _(WAIT) _(FLAGS) _(CT1) _(CT2) _(CT3) \
+    _(PAT) _(PIN) _(SE) _(INT) _(LOCK) _(IR) _(D) _(S) _(Q) _(R) _(C) _(Z) \
+    _(FIFO) _(STREAMER) _(PIX) _(K) _(STACK) _(VALID) _(S_next) _(S_aug) _(D_aug) _(R_aug) \
+    _(IR_aug) _(REP_instr) _(REP_offset) _(REP_times) _(SKIP) _(SKIPF) \
+    _(PTRA0) _(PTRB0) _(HUBOP) _(CORDIC_count) _(CORDIC) _(QX_posted) _(QY_posted) \
+    _(RW_repeat) _(RDL_mask) _(RDL_flags0) _(RDL_flags1) \
+    _(WRL_mask) _(WRL_flags0) _(WRL_flags1) _(COG) _(LUT) _(JIT_ticks)
+
+#if P2_THREADED_DISPATCH && !defined(__GNUC__)
+#undef P2_THREADED_DISPATCH
+#define P2_THREADED_DISPATCH 0
+#endif
 
 class P2Cog : public QObject
 {
@@ -49,6 +104,9 @@ public:
     p2_opcode_u rd_IR() const { return IR; }
     p2_LONG rd_ID() const { return ID; }
     p2_LONG rd_PC() const { return PC; }
+    p2_LONG rd_IR_PC() const { return IR_PC; }
+    p2_QUAD rd_ICNT() const { return ICNT; }
+    p2_QUAD rd_CNT() const { return CNT; }
     p2_WAIT_t rd_WAIT() const { return WAIT; }
     p2_FLAGS_t rd_FLAGS() const { return FLAGS; }
     p2_LONG rd_CT1() const { return CT1; }
@@ -63,25 +121,100 @@ public:
     p2_LONG rd_Q() const { return Q; }
     p2_LONG rd_C() const { return C; }
     p2_LONG rd_Z() const { return Z; }
-    QVariant rd_D_aug() const { return D_aug; }
-    QVariant rd_S_aug() const { return S_aug; }
-    QVariant rd_R_aug() const { return R_aug; }
+    QVariant rd_D_aug() const { return (VALID & VALID_D_aug) ? QVariant(D_aug) : QVariant(); }
+    QVariant rd_S_aug() const { return (VALID & VALID_S_aug) ? QVariant(S_aug) : QVariant(); }
+    QVariant rd_R_aug() const { return (VALID & VALID_R_aug) ? QVariant(R_aug) : QVariant(); }
     p2_LONG rd_cog(p2_LONG addr) const;
     p2_LONG rd_lut(p2_LONG addr) const;
     p2_LONG rd_mem(p2_LONG addr) const;
 
+    static int opindex(p2_LONG opcode);
+    static const char* opname(int index);
+    static bool dispatch_table();
+    static void set_dispatch_table(bool on);
+    static p2_JIT_mode_e jit_mode();
+    static void set_jit_mode(p2_JIT_mode_e mode);
+    p2_QUAD rd_JIT_blocks() const { return JIT ? JIT->translated() : 0; }
+    p2_QUAD rd_JIT_mismatches() const { return JIT_mismatches; }
+    p2_SHARE_e gox_share() const;
+    p2_SHARE_e get_share() const;
+    p2_LONG idle() const;
+    void fast_forward(p2_LONG ticks);
+    bool halted() const { return p2_WAIT_HALTED == WAIT.mode; }
+    void start();
+    void stop();
+    static p2_LONG state_size();
+    static p2_LONG addr2pc(p2_LONG addr);
+    static p2_LONG pc2addr(p2_LONG pc);
+    void save_state(p2_BYTE* dst) const;
+    void restore_state(const p2_BYTE* src);
+    P2Video* video() const { return VIDEO; }
+    void set_video(P2Video* video);
+    void remap(p2_LONG addr);
+    P2Profile* profile() const { return PROFILE.data(); }
+    void set_profiling(bool on);
+    const p2_STATS_t* stats() const { return STATS.data(); }
+    void set_stats(bool on);
+    void set_breakpoints(P2Breakpoints* breakpoints);
+    bool fetch_pc(p2_LONG& pc) const;
+
 public slots:
     void wr_cog(p2_LONG addr, p2_LONG val);
     void wr_lut(p2_LONG addr, p2_LONG val);
     void wr_mem(p2_LONG addr, p2_LONG val);
     void wr_PC(p2_LONG addr);
+    void wr_C(p2_LONG c);
+    void wr_Z(p2_LONG z);
     void wr_PTRA(p2_LONG addr);
     void wr_PTRB(p2_LONG addr);
 
 private:
+#define P2_OP_ENUM(name) OP_##name,
+    //! enumeration of the op_xxx() functions
+    enum p2_op_e {
+        P2_COG_OPS(P2_OP_ENUM)
+        OP_COUNT
+    };
+#undef P2_OP_ENUM
+
+    //! valid bits of the pending S_next, S_aug, D_aug, R_aug, IR_aug, REP_instr, and SETQ values
+    enum p2_valid_e {
+        VALID_S_next    = 1u << 0,
+        VALID_S_aug     = 1u << 1,
+        VALID_D_aug     = 1u << 2,
+        VALID_R_aug     = 1u << 3,
+        VALID_IR_aug    = 1u << 4,
+        VALID_REP_instr = 1u << 5,
+        VALID_Q         = 1u << 6,  //!< Q was set by the previous instruction (SETQ/SETQ2)
+        VALID_Q_next    = 1u << 7,  //!< Q was set by the current instruction
+        VALID_Q2        = 1u << 8,  //!< Q was set by the previous instruction (SETQ2)
+        VALID_Q2_next   = 1u << 9,  //!< Q was set by the current instruction (SETQ2)
+    };
+
+    //! pointer to a op_xxx() member function
+    typedef int (P2Cog::*p2_opfunc_t)();
+
+    //! predecoded instruction
+    typedef struct {
+        p2_opfunc_t func;   //!< op_xxx() function executing the instruction
+        p2_LONG opcode;     //!< instruction opcode including C, Z, and I flags
+        p2_LONG dst;        //!< destination field D
+        p2_LONG src;        //!< source field S
+        p2_WORD op;         //!< enumeration value of the op_xxx() function
+        p2_BYTE cond;       //!< condition code
+        bool valid;         //!< true if this entry is decoded
+    }   p2_DECODED_t;
+
+    static constexpr p2_LONG DEC_HUB_SIZE = 256;     //!< number of predecoded hubexec instructions
+    static const p2_opfunc_t opfuncs[OP_COUNT];     //!< op_xxx() functions by p2_op_e
+    static bool use_dispatch;                       //!< true to decode through the dispatch table
+    static p2_JIT_mode_e use_jit;                   //!< translator mode
+
     P2Hub* HUB;             //!< pointer to the HUB, i.e. the parent of this P2Cog
     p2_LONG ID;             //!< COG ID (0 … number of COGs - 1)
     p2_LONG PC;             //!< program counter
+    p2_QUAD ICNT;           //!< number of instructions retired, i.e. executed with a true condition
+    p2_QUAD CNT;            //!< HUB cycle counter as seen by this COG
     p2_WAIT_t WAIT;         //!< waiting conidition
     p2_FLAGS_t FLAGS;       //!< flags register
     p2_LONG CT1;            //!< counter CT1 value
@@ -89,9 +222,11 @@ private:
     p2_LONG CT3;            //!< counter CT3 value
     p2_PAT_t PAT;           //!< PAT mode, mask, and match
     p2_PIN_t PIN;           //!< PIN mode, mask, and match
+    p2_SE_t SE;             //!< SE1 … SE4 event configurations
     p2_INT_bits_u INT;      //!< INT disable / active / source bits union
     p2_LOCK_t LOCK;         //!<
     p2_opcode_u IR;         //!< instruction register
+    const p2_DECODED_t* DEC;//!< predecoded instruction in IR
     p2_LONG D;              //!< value of D
     p2_LONG S;              //!< value of S
     p2_LONG Q;              //!< value of Q
@@ -99,14 +234,17 @@ private:
     p2_LONG C;              //!< current carry flag
     p2_LONG Z;              //!< current zero flag
     p2_FIFO_t FIFO;         //!< stream FIFO
+    p2_STREAMER_t STREAMER; //!< streamer commands and NCO
+    p2_PIX_t PIX;           //!< pixel mixer SETPIV and SETPIX values
     p2_LONG K;              //!< stack pointer (0 … 7)
     p2_LONG STACK[8];       //!< stack of 8 levels
-    QVariant S_next;        //!< next instruction's S value
-    QVariant S_aug;         //!< augment next S with this value, if set
-    QVariant D_aug;         //!< augment next D with this value, if set
-    QVariant R_aug;         //!< augment next R with this value, if set
-    QVariant IR_aug;        //!< augment next IR with this value, if set
-    QVariant REP_instr;     //!< if REP is active, number of instructions to repeat
+    p2_LONG VALID;          //!< bit mask of the valid values below (p2_valid_e)
+    p2_LONG S_next;         //!< next instruction's S value
+    p2_LONG S_aug;          //!< augment next S with this value, if set
+    p2_LONG D_aug;          //!< augment next D with this value, if set
+    p2_LONG R_aug;          //!< augment next R with this value, if set
+    p2_LONG IR_aug;         //!< augment next IR with this value, if set
+    p2_LONG REP_instr;      //!< if REP is active, number of instructions to repeat
     p2_LONG REP_offset;     //!< if REP is active, current instruction to repeat
     p2_LONG REP_times;      //!< if REP is active, number of times to repeat
     p2_LONG SKIP;           //!< if SKIP is active, then if b0 is set, the current instruction is cancelled
@@ -114,7 +252,8 @@ private:
     p2_LONG PTRA0;          //!< actual pointer A to hub RAM
     p2_LONG PTRB0;          //!< actual pointer B to hub RAM
     p2_LONG HUBOP;          //!< non-zero if HUB operation
-    p2_LONG CORDIC_count;   //!< non-zero if CORDIC solver running
+    p2_LONG CORDIC_count;   //!< number of CORDIC solver results in flight
+    p2_CORDIC_t CORDIC;     //!< CORDIC solver results in flight and posted X and Y
     bool QX_posted;         //!< true if CORDIC solver X is posted
     bool QY_posted;         //!< true if CORDIC solver Y is posted
     bool RW_repeat;         //!< true if read/write HUB repeated
@@ -126,8 +265,25 @@ private:
     p2_LONG WRL_flags1;     //!<
     p2_COG_t COG;           //!< COG memory (512 longs)
     p2_LUT_t LUT;           //!< LUT memory (512 longs) and shadow registers
-    uchar *MEM;             //!< HUB memory pointer
-    p2_LONG MEMSIZE;        //!< HUB memory size
+    p2_DECODED_t DEC_COG[COG_SIZE]; //!< predecoded COG memory
+    p2_DECODED_t DEC_LUT[LUT_SIZE]; //!< predecoded LUT memory
+    p2_DECODED_t DEC_HUB[DEC_HUB_SIZE]; //!< predecoded hubexec and shadow register instructions
+    QScopedPointer<P2Jit> JIT;  //!< translated COG and LUT blocks, allocated on first use
+    p2_LONG JIT_ticks;      //!< remaining cycles of the translated block being run
+    p2_LONG JIT_verify;     //!< remaining instructions before comparing with the translated block
+    p2_LONG JIT_PC;         //!< PC of the translated block being verified
+    p2_JIT_flags_t JIT_flags;   //!< C and Z flags as returned by the translated block
+    p2_COG_t JIT_COG;       //!< COG memory as returned by the translated block
+    p2_QUAD JIT_mismatches; //!< number of translated blocks which differed from the interpreter
+    P2MemMap MAP;           //!< HUB memory map with COG and LUT memory in page 0
+    P2Video* VIDEO;         //!< capture of the streamer output, or nullptr
+    QScopedPointer<P2Profile> PROFILE;  //!< execution profile, or nullptr if not profiling
+    p2_LONG IR_PC;          //!< address of the instruction in IR
+    QScopedPointer<p2_STATS_t> STATS;   //!< execution statistics, or nullptr if not counting
+    P2Breakpoints* BREAK;   //!< armed breakpoints of the HUB, or nullptr
+
+    static p2_LONG rd_local(void* ctx, p2_LONG addr, int size);
+    static void wr_local(void* ctx, p2_LONG addr, p2_LONG val, int size);
 
     //! return the %n bit sign extended value for val[n:0]
     template <typename T, int n>
@@ -140,7 +296,7 @@ private:
     template <typename T, int n>
     T ZXn(T val) {
         Q_STATIC_ASSERT(n > 0 && n <= 64);
-        return static_cast<T>(val & (Q_UINT64_C(1)<<(n-1)));
+        return static_cast<T>(val & (~Q_UINT64_C(0) >> (64-n)));
     }
 
     //! return a signed 32 bit value for val[15:0]
@@ -191,13 +347,55 @@ private:
         return static_cast<p2_LONG>(val);
     }
 
+    static p2_op_e decode(const p2_opcode_u IR);
+    static QVector<p2_WORD> build_dispatch();
+    static const QVector<p2_WORD>& dispatch();
+    static p2_op_e lookup(p2_LONG opcode);
+    static void predecode(p2_DECODED_t* dec, p2_LONG opcode);
+    const p2_DECODED_t* predecoded(p2_LONG addr, p2_LONG opcode);
+    bool jit_run(bool lut, p2_LONG addr);
+    int execute();
+    void jit_compare();
+
     bool conditional(p2_Cond_e cond);
     bool conditional(unsigned cond);
     p2_LONG fifo_level();
+    void fifo_start(p2_LONG mode, p2_LONG blocks, p2_LONG addr);
+    void fifo_block(p2_LONG blocks, p2_LONG addr);
+    void fifo_wrap();
+    void fifo_fill();
+    void fifo_advance(p2_LONG n);
+    p2_LONG fifo_read(p2_LONG n);
+    p2_LONG fifo_read_var(bool sign);
+    void fifo_write(p2_LONG val, p2_LONG n);
     void check_interrupt_flags();
+    void clear_ct(p2_LONG event);
+    void wait_ct(p2_LONG event, p2_LONG ct, bool flag);
+    bool se_armed() const;
+    bool se_flag(p2_LONG event) const;
+    void set_se_flag(p2_LONG event, bool flag);
+    void update_se();
+    void setse(p2_LONG event, p2_LONG cfg);
+    void pollse(p2_LONG event);
+    void waitse(p2_LONG event);
+    bool streamer_flag(p2_LONG event) const;
+    void set_streamer_flag(p2_LONG event, bool flag);
+    void streamer_start(p2_QUAD cnt, p2_LONG cmd, p2_LONG data, p2_LONG phase);
+    void streamer_stop();
+    void streamer_update(p2_QUAD cnt);
+    void streamer_output(p2_LONG count);
+    void streamer_issue(p2_LONG cmd, p2_LONG data, bool zero);
+    void streamer_frequency(p2_LONG freq);
+    void streamer_wait(p2_LONG event);
+    void count_wait();
     void check_wait_int_state();
-    p2_LONG check_wait_flag(p2_opcode_u IR, p2_LONG value1, p2_LONG value2, bool streamflag);
     p2_LONG get_pointer(p2_LONG inst, p2_LONG size);
+    p2_LONG hub_address(bool ptr, p2_LONG size, p2_LONG count = 0);
+    p2_LONG burst_count() const;
+    void hub_stall(p2_LONG addr, p2_LONG count, bool write);
+    void burst_watch(p2_BREAK_e kind, bool lut, p2_LONG reg, p2_LONG count);
+    void burst_read(p2_LONG addr, p2_LONG count);
+    void burst_write(p2_LONG addr, p2_LONG count, bool masked);
     void save_regs();
     void update_regs();
     void updateC(bool c);
@@ -208,6 +406,10 @@ private:
     void updateLUT(p2_LONG addr, p2_LONG d);
     void updateSKIP(p2_LONG d);
     void updateSKIPF(p2_LONG d);
+    p2_LONG setq() const;
+    void cordic_issue(p2_LONG x, p2_LONG y);
+    void cordic_post(p2_QUAD cnt);
+    void cordic_get(bool y);
     void pushK(p2_LONG val);
     p2_LONG popK();
     void pushPA(p2_LONG val);
@@ -218,10 +420,14 @@ private:
     p2_LONG popPTRB();
     void augmentS(bool f);
     void augmentD(bool f);
+    p2_LONG branchS();
+    p2_LONG branchA() const;
     void updatePA(p2_LONG d);
     void updatePB(p2_LONG d);
     void updatePTRA(p2_LONG d);
     void updatePTRB(p2_LONG d);
+    static p2_LONG pin_mask(p2_LONG pin);
+    void updatePins(p2_LONG offs, p2_LONG mask, p2_LONG val);
     void updateDIR(p2_LONG pin, bool v);
     void updateOUT(p2_LONG pin, bool v);
     void updateREP(p2_LONG instr, p2_LONG times);
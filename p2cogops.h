@@ -0,0 +1,454 @@
+/****************************************************************************
+ *
+ * P2 emulator Cog op_xxx() function list
+ *
+ * Copyright (C) 2019 Jürgen Buchmüller <pullmoll@t-online.de>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ ****************************************************************************/
+#pragma once
+
+/**
+ * @file List of all P2Cog::op_xxx() functions as an X-macro.
+ *
+ * P2_COG_OPS(X) expands X(name) once for every op_name() function,
+ * in the order the functions are declared in p2cog.h. It is used to
+ * generate the P2Cog::p2_op_e enumeration, the table of member function
+ * pointers, and the labels of the threaded dispatcher.
+ */
+
+#define P2_COG_OPS(X) \
+    X(NOP) \
+    X(ROR) \
+    X(ROL) \
+    X(SHR) \
+    X(SHL) \
+    X(RCR) \
+    X(RCL) \
+    X(SAR) \
+    X(SAL) \
+    X(ADD) \
+    X(ADDX) \
+    X(ADDS) \
+    X(ADDSX) \
+    X(SUB) \
+    X(SUBX) \
+    X(SUBS) \
+    X(SUBSX) \
+    X(CMP) \
+    X(CMPX) \
+    X(CMPS) \
+    X(CMPSX) \
+    X(CMPR) \
+    X(CMPM) \
+    X(SUBR) \
+    X(CMPSUB) \
+    X(FGE) \
+    X(FLE) \
+    X(FGES) \
+    X(FLES) \
+    X(SUMC) \
+    X(SUMNC) \
+    X(SUMZ) \
+    X(SUMNZ) \
+    X(TESTB_W) \
+    X(TESTBN_W) \
+    X(TESTB_AND) \
+    X(TESTBN_AND) \
+    X(TESTB_OR) \
+    X(TESTBN_OR) \
+    X(TESTB_XOR) \
+    X(TESTBN_XOR) \
+    X(BITL) \
+    X(BITH) \
+    X(BITC) \
+    X(BITNC) \
+    X(BITZ) \
+    X(BITNZ) \
+    X(BITRND) \
+    X(BITNOT) \
+    X(AND) \
+    X(ANDN) \
+    X(OR) \
+    X(XOR) \
+    X(MUXC) \
+    X(MUXNC) \
+    X(MUXZ) \
+    X(MUXNZ) \
+    X(MOV) \
+    X(NOT) \
+    X(ABS) \
+    X(NEG) \
+    X(NEGC) \
+    X(NEGNC) \
+    X(NEGZ) \
+    X(NEGNZ) \
+    X(INCMOD) \
+    X(DECMOD) \
+    X(ZEROX) \
+    X(SIGNX) \
+    X(ENCOD) \
+    X(ONES) \
+    X(TEST) \
+    X(TESTN) \
+    X(SETNIB) \
+    X(SETNIB_ALTSN) \
+    X(GETNIB) \
+    X(GETNIB_ALTGN) \
+    X(ROLNIB) \
+    X(ROLNIB_ALTGN) \
+    X(SETBYTE) \
+    X(SETBYTE_ALTSB) \
+    X(GETBYTE) \
+    X(GETBYTE_ALTGB) \
+    X(ROLBYTE) \
+    X(ROLBYTE_ALTGB) \
+    X(SETWORD) \
+    X(SETWORD_ALTSW) \
+    X(GETWORD) \
+    X(GETWORD_ALTGW) \
+    X(ROLWORD) \
+    X(ROLWORD_ALTGW) \
+    X(ALTSN) \
+    X(ALTSN_D) \
+    X(ALTGN) \
+    X(ALTGN_D) \
+    X(ALTSB) \
+    X(ALTSB_D) \
+    X(ALTGB) \
+    X(ALTGB_D) \
+    X(ALTSW) \
+    X(ALTSW_D) \
+    X(ALTGW) \
+    X(ALTGW_D) \
+    X(ALTR) \
+    X(ALTR_D) \
+    X(ALTD) \
+    X(ALTD_D) \
+    X(ALTS) \
+    X(ALTS_D) \
+    X(ALTB) \
+    X(ALTB_D) \
+    X(ALTI) \
+    X(ALTI_D) \
+    X(SETR) \
+    X(SETD) \
+    X(SETS) \
+    X(DECOD) \
+    X(DECOD_D) \
+    X(BMASK) \
+    X(BMASK_D) \
+    X(CRCBIT) \
+    X(CRCNIB) \
+    X(MUXNITS) \
+    X(MUXNIBS) \
+    X(MUXQ) \
+    X(MOVBYTS) \
+    X(MUL) \
+    X(MULS) \
+    X(SCA) \
+    X(SCAS) \
+    X(ADDPIX) \
+    X(MULPIX) \
+    X(BLNPIX) \
+    X(MIXPIX) \
+    X(ADDCT1) \
+    X(ADDCT2) \
+    X(ADDCT3) \
+    X(WMLONG) \
+    X(RQPIN) \
+    X(RDPIN) \
+    X(RDLUT) \
+    X(RDBYTE) \
+    X(RDWORD) \
+    X(RDLONG) \
+    X(POPA) \
+    X(POPB) \
+    X(CALLD) \
+    X(RESI3) \
+    X(RESI2) \
+    X(RESI1) \
+    X(RESI0) \
+    X(RETI3) \
+    X(RETI2) \
+    X(RETI1) \
+    X(RETI0) \
+    X(CALLPA) \
+    X(CALLPB) \
+    X(DJZ) \
+    X(DJNZ) \
+    X(DJF) \
+    X(DJNF) \
+    X(IJZ) \
+    X(IJNZ) \
+    X(TJZ) \
+    X(TJNZ) \
+    X(TJF) \
+    X(TJNF) \
+    X(TJS) \
+    X(TJNS) \
+    X(TJV) \
+    X(JINT) \
+    X(JCT1) \
+    X(JCT2) \
+    X(JCT3) \
+    X(JSE1) \
+    X(JSE2) \
+    X(JSE3) \
+    X(JSE4) \
+    X(JPAT) \
+    X(JFBW) \
+    X(JXMT) \
+    X(JXFI) \
+    X(JXRO) \
+    X(JXRL) \
+    X(JATN) \
+    X(JQMT) \
+    X(JNINT) \
+    X(JNCT1) \
+    X(JNCT2) \
+    X(JNCT3) \
+    X(JNSE1) \
+    X(JNSE2) \
+    X(JNSE3) \
+    X(JNSE4) \
+    X(JNPAT) \
+    X(JNFBW) \
+    X(JNXMT) \
+    X(JNXFI) \
+    X(JNXRO) \
+    X(JNXRL) \
+    X(JNATN) \
+    X(JNQMT) \
+    X(1011110_1) \
+    X(1011111_0) \
+    X(SETPAT) \
+    X(WRPIN) \
+    X(AKPIN) \
+    X(WXPIN) \
+    X(WYPIN) \
+    X(WRLUT) \
+    X(WRBYTE) \
+    X(WRWORD) \
+    X(WRLONG) \
+    X(PUSHA) \
+    X(PUSHB) \
+    X(RDFAST) \
+    X(WRFAST) \
+    X(FBLOCK) \
+    X(XINIT) \
+    X(XSTOP) \
+    X(XZERO) \
+    X(XCONT) \
+    X(REP) \
+    X(COGINIT) \
+    X(QMUL) \
+    X(QDIV) \
+    X(QFRAC) \
+    X(QSQRT) \
+    X(QROTATE) \
+    X(QVECTOR) \
+    X(HUBSET) \
+    X(COGID) \
+    X(COGSTOP) \
+    X(LOCKNEW) \
+    X(LOCKRET) \
+    X(LOCKTRY) \
+    X(LOCKREL) \
+    X(QLOG) \
+    X(QEXP) \
+    X(RFBYTE) \
+    X(RFWORD) \
+    X(RFLONG) \
+    X(RFVAR) \
+    X(RFVARS) \
+    X(WFBYTE) \
+    X(WFWORD) \
+    X(WFLONG) \
+    X(GETQX) \
+    X(GETQY) \
+    X(GETCT) \
+    X(GETRND) \
+    X(GETRND_CZ) \
+    X(SETDACS) \
+    X(SETXFRQ) \
+    X(GETACC) \
+    X(WAITX) \
+    X(SETSE1) \
+    X(SETSE2) \
+    X(SETSE3) \
+    X(SETSE4) \
+    X(POLLINT) \
+    X(POLLCT1) \
+    X(POLLCT2) \
+    X(POLLCT3) \
+    X(POLLSE1) \
+    X(POLLSE2) \
+    X(POLLSE3) \
+    X(POLLSE4) \
+    X(POLLPAT) \
+    X(POLLFBW) \
+    X(POLLXMT) \
+    X(POLLXFI) \
+    X(POLLXRO) \
+    X(POLLXRL) \
+    X(POLLATN) \
+    X(POLLQMT) \
+    X(WAITINT) \
+    X(WAITCT1) \
+    X(WAITCT2) \
+    X(WAITCT3) \
+    X(WAITSE1) \
+    X(WAITSE2) \
+    X(WAITSE3) \
+    X(WAITSE4) \
+    X(WAITPAT) \
+    X(WAITFBW) \
+    X(WAITXMT) \
+    X(WAITXFI) \
+    X(WAITXRO) \
+    X(WAITXRL) \
+    X(WAITATN) \
+    X(ALLOWI) \
+    X(STALLI) \
+    X(TRGINT1) \
+    X(TRGINT2) \
+    X(TRGINT3) \
+    X(NIXINT1) \
+    X(NIXINT2) \
+    X(NIXINT3) \
+    X(SETINT1) \
+    X(SETINT2) \
+    X(SETINT3) \
+    X(SETQ) \
+    X(SETQ2) \
+    X(PUSH) \
+    X(POP) \
+    X(JMP) \
+    X(CALL) \
+    X(RET) \
+    X(CALLA) \
+    X(RETA) \
+    X(CALLB) \
+    X(RETB) \
+    X(JMPREL) \
+    X(SKIP) \
+    X(SKIPF) \
+    X(EXECF) \
+    X(GETPTR) \
+    X(GETBRK) \
+    X(COGBRK) \
+    X(BRK) \
+    X(SETLUTS) \
+    X(SETCY) \
+    X(SETCI) \
+    X(SETCQ) \
+    X(SETCFRQ) \
+    X(SETCMOD) \
+    X(SETPIV) \
+    X(SETPIX) \
+    X(COGATN) \
+    X(TESTP_W) \
+    X(TESTPN_W) \
+    X(TESTP_AND) \
+    X(TESTPN_AND) \
+    X(TESTP_OR) \
+    X(TESTPN_OR) \
+    X(TESTP_XOR) \
+    X(TESTPN_XOR) \
+    X(DIRL) \
+    X(DIRH) \
+    X(DIRC) \
+    X(DIRNC) \
+    X(DIRZ) \
+    X(DIRNZ) \
+    X(DIRRND) \
+    X(DIRNOT) \
+    X(OUTL) \
+    X(OUTH) \
+    X(OUTC) \
+    X(OUTNC) \
+    X(OUTZ) \
+    X(OUTNZ) \
+    X(OUTRND) \
+    X(OUTNOT) \
+    X(FLTL) \
+    X(FLTH) \
+    X(FLTC) \
+    X(FLTNC) \
+    X(FLTZ) \
+    X(FLTNZ) \
+    X(FLTRND) \
+    X(FLTNOT) \
+    X(DRVL) \
+    X(DRVH) \
+    X(DRVC) \
+    X(DRVNC) \
+    X(DRVZ) \
+    X(DRVNZ) \
+    X(DRVRND) \
+    X(DRVNOT) \
+    X(SPLITB) \
+    X(MERGEB) \
+    X(SPLITW) \
+    X(MERGEW) \
+    X(SEUSSF) \
+    X(SEUSSR) \
+    X(RGBSQZ) \
+    X(RGBEXP) \
+    X(XORO32) \
+    X(REV) \
+    X(RCZR) \
+    X(RCZL) \
+    X(WRC) \
+    X(WRNC) \
+    X(WRZ) \
+    X(WRNZ) \
+    X(MODCZ) \
+    X(SETSCP) \
+    X(GETSCP) \
+    X(JMP_ABS) \
+    X(CALL_ABS) \
+    X(CALLA_ABS) \
+    X(CALLB_ABS) \
+    X(CALLD_ABS_PA) \
+    X(CALLD_ABS_PB) \
+    X(CALLD_ABS_PTRA) \
+    X(CALLD_ABS_PTRB) \
+    X(LOC_PA) \
+    X(LOC_PB) \
+    X(LOC_PTRA) \
+    X(LOC_PTRB) \
+    X(AUGS) \
+    X(AUGD)
+
+//! Count one op_xxx() function in p2_COG_OP_COUNT
+#define P2_COG_OP_ONE(name) + 1
+
+//! Number of P2Cog::op_xxx() functions, i.e. of entries in the dispatch table
+static constexpr int p2_COG_OP_COUNT = 0 P2_COG_OPS(P2_COG_OP_ONE);
@@ -0,0 +1,192 @@
+/****************************************************************************
+ *
+ * P2 emulator COG worker thread
+ *
+ * Copyright (C) 2019 Jürgen Buchmüller <pullmoll@t-online.de>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ ****************************************************************************/
+#include "p2cogthread.h"
+
+/**
+ * @brief P2CogThread constructor
+ * @param cog pointer to the COG to run
+ * @param mutex pointer to the mutex shared with the hub
+ * @param idle pointer to the hub's condition to wake when stopping or advancing
+ * @param parent pointer to parent QObject
+ */
+P2CogThread::P2CogThread(P2Cog* cog, QMutex* mutex, QWaitCondition* idle, QObject* parent)
+    : QThread(parent)
+    , m_cog(cog)
+    , m_mutex(mutex)
+    , m_idle(idle)
+    , m_go()
+    , m_pos(0)
+    , m_watch(nowhere)
+    , m_limit(0)
+    , m_running(false)
+    , m_stop(false)
+{
+}
+
+/**
+ * @brief Set up a new slice; the thread must not be running
+ * @param limit position at the end of the slice
+ */
+void P2CogThread::start_slice(p2_QUAD limit)
+{
+    m_pos.storeRelease(2 * m_cog->rd_CNT());
+    m_limit = limit;
+}
+
+/**
+ * @brief Return true, if the thread can not run the next step itself
+ * @return true at the end of the slice or in front of a shared step
+ */
+bool P2CogThread::blocked() const
+{
+    return position() >= m_limit || p2_SHARE_NONE != share();
+}
+
+/**
+ * @brief Return the state touched by the next step
+ * @return one of p2_SHARE_e
+ */
+p2_SHARE_e P2CogThread::share() const
+{
+    return (position() & 1) ? m_cog->get_share() : m_cog->gox_share();
+}
+
+/**
+ * @brief Run the next step on the calling thread; the thread must not be running
+ */
+void P2CogThread::step()
+{
+    const p2_QUAD pos = position();
+    if (pos & 1)
+        m_cog->get();
+    else
+        m_cog->gox();
+    m_pos.storeRelease(pos + 1);
+}
+
+/**
+ * @brief Advance a halted COG to %pos without running its steps; the thread must not be running
+ *
+ * A halted COG only counts its cycles, so whole ticks are fast forwarded.
+ * Nothing is done, if the thread is already at or past %pos.
+ */
+void P2CogThread::skip_to(p2_QUAD pos)
+{
+    Q_ASSERT(m_cog->halted());
+    p2_QUAD at = position();
+    if (at >= pos)
+        return;
+    if (at & 1) {
+        m_cog->get();
+        at++;
+    }
+    const p2_QUAD ticks = (pos - at) / 2;
+    if (ticks)
+        m_cog->fast_forward(static_cast<p2_LONG>(ticks));
+    at += 2 * ticks;
+    if (at < pos) {
+        m_cog->gox();
+        at++;
+    }
+    m_pos.storeRelease(at);
+}
+
+/**
+ * @brief Let the thread run the following steps; called with the mutex locked
+ */
+void P2CogThread::resume()
+{
+    m_running = true;
+    m_go.wakeOne();
+}
+
+/**
+ * @brief Wake the hub once the position is past %pos; called with the mutex locked
+ * @param pos position to watch, or nowhere
+ */
+void P2CogThread::watch(p2_QUAD pos)
+{
+    m_watch.fetchAndStoreOrdered(pos);
+}
+
+/**
+ * @brief Ask the thread to exit and wait for it
+ */
+void P2CogThread::stop()
+{
+    m_mutex->lock();
+    m_stop = true;
+    m_go.wakeOne();
+    m_mutex->unlock();
+    wait();
+}
+
+/**
+ * @brief Run steps whenever resumed until asked to stop
+ */
+void P2CogThread::run()
+{
+    m_mutex->lock();
+    while (!m_stop) {
+        if (!m_running) {
+            m_go.wait(m_mutex);
+            continue;
+        }
+        m_mutex->unlock();
+
+        p2_QUAD pos = m_pos.loadRelaxed();
+        while (pos < m_limit) {
+            if (pos & 1) {
+                if (p2_SHARE_NONE != m_cog->get_share())
+                    break;
+                m_cog->get();
+            } else {
+                if (p2_SHARE_NONE != m_cog->gox_share())
+                    break;
+                m_cog->gox();
+            }
+            m_pos.fetchAndStoreOrdered(++pos);
+            if (pos > m_watch.loadAcquire()) {
+                m_mutex->lock();
+                m_idle->wakeAll();
+                m_mutex->unlock();
+            }
+        }
+
+        m_mutex->lock();
+        m_running = false;
+        m_idle->wakeAll();
+    }
+    m_mutex->unlock();
+}
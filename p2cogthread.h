@@ -0,0 +1,89 @@
+/****************************************************************************
+ *
+ * P2 emulator COG worker thread
+ *
+ * Copyright (C) 2019 Jürgen Buchmüller <pullmoll@t-online.de>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ ****************************************************************************/
+#pragma once
+#include <QAtomicInteger>
+#include <QMutex>
+#include <QThread>
+#include <QWaitCondition>
+#include "p2cog.h"
+
+/**
+ * @brief Worker thread running one COG in P2Hub's parallel mode
+ *
+ * The thread runs the COG's gox() and get() steps for as long as they
+ * only touch the COG's own state. It stops in front of the first step
+ * which touches shared state, or at the limit of the slice, and leaves
+ * that step to P2Hub::execute_parallel().
+ *
+ * A position counts the half cycles of the COG: 2 * CNT for the next
+ * gox(), and 2 * CNT + 1 for the next get().
+ *
+ * The running flag, the limit, and the stop flag are protected by the
+ * mutex shared with the hub. The position is published after every step.
+ */
+class P2CogThread : public QThread
+{
+    Q_OBJECT
+public:
+    P2CogThread(P2Cog* cog, QMutex* mutex, QWaitCondition* idle, QObject* parent = nullptr);
+
+    static constexpr p2_QUAD nowhere = ~Q_UINT64_C(0);  //!< no position watched
+
+    P2Cog* cog() const { return m_cog; }
+    p2_QUAD position() const { return m_pos.loadAcquire(); }
+    bool running() const { return m_running; }
+
+    void start_slice(p2_QUAD limit);
+    bool blocked() const;
+    p2_SHARE_e share() const;
+    void step();
+    void skip_to(p2_QUAD pos);
+    void resume();
+    void watch(p2_QUAD pos);
+    void stop();
+
+protected:
+    void run() override;
+
+private:
+    P2Cog* m_cog;                       //!< COG run by this thread
+    QMutex* m_mutex;                    //!< mutex shared with the hub
+    QWaitCondition* m_idle;             //!< hub's condition for stopped or advanced threads
+    QWaitCondition m_go;                //!< condition to resume this thread
+    QAtomicInteger<p2_QUAD> m_pos;      //!< position of the next step
+    QAtomicInteger<p2_QUAD> m_watch;    //!< wake the hub once the position is past this
+    p2_QUAD m_limit;                    //!< position at the end of the slice
+    bool m_running;                     //!< true while the thread runs steps
+    bool m_stop;                        //!< true when asked to exit
+};
@@ -0,0 +1,264 @@
+/****************************************************************************
+ *
+ * P2 emulator CORDIC solver
+ *
+ * Copyright (C) 2019 Jürgen Buchmüller <pullmoll@t-online.de>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ ****************************************************************************/
+#include <cmath>
+#include "p2cordic.h"
+#include "p2util.h"
+
+//! one full circle in angle units ($1_0000_0000 = 360°)
+static constexpr double full_circle = 4294967296.0;
+
+//! the ratio of a circle's circumference to its diameter
+static const double pi = std::acos(-1.0);
+
+/**
+ * @brief Compute an interpolation table of 2^%bits + 2 entries
+ * @param bits log2 of the number of intervals
+ * @param entry function returning the entry at index %i
+ * @return table of values
+ */
+QVector<qint64> P2Cordic::table(int bits, qint64 (*entry)(int i))
+{
+    QVector<qint64> result((1 << bits) + 2);
+    for (int i = 0; i < result.size(); i++)
+        result[i] = entry(i);
+    return result;
+}
+
+const QVector<qint64> P2Cordic::sin_table = P2Cordic::table(sin_bits, [](int i) -> qint64 {
+    return std::llround(std::sin(pi / 2 * i / (1 << sin_bits)) * 2147483648.0);
+});
+
+const QVector<qint64> P2Cordic::atan_table = P2Cordic::table(atan_bits, [](int i) -> qint64 {
+    return std::llround(std::atan(static_cast<double>(i) / (1 << atan_bits)) / (2 * pi) * full_circle);
+});
+
+const QVector<qint64> P2Cordic::log_table = P2Cordic::table(log_bits, [](int i) -> qint64 {
+    return std::llround(std::log2(1.0 + static_cast<double>(i) / (1 << log_bits)) * 134217728.0);
+});
+
+const QVector<qint64> P2Cordic::exp_table = P2Cordic::table(log_bits, [](int i) -> qint64 {
+    return std::llround(std::exp2(static_cast<double>(i) / (1 << log_bits)) * 2147483648.0);
+});
+
+/**
+ * @brief Linear interpolation between table[i] and table[i+1]
+ * @param table table of values
+ * @param i index
+ * @param frac fraction between i and i+1
+ * @param bits number of bits in %frac
+ * @return interpolated value
+ */
+static inline qint64 interpolate(const QVector<qint64>& table, p2_LONG i, p2_LONG frac, int bits)
+{
+    const qint64 lo = table[static_cast<int>(i)];
+    const qint64 hi = table[static_cast<int>(i) + 1];
+    return lo + (((hi - lo) * static_cast<qint64>(frac)) >> bits);
+}
+
+/**
+ * @brief Return the cycle at which COG %id can issue a command
+ * @param id COG number
+ * @param cnt current cycle
+ * @param ncogs number of COGs (1, 2, 4, 8, or 16), which is the issue period
+ * @return first cycle >= %cnt in the COG's issue slot
+ */
+p2_QUAD P2Cordic::slot(p2_LONG id, p2_QUAD cnt, p2_LONG ncogs)
+{
+    return cnt + ((id - cnt) & (ncogs - 1));
+}
+
+/**
+ * @brief Unsigned multiplication (QMUL)
+ * @param d multiplicand
+ * @param s multiplier
+ * @param x receives the lower long of the product
+ * @param y receives the upper long of the product
+ */
+void P2Cordic::mul(p2_LONG d, p2_LONG s, p2_LONG& x, p2_LONG& y)
+{
+    const p2_QUAD product = static_cast<p2_QUAD>(d) * s;
+    x = static_cast<p2_LONG>(product);
+    y = static_cast<p2_LONG>(product >> 32);
+}
+
+/**
+ * @brief Unsigned division (QDIV, QFRAC)
+ *
+ * A quotient which does not fit in 32 bits is truncated. Division by
+ * zero returns $FFFF_FFFF and the lower long of the dividend.
+ *
+ * @param dividend 64 bit dividend
+ * @param divisor 32 bit divisor
+ * @param x receives the quotient
+ * @param y receives the remainder
+ */
+void P2Cordic::div(p2_QUAD dividend, p2_LONG divisor, p2_LONG& x, p2_LONG& y)
+{
+    if (!divisor) {
+        x = 0xffffffffu;
+        y = static_cast<p2_LONG>(dividend);
+        return;
+    }
+    x = static_cast<p2_LONG>(dividend / divisor);
+    y = static_cast<p2_LONG>(dividend % divisor);
+}
+
+/**
+ * @brief Unsigned square root (QSQRT)
+ * @param val 64 bit radicand
+ * @param x receives the integer square root
+ * @param y receives 0
+ */
+void P2Cordic::sqrt(p2_QUAD val, p2_LONG& x, p2_LONG& y)
+{
+    // the double estimate is off by at most one
+    p2_QUAD root = static_cast<p2_QUAD>(std::sqrt(static_cast<double>(val)));
+    if (root > 0xffffffffu)
+        root = 0xffffffffu;
+    while (root * root > val)
+        root--;
+    while (root < 0xffffffffu && (root + 1) * (root + 1) <= val)
+        root++;
+    x = static_cast<p2_LONG>(root);
+    y = 0;
+}
+
+/**
+ * @brief Rotate the point (%x0, %y0) by %angle (QROTATE)
+ * @param x0 signed X coordinate
+ * @param y0 signed Y coordinate
+ * @param angle angle ($1_0000_0000 = 360°)
+ * @param x receives the rotated X coordinate
+ * @param y receives the rotated Y coordinate
+ */
+void P2Cordic::rotate(p2_LONG x0, p2_LONG y0, p2_LONG angle, p2_LONG& x, p2_LONG& y) const
+{
+    const qint64 sx = static_cast<qint32>(x0);
+    const qint64 sy = static_cast<qint32>(y0);
+    const qint64 s = sin(angle);
+    const qint64 c = sin(angle + 0x40000000u);
+    x = static_cast<p2_LONG>((sx * c - sy * s + (Q_INT64_C(1) << 30)) >> 31);
+    y = static_cast<p2_LONG>((sx * s + sy * c + (Q_INT64_C(1) << 30)) >> 31);
+}
+
+/**
+ * @brief Convert the point (%x0, %y0) to polar coordinates (QVECTOR)
+ * @param x0 signed X coordinate
+ * @param y0 signed Y coordinate
+ * @param x receives the length
+ * @param y receives the angle ($1_0000_0000 = 360°)
+ */
+void P2Cordic::vector(p2_LONG x0, p2_LONG y0, p2_LONG& x, p2_LONG& y) const
+{
+    const qint64 sx = static_cast<qint32>(x0);
+    const qint64 sy = static_cast<qint32>(y0);
+    p2_LONG unused;
+    sqrt(static_cast<p2_QUAD>(sx * sx) + static_cast<p2_QUAD>(sy * sy), x, unused);
+    y = atan(y0, x0);
+}
+
+/**
+ * @brief Unsigned number to logarithm (QLOG)
+ * @param val number
+ * @return log2(%val) in 5.27 fixed point, or 0 for 0
+ */
+p2_LONG P2Cordic::log(p2_LONG val) const
+{
+    if (!val)
+        return 0;
+    const p2_LONG msb = 31u - P2Util::lzc(val);
+    const p2_LONG mant = (val << (31 - msb)) & 0x7fffffffu;
+    const int shift = 31 - log_bits;
+    const qint64 frac = interpolate(log_table, mant >> shift, mant & ((1u << shift) - 1), shift);
+    return (msb << 27) + static_cast<p2_LONG>(frac);
+}
+
+/**
+ * @brief Logarithm to unsigned number (QEXP)
+ * @param val logarithm in 5.27 fixed point
+ * @return 2^%val
+ */
+p2_LONG P2Cordic::exp(p2_LONG val) const
+{
+    const p2_LONG exponent = val >> 27;
+    const p2_LONG frac = val & 0x07ffffffu;
+    const int shift = 27 - log_bits;
+    const p2_QUAD mant = static_cast<p2_QUAD>(interpolate(exp_table, frac >> shift, frac & ((1u << shift) - 1), shift));
+    const p2_QUAD result = ((mant << exponent) + (Q_UINT64_C(1) << 30)) >> 31;
+    return result > 0xffffffffu ? 0xffffffffu : static_cast<p2_LONG>(result);
+}
+
+/**
+ * @brief Return the sine of %angle
+ * @param angle angle ($1_0000_0000 = 360°)
+ * @return sine in 1.31 fixed point
+ */
+qint64 P2Cordic::sin(p2_LONG angle) const
+{
+    const int shift = 30 - sin_bits;
+    p2_LONG a = angle & 0x3fffffffu;
+    if (angle & 0x40000000u)
+        a = 0x40000000u - a;
+    const qint64 val = interpolate(sin_table, a >> shift, a & ((1u << shift) - 1), shift);
+    return (angle & 0x80000000u) ? -val : val;
+}
+
+/**
+ * @brief Return the angle of the point (%x, %y)
+ * @param y signed Y coordinate
+ * @param x signed X coordinate
+ * @return angle ($1_0000_0000 = 360°)
+ */
+p2_LONG P2Cordic::atan(p2_LONG y, p2_LONG x) const
+{
+    const qint64 sx = static_cast<qint32>(x);
+    const qint64 sy = static_cast<qint32>(y);
+    const p2_QUAD ax = static_cast<p2_QUAD>(sx < 0 ? -sx : sx);
+    const p2_QUAD ay = static_cast<p2_QUAD>(sy < 0 ? -sy : sy);
+    if (!ax && !ay)
+        return 0;
+
+    // angle in the first octant, then mirrored to the others
+    const bool steep = ay > ax;
+    const int shift = 30 - atan_bits;
+    const p2_LONG ratio = static_cast<p2_LONG>(((steep ? ax : ay) << 30) / (steep ? ay : ax));
+    p2_LONG a = static_cast<p2_LONG>(interpolate(atan_table, ratio >> shift, ratio & ((1u << shift) - 1), shift));
+    if (steep)
+        a = 0x40000000u - a;
+    if (sx < 0)
+        a = 0x80000000u - a;
+    if (sy < 0)
+        a = 0u - a;
+    return a;
+}
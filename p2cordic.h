@@ -0,0 +1,87 @@
+/****************************************************************************
+ *
+ * P2 emulator CORDIC solver
+ *
+ * Copyright (C) 2019 Jürgen Buchmüller <pullmoll@t-online.de>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ ****************************************************************************/
+#pragma once
+#include <QVector>
+#include "p2defs.h"
+
+/**
+ * @file CORDIC solver shared by all COGs.
+ *
+ * The hardware solver is a pipeline which accepts a command from each
+ * COG once per turn of the egg-beater, i.e. every number of COGs cycles,
+ * in a slot depending on the COG ID, and posts the results latency
+ * cycles later. So the COGs never compete for
+ * it, and the results only depend on the operands.
+ *
+ * P2Cordic computes the results at once with host integer math: 64 bit
+ * multiplication and division, an integer square root, and interpolated
+ * tables for sine, arc tangent, logarithm, and exponent, which are
+ * computed once and shared by all instances. Each P2Cog
+ * keeps the results of its commands in flight in a p2_CORDIC_t until
+ * they are due.
+ */
+
+class P2Cordic
+{
+public:
+    //! cycles from issuing a command until its results are posted
+    static constexpr p2_LONG latency = 55;
+
+    static p2_QUAD slot(p2_LONG id, p2_QUAD cnt, p2_LONG ncogs);
+
+    static void mul(p2_LONG d, p2_LONG s, p2_LONG& x, p2_LONG& y);
+    static void div(p2_QUAD dividend, p2_LONG divisor, p2_LONG& x, p2_LONG& y);
+    static void sqrt(p2_QUAD val, p2_LONG& x, p2_LONG& y);
+    void rotate(p2_LONG x0, p2_LONG y0, p2_LONG angle, p2_LONG& x, p2_LONG& y) const;
+    void vector(p2_LONG x0, p2_LONG y0, p2_LONG& x, p2_LONG& y) const;
+    p2_LONG log(p2_LONG val) const;
+    p2_LONG exp(p2_LONG val) const;
+
+private:
+    //! log2 of the number of entries in the quarter wave sine table
+    static constexpr int sin_bits = 14;
+    //! log2 of the number of entries in the arc tangent table
+    static constexpr int atan_bits = 14;
+    //! log2 of the number of entries in the logarithm and exponent tables
+    static constexpr int log_bits = 12;
+
+    static const QVector<qint64> sin_table;     //!< sin(0 … 90°) in 1.31 fixed point
+    static const QVector<qint64> atan_table;    //!< atan(0 … 1) in angle units ($1_0000_0000 = 360°)
+    static const QVector<qint64> log_table;     //!< log2(1 … 2) in 5.27 fixed point
+    static const QVector<qint64> exp_table;     //!< 2^(0 … 1) in 1.31 fixed point
+
+    static QVector<qint64> table(int bits, qint64 (*entry)(int i));
+    qint64 sin(p2_LONG angle) const;
+    p2_LONG atan(p2_LONG y, p2_LONG x) const;
+};
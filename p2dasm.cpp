@@ -40,6 +40,7 @@
 P2Dasm::P2Dasm(const P2Cog* cog, QObject* parent)
     : QObject(parent)
     , COG(cog)
+    , m_tokens()
     , m_lowercase(false)
     , pad_opcode(40)
     , pad_inst(-10)
@@ -106,7 +107,7 @@ bool P2Dasm::dasm(p2_LONG addr, QString* opcode, QString* instruction, QString*
     // check for the condition
     QString cond;
     if (IR.opcode())
-        cond = Token.string(conditional(IR.cond()), m_lowercase);
+        cond = m_tokens.string(conditional(IR.cond()), m_lowercase);
     cond.resize(14, QChar::Space);
 
     if (opcode) {
@@ -1601,7 +1602,7 @@ bool P2Dasm::dasm(p2_LONG addr, QString* opcode, QString* instruction, QString*
     }
 
     if (brief)
-        *brief = Doc.brief(IR.opcode());
+        *brief = P2Doc::instance().brief(IR.opcode());
 
     // FIXME: return false for invalid instructions?
     return true;
@@ -1649,7 +1650,7 @@ void P2Dasm::set_lowercase(bool flag)
  */
 QString P2Dasm::format_imm(bool im)
 {
-    return Token.string(im ? t_IMMEDIATE : t_none, m_lowercase);
+    return m_tokens.string(im ? t_IMMEDIATE : t_none, m_lowercase);
 }
 
 /**
@@ -1686,7 +1687,7 @@ QString P2Dasm::format_bin(uint num, int digits)
 void P2Dasm::format_inst(QString* instruction, p2_TOKEN_e inst)
 {
     Q_ASSERT(nullptr != instruction);
-    *instruction = Token.string(inst, m_lowercase);
+    *instruction = m_tokens.string(inst, m_lowercase);
 }
 
 /**
@@ -1725,11 +1726,11 @@ void P2Dasm::format_WCZ(QString* instruction, p2_TOKEN_e wcz)
     if (IR.wc() || IR.wz()) {
         instruction->resize(pad_wcz, QChar::Space);
         if (IR.wc() && IR.wz()) {
-            instruction->append(Token.string(wcz, m_lowercase));
+            instruction->append(m_tokens.string(wcz, m_lowercase));
         } else if (IR.wc()) {
-            instruction->append(Token.string(wc, m_lowercase));
+            instruction->append(m_tokens.string(wc, m_lowercase));
         } else {
-            instruction->append(Token.string(wz, m_lowercase));
+            instruction->append(m_tokens.string(wz, m_lowercase));
         }
     }
 }
@@ -1739,7 +1740,7 @@ void P2Dasm::format_WC(QString* instruction, p2_TOKEN_e wc)
     Q_ASSERT(nullptr != instruction);
     if (IR.wc()) {
         instruction->resize(pad_wcz, QChar::Space);
-        instruction->append(Token.string(wc, m_lowercase));
+        instruction->append(m_tokens.string(wc, m_lowercase));
     }
 }
 
@@ -1748,7 +1749,7 @@ void P2Dasm::format_WZ(QString* instruction, p2_TOKEN_e wz)
     Q_ASSERT(nullptr != instruction);
     if (IR.wz()) {
         instruction->resize(pad_wcz, QChar::Space);
-        instruction->append(Token.string(wz, m_lowercase));
+        instruction->append(m_tokens.string(wz, m_lowercase));
     }
 }
 
@@ -1767,11 +1768,11 @@ void P2Dasm::format_D_IM_S_WCZ(QString* instruction, p2_TOKEN_e inst, p2_TOKEN_e
     if (!IR.im() && IR.dst() == IR.src()) {
         // short form
         *instruction = QString("%1%2")
-                       .arg(Token.string(inst, m_lowercase), pad_inst)
+                       .arg(m_tokens.string(inst, m_lowercase), pad_inst)
                        .arg(format_num(IR.dst()));
     } else {
         *instruction = QString("%1%2,%3%4")
-                       .arg(Token.string(inst, m_lowercase), pad_inst)
+                       .arg(m_tokens.string(inst, m_lowercase), pad_inst)
                        .arg(format_num(IR.dst()))
                        .arg(format_imm(IR.im()))
                        .arg(format_num(IR.src()));
@@ -1794,11 +1795,11 @@ void P2Dasm::format_D_IM_S_WC(QString* instruction, p2_TOKEN_e inst)
     if (!IR.im() && IR.dst() == IR.src()) {
         // short form
         *instruction = QString("%1%2")
-                       .arg(Token.string(inst, m_lowercase), pad_inst)
+                       .arg(m_tokens.string(inst, m_lowercase), pad_inst)
                        .arg(format_num(IR.dst()));
     } else {
         *instruction = QString("%1%2,%3%4")
-                       .arg(Token.string(inst, m_lowercase), pad_inst)
+                       .arg(m_tokens.string(inst, m_lowercase), pad_inst)
                        .arg(format_num(IR.dst()))
                        .arg(format_imm(IR.im()))
                        .arg(format_num(IR.src()));
@@ -1821,11 +1822,11 @@ void P2Dasm::format_D_IM_S_WZ(QString* instruction, p2_TOKEN_e inst, p2_TOKEN_e
     if (!IR.im() && IR.dst() == IR.src()) {
         // short form
         *instruction = QString("%1%2")
-                       .arg(Token.string(inst, m_lowercase), pad_inst)
+                       .arg(m_tokens.string(inst, m_lowercase), pad_inst)
                        .arg(format_num(IR.dst()));
     } else {
         *instruction = QString("%1%2,%3%4")
-                       .arg(Token.string(inst, m_lowercase), pad_inst)
+                       .arg(m_tokens.string(inst, m_lowercase), pad_inst)
                        .arg(format_num(IR.dst()))
                        .arg(format_imm(IR.im()))                // I
                        .arg(format_num(IR.src()));
@@ -1848,11 +1849,11 @@ void P2Dasm::format_WZ_D_IM_S(QString* instruction, p2_TOKEN_e inst)
     if (!IR.wz() && !IR.im() && IR.dst() == IR.src()) {
         // short form
         *instruction = QString("%1%2")
-                       .arg(Token.string(inst, m_lowercase), pad_inst)
+                       .arg(m_tokens.string(inst, m_lowercase), pad_inst)
                        .arg(format_num(IR.dst()));
     } else {
         *instruction = QString("%1%2%3,%4%5")
-                       .arg(Token.string(inst, m_lowercase), pad_inst)
+                       .arg(m_tokens.string(inst, m_lowercase), pad_inst)
                        .arg(format_imm(IR.wz()))              // L
                        .arg(format_num(IR.dst()))
                        .arg(format_imm(IR.im()))              // I
@@ -1874,11 +1875,11 @@ void P2Dasm::format_WZ_D_IM_S_WC(QString* instruction, p2_TOKEN_e inst)
     if (!IR.wz() && !IR.im() && IR.dst() == IR.src()) {
         // short form
         *instruction = QString("%1%2")
-                       .arg(Token.string(inst, m_lowercase), pad_inst)
+                       .arg(m_tokens.string(inst, m_lowercase), pad_inst)
                        .arg(format_num(IR.dst()));
     } else {
         *instruction = QString("%1%2%3,%4%5")
-                       .arg(Token.string(inst, m_lowercase), pad_inst)
+                       .arg(m_tokens.string(inst, m_lowercase), pad_inst)
                        .arg(format_imm(IR.wz()))              // L
                        .arg(format_num(IR.dst()))
                        .arg(format_imm(IR.im()))              // I
@@ -1900,7 +1901,7 @@ void P2Dasm::format_D_IM_S_NNN(QString* instruction, p2_TOKEN_e inst, uint max)
     Q_ASSERT(nullptr != instruction);
     uint nnn = (IR.opcode() >> p2_shift_NNN) & max;
     *instruction = QString("%1%2,%3%4,#%5")
-                   .arg(Token.string(inst, m_lowercase), pad_inst)
+                   .arg(m_tokens.string(inst, m_lowercase), pad_inst)
                    .arg(format_num(IR.dst()))
                    .arg(format_imm(IR.im()))
                    .arg(format_num(IR.src()))
@@ -1919,7 +1920,7 @@ void P2Dasm::format_D_IMM_S(QString* instruction, p2_TOKEN_e inst)
 {
     Q_ASSERT(nullptr != instruction);
     *instruction = QString("%1%2,%3%4")
-                   .arg(Token.string(inst, m_lowercase), pad_inst)
+                   .arg(m_tokens.string(inst, m_lowercase), pad_inst)
                    .arg(format_num(IR.dst()))
                    .arg(format_imm(IR.im()))
                    .arg(format_num(IR.src()));
@@ -1938,7 +1939,7 @@ void P2Dasm::format_D_CZ(QString* instruction, p2_TOKEN_e inst, p2_TOKEN_e with)
 {
     Q_ASSERT(nullptr != instruction);
     *instruction = QString("%1%2")
-                   .arg(Token.string(inst, m_lowercase), pad_inst)
+                   .arg(m_tokens.string(inst, m_lowercase), pad_inst)
                    .arg(format_num(IR.dst()));
     format_WCZ(instruction, with);
 }
@@ -1956,7 +1957,7 @@ void P2Dasm::format_CZ(QString* instruction, p2_TOKEN_e inst, p2_TOKEN_e with)
 {
     Q_ASSERT(nullptr != instruction);
     *instruction = QString("%1")
-                   .arg(Token.string(inst, m_lowercase), pad_inst);
+                   .arg(m_tokens.string(inst, m_lowercase), pad_inst);
     format_WCZ(instruction, with);
 }
 
@@ -1978,16 +1979,16 @@ void P2Dasm::format_MODCZ_WCZ(QString* instruction, p2_TOKEN_e inst, p2_TOKEN_e
     if (0 == cccc) {
         // short form 1
         *instruction = QString("%1%2")
-                       .arg(Token.string(t_MODZ, m_lowercase), pad_inst)
+                       .arg(m_tokens.string(t_MODZ, m_lowercase), pad_inst)
                        .arg(conditional(zzzz));
     } else if (0 == zzzz) {
         // short form 2
         *instruction = QString("%1%2")
-                       .arg(Token.string(t_MODC, m_lowercase), pad_inst)
+                       .arg(m_tokens.string(t_MODC, m_lowercase), pad_inst)
                        .arg(conditional(cccc));
     } else {
         *instruction = QString("%1%2,%3")
-                       .arg(Token.string(inst, m_lowercase), pad_inst)
+                       .arg(m_tokens.string(inst, m_lowercase), pad_inst)
                        .arg(conditional(cccc))
                        .arg(conditional(zzzz));
     }
@@ -2006,7 +2007,7 @@ void P2Dasm::format_D(QString* instruction, p2_TOKEN_e inst)
 {
     Q_ASSERT(nullptr != instruction);
     *instruction = QString("%1%2")
-                   .arg(Token.string(inst, m_lowercase), pad_inst)
+                   .arg(m_tokens.string(inst, m_lowercase), pad_inst)
                    .arg(format_num(IR.dst()));
 }
 
@@ -2022,7 +2023,7 @@ void P2Dasm::format_WZ_D(QString* instruction, p2_TOKEN_e inst)
 {
     Q_ASSERT(nullptr != instruction);
     *instruction = QString("%1%2%3")
-                   .arg(Token.string(inst, m_lowercase), pad_inst)
+                   .arg(m_tokens.string(inst, m_lowercase), pad_inst)
                    .arg(format_imm(IR.wz()))
                    .arg(format_num(IR.dst()));
 }
@@ -2039,7 +2040,7 @@ void P2Dasm::format_IM_D(QString* instruction, p2_TOKEN_e inst)
 {
     Q_ASSERT(nullptr != instruction);
     *instruction = QString("%1%2%3")
-                   .arg(Token.string(inst, m_lowercase), pad_inst)
+                   .arg(m_tokens.string(inst, m_lowercase), pad_inst)
                    .arg(format_imm(IR.im()))
                    .arg(format_num(IR.dst()));
 }
@@ -2057,7 +2058,7 @@ void P2Dasm::format_IM_D_WCZ(QString* instruction, p2_TOKEN_e inst, p2_TOKEN_e w
 {
     Q_ASSERT(nullptr != instruction);
     *instruction = QString("%1%2%3")
-                   .arg(Token.string(inst, m_lowercase), pad_inst)
+                   .arg(m_tokens.string(inst, m_lowercase), pad_inst)
                    .arg(format_imm(IR.im()))
                    .arg(format_num(IR.dst()));
     format_WCZ(instruction, with);
@@ -2075,7 +2076,7 @@ void P2Dasm::format_IM_D_WC(QString* instruction, p2_TOKEN_e inst)
 {
     Q_ASSERT(nullptr != instruction);
     *instruction = QString("%1%2%3")
-                   .arg(Token.string(inst, m_lowercase), pad_inst)
+                   .arg(m_tokens.string(inst, m_lowercase), pad_inst)
                    .arg(format_imm(IR.im()))
                    .arg(format_num(IR.dst()));
     format_WC(instruction, t_WC);
@@ -2131,9 +2132,9 @@ void P2Dasm::format_PC_A20(QString* instruction, p2_TOKEN_e inst, p2_TOKEN_e des
     const p2_LONG aaaa = IR.opcode() & A20MASK;
     const p2_LONG addr = IR.wc() ? (PC + aaaa) & A20MASK : aaaa;
     *instruction = QString("%1%2%3%4$%5")
-                   .arg(Token.string(inst, m_lowercase), pad_inst)
-                   .arg(Token.string(dest, m_lowercase))
-                   .arg(Token.string(dest != t_none ? t_COMMA : t_none, m_lowercase))
+                   .arg(m_tokens.string(inst, m_lowercase), pad_inst)
+                   .arg(m_tokens.string(dest, m_lowercase))
+                   .arg(m_tokens.string(dest != t_none ? t_COMMA : t_none, m_lowercase))
                    .arg(format_imm(IR.im()))
                    .arg(addr, 0, 16);
 }
@@ -2151,7 +2152,7 @@ void P2Dasm::format_IMM23(QString* instruction, p2_TOKEN_e inst)
     Q_ASSERT(nullptr != instruction);
     const p2_LONG nnnn = (IR.opcode() << AUG_SHIFT) & AUG_MASK;
     *instruction = QString("%1%2$%3")
-                   .arg(Token.string(inst, m_lowercase), pad_inst)
+                   .arg(m_tokens.string(inst, m_lowercase), pad_inst)
                    .arg(format_imm(IR.im()))
                    .arg(nnnn << 9, 0, 16, QChar('0'));
 }
@@ -34,7 +34,7 @@
 #pragma once
 #include <QObject>
 #include "p2opcode.h"
-#include "p2tokens.h"
+#include "p2token.h"
 
 class P2Cog;
 
@@ -54,6 +54,7 @@ public slots:
 
 private:
     const P2Cog* COG;
+    P2Token m_tokens;
     bool m_lowercase;
     int pad_opcode;
     int pad_inst;
@@ -44,6 +44,7 @@
  */
 
 #include "p2tokens.h"
+#include "p2cogops.h"
 
 /*
  * Definitions for the basic types based on Qt5 types
@@ -1209,15 +1210,17 @@ typedef enum {
  */
 typedef struct {
 #if (Q_BYTE_ORDER == Q_LITTLE_ENDIAN)
-    uint address:22;            //!< 22 bits of address
+    uint address:20;            //!< 20 bits of address
     bool rel:1;                 //!< R if true, relative to PC, otherwise absolute
+    uint ww:2;                  //!< register PA, PB, PTRA, or PTRB (CALLD/LOC)
     uint inst:5;                //!< instruction type
     uint cond:4;                //!< conditional execution
 #elif (Q_BYTE_ORDER == Q_BIG_ENDIAN)
     uint cond:4;                //!< conditional execution
     uint inst:5;                //!< instruction type
+    uint ww:2;                  //!< register PA, PB, PTRA, or PTRB (CALLD/LOC)
     bool rel:1;                 //!< R if true, relative to PC, otherwise absolute
-    uint address:22;            //!< 22 bits of address
+    uint address:20;            //!< 20 bits of address
 #else
 #error "Unknown byte order!"
 #endif
@@ -1558,6 +1561,14 @@ typedef struct {
     p2_LONG num;                //!< pin number
 }   p2_PIN_t;
 
+/**
+ * @brief SE1 … SE4 smart pin event data
+ */
+typedef struct {
+    p2_LONG cfg[4];             //!< event configurations (SETSEx D[8:0])
+    p2_LONG prev;               //!< previous IN of the events' pins (bits 0 … 3)
+}   p2_SE_t;
+
 /**
  * @brief INT disable / active / source data
  */
@@ -1614,7 +1625,9 @@ typedef enum {
     p2_WAIT_PIN,                //!< waiting for PIN to change level
     p2_WAIT_HUB,                //!< waiting for HUB access
     p2_WAIT_CACHE,              //!< waiting on FIFO cache to be filled
-    p2_WAIT_FLAG                //!< waiting for a specific FLAG bit
+    p2_WAIT_FLAG,               //!< waiting for a specific FLAG bit
+    p2_WAIT_STREAMER,           //!< waiting for the streamer to buffer a command (event 0), or for a streamer event flag
+    p2_WAIT_HALTED              //!< stopped by COGSTOP, or not started yet; only COGINIT ends this
 }   p2_WAIT_mode_e;
 
 /**
@@ -1623,24 +1636,190 @@ typedef enum {
 typedef struct {
     p2_LONG flag;               //!< non-zero if waiting
     p2_WAIT_mode_e mode;        //!< current wait mode
+    p2_LONG event;              //!< CTx event flag to clear when done (p2_WAIT_FLAG)
 }   p2_WAIT_t;
 
+/**
+ * @brief Execution statistics of a COG
+ *
+ * Instructions whose condition is false are counted in cond_failed only,
+ * and NOPs in nops only, so the sum of ops[] and nops is the number of
+ * instructions retired.
+ */
+typedef struct {
+    p2_QUAD ops[p2_COG_OP_COUNT];           //!< instructions executed per P2Cog::op_xxx() function (dispatch entry)
+    p2_QUAD nops;                           //!< NOPs ($00000000) executed
+    p2_QUAD waits[p2_WAIT_HALTED + 1];      //!< cycles spent waiting per p2_WAIT_mode_e
+    p2_QUAD skipped;                        //!< instructions cancelled by SKIP
+    p2_QUAD skipped_fast;                   //!< instructions jumped over by SKIPF or EXECF
+    p2_QUAD cond_failed;                    //!< instructions whose condition was false
+}   p2_STATS_t;
+
+//! Number of BYTEs in a FIFO block (RDFAST/WRFAST/FBLOCK block size unit)
+static constexpr p2_LONG FIFO_BLOCK = 64;
+
+/**
+ * @brief FIFO modes
+ */
+typedef enum {
+    p2_FIFO_IDLE,               //!< FIFO not in use
+    p2_FIFO_READ,               //!< reading from the HUB (RDFAST)
+    p2_FIFO_WRITE,              //!< writing to the HUB (WRFAST)
+}   p2_FIFO_mode_e;
+
 /**
  * @brief FIFO configuration and status
+ *
+ * The head is where RFxxx/WFxxx access the HUB, the tail is where the
+ * FIFO fetches from the HUB ahead of the head. Both run through blocks
+ * of head_left/tail_left bytes, and continue at next_addr when a block
+ * is exhausted.
  */
 typedef struct {
-    p2_LONG buff[16];           //!< buffer of 16 longs read from / written to the HUB
-    p2_LONG rindex;             //!< current read index
-    p2_LONG windex;             //!< current write index
-    p2_LONG head_addr;          //!< head address
+    union {
+        p2_LONG buff[16];       //!< buffer of 16 longs read from the HUB
+        p2_BYTE bytes[FIFO_BLOCK];  //!< the same buffer as BYTEs
+    };
+    p2_LONG rindex;             //!< number of BYTEs read from the buffer
+    p2_LONG windex;             //!< number of BYTEs written to the buffer
+    p2_LONG head_addr;          //!< head address (GETPTR)
+    p2_LONG head_left;          //!< BYTEs left in the head's block
     p2_LONG tail_addr;          //!< tail address
-    p2_LONG addr0;              //!< 1st address
-    p2_LONG addr1;              //!< 2nd address
-    p2_LONG mode;               //!< FIFO mode
+    p2_LONG tail_left;          //!< BYTEs left in the tail's block
+    p2_LONG wrap_addr;          //!< block the tail wrapped to ahead of the head
+    p2_LONG wrap_left;          //!< size of that block, or 0 if none
+    p2_LONG next_addr;          //!< start address of the next block (FBLOCK)
+    p2_LONG next_size;          //!< size of the next block in BYTEs (FBLOCK)
+    p2_LONG mode;               //!< FIFO mode (p2_FIFO_mode_e)
     p2_LONG word;               //!< FIFO word
     p2_LONG flag;               //!< FIFO flags
 }   p2_FIFO_t;
 
+//! Number of CORDIC results a COG can have in flight
+static constexpr int CORDIC_DEPTH = 8;
+
+/**
+ * @brief CORDIC results of a COG
+ */
+typedef struct {
+    p2_LONG X;                  //!< posted result X (GETQX)
+    p2_LONG Y;                  //!< posted result Y (GETQY)
+    p2_LONG head;               //!< index of the oldest result in flight
+    struct {
+        p2_QUAD ready;          //!< cycle at which the result is posted
+        p2_LONG X;              //!< result X
+        p2_LONG Y;              //!< result Y
+    }   pipe[CORDIC_DEPTH];     //!< results in flight
+}   p2_CORDIC_t;
+
+//! Number of smart pins
+static constexpr int PIN_COUNT = 64;
+
+/**
+ * @brief Smart pin modes (WRPIN D[5:1])
+ */
+typedef enum {
+    p2_SMART_OFF,               //!< %00000 smart pin off
+    p2_SMART_REPOSITORY,        //!< %00001 long repository
+    p2_SMART_DAC_DITHER_NOISE,  //!< %00010 DAC 16-bit dither, noise
+    p2_SMART_DAC_DITHER_PWM,    //!< %00011 DAC 16-bit dither, PWM
+    p2_SMART_PULSE,             //!< %00100 pulse/cycle output
+    p2_SMART_TRANSITION,        //!< %00101 transition output
+    p2_SMART_NCO_FREQ,          //!< %00110 NCO frequency
+    p2_SMART_NCO_DUTY,          //!< %00111 NCO duty
+    p2_SMART_PWM_TRIANGLE,      //!< %01000 PWM triangle
+    p2_SMART_PWM_SAWTOOTH,      //!< %01001 PWM sawtooth
+    p2_SMART_PWM_SMPS,          //!< %01010 PWM switch-mode power supply
+    p2_SMART_QUADRATURE,        //!< %01011 A-B quadrature encoder
+    p2_SMART_REG_UP,            //!< %01100 inc on A-rise & B-high
+    p2_SMART_REG_UP_DOWN,       //!< %01101 inc on A-rise & B-high / dec on A-rise & B-low
+    p2_SMART_COUNT_RISES,       //!< %01110 inc on A-rise / dec on B-rise
+    p2_SMART_COUNT_HIGHS,       //!< %01111 inc on A-high / dec on B-high
+    p2_SMART_STATE_TICKS,       //!< %10000 time A-states
+    p2_SMART_HIGH_TICKS,        //!< %10001 time A-highs
+    p2_SMART_EVENTS_TICKS,      //!< %10010 time X A-highs/rises/edges
+    p2_SMART_PERIODS_TICKS,     //!< %10011 for X periods, count time
+    p2_SMART_PERIODS_HIGHS,     //!< %10100 for X periods, count states
+    p2_SMART_COUNTER_TICKS,     //!< %10101 for periods in X+ clocks, count time
+    p2_SMART_COUNTER_HIGHS,     //!< %10110 for periods in X+ clocks, count states
+    p2_SMART_COUNTER_PERIODS,   //!< %10111 for periods in X+ clocks, count periods
+    p2_SMART_ADC,               //!< %11000 ADC sample/filter/capture, internally clocked
+    p2_SMART_ADC_EXT,           //!< %11001 ADC sample/filter/capture, externally clocked
+    p2_SMART_ADC_SCOPE,         //!< %11010 ADC scope with trigger
+    p2_SMART_USB_PAIR,          //!< %11011 USB host/device
+    p2_SMART_SYNC_TX,           //!< %11100 sync serial transmit
+    p2_SMART_SYNC_RX,           //!< %11101 sync serial receive
+    p2_SMART_ASYNC_TX,          //!< %11110 async serial transmit
+    p2_SMART_ASYNC_RX           //!< %11111 async serial receive
+}   p2_SMART_mode_e;
+
+/**
+ * @brief Streamer modes (XINIT/XZERO/XCONT D[31:28])
+ *
+ * The LUT modes look up each 1, 2, 4, or 8 bit field of the data in the
+ * LUT, starting with the least significant field. The RGB modes expand
+ * the data to $RRGGBB00.
+ */
+typedef enum {
+    p2_XMODE_NONE,              //!< %0000 no output, the command only takes time
+    p2_XMODE_RFBYTE_RGB8,       //!< %0001 RFBYTE 3:3:2 RGB
+    p2_XMODE_RFWORD_RGB16,      //!< %0010 RFWORD 5:6:5 RGB
+    p2_XMODE_RFLONG_RGB24,      //!< %0011 RFLONG $RRGGBBxx
+    p2_XMODE_RFLONG_32X1_LUT,   //!< %0100 RFLONG 32 x 1 bit -> LUT
+    p2_XMODE_RFLONG_16X2_LUT,   //!< %0101 RFLONG 16 x 2 bits -> LUT
+    p2_XMODE_RFLONG_8X4_LUT,    //!< %0110 RFLONG 8 x 4 bits -> LUT
+    p2_XMODE_RFLONG_4X8_LUT,    //!< %0111 RFLONG 4 x 8 bits -> LUT
+    p2_XMODE_IMM_32X1_LUT,      //!< %1000 S 32 x 1 bit -> LUT
+    p2_XMODE_IMM_16X2_LUT,      //!< %1001 S 16 x 2 bits -> LUT
+    p2_XMODE_IMM_8X4_LUT,       //!< %1010 S 8 x 4 bits -> LUT
+    p2_XMODE_IMM_4X8_LUT,       //!< %1011 S 4 x 8 bits -> LUT
+    p2_XMODE_IMM_1X32,          //!< %1100 S 1 x 32 bits -> DACs
+}   p2_XMODE_e;
+
+/**
+ * @brief Streamer state
+ *
+ * Only the active command's NCO timing is tracked: %end is the cycle of
+ * its final rollover, at which the buffered command, if any, becomes
+ * active. The data of a command is output all at once at %end.
+ */
+typedef struct {
+    p2_LONG freq;               //!< NCO frequency (SETXFRQ); the NCO rolls over when bit 31 is set
+    p2_LONG phase;              //!< NCO phase at cycle %start
+    p2_QUAD start;              //!< cycle at which the NCO phase was %phase
+    p2_QUAD end;                //!< cycle of the final NCO rollover of the active command
+    p2_LONG left;               //!< NCO rollovers left at cycle %start, or 0 if idle
+    p2_LONG cmd;                //!< active command D
+    p2_LONG data;               //!< active command S
+    p2_LONG next;               //!< buffered command: 0 = none, 1 = XCONT, 2 = XZERO
+    p2_LONG next_cmd;           //!< buffered command D
+    p2_LONG next_data;          //!< buffered command S
+    p2_LONG dacs;               //!< DAC values (SETDACS)
+    p2_LONG cmod;               //!< colorspace converter mode (SETCMOD)
+    p2_LONG cy;                 //!< colorspace converter Y coefficients (SETCY)
+    p2_LONG ci;                 //!< colorspace converter I coefficients (SETCI)
+    p2_LONG cq;                 //!< colorspace converter Q coefficients (SETCQ)
+    p2_LONG cfrq;               //!< colorspace converter frequency (SETCFRQ)
+}   p2_STREAMER_t;
+
+/**
+ * @brief Pixel operations (ADDPIX, MULPIX, BLNPIX, MIXPIX)
+ */
+typedef enum {
+    p2_PIX_ADD,                 //!< add bytes with $FF saturation
+    p2_PIX_MUL,                 //!< multiply bytes, $FF = 1.0
+    p2_PIX_BLN,                 //!< alpha-blend bytes using PIV
+    p2_PIX_MIX                  //!< mix bytes using PIV and the MIXPIX mode
+}   p2_PIX_op_e;
+
+/**
+ * @brief Pixel mixer state set by SETPIV and SETPIX
+ */
+typedef struct {
+    p2_BYTE piv;                //!< BLNPIX/MIXPIX blend factor (SETPIV D[7:0])
+    p2_BYTE mode;               //!< MIXPIX mode (SETPIX D[5:0]): D[5:3] DMIX, D[2:0] SMIX
+}   p2_PIX_t;
+
 /**
  * @brief Ummm.. not yet used. Meant to put in a structure what is in the instruction queue
  */
@@ -37,9 +37,6 @@
 #include "p2doc.h"
 #include "p2html.h"
 
-// Global instance
-P2Doc Doc;
-
 P2Doc::P2Doc()
     : m_opcodes()
     , m_masks()
@@ -552,6 +549,21 @@ P2Doc::P2Doc()
     qDebug("%s: masks = %d", __func__, m_masks.count());
 }
 
+/**
+ * @brief Return the shared P2Doc instance
+ *
+ * The tables are built on first use, so programs which never show the
+ * documentation do not pay for them. They are not modified afterwards,
+ * so the instance can be read from any thread.
+ *
+ * @return const reference to the P2Doc
+ */
+const P2Doc& P2Doc::instance()
+{
+    static const P2Doc doc;
+    return doc;
+}
+
 static void put_spaces(QString& mask)
 {
     mask.insert( 4, QChar(' '));
@@ -826,7 +838,7 @@ const QStringList P2Doc::descr(p2_LONG opcode) const
  * @param instr 32 bit value of the masked opcode
  * @return token value for the instruction, or t_invalid if none exists
  */
-p2_TOKEN_e P2Doc::token(p2_LONG opcode)
+p2_TOKEN_e P2Doc::token(p2_LONG opcode) const
 {
     P2DocOpcode op = opcode_of(opcode);
     if (!op.isNull() && op->isDefined())
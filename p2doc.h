@@ -44,6 +44,8 @@ public:
 
     P2Doc();
 
+    static const P2Doc& instance();
+
     const QStringList html_opcodes() const;
     const QStringList html_opcode(const p2_LONG opcode) const;
 
@@ -51,7 +53,7 @@ public:
     const QString brief(p2_LONG opcode) const;
     const QString instr(p2_LONG opcode) const;
     const QStringList descr(p2_LONG opcode) const;
-    p2_TOKEN_e token(p2_LONG opcode);
+    p2_TOKEN_e token(p2_LONG opcode) const;
 
 private:
     enum match_flags {
@@ -620,5 +622,3 @@ private:
     void params_PC_A20(P2DocOpcode& op);
     void params_IMM23(P2DocOpcode& op);
 };
-
-extern P2Doc Doc;
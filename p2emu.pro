@@ -24,23 +24,45 @@ QMAKE_CXXFLAGS += -DVER_MAJ=$$VER_MAJ -DVER_MIN=$$VER_MIN -DVER_PAT=$$VER_PAT
 # You can also select to disable deprecated APIs only up to a certain version of Qt.
 DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
+# Emulator trace level (see p2trace.h): 0 = off, 1 = HUB events,
+# 2 = COG instruction fetch/execute, 3 = HUB memory writes
+DEFINES += P2_TRACE_LEVEL=0
+
+# Dispatch the COG instructions through a table of labels (see p2cog.h);
+# needs GCC or Clang
+# DEFINES += P2_THREADED_DISPATCH=1
+
 SOURCES += \
+	csv.cpp \
 	dialogs/preferences.cpp \
 	main.cpp \
 	mainwindow.cpp \
 	p2asm.cpp \
 	p2atom.cpp \
+	p2break.cpp \
 	p2cog.cpp \
+	p2cogthread.cpp \
+	p2cordic.cpp \
 	p2dasm.cpp \
 	p2defs.cpp \
 	p2doc.cpp \
 	p2docopcode.cpp \
 	p2hub.cpp \
+	p2jit.cpp \
+	p2memmap.cpp \
 	p2opcode.cpp \
+	p2pins.cpp \
+	p2pixel.cpp \
+	p2profile.cpp \
+	p2rewind.cpp \
+	p2serial.cpp \
+	p2snapshot.cpp \
 	p2symbol.cpp \
 	p2symboltable.cpp \
 	p2token.cpp \
+	p2trace.cpp \
 	p2union.cpp \
+	p2video.cpp \
 	p2word.cpp \
 	delegates/p2opcodedelegate.cpp \
 	delegates/p2sourcedelegate.cpp \
@@ -60,22 +82,37 @@ SOURCES += \
 	views/p2hubview.cpp
 
 HEADERS += \
+	csv.h \
 	dialogs/preferences.h \
 	mainwindow.h \
 	p2asm.h \
 	p2atom.h \
+	p2break.h \
 	p2cog.h \
+	p2cogops.h \
+	p2cogthread.h \
+	p2cordic.h \
 	p2dasm.h \
 	p2defs.h \
 	p2doc.h \
 	p2docopcode.h \
 	p2hub.h \
+	p2jit.h \
+	p2memmap.h \
 	p2opcode.h \
+	p2pins.h \
+	p2pixel.h \
+	p2profile.h \
+	p2rewind.h \
+	p2serial.h \
+	p2snapshot.h \
 	p2symbol.h \
 	p2symboltable.h \
 	p2token.h \
 	p2tokens.h \
+	p2trace.h \
 	p2union.h \
+	p2video.h \
 	p2word.h \
 	delegates/p2opcodedelegate.h \
 	delegates/p2sourcedelegate.h \
@@ -129,8 +166,6 @@ TRANSLATIONS += \
 
 DISTFILES += \
 	README.md \
-	csv.cpp \
-	csv.h \
 	doc/MainLoader.lst1 \
 	doc/NTSC_256_x_192.lst1 \
 	doc/NTSC_256_x_192_interrupt.lst1 \
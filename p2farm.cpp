@@ -0,0 +1,485 @@
+/****************************************************************************
+ *
+ * P2 emulator batch runs of many object files
+ *
+ * Copyright (C) 2019 Jürgen Buchmüller <pullmoll@t-online.de>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ ****************************************************************************/
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QScopedPointer>
+#include <QThread>
+#include "p2farm.h"
+#include "p2cog.h"
+
+//! Default number of emulated cycles per job
+static constexpr p2_QUAD default_cycles = Q_UINT64_C(100000000);
+
+//! Number of CNT ticks to run per P2Hub::execute() slice
+static constexpr int slice_ticks = 1024;
+
+/**
+ * @brief Worker thread taking jobs until no queue has any left
+ */
+class P2Farm::Worker : public QThread
+{
+public:
+    Worker(P2Farm* farm, int id)
+        : QThread()
+        , m_farm(farm)
+        , m_id(id)
+    {}
+
+protected:
+    void run() override
+    {
+        bool stolen = false;
+        for (int idx = m_farm->take(m_id, &stolen); idx >= 0; idx = m_farm->take(m_id, &stolen))
+            m_farm->run_job(idx, m_id, stolen);
+    }
+
+private:
+    P2Farm* m_farm;                 //!< farm the jobs come from
+    int m_id;                       //!< index of this worker's queue
+};
+
+//! Initial value of the 64 bit FNV-1a hash
+static constexpr p2_QUAD fnv1a_basis = Q_UINT64_C(14695981039346656037);
+
+/**
+ * @brief Continue the 64 bit FNV-1a hash %hash with a block of memory
+ * @param hash hash of the preceding data
+ * @param data pointer to the data
+ * @param size number of bytes
+ * @return hash value
+ */
+static p2_QUAD fnv1a(p2_QUAD hash, const p2_BYTE* data, p2_LONG size)
+{
+    for (p2_LONG i = 0; i < size; i++) {
+        hash ^= data[i];
+        hash *= Q_UINT64_C(1099511628211);
+    }
+    return hash;
+}
+
+/**
+ * @brief Return the name of a HUB timing tier
+ * @param timing HUB timing
+ * @return lower case name as used on the command line
+ */
+static QString timing_name(p2_HUB_timing_e timing)
+{
+    switch (timing) {
+    case p2_HUB_FUNCTIONAL:
+        return QStringLiteral("functional");
+    case p2_HUB_APPROXIMATE:
+        return QStringLiteral("approximate");
+    case p2_HUB_LATENCY:
+        return QStringLiteral("latency");
+    }
+    return QString();
+}
+
+P2Farm::P2Farm()
+    : m_workers(QThread::idealThreadCount())
+    , m_cogs(8)
+    , m_cycles(default_cycles)
+    , m_use_stop_pc(false)
+    , m_stop_pc(0)
+    , m_timeout(0)
+    , m_timing(p2_HUB_APPROXIMATE)
+    , m_fast_forward(true)
+    , m_results()
+    , m_queues()
+    , m_mutex()
+    , m_stolen(0)
+    , m_nsecs(0)
+{
+    if (m_workers < 1)
+        m_workers = 1;
+}
+
+/**
+ * @brief Return the number of worker threads
+ * @return number of workers
+ */
+int P2Farm::workers() const
+{
+    return m_workers;
+}
+
+/**
+ * @brief Set the number of worker threads
+ * @param workers number of workers (at least 1)
+ */
+void P2Farm::set_workers(int workers)
+{
+    m_workers = qMax(1, workers);
+}
+
+/**
+ * @brief Return the number of COGs of every P2Hub
+ * @return number of COGs
+ */
+int P2Farm::cogs() const
+{
+    return m_cogs;
+}
+
+/**
+ * @brief Set the number of COGs of every P2Hub
+ * @param ncogs number of COGs (1, 2, 4, 8, or 16)
+ */
+void P2Farm::set_cogs(int ncogs)
+{
+    Q_ASSERT(ncogs >= 1 && ncogs <= 16 && 0 == (ncogs & (ncogs - 1)));
+    m_cogs = ncogs;
+}
+
+/**
+ * @brief Return the cycle limit of a job
+ * @return number of cycles
+ */
+p2_QUAD P2Farm::cycles() const
+{
+    return m_cycles;
+}
+
+/**
+ * @brief Set the cycle limit of a job
+ * @param cycles number of cycles
+ */
+void P2Farm::set_cycles(p2_QUAD cycles)
+{
+    m_cycles = cycles;
+}
+
+/**
+ * @brief Return true, if a job stops when COG #0 reaches stop_pc()
+ * @return true if a stop address is set
+ */
+bool P2Farm::has_stop_pc() const
+{
+    return m_use_stop_pc;
+}
+
+/**
+ * @brief Return the stop address
+ * @return address at which COG #0 stops a job
+ */
+p2_LONG P2Farm::stop_pc() const
+{
+    return m_stop_pc;
+}
+
+/**
+ * @brief Stop every job when COG #0 is about to execute an address
+ *
+ * The COG is checked after every CNT tick instead of every slice,
+ * so this makes the jobs somewhat slower.
+ *
+ * @param pc address to stop at
+ */
+void P2Farm::set_stop_pc(p2_LONG pc)
+{
+    m_use_stop_pc = true;
+    m_stop_pc = pc;
+}
+
+/**
+ * @brief Return the host time limit of a job
+ * @return milliseconds, or 0 for no limit
+ */
+p2_QUAD P2Farm::timeout() const
+{
+    return m_timeout;
+}
+
+/**
+ * @brief Set the host time limit of a job
+ * @param msecs milliseconds, or 0 for no limit
+ */
+void P2Farm::set_timeout(p2_QUAD msecs)
+{
+    m_timeout = msecs;
+}
+
+/**
+ * @brief Return the HUB timing of the P2Hubs
+ * @return HUB timing tier
+ */
+p2_HUB_timing_e P2Farm::timing() const
+{
+    return m_timing;
+}
+
+/**
+ * @brief Set the HUB timing of the P2Hubs
+ * @param timing HUB timing tier
+ */
+void P2Farm::set_timing(p2_HUB_timing_e timing)
+{
+    m_timing = timing;
+}
+
+/**
+ * @brief Return true, if the P2Hubs skip cycles while all COGs are waiting
+ * @return true if fast forward is enabled
+ */
+bool P2Farm::fast_forward() const
+{
+    return m_fast_forward;
+}
+
+/**
+ * @brief Enable or disable fast forward of the P2Hubs
+ * @param on true to skip cycles while all COGs are waiting
+ */
+void P2Farm::set_fast_forward(bool on)
+{
+    m_fast_forward = on;
+}
+
+/**
+ * @brief Add a job
+ * @param filename object file to run
+ */
+void P2Farm::add(const QString& filename)
+{
+    p2_FARM_result_t result;
+    result.filename = filename;
+    result.worker = -1;
+    result.stolen = false;
+    result.cycles = 0;
+    result.instructions = 0;
+    result.idle = 0;
+    result.nsecs = 0;
+    result.checksum = 0;
+    m_results += result;
+}
+
+/**
+ * @brief Return the number of jobs
+ * @return number of jobs
+ */
+int P2Farm::count() const
+{
+    return m_results.count();
+}
+
+/**
+ * @brief Return the result of a job
+ * @param idx index of the job in the order they were added
+ * @return const reference to the result
+ */
+const p2_FARM_result_t& P2Farm::result(int idx) const
+{
+    return m_results[idx];
+}
+
+/**
+ * @brief Return the number of jobs stolen by the last run()
+ * @return number of jobs a worker took from another worker's queue
+ */
+int P2Farm::stolen() const
+{
+    return m_stolen;
+}
+
+/**
+ * @brief Return the number of jobs whose file could not be loaded
+ * @return number of failed jobs
+ */
+int P2Farm::failed() const
+{
+    int count = 0;
+    for (const p2_FARM_result_t& result : m_results)
+        if (result.pc.isEmpty())
+            count++;
+    return count;
+}
+
+/**
+ * @brief Run all jobs and wait for them to finish
+ */
+void P2Farm::run()
+{
+    const int nworkers = qMax(1, qMin(m_workers, m_results.count()));
+    QElapsedTimer timer;
+    timer.start();
+
+    m_stolen = 0;
+    m_queues.fill(QVector<int>(), nworkers);
+    for (int idx = 0; idx < m_results.count(); idx++)
+        m_queues[idx % nworkers] += idx;
+
+    QVector<Worker*> threads;
+    for (int id = 0; id < nworkers; id++) {
+        threads += new Worker(this, id);
+        threads.last()->start();
+    }
+    for (Worker* thread : threads) {
+        thread->wait();
+        delete thread;
+    }
+    m_nsecs = timer.nsecsElapsed();
+}
+
+/**
+ * @brief Return the results of the last run() as JSON document
+ * @return UTF-8 encoded JSON
+ */
+QByteArray P2Farm::report() const
+{
+    QJsonArray jobs;
+    for (const p2_FARM_result_t& result : m_results) {
+        const double seconds = static_cast<double>(result.nsecs) / 1e9;
+        QJsonObject job;
+        job.insert(QStringLiteral("file"), result.filename);
+        job.insert(QStringLiteral("stopped_by"), result.reason);
+        job.insert(QStringLiteral("worker"), result.worker);
+        job.insert(QStringLiteral("stolen"), result.stolen);
+        job.insert(QStringLiteral("cycles"), static_cast<qint64>(result.cycles));
+        job.insert(QStringLiteral("instructions"), static_cast<qint64>(result.instructions));
+        job.insert(QStringLiteral("idle_skipped"), static_cast<qint64>(result.idle));
+        job.insert(QStringLiteral("host_time"), seconds);
+        job.insert(QStringLiteral("emulated_mhz"), seconds > 0.0 ? static_cast<double>(result.cycles) / seconds / 1e6 : 0.0);
+        job.insert(QStringLiteral("checksum"), QStringLiteral("%1").arg(result.checksum, 16, 16, QChar('0')));
+        QJsonArray pcs;
+        for (p2_LONG pc : result.pc)
+            pcs.append(QStringLiteral("$%1").arg(pc, 5, 16, QChar('0')));
+        job.insert(QStringLiteral("pc"), pcs);
+        jobs.append(job);
+    }
+
+    QJsonObject root;
+    root.insert(QStringLiteral("cogs"), m_cogs);
+    root.insert(QStringLiteral("cycles"), static_cast<qint64>(m_cycles));
+    root.insert(QStringLiteral("hub_timing"), timing_name(m_timing));
+    root.insert(QStringLiteral("workers"), qMax(1, qMin(m_workers, m_results.count())));
+    root.insert(QStringLiteral("stolen"), m_stolen);
+    root.insert(QStringLiteral("failed"), failed());
+    root.insert(QStringLiteral("host_time"), static_cast<double>(m_nsecs) / 1e9);
+    root.insert(QStringLiteral("jobs"), jobs);
+    return QJsonDocument(root).toJson(QJsonDocument::Indented);
+}
+
+/**
+ * @brief Take the next job for a worker
+ *
+ * The worker's own queue is used up from the back, other queues are
+ * robbed from the front, starting with the longest.
+ *
+ * @param worker index of the worker
+ * @param stolen set to true, if the job comes from another worker's queue
+ * @return index of the job, or -1 if there are none left
+ */
+int P2Farm::take(int worker, bool* stolen)
+{
+    QMutexLocker lock(&m_mutex);
+    QVector<int>& own = m_queues[worker];
+    if (!own.isEmpty()) {
+        *stolen = false;
+        return own.takeLast();
+    }
+
+    int victim = -1;
+    for (int id = 0; id < m_queues.count(); id++)
+        if (!m_queues[id].isEmpty() && (victim < 0 || m_queues[id].count() > m_queues[victim].count()))
+            victim = id;
+    if (victim < 0)
+        return -1;
+    m_stolen++;
+    *stolen = true;
+    return m_queues[victim].takeFirst();
+}
+
+/**
+ * @brief Run one job on a P2Hub of its own
+ *
+ * The P2Hub is allocated on the heap, because its HUB memory is too
+ * large for the stack of a worker thread.
+ *
+ * @param idx index of the job
+ * @param worker index of the worker running it
+ * @param stolen true, if the job was stolen from another worker's queue
+ */
+void P2Farm::run_job(int idx, int worker, bool stolen)
+{
+    p2_FARM_result_t& result = m_results[idx];
+    result.worker = worker;
+    result.stolen = stolen;
+
+    QElapsedTimer timer;
+    timer.start();
+
+    QScopedPointer<P2Hub> hub(new P2Hub(m_cogs));
+    hub->set_fast_forward(m_fast_forward);
+    hub->set_timing(m_timing);
+    QFileInfo info(result.filename);
+    if (!info.path().startsWith(QChar(':')))
+        hub->set_pathname(info.path());
+    if (!hub->load_obj(result.filename)) {
+        result.reason = QStringLiteral("load error");
+        result.nsecs = timer.nsecsElapsed();
+        return;
+    }
+    // Start COG #0 at $00000 like the booter does after loading an image
+    hub->coginit(0, 0, 0);
+
+    P2Cog* cog0 = hub->cog(0);
+    const int ticks = m_use_stop_pc ? 1 : slice_ticks;
+    result.reason = QStringLiteral("cycle limit");
+    while (hub->count() < m_cycles) {
+        if (m_use_stop_pc && cog0->rd_PC() == m_stop_pc) {
+            result.reason = QStringLiteral("stop address reached");
+            break;
+        }
+        if (m_timeout && static_cast<p2_QUAD>(timer.elapsed()) >= m_timeout) {
+            result.reason = QStringLiteral("timeout");
+            break;
+        }
+        const p2_QUAD left = m_cycles - hub->count();
+        const int run = static_cast<int>(qMin<p2_QUAD>(left, static_cast<p2_QUAD>(ticks)));
+        hub->execute(run * m_cogs * 2);
+    }
+
+    result.cycles = hub->count();
+    result.instructions = hub->retired();
+    result.idle = hub->fast_forwarded();
+    result.checksum = fnv1a_basis;
+    for (p2_LONG page = 0; page < PAGE_COUNT; page++)
+        result.checksum = fnv1a(result.checksum, hub->rd_page(page), PAGE_SIZE);
+    for (int id = 0; id < m_cogs; id++)
+        result.pc += hub->cog(id)->rd_PC();
+    result.nsecs = timer.nsecsElapsed();
+}
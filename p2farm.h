@@ -0,0 +1,119 @@
+/****************************************************************************
+ *
+ * P2 emulator batch runs of many object files
+ *
+ * Copyright (C) 2019 Jürgen Buchmüller <pullmoll@t-online.de>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ ****************************************************************************/
+#pragma once
+#include <QByteArray>
+#include <QMutex>
+#include <QString>
+#include <QVector>
+#include "p2defs.h"
+#include "p2hub.h"
+
+/**
+ * @file Batch runs of many object files, each on a P2Hub of its own.
+ *
+ * P2Farm runs its jobs on a number of worker threads. Every worker gets
+ * an equal share of the jobs in a queue of its own and takes them from
+ * the back. A worker whose queue is empty steals from the front of the
+ * longest other queue, so a few long runs do not leave the remaining
+ * workers idle.
+ *
+ * Every job creates, runs, and destroys its own P2Hub. The only state
+ * shared between the jobs is P2Cog's process wide dispatch and translator
+ * mode, which has to be set before run().
+ */
+
+//! Result of one job
+typedef struct {
+    QString filename;           //!< object file run by the job
+    QString reason;             //!< what stopped the run
+    int worker;                 //!< worker which ran the job
+    bool stolen;                //!< true, if the job was stolen from another worker's queue
+    p2_QUAD cycles;             //!< emulated cycles
+    p2_QUAD instructions;       //!< retired instructions
+    p2_QUAD idle;               //!< cycles skipped while all COGs were waiting
+    qint64 nsecs;               //!< host time of the run
+    p2_QUAD checksum;           //!< FNV-1a hash of the HUB memory at the end
+    QVector<p2_LONG> pc;        //!< PC of every COG at the end
+}   p2_FARM_result_t;
+
+class P2Farm
+{
+public:
+    explicit P2Farm();
+
+    int workers() const;
+    void set_workers(int workers);
+    int cogs() const;
+    void set_cogs(int ncogs);
+    p2_QUAD cycles() const;
+    void set_cycles(p2_QUAD cycles);
+    bool has_stop_pc() const;
+    p2_LONG stop_pc() const;
+    void set_stop_pc(p2_LONG pc);
+    p2_QUAD timeout() const;
+    void set_timeout(p2_QUAD msecs);
+    p2_HUB_timing_e timing() const;
+    void set_timing(p2_HUB_timing_e timing);
+    bool fast_forward() const;
+    void set_fast_forward(bool on);
+
+    void add(const QString& filename);
+    int count() const;
+    const p2_FARM_result_t& result(int idx) const;
+    int stolen() const;
+    int failed() const;
+
+    void run();
+    QByteArray report() const;
+
+private:
+    class Worker;
+
+    int m_workers;                  //!< number of worker threads
+    int m_cogs;                     //!< number of COGs per P2Hub
+    p2_QUAD m_cycles;               //!< cycle limit per job
+    bool m_use_stop_pc;             //!< true, if a job stops at m_stop_pc
+    p2_LONG m_stop_pc;              //!< address at which COG #0 stops a job
+    p2_QUAD m_timeout;              //!< host time limit per job in milliseconds
+    p2_HUB_timing_e m_timing;       //!< HUB timing of the P2Hubs
+    bool m_fast_forward;            //!< true to skip cycles while all COGs are waiting
+    QVector<p2_FARM_result_t> m_results;    //!< one result per job
+    QVector<QVector<int>> m_queues;         //!< job indices per worker
+    QMutex m_mutex;                 //!< protects the queues and m_stolen
+    int m_stolen;                   //!< number of jobs stolen from other workers
+    qint64 m_nsecs;                 //!< host time of the last run()
+
+    int take(int worker, bool* stolen);
+    void run_job(int idx, int worker, bool stolen);
+};
@@ -0,0 +1,765 @@
+/****************************************************************************
+ *
+ * P2 emulator GDB remote serial protocol server
+ *
+ * Copyright (C) 2019 Jürgen Buchmüller <pullmoll@t-online.de>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ ****************************************************************************/
+#include "p2gdb.h"
+#include "p2hub.h"
+#include "p2cog.h"
+#include "p2memmap.h"
+
+//! Number of registers per COG in the register packets
+static constexpr int gdb_registers = 7;
+
+//! Address of the whole HUB memory in the address space of the client
+static constexpr p2_LONG gdb_hub_addr0 = MEM_SIZE;
+
+//! Maximum number of bytes in a memory read reply
+static constexpr p2_LONG gdb_read_max = 0x7f0;
+
+//! Number of ticks to run between two checks for an interrupt by the client
+static constexpr int continue_ticks = 1 << 14;
+
+//! Number of ticks after which a step of a waiting COG gives up
+static constexpr p2_QUAD step_ticks = Q_UINT64_C(1) << 20;
+
+//! Signal numbers of the stop replies
+static constexpr int sig_int = 2;
+static constexpr int sig_trap = 5;
+
+//! Target description of the registers of a COG
+static const char target_xml[] =
+        "<?xml version=\"1.0\"?>"
+        "<!DOCTYPE target SYSTEM \"gdb-target.dtd\">"
+        "<target version=\"1.0\">"
+        "<feature name=\"org.propeller2.cog\">"
+        "<reg name=\"pc\" bitsize=\"32\" type=\"code_ptr\" regnum=\"0\"/>"
+        "<reg name=\"c\" bitsize=\"32\" type=\"uint32\"/>"
+        "<reg name=\"z\" bitsize=\"32\" type=\"uint32\"/>"
+        "<reg name=\"pa\" bitsize=\"32\" type=\"uint32\"/>"
+        "<reg name=\"pb\" bitsize=\"32\" type=\"uint32\"/>"
+        "<reg name=\"ptra\" bitsize=\"32\" type=\"data_ptr\"/>"
+        "<reg name=\"ptrb\" bitsize=\"32\" type=\"data_ptr\"/>"
+        "</feature>"
+        "</target>";
+
+/**
+ * @brief Format a byte as two hexadecimal digits
+ * @param val byte
+ * @return hexadecimal digits
+ */
+static QByteArray hex_byte(p2_BYTE val)
+{
+    static const char digits[] = "0123456789abcdef";
+    QByteArray result;
+    result += digits[val >> 4];
+    result += digits[val & 15];
+    return result;
+}
+
+/**
+ * @brief Format a long as eight hexadecimal digits in target (little endian) byte order
+ * @param val long
+ * @return hexadecimal digits
+ */
+static QByteArray hex_long(p2_LONG val)
+{
+    QByteArray result;
+    for (int i = 0; i < sz_LONG; i++, val >>= 8)
+        result += hex_byte(static_cast<p2_BYTE>(val));
+    return result;
+}
+
+/**
+ * @brief Parse eight hexadecimal digits in target (little endian) byte order
+ * @param str hexadecimal digits
+ * @param val reference to the long to set
+ * @return true on success, or false on error
+ */
+static bool parse_long(const QByteArray& str, p2_LONG& val)
+{
+    if (str.size() != 2 * sz_LONG)
+        return false;
+    val = 0;
+    for (int i = sz_LONG - 1; i >= 0; i--) {
+        bool ok;
+        const p2_LONG byte = str.mid(2 * i, 2).toUInt(&ok, 16);
+        if (!ok)
+            return false;
+        val = (val << 8) | byte;
+    }
+    return true;
+}
+
+/**
+ * @brief Parse a hexadecimal number
+ * @param str hexadecimal digits
+ * @param val reference to the value to set
+ * @return true on success, or false on error
+ */
+static bool parse_hex(const QByteArray& str, p2_LONG& val)
+{
+    bool ok;
+    val = str.toUInt(&ok, 16);
+    return ok;
+}
+
+/**
+ * @brief Parse an "address,length" pair of hexadecimal numbers
+ * @param str string to parse
+ * @param addr reference to the address to set
+ * @param size reference to the length to set
+ * @return true on success, or false on error
+ */
+static bool parse_range(const QByteArray& str, p2_LONG& addr, p2_LONG& size)
+{
+    const int comma = str.indexOf(',');
+    return comma > 0 && parse_hex(str.left(comma), addr) && parse_hex(str.mid(comma + 1), size);
+}
+
+P2GdbServer::P2GdbServer(P2Hub* hub)
+    : m_hub(hub)
+    , m_server()
+    , m_socket()
+    , m_input()
+    , m_stop()
+    , m_noack(false)
+    , m_cog(0)
+    , m_step_cog(-1)
+{
+}
+
+/**
+ * @brief Listen for a client on a TCP port of the local host
+ * @param port port number, or 0 to pick a free port
+ * @return true on success, or false on error
+ */
+bool P2GdbServer::listen(quint16 port)
+{
+    return m_server.listen(QHostAddress::LocalHost, port);
+}
+
+/**
+ * @brief Return the port the server listens on
+ * @return port number
+ */
+quint16 P2GdbServer::port() const
+{
+    return m_server.serverPort();
+}
+
+/**
+ * @brief Return a description of the last error of the server
+ * @return error string
+ */
+QString P2GdbServer::errorString() const
+{
+    return m_server.errorString();
+}
+
+/**
+ * @brief Wait for a client and handle its packets until it detaches, kills, or disconnects
+ *
+ * The HUB is stopped, except while the client continues or steps it.
+ *
+ * @return true if a client was served, or false on error
+ */
+bool P2GdbServer::serve()
+{
+    if (!m_server.waitForNewConnection(-1))
+        return false;
+    m_socket.reset(m_server.nextPendingConnection());
+    if (!m_socket)
+        return false;
+    m_socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+
+    m_input.clear();
+    m_noack = false;
+    m_cog = 0;
+    m_step_cog = -1;
+    m_stop = stop_reply(sig_trap);
+    m_hub->arm_breakpoints(true);
+
+    QByteArray packet;
+    bool done = false;
+    while (!done && receive(packet)) {
+        // kill has no reply
+        if (packet == QByteArray("k"))
+            break;
+        send(handle(packet, done));
+    }
+    m_socket->close();
+    m_socket.reset();
+    return true;
+}
+
+/**
+ * @brief Receive the next packet, and acknowledge it unless in no-ack mode
+ *
+ * Acknowledgements and interrupts received while the HUB is stopped are dropped.
+ *
+ * @param packet reference to the packet data to set
+ * @return true on success, or false if the client disconnected
+ */
+bool P2GdbServer::receive(QByteArray& packet)
+{
+    for (;;) {
+        const int start = m_input.indexOf('$');
+        if (start < 0) {
+            m_input.clear();
+        } else {
+            const int end = m_input.indexOf('#', start);
+            if (end > 0 && end + 2 < m_input.size()) {
+                packet = m_input.mid(start + 1, end - start - 1);
+                bool ok;
+                const p2_LONG checksum = m_input.mid(end + 1, 2).toUInt(&ok, 16);
+                m_input = m_input.mid(end + 3);
+                p2_BYTE sum = 0;
+                for (int i = 0; i < packet.size(); i++)
+                    sum += static_cast<p2_BYTE>(packet.at(i));
+                if (m_noack)
+                    return true;
+                if (ok && checksum == sum) {
+                    m_socket->write(QByteArray("+"));
+                    return true;
+                }
+                m_socket->write(QByteArray("-"));
+                continue;
+            }
+        }
+        if (!m_socket->waitForReadyRead(-1))
+            return false;
+        m_input += m_socket->readAll();
+    }
+}
+
+/**
+ * @brief Check for an interrupt (Ctrl-C) from the client without waiting
+ * @return true if the client interrupted or disconnected
+ */
+bool P2GdbServer::interrupted()
+{
+    if (m_socket->waitForReadyRead(0))
+        m_input += m_socket->readAll();
+    const int idx = m_input.indexOf('\x03');
+    if (idx < 0)
+        return QAbstractSocket::ConnectedState != m_socket->state();
+    QByteArray rest = m_input.left(idx);
+    rest += m_input.mid(idx + 1);
+    m_input = rest;
+    return true;
+}
+
+/**
+ * @brief Send a packet, escaping the characters with a meaning in the protocol
+ * @param data packet data; empty for an unsupported request
+ */
+void P2GdbServer::send(const QByteArray& data)
+{
+    QByteArray packet("$");
+    p2_BYTE sum = 0;
+    for (int i = 0; i < data.size(); i++) {
+        char ch = data.at(i);
+        if ('$' == ch || '#' == ch || '}' == ch || '*' == ch) {
+            packet += '}';
+            sum += static_cast<p2_BYTE>('}');
+            ch ^= 0x20;
+        }
+        packet += ch;
+        sum += static_cast<p2_BYTE>(ch);
+    }
+    packet += '#';
+    packet += hex_byte(sum);
+    m_socket->write(packet);
+    m_socket->waitForBytesWritten(-1);
+}
+
+/**
+ * @brief Handle a packet
+ * @param packet packet data
+ * @param done reference to a flag set to true when the client detaches
+ * @return reply; empty if the request is not supported
+ */
+QByteArray P2GdbServer::handle(const QByteArray& packet, bool& done)
+{
+    if (packet.isEmpty())
+        return QByteArray();
+    const QByteArray args = packet.mid(1);
+    p2_LONG addr = 0;
+    p2_LONG size = 0;
+    p2_LONG val = 0;
+
+    switch (packet.at(0)) {
+    case '?':
+        return m_stop;
+
+    case 'g':
+        {
+            QByteArray reply;
+            for (int regnum = 0; regnum < gdb_registers; regnum++)
+                reply += hex_long(rd_reg(regnum));
+            return reply;
+        }
+
+    case 'G':
+        for (int regnum = 0; regnum < gdb_registers; regnum++)
+            if (!parse_long(args.mid(regnum * 2 * sz_LONG, 2 * sz_LONG), val) || !wr_reg(regnum, val))
+                return QByteArray("E01");
+        return QByteArray("OK");
+
+    case 'p':
+        if (!parse_hex(args, addr) || addr >= gdb_registers)
+            return QByteArray("E01");
+        return hex_long(rd_reg(static_cast<int>(addr)));
+
+    case 'P':
+        {
+            const int eq = args.indexOf('=');
+            if (eq < 0 || !parse_hex(args.left(eq), addr) || !parse_long(args.mid(eq + 1), val) ||
+                    !wr_reg(static_cast<int>(addr), val))
+                return QByteArray("E01");
+            return QByteArray("OK");
+        }
+
+    case 'm':
+        {
+            QByteArray data;
+            if (!parse_range(args, addr, size) || !rd_memory(addr, qMin(size, gdb_read_max), data))
+                return QByteArray("E01");
+            return data.toHex();
+        }
+
+    case 'M':
+        {
+            const int colon = args.indexOf(':');
+            if (colon < 0 || !parse_range(args.left(colon), addr, size))
+                return QByteArray("E01");
+            const QByteArray data = QByteArray::fromHex(args.mid(colon + 1));
+            if (static_cast<p2_LONG>(data.size()) != size || !wr_memory(addr, data))
+                return QByteArray("E01");
+            return QByteArray("OK");
+        }
+
+    case 'Z':
+    case 'z':
+        {
+            const QList<QByteArray> fields = args.split(',');
+            if (fields.count() < 3 || !parse_hex(fields[1], addr) || !parse_hex(fields[2], size))
+                return QByteArray("E01");
+            const int type = fields[0].toInt();
+            if (type < 0 || type > 4)
+                return QByteArray();
+            if (!set_point(type, addr, size, 'Z' == packet.at(0)))
+                return QByteArray("E01");
+            return QByteArray("OK");
+        }
+
+    case 'c':
+        return run(-1);
+
+    case 's':
+        return run(m_step_cog >= 0 ? m_step_cog : m_cog);
+
+    case 'H':
+        {
+            const int id = thread_cog(args.mid(1));
+            if (id < -1)
+                return QByteArray("E01");
+            if (args.startsWith('g')) {
+                if (id >= 0)
+                    m_cog = id;
+            } else {
+                m_step_cog = id;
+            }
+            return QByteArray("OK");
+        }
+
+    case 'T':
+        return thread_cog(args) >= 0 ? QByteArray("OK") : QByteArray("E01");
+
+    case 'q':
+    case 'Q':
+        return query(packet);
+
+    case 'v':
+        return vcont(packet);
+
+    case 'D':
+        done = true;
+        return QByteArray("OK");
+    }
+    return QByteArray();
+}
+
+/**
+ * @brief Handle a general query or set packet
+ * @param packet packet data starting with 'q' or 'Q'
+ * @return reply; empty if the query is not supported
+ */
+QByteArray P2GdbServer::query(const QByteArray& packet)
+{
+    if (packet.startsWith("qSupported"))
+        return QByteArray("PacketSize=1000;qXfer:features:read+;QStartNoAckMode+;vContSupported+");
+
+    if (packet == QByteArray("QStartNoAckMode")) {
+        m_noack = true;
+        return QByteArray("OK");
+    }
+
+    if (packet == QByteArray("qAttached"))
+        return QByteArray("1");
+
+    if (packet == QByteArray("qC")) {
+        QByteArray reply("QC");
+        reply += QByteArray::number(static_cast<uint>(m_cog + 1), 16);
+        return reply;
+    }
+
+    if (packet == QByteArray("qfThreadInfo")) {
+        QByteArray reply("m");
+        for (int id = 0; id < m_hub->ncogs(); id++) {
+            if (id)
+                reply += ',';
+            reply += QByteArray::number(static_cast<uint>(id + 1), 16);
+        }
+        return reply;
+    }
+
+    if (packet == QByteArray("qsThreadInfo"))
+        return QByteArray("l");
+
+    if (packet.startsWith("qThreadExtraInfo,")) {
+        const int id = thread_cog(packet.mid(17));
+        if (id < 0)
+            return QByteArray("E01");
+        const P2Cog* cog = m_hub->cog(id);
+        const QString info = QString("COG #%1%2")
+                             .arg(id)
+                             .arg(cog->halted() ? QStringLiteral(" halted")
+                                  : cog->rd_WAIT().flag ? QStringLiteral(" waiting") : QString());
+        return info.toLatin1().toHex();
+    }
+
+    if (packet.startsWith("qXfer:features:read:")) {
+        const QList<QByteArray> fields = packet.split(':');
+        p2_LONG offset = 0;
+        p2_LONG length = 0;
+        if (fields.count() != 5 || !parse_range(fields[4], offset, length))
+            return QByteArray("E01");
+        if (fields[3] != QByteArray("target.xml"))
+            return QByteArray("E00");
+        const QByteArray xml(target_xml);
+        const QByteArray chunk = xml.mid(static_cast<int>(qMin<p2_LONG>(offset, static_cast<p2_LONG>(xml.size()))),
+                                         static_cast<int>(length));
+        const bool last = offset + length >= static_cast<p2_LONG>(xml.size());
+        QByteArray reply(last ? "l" : "m");
+        reply += chunk;
+        return reply;
+    }
+
+    if (packet.startsWith("qSymbol"))
+        return QByteArray("OK");
+
+    return QByteArray();
+}
+
+/**
+ * @brief Handle a 'v' packet
+ *
+ * A vCont action list steps if it has a step action, and continues otherwise.
+ *
+ * @param packet packet data starting with 'v'
+ * @return reply; empty if the packet is not supported
+ */
+QByteArray P2GdbServer::vcont(const QByteArray& packet)
+{
+    if (packet == QByteArray("vCont?"))
+        return QByteArray("vCont;c;C;s;S");
+
+    if (!packet.startsWith("vCont;"))
+        return QByteArray();
+
+    const QList<QByteArray> actions = packet.mid(6).split(';');
+    for (const QByteArray& action : actions) {
+        if (!action.startsWith('s') && !action.startsWith('S'))
+            continue;
+        const int colon = action.indexOf(':');
+        const int id = colon < 0 ? -1 : thread_cog(action.mid(colon + 1));
+        if (id < -1)
+            return QByteArray("E01");
+        return run(id >= 0 ? id : m_cog);
+    }
+    return run(-1);
+}
+
+/**
+ * @brief Continue or step the HUB until a stop
+ *
+ * Continuing runs until a breakpoint or watchpoint is hit, or the client
+ * interrupts. Stepping runs until COG %step_cog has retired an instruction.
+ *
+ * @param step_cog COG to step, or -1 to continue
+ * @return stop reply
+ */
+QByteArray P2GdbServer::run(int step_cog)
+{
+    P2Breakpoints* breakpoints = m_hub->breakpoints();
+    const p2_BREAK_hit_t& hit = breakpoints->hit();
+    const int tick_cycles = 2 * m_hub->ncogs();
+    breakpoints->resume();
+
+    if (step_cog >= 0) {
+        const P2Cog* cog = m_hub->cog(step_cog);
+        const p2_QUAD retired = cog->rd_ICNT();
+        for (p2_QUAD ticks = 0; ticks < step_ticks && cog->rd_ICNT() == retired; ticks++) {
+            m_hub->execute(tick_cycles);
+            if (p2_BREAK_NONE != hit.kind)
+                return m_stop = stop_reply(sig_trap, &hit);
+        }
+        m_cog = step_cog;
+        return m_stop = stop_reply(sig_trap);
+    }
+
+    for (;;) {
+        m_hub->execute(continue_ticks * tick_cycles);
+        if (p2_BREAK_NONE != hit.kind)
+            return m_stop = stop_reply(sig_trap, &hit);
+        if (interrupted())
+            return m_stop = stop_reply(sig_int);
+    }
+}
+
+/**
+ * @brief Make a stop reply, and select the COG of a hit as current thread
+ * @param signal signal number
+ * @param hit pointer to the breakpoint or watchpoint hit, or nullptr
+ * @return stop reply
+ */
+QByteArray P2GdbServer::stop_reply(int signal, const p2_BREAK_hit_t* hit)
+{
+    QByteArray reply("T");
+    reply += hex_byte(static_cast<p2_BYTE>(signal));
+    if (hit) {
+        m_cog = hit->cog;
+        if (p2_BREAK_READ == hit->kind || p2_BREAK_WRITE == hit->kind) {
+            const P2Breakpoints* breakpoints = m_hub->breakpoints();
+            const bool access = breakpoints->test(p2_BREAK_READ, hit->space, hit->addr) &&
+                                breakpoints->test(p2_BREAK_WRITE, hit->space, hit->addr);
+            p2_LONG addr = hit->addr;
+            switch (hit->space) {
+            case p2_BREAK_COG:
+                addr = COG_ADDR0 + addr * sz_LONG;
+                break;
+            case p2_BREAK_LUT:
+                addr = LUT_ADDR0 + addr * sz_LONG;
+                break;
+            case p2_BREAK_HUB:
+                if (addr < HUB_ADDR0)
+                    addr += gdb_hub_addr0;
+                break;
+            }
+            reply += access ? "awatch:" : p2_BREAK_READ == hit->kind ? "rwatch:" : "watch:";
+            reply += QByteArray::number(addr, 16);
+            reply += ';';
+        }
+    }
+    reply += "thread:";
+    reply += QByteArray::number(static_cast<uint>(m_cog + 1), 16);
+    reply += ';';
+    return reply;
+}
+
+/**
+ * @brief Return the COG of a thread id
+ * @param tid hexadecimal thread id, "0" for any, or "-1" for all threads
+ * @return COG id, -1 for any or all threads, or -2 if the thread does not exist
+ */
+int P2GdbServer::thread_cog(const QByteArray& tid) const
+{
+    if (tid == QByteArray("-1") || tid == QByteArray("0"))
+        return -1;
+    p2_LONG id = 0;
+    if (!parse_hex(tid, id) || id < 1 || id > static_cast<p2_LONG>(m_hub->ncogs()))
+        return -2;
+    return static_cast<int>(id) - 1;
+}
+
+/**
+ * @brief Read a register of the current thread
+ * @param regnum register number: PC, C, Z, PA, PB, PTRA, PTRB
+ * @return register value
+ */
+p2_LONG P2GdbServer::rd_reg(int regnum) const
+{
+    const P2Cog* cog = m_hub->cog(m_cog);
+    p2_LONG pc = 0;
+    switch (regnum) {
+    case 0:
+        // the address of the next instruction, after those skipped by SKIPF
+        if (!cog->fetch_pc(pc))
+            pc = cog->rd_PC();
+        return pc;
+    case 1:
+        return cog->rd_C();
+    case 2:
+        return cog->rd_Z();
+    case 3:
+        return cog->rd_cog(offs_PA);
+    case 4:
+        return cog->rd_cog(offs_PB);
+    case 5:
+        return cog->rd_cog(offs_PTRA);
+    case 6:
+        return cog->rd_cog(offs_PTRB);
+    }
+    return 0;
+}
+
+/**
+ * @brief Write a register of the current thread
+ * @param regnum register number: PC, C, Z, PA, PB, PTRA, PTRB
+ * @param val value to write
+ * @return true on success, or false for an invalid register number
+ */
+bool P2GdbServer::wr_reg(int regnum, p2_LONG val)
+{
+    P2Cog* cog = m_hub->cog(m_cog);
+    switch (regnum) {
+    case 0:
+        cog->wr_PC(val);
+        return true;
+    case 1:
+        cog->wr_C(val);
+        return true;
+    case 2:
+        cog->wr_Z(val);
+        return true;
+    case 3:
+        cog->wr_cog(offs_PA, val);
+        return true;
+    case 4:
+        cog->wr_cog(offs_PB, val);
+        return true;
+    case 5:
+        cog->wr_PTRA(val);
+        return true;
+    case 6:
+        cog->wr_PTRB(val);
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Read memory as seen by the current thread
+ * @param addr first address
+ * @param size number of bytes
+ * @param data reference to the bytes to set
+ * @return true on success, or false if the range is outside the memory
+ */
+bool P2GdbServer::rd_memory(p2_LONG addr, p2_LONG size, QByteArray& data) const
+{
+    const P2Cog* cog = m_hub->cog(m_cog);
+    const P2MemMap& map = m_hub->map();
+    if (addr >= 2 * MEM_SIZE || size > 2 * MEM_SIZE - addr)
+        return false;
+    data.clear();
+    for (p2_LONG a = addr; a < addr + size; a++) {
+        if (a >= gdb_hub_addr0) {
+            data += static_cast<char>(map.rd_BYTE(a - gdb_hub_addr0));
+        } else {
+            const p2_LONG val = cog->rd_mem(a & ~3u);
+            data += static_cast<char>(val >> ((a & 3) * 8));
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Write memory as seen by the current thread
+ * @param addr first address
+ * @param data bytes to write
+ * @return true on success, or false if the range is outside the memory
+ */
+bool P2GdbServer::wr_memory(p2_LONG addr, const QByteArray& data)
+{
+    P2Cog* cog = m_hub->cog(m_cog);
+    const P2MemMap& map = m_hub->map();
+    const p2_LONG size = static_cast<p2_LONG>(data.size());
+    if (addr >= 2 * MEM_SIZE || size > 2 * MEM_SIZE - addr)
+        return false;
+    for (p2_LONG i = 0; i < size; i++) {
+        const p2_LONG a = addr + i;
+        const p2_BYTE val = static_cast<p2_BYTE>(data.at(static_cast<int>(i)));
+        if (a >= gdb_hub_addr0) {
+            map.wr_BYTE(a - gdb_hub_addr0, val);
+        } else if (a >= HUB_ADDR0) {
+            map.wr_BYTE(a, val);
+        } else {
+            // COG and LUT memory are written as longs, so the predecoded instruction is dropped
+            const p2_LONG shift = (a & 3) * 8;
+            const p2_LONG old = cog->rd_mem(a & ~3u);
+            cog->wr_mem(a & ~3u, (old & ~(0xffu << shift)) | (static_cast<p2_LONG>(val) << shift));
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Set or remove a breakpoint or watchpoint
+ * @param type 0 or 1 for a breakpoint, 2 for a write, 3 for a read, 4 for an access watchpoint
+ * @param addr first address
+ * @param size number of bytes
+ * @param on true to set, false to remove
+ * @return true on success, or false if the range is outside the memory
+ */
+bool P2GdbServer::set_point(int type, p2_LONG addr, p2_LONG size, bool on)
+{
+    P2Breakpoints* breakpoints = m_hub->breakpoints();
+    if (type < 2) {
+        if (addr >= MEM_SIZE)
+            return false;
+        breakpoints->set_breakpoint(addr, on);
+    } else {
+        if (addr >= 2 * MEM_SIZE || size > 2 * MEM_SIZE - addr)
+            return false;
+        for (p2_LONG a = addr; a < addr + size; a++) {
+            const p2_BREAK_space_e space = a >= gdb_hub_addr0 ? p2_BREAK_HUB : P2Breakpoints::space(a);
+            const p2_LONG index = a >= gdb_hub_addr0 ? a - gdb_hub_addr0 : P2Breakpoints::index(a);
+            if (3 != type)
+                breakpoints->set(p2_BREAK_WRITE, space, index, on);
+            if (2 != type)
+                breakpoints->set(p2_BREAK_READ, space, index, on);
+        }
+    }
+    m_hub->arm_breakpoints(true);
+    return true;
+}
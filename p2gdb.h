@@ -0,0 +1,102 @@
+/****************************************************************************
+ *
+ * P2 emulator GDB remote serial protocol server
+ *
+ * Copyright (C) 2019 Jürgen Buchmüller <pullmoll@t-online.de>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ ****************************************************************************/
+#pragma once
+#include <QByteArray>
+#include <QScopedPointer>
+#include <QString>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include "p2defs.h"
+#include "p2break.h"
+
+class P2Hub;
+class P2Cog;
+
+/**
+ * @file GDB remote serial protocol server.
+ *
+ * P2GdbServer lets GDB, or any script speaking the remote serial
+ * protocol, debug a P2Hub over a TCP port on the local host. Every COG
+ * is a thread (thread id = COG id + 1). The registers of a thread are
+ * PC, C, Z, PA, PB, PTRA, and PTRB, 32 bits each; the target description
+ * names them for GDB.
+ *
+ * Memory addresses are those of the COGs' PC: $00000 … $007ff is the
+ * COG memory and $00800 … $00fff the LUT memory of the current thread,
+ * $01000 … $fffff is HUB memory. The whole HUB memory, including its
+ * first 4KiB, is also at $100000 … $1fffff.
+ *
+ * Breakpoints (Z0, Z1) and watchpoints (Z2 write, Z3 read, Z4 access) go
+ * to the HUB's P2Breakpoints. The COGs run in lockstep, so continuing
+ * or stepping one thread runs all of them; a step ends when the stepped
+ * COG has retired one instruction.
+ */
+
+class P2GdbServer
+{
+public:
+    explicit P2GdbServer(P2Hub* hub);
+
+    bool listen(quint16 port);
+    quint16 port() const;
+    QString errorString() const;
+    bool serve();
+
+private:
+    P2Hub* m_hub;                   //!< HUB being debugged
+    QTcpServer m_server;            //!< server listening for a client
+    QScopedPointer<QTcpSocket> m_socket;    //!< connection to the client
+    QByteArray m_input;             //!< bytes received and not yet handled
+    QByteArray m_stop;              //!< last stop reply
+    bool m_noack;                   //!< true after QStartNoAckMode
+    int m_cog;                      //!< COG of register and memory accesses (Hg)
+    int m_step_cog;                 //!< COG to step (Hc), or -1 for the current one
+
+    bool receive(QByteArray& packet);
+    bool interrupted();
+    void send(const QByteArray& data);
+    QByteArray handle(const QByteArray& packet, bool& done);
+    QByteArray query(const QByteArray& packet);
+    QByteArray vcont(const QByteArray& packet);
+
+    QByteArray run(int step_cog);
+    QByteArray stop_reply(int signal, const p2_BREAK_hit_t* hit = nullptr);
+    int thread_cog(const QByteArray& tid) const;
+
+    p2_LONG rd_reg(int regnum) const;
+    bool wr_reg(int regnum, p2_LONG val);
+    bool rd_memory(p2_LONG addr, p2_LONG size, QByteArray& data) const;
+    bool wr_memory(p2_LONG addr, const QByteArray& data);
+    bool set_point(int type, p2_LONG addr, p2_LONG size, bool on);
+};
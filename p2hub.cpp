@@ -36,28 +36,70 @@
 #include <QFile>
 #include "p2hub.h"
 #include "p2cog.h"
+#include "p2cogthread.h"
+#include "p2serial.h"
+
+/**
+ * @brief Return a page of zeroes, which all HUBs share until they write to it
+ * @return const reference to the page
+ */
+static const QByteArray& zero_page()
+{
+    static const QByteArray page(static_cast<int>(PAGE_SIZE), '\0');
+    return page;
+}
 
 P2Hub::P2Hub(int ncogs, QObject* parent)
     : QObject(parent)
     , XORO128_s0(1)
     , XORO128_s1(0)
     , CNT(0)
+    , RND(0)
     , PIN(0)
+    , DIR(0)
+    , OUT(0)
+    , IN(0)
+    , MUX(0)
     , COGS()
+    , THREADS()
+    , THREADS_mutex()
+    , THREADS_idle()
     , nCOGS(ncogs)
     , mCOGS(ncogs - 1)
-    , pin_mode(64, 0)
-    , pin_X(64, 0)
-    , pin_Y(64, 0)
+    , LOCK(0)
     , scope_pin0(0)
     , scope_enable(false)
-    , MEM()
+    , ffwd_enable(true)
+    , ffwd_cycles(0)
+    , TIMING(p2_HUB_APPROXIMATE)
+    , SLOTS()
+    , TRACE(P2_TRACE_LEVEL > 0 ? 16 : 0)
+    , MAP()
+    , CORDIC()
+    , PINS()
+    , BREAKPOINTS()
+    , BREAK(nullptr)
+    , BREAK_armed(false)
+    , BREAK_cog(0)
+    , SERIAL(nullptr)
+    , RAM(static_cast<int>(PAGE_COUNT), zero_page())
 {
     Q_ASSERT(ncogs <= 16);
+    map_pages();
+    // COG #id has the window to slice (CNT - id) & mCOGS
+    for (int id = 0; id < ncogs; id++)
+        for (int slice = 0; slice < ncogs; slice++)
+            for (int phase = 0; phase < ncogs; phase++)
+                SLOTS[id][slice][phase] = static_cast<p2_BYTE>((slice + id - phase) & (ncogs - 1));
     for (int idx = 0; idx < ncogs; idx++)
         COGS += (new P2Cog(idx, this));
 }
 
+P2Hub::~P2Hub()
+{
+    set_parallel(false);
+}
+
 /**
  * @brief Execute COGs round robin for %run_cycles
  * @param run_cycles number of cycles to run COGs
@@ -65,16 +107,71 @@ P2Hub::P2Hub(int ncogs, QObject* parent)
  */
 int P2Hub::execute(int run_cycles)
 {
+    if (BREAK)
+        return execute_break(run_cycles);
+    if (!THREADS.isEmpty())
+        return execute_parallel(run_cycles);
+
+    P2_TRACE(p2_TRACE_HUB, TRACE, CNT, p2_TRACE_EXECUTE, 0, 0, static_cast<p2_LONG>(run_cycles));
+    while (run_cycles > 0) {
+        if (ffwd_enable) {
+            const int skipped = skip_idle(run_cycles);
+            if (skipped) {
+                run_cycles -= skipped;
+                continue;
+            }
+        }
+        xoro128();
+        for (int id = 0; id < nCOGS; id++) {
+            P2Cog* cog = COGS[id];
+            P2_TRACE(p2_TRACE_COG, TRACE, CNT, p2_TRACE_GOX, id, cog->rd_PC(), static_cast<p2_LONG>(run_cycles));
+            run_cycles -= cog->gox();
+        }
+        for (int id = 0; id < nCOGS; id++) {
+            P2Cog* cog = COGS[id];
+            P2_TRACE(p2_TRACE_COG, TRACE, CNT, p2_TRACE_GET, id, cog->rd_PC(), cog->rd_IR().opcode);
+            run_cycles -= cog->get();
+        }
+        CNT++;
+    }
+    return run_cycles;
+}
+
+/**
+ * @brief Execute the COGs serially until a breakpoint or watchpoint is hit
+ *
+ * This is the loop of execute() with the checks of the armed breakpoints.
+ * It stops before a COG fetches an instruction at a breakpoint, and after
+ * a cycle in which a watchpoint was hit. To continue, the hit is resumed
+ * with P2Breakpoints::resume().
+ *
+ * @param run_cycles number of cycles to run COGs
+ * @return cycles left to run when stopped by a hit, or cycles actually run (may be < 0)
+ */
+int P2Hub::execute_break(int run_cycles)
+{
+    P2_TRACE(p2_TRACE_HUB, TRACE, CNT, p2_TRACE_EXECUTE, 0, 0, static_cast<p2_LONG>(run_cycles));
     while (run_cycles > 0) {
+        if (p2_BREAK_NONE != BREAK->hit().kind || break_fetch())
+            break;
+        if (ffwd_enable) {
+            const int skipped = skip_idle(run_cycles);
+            if (skipped) {
+                run_cycles -= skipped;
+                continue;
+            }
+        }
         xoro128();
         for (int id = 0; id < nCOGS; id++) {
             P2Cog* cog = COGS[id];
-            qDebug("%s: COG #%x gox (%d cycles left)", __func__, id, run_cycles);
+            BREAK_cog = id;
+            P2_TRACE(p2_TRACE_COG, TRACE, CNT, p2_TRACE_GOX, id, cog->rd_PC(), static_cast<p2_LONG>(run_cycles));
             run_cycles -= cog->gox();
         }
         for (int id = 0; id < nCOGS; id++) {
             P2Cog* cog = COGS[id];
-            qDebug("%s: COG #%x get (%d cycles left)", __func__, id, run_cycles);
+            BREAK_cog = id;
+            P2_TRACE(p2_TRACE_COG, TRACE, CNT, p2_TRACE_GET, id, cog->rd_PC(), cog->rd_IR().opcode);
             run_cycles -= cog->get();
         }
         CNT++;
@@ -82,6 +179,314 @@ int P2Hub::execute(int run_cycles)
     return run_cycles;
 }
 
+/**
+ * @brief Check the addresses the COGs will fetch from in this cycle
+ * @return true if a COG is at a breakpoint, which is then recorded as hit
+ */
+bool P2Hub::break_fetch()
+{
+    for (int id = 0; id < nCOGS; id++) {
+        p2_LONG pc;
+        if (!COGS[id]->fetch_pc(pc) || BREAK->resumed(CNT, id) || !BREAK->breakpoint(pc))
+            continue;
+        BREAK->record(p2_BREAK_EXEC, P2Breakpoints::space(pc), P2Breakpoints::index(pc), id, pc, CNT);
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Record a hit if a watchpoint is set for a HUB memory access
+ * @param kind p2_BREAK_READ or p2_BREAK_WRITE
+ * @param addr first address
+ * @param size number of bytes
+ */
+void P2Hub::break_watch(p2_BREAK_e kind, p2_LONG addr, p2_LONG size) const
+{
+    if (!BREAK->test(kind, p2_BREAK_HUB, addr, size))
+        return;
+    // record the first watched byte of a block
+    while (!BREAK->test(kind, p2_BREAK_HUB, addr))
+        addr++;
+    BREAK->record(kind, p2_BREAK_HUB, addr & A20MASK, BREAK_cog, COGS[BREAK_cog]->rd_IR_PC(), CNT);
+}
+
+/**
+ * @brief Skip the CNT ticks in which all COGs are only waiting
+ *
+ * Jumps CNT to the last cycle before the first COG's wait ends, or
+ * to the end of %run_cycles. RND is advanced by the skipped ticks,
+ * and the COGs update their CTx event flags, so the state is the same
+ * as after executing the ticks one by one.
+ *
+ * @param run_cycles number of cycles left to run
+ * @return number of cycles skipped
+ */
+int P2Hub::skip_idle(int run_cycles)
+{
+    const int tick_cycles = 2 * nCOGS;
+    p2_LONG ticks = static_cast<p2_LONG>((run_cycles + tick_cycles - 1) / tick_cycles);
+    for (int id = 0; id < nCOGS && ticks > 0; id++)
+        ticks = qMin(ticks, COGS[id]->idle());
+    if (0 == ticks)
+        return 0;
+
+    for (p2_LONG i = 0; i < ticks; i++)
+        xoro128();
+    for (int id = 0; id < nCOGS; id++)
+        COGS[id]->fast_forward(ticks);
+    CNT += ticks;
+    ffwd_cycles += ticks;
+    return static_cast<int>(ticks) * tick_cycles;
+}
+
+/**
+ * @brief Return true, if idle cycles are skipped
+ * @return true if enabled
+ */
+bool P2Hub::fast_forward() const
+{
+    return ffwd_enable;
+}
+
+/**
+ * @brief Enable or disable skipping cycles in which all COGs are waiting
+ * @param on true to enable
+ */
+void P2Hub::set_fast_forward(bool on)
+{
+    ffwd_enable = on;
+}
+
+/**
+ * @brief Return the accuracy of the HUB memory timing
+ * @return one of p2_HUB_timing_e
+ */
+p2_HUB_timing_e P2Hub::timing() const
+{
+    return TIMING;
+}
+
+/**
+ * @brief Set the accuracy of the HUB memory timing
+ * @param timing one of p2_HUB_timing_e
+ */
+void P2Hub::set_timing(p2_HUB_timing_e timing)
+{
+    TIMING = timing;
+}
+
+/**
+ * @brief Return the breakpoints and watchpoints
+ *
+ * After changing them, arm_breakpoints() makes the change effective.
+ *
+ * @return pointer to the breakpoints
+ */
+P2Breakpoints* P2Hub::breakpoints()
+{
+    return &BREAKPOINTS;
+}
+
+/**
+ * @brief Return true, if the breakpoints are armed
+ * @return true if armed
+ */
+bool P2Hub::breakpoints_armed() const
+{
+    return BREAK_armed;
+}
+
+/**
+ * @brief Arm or disarm the breakpoints and watchpoints
+ *
+ * While armed and not empty, execute() runs the COGs serially, without
+ * translated blocks, and stops at hits. Otherwise the breakpoints cost
+ * nothing but a test of a null pointer.
+ *
+ * @param on true to arm
+ */
+void P2Hub::arm_breakpoints(bool on)
+{
+    BREAK_armed = on;
+    BREAK = on && !BREAKPOINTS.isEmpty() ? &BREAKPOINTS : nullptr;
+    for (int id = 0; id < nCOGS; id++)
+        COGS[id]->set_breakpoints(BREAK);
+}
+
+/**
+ * @brief Return the number of CNT ticks skipped while all COGs were waiting
+ * @return number of ticks
+ */
+p2_QUAD P2Hub::fast_forwarded() const
+{
+    return ffwd_cycles;
+}
+
+/**
+ * @brief Return true, if the COGs are executed on worker threads
+ * @return true in parallel mode
+ */
+bool P2Hub::parallel() const
+{
+    return !THREADS.isEmpty();
+}
+
+/**
+ * @brief Switch between serial and parallel execution of the COGs
+ * @param on true to start a worker thread per COG, false to stop them
+ */
+void P2Hub::set_parallel(bool on)
+{
+    if (on == parallel())
+        return;
+    if (on) {
+        for (int id = 0; id < nCOGS; id++) {
+            P2CogThread* thread = new P2CogThread(COGS[id], &THREADS_mutex, &THREADS_idle, this);
+            thread->start();
+            THREADS += thread;
+        }
+    } else {
+        for (int id = 0; id < THREADS.count(); id++) {
+            THREADS[id]->stop();
+            delete THREADS[id];
+        }
+        THREADS.clear();
+    }
+}
+
+/**
+ * @brief Advance the parked threads of halted COGs to a shared step
+ *
+ * The steps of the COGs with a lower ID than %id at %pos come before
+ * the shared step in the serial order, so those COGs are advanced past it.
+ *
+ * @param pos position of the shared step, or the end of the slice
+ * @param id ID of the COG executing the shared step
+ */
+void P2Hub::skip_halted(p2_QUAD pos, p2_LONG id)
+{
+    for (int n = 0; n < nCOGS; n++) {
+        P2CogThread* thread = THREADS[n];
+        if (thread->cog()->halted())
+            thread->skip_to(static_cast<p2_LONG>(n) < id ? pos + 1 : pos);
+    }
+}
+
+/**
+ * @brief Execute COGs on their worker threads for %run_cycles
+ *
+ * Every COG spends one cycle in gox() and one in get() per CNT tick,
+ * so the slice is run_cycles / (2 * nCOGS) ticks, rounded up, just
+ * like the serial loop in execute().
+ *
+ * The worker threads run their COGs ahead as long as the steps only
+ * touch the COG's own state. A step touching HUB memory, pins, locks,
+ * or RND is executed here, on the calling thread, once no other COG
+ * can still come up with an earlier one. Steps are ordered by tick,
+ * gox() before get(), and COG ID, which is the order of the serial loop,
+ * so the results are the same, and the same for every run.
+ *
+ * Halted COGs are parked: they run no steps and are only brought up
+ * to the position of a COGINIT or COGSTOP, and to the end of the slice,
+ * by skip_halted(). A COGINIT of a halted COG thus starts it at the
+ * same cycle as in serial mode, and the idle COGs of a program using
+ * fewer than all COGs do not hold back the others.
+ *
+ * The one exception is COGINIT of a running COG: it waits for all
+ * workers to stop and then restarts the target COG at the position the
+ * target has reached, which may be up to one slice later than in
+ * serial mode.
+ *
+ * @param run_cycles number of cycles to run COGs
+ * @return cycles actually run (may be < 0)
+ */
+int P2Hub::execute_parallel(int run_cycles)
+{
+    //! number of private steps run on this thread before resuming a worker
+    static constexpr int parallel_burst = 64;
+
+    if (ffwd_enable)
+        run_cycles -= skip_idle(run_cycles);
+    if (run_cycles <= 0)
+        return run_cycles;
+    P2_TRACE(p2_TRACE_HUB, TRACE, CNT, p2_TRACE_EXECUTE, 0, 0, static_cast<p2_LONG>(run_cycles));
+
+    const int tick_cycles = 2 * nCOGS;
+    const p2_QUAD ticks = static_cast<p2_QUAD>((run_cycles + tick_cycles - 1) / tick_cycles);
+    const p2_QUAD start = CNT;
+    const p2_QUAD limit = 2 * (start + ticks);
+    p2_QUAD rnd_cnt = start;    // next tick to update RND for
+
+    THREADS_mutex.lock();
+    for (int id = 0; id < nCOGS; id++) {
+        THREADS[id]->start_slice(limit);
+        if (!THREADS[id]->blocked())
+            THREADS[id]->resume();
+    }
+
+    for (;;) {
+        // Find the earliest shared step of the stopped COGs
+        P2CogThread* next = nullptr;
+        p2_QUAD at = limit;
+        for (int id = 0; id < nCOGS; id++) {
+            P2CogThread* thread = THREADS[id];
+            if (thread->cog()->halted())
+                continue;
+            if (!thread->running() && thread->position() < at) {
+                next = thread;
+                at = thread->position();
+            }
+        }
+
+        // Wait for the running COGs which may still reach an earlier one,
+        // or for all of them before a COGINIT
+        const bool global = next && p2_SHARE_COGS == next->share();
+        bool wait = false;
+        for (int id = 0; id < nCOGS; id++) {
+            P2CogThread* thread = THREADS[id];
+            if (thread->running() && (global || thread->position() <= at)) {
+                thread->watch(global ? P2CogThread::nowhere : at);
+                wait = true;
+            }
+        }
+        if (wait) {
+            THREADS_idle.wait(&THREADS_mutex);
+            for (int id = 0; id < nCOGS; id++)
+                THREADS[id]->watch(P2CogThread::nowhere);
+            continue;
+        }
+        if (!next)
+            break;
+
+        // Execute the step with CNT and RND at its tick
+        THREADS_mutex.unlock();
+        CNT = at / 2;
+        while (rnd_cnt <= CNT) {
+            xoro128();
+            rnd_cnt++;
+        }
+        if (global)
+            skip_halted(at, next->cog()->rd_ID());
+        next->step();
+        // Short runs of private steps are cheaper here than on the worker
+        for (int n = 0; n < parallel_burst && !next->blocked(); n++)
+            next->step();
+        THREADS_mutex.lock();
+        if (!next->blocked())
+            next->resume();
+    }
+    THREADS_mutex.unlock();
+    skip_halted(limit, 0);
+
+    while (rnd_cnt < start + ticks) {
+        xoro128();
+        rnd_cnt++;
+    }
+    CNT = start + ticks;
+    return run_cycles - static_cast<int>(ticks) * tick_cycles;
+}
+
 /**
  * @brief Load a file into HUB memory
  * @param filename name of the file or resource
@@ -91,28 +496,164 @@ bool P2Hub::load_obj(const QString& filename)
 {
     static const QString booter = QStringLiteral(":/bin/ROM_Booter_v33_01j.bin");
     if (filename != booter) {
+        static const p2_LONG zeroes[PAGE_SIZE / sz_LONG] = {};
         load_obj(booter);
         for (p2_LONG addr = 0; addr < HUB_ADDR0; addr += 4)
             wr_mem(0, addr, 0);
+        wr_page(0, reinterpret_cast<const p2_BYTE*>(zeroes));
     }
     QFile file(filename);
     if (!file.open(QIODevice::ReadOnly))
         return false;
 
-    QByteArray bin = file.read(MEM_SIZE);
+    const QByteArray bin = file.read(MEM_SIZE);
+    const p2_LONG size = static_cast<p2_LONG>(bin.size());
     // qDebug("%s: file=%s size=0x%06x (%d)", __func__, qPrintable(filename), bin.size(), bin.size());
-    for (p2_LONG i = 0; i < static_cast<p2_LONG>(bin.size()); i += 4) {
-        p2_LONG value = // read as little-endian for both endiannesses
-                (static_cast<p2_LONG>(static_cast<p2_BYTE>(bin[i+0])) <<  0) |
-                (static_cast<p2_LONG>(static_cast<p2_BYTE>(bin[i+1])) <<  8) |
-                (static_cast<p2_LONG>(static_cast<p2_BYTE>(bin[i+2])) << 16) |
-                (static_cast<p2_LONG>(static_cast<p2_BYTE>(bin[i+3])) << 24);
-        wr_mem(0, i, value);
+    // read as little-endian for both endiannesses
+    const p2_BYTE* data = reinterpret_cast<const p2_BYTE*>(bin.constData());
+
+    // the first page goes to COG #0's COG and LUT memory
+    for (p2_LONG i = 0; i < size && i < HUB_ADDR0; i += 4)
+        wr_mem(0, i, qFromLittleEndian<p2_LONG>(data + i));
+
+    // the HUB memory is written page by page, so pages which
+    // don't change, e.g. those full of zeroes, stay shared; this
+    // includes the first page, from which RDxxxx, RFxxxx, and the
+    // streamer read, e.g. palettes, while COG #0 executes its copy
+    for (p2_LONG addr = 0; addr < size; addr += PAGE_SIZE) {
+        p2_LONG page[PAGE_SIZE / sz_LONG];
+        memcpy(page, rd_page(addr >> PAGE_SHIFT), PAGE_SIZE);
+        for (p2_LONG i = 0; i < PAGE_SIZE && addr + i < size; i += 4)
+            page[i / sz_LONG] = qFromLittleEndian<p2_LONG>(data + addr + i);
+        wr_page(addr >> PAGE_SHIFT, reinterpret_cast<const p2_BYTE*>(page));
     }
 
     return true;
 }
 
+/**
+ * @brief Return the size of the HUB's state in a snapshot
+ * @return number of bytes written by save_state()
+ */
+p2_LONG P2Hub::state_size() const
+{
+    return 0 P2_HUB_STATE(P2_STATE_SIZE) + PINS.state_size();
+}
+
+/**
+ * @brief Save the HUB's state, but not its memory or COGs
+ * @param dst buffer of state_size() bytes
+ */
+void P2Hub::save_state(p2_BYTE* dst) const
+{
+    P2_HUB_STATE(P2_STATE_SAVE)
+    PINS.save_state(dst);
+}
+
+/**
+ * @brief Restore the HUB's state, but not its memory or COGs
+ * @param src buffer of state_size() bytes
+ */
+void P2Hub::restore_state(const p2_BYTE* src)
+{
+    P2_HUB_STATE(P2_STATE_LOAD)
+    PINS.restore_state(src);
+}
+
+/**
+ * @brief Save the whole machine state to a snapshot file
+ * @param filename name of the file to create
+ * @return true on success, or false on error
+ */
+bool P2Hub::save_snapshot(const QString& filename) const
+{
+    const p2_SNAPSHOT_HEADER_t hdr = P2Snapshot::layout(nCOGS, state_size(), P2Cog::state_size());
+    QByteArray data(static_cast<int>(hdr.file_size), '\0');
+    p2_BYTE* base = reinterpret_cast<p2_BYTE*>(data.data());
+
+    memcpy(base, &hdr, sizeof(hdr));
+    for (p2_LONG page = 0; page < PAGE_COUNT; page++)
+        memcpy(base + hdr.mem_offset + page * PAGE_SIZE, rd_page(page), PAGE_SIZE);
+
+    save_state(base + hdr.hub_offset);
+    for (int id = 0; id < nCOGS; id++)
+        COGS[id]->save_state(base + hdr.cog_offset + static_cast<p2_LONG>(id) * hdr.cog_stride);
+
+    QFile file(filename);
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+    return file.write(data) == data.size();
+}
+
+/**
+ * @brief Restore the whole machine state from a mapped snapshot
+ *
+ * The snapshot must have been saved with the same number of COGs
+ * and the same format version, i.e. its header must be the one
+ * P2Snapshot::layout() gives for this machine.
+ *
+ * @param snap mapped snapshot
+ * @return true on success, or false if the snapshot does not match
+ */
+bool P2Hub::restore_snapshot(const P2Snapshot& snap)
+{
+    const p2_SNAPSHOT_HEADER_t* hdr = snap.header();
+    const p2_SNAPSHOT_HEADER_t expect = P2Snapshot::layout(nCOGS, state_size(), P2Cog::state_size());
+    if (!hdr || memcmp(hdr, &expect, sizeof(expect)))
+        return false;
+
+    for (p2_LONG page = 0; page < PAGE_COUNT; page++)
+        wr_page(page, snap.mem() + page * PAGE_SIZE);
+
+    restore_state(snap.hub());
+    for (int id = 0; id < nCOGS; id++)
+        COGS[id]->restore_state(snap.cog(id));
+    return true;
+}
+
+/**
+ * @brief Make this HUB a copy of the HUB %from
+ *
+ * The HUB memory pages are shared with %from, so a fork costs only the
+ * pages either of them writes to afterwards. The HUB and COG states are
+ * copied like in a snapshot. Settings such as the timing or parallel
+ * execution are not copied.
+ *
+ * @param from HUB to copy
+ * @return true on success, or false if the number of COGs differs
+ */
+bool P2Hub::fork(P2Hub* from)
+{
+    if (from == this || from->nCOGS != nCOGS)
+        return false;
+
+    set_pages(from->share_pages());
+
+    QByteArray data(static_cast<int>(state_size()), '\0');
+    from->save_state(reinterpret_cast<p2_BYTE*>(data.data()));
+    restore_state(reinterpret_cast<const p2_BYTE*>(data.constData()));
+
+    data.resize(static_cast<int>(P2Cog::state_size()));
+    for (int id = 0; id < nCOGS; id++) {
+        from->COGS[id]->save_state(reinterpret_cast<p2_BYTE*>(data.data()));
+        COGS[id]->restore_state(reinterpret_cast<const p2_BYTE*>(data.constData()));
+    }
+    return true;
+}
+
+/**
+ * @brief Restore the whole machine state from a snapshot file
+ * @param filename name of the file
+ * @return true on success, or false on error
+ */
+bool P2Hub::restore_snapshot(const QString& filename)
+{
+    P2Snapshot snap;
+    if (!snap.open(filename))
+        return false;
+    return restore_snapshot(snap);
+}
+
 bool P2Hub::set_pathname(const QString& pathname)
 {
     if (pathname == m_pathname)
@@ -130,30 +671,111 @@ P2Cog* P2Hub::cog(int id)
 }
 
 /**
- * @brief Return a pointer to the HUB memory
- * @return pointer to MEM
+ * @brief Return the number of COGs
+ * @return number of COGs (1 … 16)
  */
-p2_BYTE* P2Hub::mem()
+int P2Hub::ncogs() const
 {
-    return MEM.B;
+    return nCOGS;
+}
+
+/**
+ * @brief Return a pointer to the trace ring buffer
+ * @return pointer to TRACE
+ */
+P2Trace* P2Hub::trace()
+{
+    return &TRACE;
 }
 
 /**
  * @brief Return the size of the HUB memory in bytes
- * @return size of MEM
+ * @return size of the HUB memory
  */
 p2_LONG P2Hub::memsize() const
 {
-    return sizeof(MEM);
+    return MEM_SIZE;
+}
+
+/**
+ * @brief Return the HUB memory map
+ * @return const reference to the memory map
+ */
+const P2MemMap& P2Hub::map() const
+{
+    return MAP;
 }
 
-void P2Hub::coginit(p2_LONG cog, p2_LONG ptra, p2_LONG ptrb)
+/**
+ * @brief Return the CORDIC solver
+ * @return const reference to the solver
+ */
+const P2Cordic& P2Hub::cordic() const
 {
-    int id = static_cast<int>(cog);
-    Q_ASSERT(id < nCOGS);
-    COGS[id]->wr_PC(ptrb);
-    COGS[id]->wr_PTRA(ptra);
-    COGS[id]->wr_PTRB(ptrb);
+    return CORDIC;
+}
+
+/**
+ * @brief Return the smart pins
+ * @return const reference to the smart pins
+ */
+const P2Pins& P2Hub::pins() const
+{
+    return PINS;
+}
+
+/**
+ * @brief Start a COG (COGINIT)
+ *
+ * With D[4] clear D[3:0] selects the COG, with D[4] set the lowest
+ * numbered halted COG is started. With D[5] clear the COG loads 496
+ * longs from HUB %s into its registers $000 … $1EF and starts at $000,
+ * with D[5] set it starts executing at %s (hubexec).
+ *
+ * @param cog value of D
+ * @param ptra value for PTRA (prior SETQ)
+ * @param s start address; also the value for PTRB
+ * @return COG number that was started, or -1 if none
+ */
+int P2Hub::coginit(p2_LONG cog, p2_LONG ptra, p2_LONG s)
+{
+    int id = -1;
+    if (cog & 0x10) {
+        for (int i = 0; i < nCOGS && id < 0; i++)
+            if (COGS[i]->halted())
+                id = i;
+    } else {
+        id = static_cast<int>(cog & 15);
+    }
+    if (id < 0 || id >= nCOGS)
+        return -1;
+
+    P2_TRACE(p2_TRACE_HUB, TRACE, CNT, p2_TRACE_COGINIT, id, s, ptra);
+    P2Cog* c = COGS[id];
+    if (cog & 0x20) {
+        c->wr_PC(P2Cog::addr2pc(s));
+    } else {
+        // $1F0 … $1FF are the special registers and not loaded
+        for (p2_LONG offs = 0; offs < offs_IJMP3; offs++)
+            c->wr_cog(offs, MAP.rd_LONG(s + offs * sz_LONG));
+        c->wr_PC(COG_ADDR0);
+    }
+    c->wr_PTRA(ptra);
+    c->wr_PTRB(s);
+    c->start();
+    return id;
+}
+
+/**
+ * @brief Stop a COG
+ * @param cog COG number in bits 3:0; a COG that does not exist is ignored
+ */
+void P2Hub::cogstop(p2_LONG cog)
+{
+    const int id = static_cast<int>(cog & 15);
+    if (id >= nCOGS)
+        return;
+    COGS[id]->stop();
 }
 
 /**
@@ -166,12 +788,92 @@ p2_QUAD P2Hub::count() const
 }
 
 /**
- * @brief Return the number for free HUB slots
- * @return number of free HUB slots
+ * @brief Return the total number of instructions retired by all COGs
+ * @return sum of the COGs' instruction counters
+ */
+p2_QUAD P2Hub::retired() const
+{
+    p2_QUAD total = 0;
+    for (int id = 0; id < nCOGS; id++)
+        total += COGS[id]->rd_ICNT();
+    return total;
+}
+
+/**
+ * @brief Return the sum of the execution statistics of all COGs
+ * @return statistics; COGs which are not counting add nothing
  */
-p2_LONG P2Hub::hubslots() const
+p2_STATS_t P2Hub::stats() const
 {
-    return 0;
+    p2_STATS_t total = p2_STATS_t();
+    for (int id = 0; id < nCOGS; id++) {
+        const p2_STATS_t* stats = COGS[id]->stats();
+        if (!stats)
+            continue;
+        for (int i = 0; i < p2_COG_OP_COUNT; i++)
+            total.ops[i] += stats->ops[i];
+        total.nops += stats->nops;
+        for (int i = 0; i <= p2_WAIT_HALTED; i++)
+            total.waits[i] += stats->waits[i];
+        total.skipped += stats->skipped;
+        total.skipped_fast += stats->skipped_fast;
+        total.cond_failed += stats->cond_failed;
+    }
+    return total;
+}
+
+/**
+ * @brief Return the number of cycles until a COG's window to the slice of an address
+ * @param id COG index
+ * @param addr HUB address
+ * @param cnt cycle at which the COG accesses the HUB
+ * @return number of cycles (0 … number of COGs - 1)
+ */
+p2_LONG P2Hub::hubslots(p2_LONG id, p2_LONG addr, p2_QUAD cnt) const
+{
+    const p2_LONG mask = static_cast<p2_LONG>(mCOGS);
+    return SLOTS[id & mask][(addr >> 2) & mask][cnt & mask];
+}
+
+/**
+ * @brief Return the number of cycles a COG waits for a HUB access
+ *
+ * The result depends on the timing set with set_timing().
+ *
+ * @param id COG index
+ * @param addr HUB address of the first byte
+ * @param cnt cycle at which the COG accesses the HUB
+ * @param count number of longs of a SETQ burst, or 0 for a single access
+ * @param write true for a write, false for a read
+ * @return number of cycles to wait
+ */
+p2_LONG P2Hub::hub_cycles(p2_LONG id, p2_LONG addr, p2_QUAD cnt, p2_LONG count, bool write) const
+{
+    if (p2_HUB_FUNCTIONAL == TIMING)
+        return 0;
+    p2_LONG cycles = hubslots(id, addr, cnt) + (count > 1 ? count - 1 : 0);
+    if (p2_HUB_LATENCY == TIMING)
+        cycles += write ? write_latency : read_latency;
+    return cycles;
+}
+
+/**
+ * @brief Return the number of cycles RDFAST waits until the FIFO has data
+ *
+ * The FIFO starts to fill in the COG's window to the slice of %addr, and
+ * the first long arrives after the read latency. This does not depend on
+ * the timing tier, except that p2_HUB_FUNCTIONAL never stalls.
+ *
+ * @param id COG index
+ * @param addr HUB address of the first byte
+ * @param cnt cycle at which the COG executes RDFAST
+ * @return number of cycles to wait
+ */
+p2_LONG P2Hub::fifo_cycles(p2_LONG id, p2_LONG addr, p2_QUAD cnt) const
+{
+    if (p2_HUB_FUNCTIONAL == TIMING)
+        return 0;
+    return hubslots(id, addr, cnt) + read_latency;
 }
 
 /**
@@ -235,9 +937,9 @@ void P2Hub::xoro128()
  */
 p2_BYTE P2Hub::rd_BYTE(p2_LONG addr) const
 {
-    if (addr < sizeof(MEM))
-        return MEM.B[addr];
-    return 0x00;
+    if (BREAK)
+        break_watch(p2_BREAK_READ, addr, sz_BYTE);
+    return MAP.rd_BYTE(addr);
 }
 
 /**
@@ -247,8 +949,10 @@ p2_BYTE P2Hub::rd_BYTE(p2_LONG addr) const
  */
 void P2Hub::wr_BYTE(p2_LONG addr, p2_BYTE val)
 {
-    if (addr < sizeof(MEM))
-        MEM.B[addr] = val;
+    P2_TRACE(p2_TRACE_MEM, TRACE, CNT, p2_TRACE_WR_BYTE, 0, addr, val);
+    if (BREAK)
+        break_watch(p2_BREAK_WRITE, addr, sz_BYTE);
+    MAP.wr_BYTE(addr, val);
 }
 
 /**
@@ -258,9 +962,9 @@ void P2Hub::wr_BYTE(p2_LONG addr, p2_BYTE val)
  */
 p2_WORD P2Hub::rd_WORD(p2_LONG addr) const
 {
-    if (addr < sizeof(MEM))
-        return MEM.W[addr/2];
-    return 0x0000;
+    if (BREAK)
+        break_watch(p2_BREAK_READ, addr, sz_WORD);
+    return MAP.rd_WORD(addr);
 }
 
 /**
@@ -270,8 +974,10 @@ p2_WORD P2Hub::rd_WORD(p2_LONG addr) const
  */
 void P2Hub::wr_WORD(p2_LONG addr, p2_WORD val)
 {
-    if (addr < sizeof(MEM))
-        MEM.W[addr/2] = val;
+    P2_TRACE(p2_TRACE_MEM, TRACE, CNT, p2_TRACE_WR_WORD, 0, addr, val);
+    if (BREAK)
+        break_watch(p2_BREAK_WRITE, addr, sz_WORD);
+    MAP.wr_WORD(addr, val);
 }
 
 /**
@@ -281,9 +987,9 @@ void P2Hub::wr_WORD(p2_LONG addr, p2_WORD val)
  */
 p2_LONG P2Hub::rd_LONG(p2_LONG addr) const
 {
-    if (addr < sizeof(MEM))
-        return MEM.L[addr/4];
-    return 0x00000000;
+    if (BREAK)
+        break_watch(p2_BREAK_READ, addr, sz_LONG);
+    return MAP.rd_LONG(addr);
 }
 
 /**
@@ -293,8 +999,138 @@ p2_LONG P2Hub::rd_LONG(p2_LONG addr) const
  */
 void P2Hub::wr_LONG(p2_LONG addr, p2_LONG val)
 {
-    if (addr < sizeof(MEM))
-        MEM.L[addr/4] = val;
+    P2_TRACE(p2_TRACE_MEM, TRACE, CNT, p2_TRACE_WR_LONG, 0, addr, val);
+    if (BREAK)
+        break_watch(p2_BREAK_WRITE, addr, sz_LONG);
+    MAP.wr_LONG(addr, val);
+}
+
+/**
+ * @brief Read %size bytes at address %addr from HUB memory into %dst
+ * @param addr first address
+ * @param dst destination buffer
+ * @param size number of bytes
+ */
+void P2Hub::rd_block(p2_LONG addr, p2_BYTE* dst, p2_LONG size) const
+{
+    if (BREAK)
+        break_watch(p2_BREAK_READ, addr, size);
+    MAP.rd_block(addr, dst, size);
+}
+
+/**
+ * @brief Write %size bytes from %src to address %addr in HUB memory
+ * @param addr first address
+ * @param src source buffer
+ * @param size number of bytes
+ */
+void P2Hub::wr_block(p2_LONG addr, const p2_BYTE* src, p2_LONG size)
+{
+    if (BREAK)
+        break_watch(p2_BREAK_WRITE, addr, size);
+    MAP.wr_block(addr, src, size);
+}
+
+/**
+ * @brief Return the contents of HUB memory page %page
+ * @param page page number (0 … PAGE_COUNT-1)
+ * @return pointer to PAGE_SIZE bytes
+ */
+const p2_BYTE* P2Hub::rd_page(p2_LONG page) const
+{
+    return reinterpret_cast<const p2_BYTE*>(RAM.at(static_cast<int>(page)).constData());
+}
+
+/**
+ * @brief Write the contents of HUB memory page %page
+ *
+ * A shared page which already has the same contents stays shared.
+ *
+ * @param page page number (0 … PAGE_COUNT-1)
+ * @param src pointer to PAGE_SIZE bytes
+ */
+void P2Hub::wr_page(p2_LONG page, const p2_BYTE* src)
+{
+    if (0 == memcmp(rd_page(page), src, PAGE_SIZE))
+        return;
+    unshare(page);
+    memcpy(RAM[static_cast<int>(page)].data(), src, PAGE_SIZE);
+}
+
+/**
+ * @brief Share the HUB memory pages, e.g. with a checkpoint or a forked HUB
+ *
+ * All pages are mapped read only again, so the next write to a
+ * page makes a private copy of it, and the returned pages keep
+ * the current contents.
+ *
+ * @return vector of PAGE_COUNT pages of PAGE_SIZE bytes
+ */
+QVector<QByteArray> P2Hub::share_pages()
+{
+    map_pages();
+    return RAM;
+}
+
+/**
+ * @brief Set the HUB memory to %pages and share them until written
+ * @param pages vector of PAGE_COUNT pages of PAGE_SIZE bytes, e.g. from share_pages()
+ */
+void P2Hub::set_pages(const QVector<QByteArray>& pages)
+{
+    Q_ASSERT(pages.count() == static_cast<int>(PAGE_COUNT));
+    RAM = pages;
+    map_pages();
+}
+
+/**
+ * @brief Map all HUB memory pages read only, with wr_shared() to write them
+ */
+void P2Hub::map_pages()
+{
+    for (p2_LONG page = 0; page < PAGE_COUNT; page++) {
+        const p2_LONG addr = page << PAGE_SHIFT;
+        MAP.map_shared(addr, PAGE_SIZE, rd_page(page), wr_shared, this);
+        for (P2Cog* cog : COGS)
+            cog->remap(addr);
+    }
+}
+
+/**
+ * @brief Make a private copy of HUB memory page %page, if it is shared, and map it writeable
+ * @param page page number (0 … PAGE_COUNT-1)
+ */
+void P2Hub::unshare(p2_LONG page)
+{
+    const p2_LONG addr = page << PAGE_SHIFT;
+    p2_BYTE* host = reinterpret_cast<p2_BYTE*>(RAM[static_cast<int>(page)].data());
+    MAP.map_ram(addr, PAGE_SIZE, host);
+    for (P2Cog* cog : COGS)
+        cog->remap(addr);
+}
+
+/**
+ * @brief Write handler for shared pages: unshare the page, then write %val
+ * @param ctx pointer to the P2Hub
+ * @param addr address
+ * @param val value to write
+ * @param size number of bytes (1, 2, or 4)
+ */
+void P2Hub::wr_shared(void* ctx, p2_LONG addr, p2_LONG val, int size)
+{
+    P2Hub* hub = static_cast<P2Hub*>(ctx);
+    hub->unshare(addr >> PAGE_SHIFT);
+    switch (size) {
+    case sz_BYTE:
+        hub->MAP.wr_BYTE(addr, static_cast<p2_BYTE>(val));
+        break;
+    case sz_WORD:
+        hub->MAP.wr_WORD(addr, static_cast<p2_WORD>(val));
+        break;
+    default:
+        hub->MAP.wr_LONG(addr, val);
+        break;
+    }
 }
 
 /**
@@ -361,18 +1197,9 @@ void P2Hub::wr_lut(int cog, p2_LONG offs, p2_LONG val)
  */
 p2_LONG P2Hub::rd_mem(int cog, p2_LONG addr) const
 {
-    p2_LONG data = 0;
     if (cog >= nCOGS)
         return 0;
-    if (addr < LUT_ADDR0) {
-        data = rd_cog(cog, addr/4);
-    } else if (addr < HUB_ADDR0) {
-        data = rd_lut(cog, (addr - LUT_ADDR0) / 4);
-    } else {
-        Q_ASSERT(addr < MEM_SIZE);
-        data = MEM.L[addr/4];
-    }
-    return data;
+    return COGS[cog]->rd_mem(addr);
 }
 
 /**
@@ -385,14 +1212,8 @@ void P2Hub::wr_mem(int cog, p2_LONG addr, p2_LONG val)
 {
     if (cog >= nCOGS)
         return;
-    if (addr < LUT_ADDR0) {
-        wr_cog(cog, addr / 4, val);
-    } else if (addr < HUB_ADDR0) {
-        wr_lut(cog, (addr - LUT_ADDR0) / 4, val);
-    } else {
-        Q_ASSERT(addr < MEM_SIZE);
-        MEM.L[addr/4] = val;
-    }
+    P2_TRACE(p2_TRACE_MEM, TRACE, CNT, p2_TRACE_WR_LONG, cog, addr, val);
+    COGS[cog]->wr_mem(addr, val);
 }
 
 /**
@@ -452,7 +1273,10 @@ void P2Hub::wr_DIR(p2_LONG port, p2_LONG val)
     Q_ASSERT(port < 64);
     const p2_QUAD mask = Q_UINT64_C(1) << port;
     const p2_QUAD bit = static_cast<p2_QUAD>(val & 1) << port;
+    sync_pins();
     DIR = (DIR & ~mask) | bit;
+    if (SERIAL)
+        serial_line();
 }
 
 /**
@@ -476,7 +1300,35 @@ void P2Hub::wr_OUT(p2_LONG port, p2_LONG val)
     Q_ASSERT(port < 64);
     const p2_QUAD mask = Q_UINT64_C(1) << port;
     const p2_QUAD bit = static_cast<p2_QUAD>(val & 1) << port;
+    sync_pins();
     OUT = (OUT & ~mask) | bit;
+    if (SERIAL)
+        serial_line();
+}
+
+/**
+ * @brief Write a COG's DIRA, DIRB, OUTA, or OUTB register to the pins
+ * @param offs register offset (offs_DIRA … offs_OUTB)
+ * @param val new value for the 32 pins
+ */
+void P2Hub::wr_port(p2_LONG offs, p2_LONG val)
+{
+    const uchar shift = (offs & 1) ? 32 : 0;
+    const p2_QUAD mask = Q_UINT64_C(0xffffffff) << shift;
+    const p2_QUAD bits = static_cast<p2_QUAD>(val) << shift;
+    sync_pins();
+    switch (offs) {
+    case offs_DIRA:
+    case offs_DIRB:
+        DIR = (DIR & ~mask) | bits;
+        break;
+    case offs_OUTA:
+    case offs_OUTB:
+        OUT = (OUT & ~mask) | bits;
+        break;
+    }
+    if (SERIAL)
+        serial_line();
 }
 
 /**
@@ -501,12 +1353,134 @@ void P2Hub::wr_SCP(p2_LONG n)
 }
 
 /**
- * @brief Return true, if pin %n is high (0 … 31 on PA, 32 … 63 on PB)
+ * @brief Return true, if IN of pin %n is high (0 … 31 on PA, 32 … 63 on PB)
+ *
+ * IN of a smart pin is its IN flag, IN of a normal pin is its level.
+ *
  * @param n pin number
  * @return true if high, or false otherwise
  */
 bool P2Hub::rd_PIN(p2_LONG n)
 {
     p2_BYTE shift = n & 63;
-    return ((PIN >> shift) & 1) != 0;
+    sync_pins();
+    return ((IN >> shift) & 1) != 0;
+}
+
+/**
+ * @brief Return IN of all pins, i.e. the values of INA and INB
+ * @return IN bits (0 … 31 on PA, 32 … 63 on PB)
+ */
+p2_QUAD P2Hub::rd_IN()
+{
+    sync_pins();
+    return IN;
+}
+
+/**
+ * @brief Write the configuration of smart pin %pin, and acknowledge it
+ * @param pin pin number
+ * @param val new configuration
+ */
+void P2Hub::wrpin(p2_LONG pin, p2_LONG val)
+{
+    sync_pins();
+    PINS.wrpin(pin, val);
+}
+
+/**
+ * @brief Write the parameter X of smart pin %pin, and acknowledge it
+ * @param pin pin number
+ * @param val new parameter X
+ */
+void P2Hub::wxpin(p2_LONG pin, p2_LONG val)
+{
+    sync_pins();
+    PINS.wxpin(pin, val);
+}
+
+/**
+ * @brief Write the parameter Y of smart pin %pin, and acknowledge it
+ * @param pin pin number
+ * @param val new parameter Y
+ */
+void P2Hub::wypin(p2_LONG pin, p2_LONG val)
+{
+    sync_pins();
+    PINS.wypin(pin, val);
+}
+
+/**
+ * @brief Read the result Z of smart pin %pin
+ * @param pin pin number
+ * @param c returns the modal C
+ * @param ack true to acknowledge the pin (RDPIN), false to not (RQPIN)
+ * @return result Z
+ */
+p2_LONG P2Hub::rdpin(p2_LONG pin, bool& c, bool ack)
+{
+    sync_pins();
+    const p2_LONG result = PINS.rdpin(pin, c);
+    if (ack)
+        PINS.akpin(pin);
+    return result;
+}
+
+/**
+ * @brief Acknowledge smart pin %pin
+ * @param pin pin number
+ */
+void P2Hub::akpin(p2_LONG pin)
+{
+    sync_pins();
+    PINS.akpin(pin);
+}
+
+/**
+ * @brief Run the smart pins up to the current CNT, and update IN
+ *
+ * Called before anything reads the pins, or changes DIR or OUT.
+ */
+void P2Hub::sync_pins()
+{
+    PINS.run(CNT, DIR, OUT);
+    IN = PINS.in(DIR, OUT);
+}
+
+/**
+ * @brief Return the serial bridge
+ * @return pointer to the bridge, or nullptr if none is attached
+ */
+P2Serial* P2Hub::serial() const
+{
+    return SERIAL;
+}
+
+/**
+ * @brief Attach a serial bridge to its pins, or detach it
+ *
+ * The host calls P2Serial::poll() between calls to execute().
+ *
+ * @param serial pointer to the bridge, or nullptr to detach
+ */
+void P2Hub::set_serial(P2Serial* serial)
+{
+    sync_pins();
+    SERIAL = serial;
+    PINS.set_serial(serial);
+    if (SERIAL)
+        serial_line();
+}
+
+/**
+ * @brief Pass the level of the serial bridge's transmit pin to the bridge
+ *
+ * Called after DIR or OUT changed.
+ */
+void P2Hub::serial_line()
+{
+    // let the pins see the new DIR before looking at the level
+    sync_pins();
+    const int pin = SERIAL->tx_pin();
+    SERIAL->line(CNT, (PINS.level(DIR, OUT) >> pin) & 1);
 }
@@ -32,27 +32,85 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  ****************************************************************************/
 #pragma once
+#include <QByteArray>
+#include <QMutex>
 #include <QObject>
 #include <QVector>
+#include <QWaitCondition>
 #include "p2defs.h"
+#include "p2break.h"
+#include "p2cordic.h"
+#include "p2memmap.h"
+#include "p2pins.h"
+#include "p2snapshot.h"
+#include "p2trace.h"
 
 class P2Cog;
+class P2Serial;
+class P2CogThread;
+
+/**
+ * @brief Accuracy of the HUB memory timing
+ *
+ * The HUB RAM is divided into one slice per COG, selected by the long
+ * address modulo the number of COGs. In each cycle each COG has a window
+ * to one slice, and the next cycle to the next one (egg-beater).
+ * None of the tiers models the stalls of hub execution, or of RFxxx/WFxxx
+ * while the FIFO refills.
+ */
+typedef enum {
+    p2_HUB_FUNCTIONAL,          //!< HUB accesses never stall
+    p2_HUB_APPROXIMATE,         //!< wait for the window to the first slice, then one cycle per long of a SETQ burst
+    p2_HUB_LATENCY,             //!< also wait a fixed read or write latency after the window
+}   p2_HUB_timing_e;
+
+//! Members of P2Hub saved in a snapshot, in file order (followed by the smart pins)
+#define P2_HUB_STATE(_) \
+    _(XORO128_s0) _(XORO128_s1) _(CNT) _(RND) _(PIN) _(DIR) _(OUT) _(MUX) \
+    _(LOCK) _(scope_pin0) _(scope_enable)
 
 class P2Hub : public QObject
 {
     Q_OBJECT
 public:
     P2Hub(int ncogs, QObject* parent = nullptr);
+    ~P2Hub();
 
     int execute(int cycles);
+    bool parallel() const;
+    void set_parallel(bool on);
+    bool fast_forward() const;
+    void set_fast_forward(bool on);
+    p2_QUAD fast_forwarded() const;
+    p2_HUB_timing_e timing() const;
+    void set_timing(p2_HUB_timing_e timing);
+    P2Breakpoints* breakpoints();
+    bool breakpoints_armed() const;
+    void arm_breakpoints(bool on);
+    P2Serial* serial() const;
+    void set_serial(P2Serial* serial);
+
+    //! cycles after the window until a read completes, besides the instruction's own cycle
+    static constexpr p2_LONG read_latency = 8;
+    //! cycles after the window until a write completes, besides the instruction's own cycle
+    static constexpr p2_LONG write_latency = 2;
 
     P2Cog* cog(int id);
-    p2_BYTE* mem();
+    int ncogs() const;
+    P2Trace* trace();
     p2_LONG memsize() const;
+    const P2MemMap& map() const;
+    const P2Cordic& cordic() const;
+    const P2Pins& pins() const;
 
-    void coginit(p2_LONG id, p2_LONG ptra, p2_LONG ptrb);
+    int coginit(p2_LONG cog, p2_LONG ptra, p2_LONG s);
+    void cogstop(p2_LONG id);
     p2_QUAD count() const;
-    p2_LONG hubslots() const;
+    p2_QUAD retired() const;
+    p2_STATS_t stats() const;
+    p2_LONG hubslots(p2_LONG id, p2_LONG addr, p2_QUAD cnt) const;
+    p2_LONG hub_cycles(p2_LONG id, p2_LONG addr, p2_QUAD cnt, p2_LONG count, bool write) const;
+    p2_LONG fifo_cycles(p2_LONG id, p2_LONG addr, p2_QUAD cnt) const;
     p2_LONG cogindex() const;
     int lockstate(int id) const;
     p2_LONG random(uint index = 0);
@@ -66,6 +124,14 @@ public:
     p2_LONG rd_LONG(p2_LONG addr) const;
     void wr_LONG(p2_LONG addr, p2_LONG val);
 
+    void rd_block(p2_LONG addr, p2_BYTE* dst, p2_LONG size) const;
+    void wr_block(p2_LONG addr, const p2_BYTE* src, p2_LONG size);
+
+    const p2_BYTE* rd_page(p2_LONG page) const;
+    void wr_page(p2_LONG page, const p2_BYTE* src);
+    QVector<QByteArray> share_pages();
+    void set_pages(const QVector<QByteArray>& pages);
+
     p2_LONG rd_cog(int cog, p2_LONG offs) const;
     void wr_cog(int cog, p2_LONG offs, p2_LONG val);
 
@@ -87,10 +153,27 @@ public:
     p2_LONG rd_OUT(p2_LONG port);
     void wr_OUT(p2_LONG port, p2_LONG val);
 
+    void wr_port(p2_LONG offs, p2_LONG val);
+
     p2_LONG rd_SCP();
     void wr_SCP(p2_LONG n);
 
     bool rd_PIN(p2_LONG n);
+    p2_QUAD rd_IN();
+
+    void wrpin(p2_LONG pin, p2_LONG val);
+    void wxpin(p2_LONG pin, p2_LONG val);
+    void wypin(p2_LONG pin, p2_LONG val);
+    p2_LONG rdpin(p2_LONG pin, bool& c, bool ack);
+    void akpin(p2_LONG pin);
+
+    p2_LONG state_size() const;
+    void save_state(p2_BYTE* dst) const;
+    void restore_state(const p2_BYTE* src);
+    bool save_snapshot(const QString& filename) const;
+    bool restore_snapshot(const P2Snapshot& snap);
+    bool restore_snapshot(const QString& filename);
+    bool fork(P2Hub* from);
 
 public slots:
     bool load_obj(const QString& filename);
@@ -99,6 +182,17 @@ public slots:
 private:
     p2_QUAD rotl(p2_QUAD val, uchar shift);
     void xoro128();
+    int execute_parallel(int run_cycles);
+    void skip_halted(p2_QUAD pos, p2_LONG id);
+    int execute_break(int run_cycles);
+    bool break_fetch();
+    void break_watch(p2_BREAK_e kind, p2_LONG addr, p2_LONG size) const;
+    int skip_idle(int run_cycles);
+    void sync_pins();
+    void serial_line();
+    void map_pages();
+    void unshare(p2_LONG page);
+    static void wr_shared(void* ctx, p2_LONG addr, p2_LONG val, int size);
 
     p2_QUAD XORO128_s0;     //!< Xoroshiro128 PRNG state[0]
     p2_QUAD XORO128_s1;     //!< Xoroshiro128 PRNG state[1]
@@ -107,20 +201,30 @@ private:
     p2_QUAD PIN;            //!< 64 pins (0 … 31 on PA, 32 … 63 on PB)
     p2_QUAD DIR;            //!< 64 direction bits (0 … 31 on PA, 32 … 63 on PB)
     p2_QUAD OUT;            //!< 64 output bits (0 … 31 on PA, 32 … 63 on PB)
+    p2_QUAD IN;             //!< 64 input bits as of the last sync_pins() (0 … 31 on PA, 32 … 63 on PB)
     p2_LONG MUX;            //!< scope input MUX (TODO: how is it defined?)
     QVector<P2Cog*> COGS;   //!< vector of available COGs
+    QVector<P2CogThread*> THREADS;  //!< worker threads in parallel mode
+    QMutex THREADS_mutex;   //!< protects the worker threads' running state
+    QWaitCondition THREADS_idle;    //!< signalled when a worker stops or advances
     int nCOGS;              //!< number of available COGs (1 … 16)
     int mCOGS;              //!< COG mask
     p2_LONG LOCK;           //!< lock state
-    QVector<p2_LONG> pin_mode;
-    QVector<p2_LONG> pin_X;
-    QVector<p2_LONG> pin_Y;
     p2_LONG scope_pin0;
     p2_LONG scope_enable;
+    bool ffwd_enable;       //!< true to skip cycles in which all COGs are waiting
+    p2_QUAD ffwd_cycles;    //!< number of CNT ticks skipped
+    p2_HUB_timing_e TIMING; //!< accuracy of the HUB memory timing
+    p2_BYTE SLOTS[16][16][16];      //!< cycles until a COG's window to a slice, by COG, slice, and CNT phase
     QString m_pathname;     //!< path name for object files
-    union {
-        p2_BYTE B[MEM_SIZE];
-        p2_WORD W[MEM_SIZE/2];
-        p2_LONG L[MEM_SIZE/4];
-    } MEM;
+    P2Trace TRACE;          //!< trace ring buffer
+    P2MemMap MAP;           //!< HUB memory map
+    P2Cordic CORDIC;        //!< CORDIC solver
+    P2Pins PINS;            //!< smart pins
+    P2Breakpoints BREAKPOINTS;  //!< breakpoints and watchpoints
+    P2Breakpoints* BREAK;   //!< BREAKPOINTS while armed and not empty, else nullptr
+    bool BREAK_armed;       //!< true if the breakpoints are armed
+    int BREAK_cog;          //!< COG running while the breakpoints are armed
+    P2Serial* SERIAL;       //!< serial bridge to the host, or nullptr
+    QVector<QByteArray> RAM;    //!< HUB memory pages, shared with other HUBs and checkpoints until written
 };
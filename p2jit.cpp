@@ -0,0 +1,506 @@
+/****************************************************************************
+ *
+ * P2 emulator x86-64 basic block translator
+ *
+ * Copyright (C) 2019 Jürgen Buchmüller <pullmoll@t-online.de>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ ****************************************************************************/
+#include <QtGlobal>
+#include <string.h>
+#if defined(Q_OS_WIN)
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+#include "p2jit.h"
+
+/**
+ * Register usage of the generated code
+ *
+ * Only registers which are volatile in both the System V and the
+ * Windows x64 calling conventions are used.
+ *
+ *  r10     pointer to the COG registers
+ *  r11     pointer to the p2_JIT_flags_t
+ *  r8d     C flag (0 or 1)
+ *  r9d     Z flag (0 or 1)
+ *  eax     D, then the result
+ *  ecx     S
+ *  edx     new C, scratch
+ */
+
+P2Jit::P2Jit()
+    : m_buffer(nullptr)
+    , m_used(0)
+    , m_code()
+    , m_blocks()
+    , m_failed()
+    , m_cover()
+    , m_translated(0)
+{
+#if P2_JIT
+#if defined(Q_OS_WIN)
+    void* mem = VirtualAlloc(nullptr, buffer_size, MEM_COMMIT | MEM_RESERVE, PAGE_EXECUTE_READWRITE);
+#else
+    void* mem = mmap(nullptr, buffer_size, PROT_READ | PROT_WRITE | PROT_EXEC, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (MAP_FAILED == mem)
+        mem = nullptr;
+#endif
+    m_buffer = reinterpret_cast<p2_BYTE*>(mem);
+#endif
+}
+
+P2Jit::~P2Jit()
+{
+    if (!m_buffer)
+        return;
+#if defined(Q_OS_WIN)
+    VirtualFree(m_buffer, 0, MEM_RELEASE);
+#else
+    munmap(m_buffer, buffer_size);
+#endif
+}
+
+/**
+ * @brief Return true, if the translator is compiled in for this host
+ * @return true if available
+ */
+bool P2Jit::available()
+{
+    return P2_JIT != 0;
+}
+
+/**
+ * @brief Return the translated block starting at an address
+ *
+ * The block is translated on first use. Instructions which can not
+ * start a block are remembered until they are written.
+ *
+ * @param lut true for LUT, false for COG addresses
+ * @param addr long address (0 … $1ff)
+ * @param code pointer to the 512 longs of COG or LUT memory
+ * @return pointer to the block, or nullptr if there is none
+ */
+const p2_JIT_block_t* P2Jit::block(bool lut, p2_LONG addr, const p2_LONG* code)
+{
+    if (!m_buffer || m_failed[lut][addr])
+        return nullptr;
+    p2_JIT_block_t& blk = m_blocks[lut][addr];
+    if (blk.code)
+        return &blk;
+    if (!translate(blk, lut, addr, code)) {
+        m_failed[lut][addr] = 1;
+        return nullptr;
+    }
+    return &blk;
+}
+
+/**
+ * @brief Return true, if an address is part of a translated block
+ * @param lut true for LUT, false for COG addresses
+ * @param addr long address (0 … $1ff)
+ * @return true if covered by a block
+ */
+bool P2Jit::covers(bool lut, p2_LONG addr) const
+{
+    return m_cover[lut][addr & COG_MASK] != 0;
+}
+
+/**
+ * @brief Drop all translated blocks containing an address
+ * @param lut true for LUT, false for COG addresses
+ * @param addr long address (0 … $1ff)
+ */
+void P2Jit::drop_covering(bool lut, p2_LONG addr)
+{
+    const p2_LONG first = addr >= max_count - 1 ? addr - (max_count - 1) : 0;
+    for (p2_LONG start = first; start <= addr; start++) {
+        const p2_JIT_block_t& blk = m_blocks[lut][start];
+        if (blk.code && start + blk.count > addr)
+            drop(lut, start);
+    }
+}
+
+/**
+ * @brief Drop all translated blocks, forget failed translations, and reset the code buffer
+ */
+void P2Jit::flush()
+{
+    for (int lut = 0; lut < 2; lut++) {
+        for (p2_LONG addr = 0; addr < COG_SIZE; addr++) {
+            m_blocks[lut][addr].code = nullptr;
+            m_blocks[lut][addr].count = 0;
+            m_blocks[lut][addr].writes.clear();
+        }
+    }
+    memset(m_failed, 0, sizeof(m_failed));
+    memset(m_cover, 0, sizeof(m_cover));
+    m_used = 0;
+}
+
+/**
+ * @brief Return the number of blocks translated so far
+ * @return number of blocks
+ */
+p2_QUAD P2Jit::translated() const
+{
+    return m_translated;
+}
+
+/**
+ * @brief Drop the translated block starting at an address
+ * @param lut true for LUT, false for COG addresses
+ * @param start long address of the block
+ */
+void P2Jit::drop(bool lut, p2_LONG start)
+{
+    p2_JIT_block_t& blk = m_blocks[lut][start];
+    for (p2_LONG i = 0; i < blk.count; i++)
+        m_cover[lut][start + i]--;
+    blk.code = nullptr;
+    blk.count = 0;
+    blk.writes.clear();
+}
+
+/**
+ * @brief Return true, if an instruction can be part of a block
+ * @param opcode instruction opcode
+ * @param start long address where the block starts
+ * @param lut true for LUT, false for COG addresses
+ * @return true if the instruction can be translated
+ */
+bool P2Jit::translatable(p2_LONG opcode, p2_LONG start, bool lut)
+{
+    p2_opcode_u IR;
+    IR.opcode = opcode;
+
+    // _RET_ is a branch
+    if (cc__ret_ == IR.op7.cond)
+        return false;
+
+    // Leave the shadow registers to the interpreter
+    if (IR.op7.dst >= 0x1f0 || (!IR.op7.im && IR.op7.src >= 0x1f0))
+        return false;
+
+    bool writes = true;
+    switch (IR.op7.inst) {
+    case p2_CMP:
+    case p2_CMPX:
+    case p2_CMPR:
+    case p2_TEST:
+    case p2_TESTN:
+        writes = false;
+        break;
+    case p2_MOV:
+    case p2_NOT:
+    case p2_NEG:
+    case p2_ADD:
+    case p2_ADDX:
+    case p2_SUB:
+    case p2_SUBX:
+    case p2_SUBR:
+    case p2_AND:
+    case p2_ANDN:
+    case p2_OR:
+    case p2_XOR:
+    case p2_SHL:
+    case p2_SHR:
+    case p2_ROL:
+    case p2_ROR:
+        break;
+    default:
+        return false;
+    }
+
+    // Do not modify code which might be part of this block
+    if (writes && !lut && IR.op7.dst >= start && IR.op7.dst < start + max_count)
+        return false;
+
+    return true;
+}
+
+/**
+ * @brief Translate a block
+ * @param blk reference to the block to fill in
+ * @param lut true for LUT, false for COG addresses
+ * @param addr long address of the first instruction
+ * @param code pointer to the 512 longs of COG or LUT memory
+ * @return true on success, or false if the first instruction is not translatable
+ */
+bool P2Jit::translate(p2_JIT_block_t& blk, bool lut, p2_LONG addr, const p2_LONG* code)
+{
+    const p2_LONG end = lut ? LUT_SIZE : 0x1f0;
+    p2_LONG count = 0;
+    while (count < max_count && addr + count < end && translatable(code[addr + count], addr, lut))
+        count++;
+    if (0 == count)
+        return false;
+
+    m_code.clear();
+    QVector<p2_LONG> writes;
+
+    // prologue: load the pointers and flags
+#if defined(Q_OS_WIN)
+    out({0x49, 0x89, 0xca});               // mov r10,rcx
+    out({0x49, 0x89, 0xd3});               // mov r11,rdx
+#else
+    out({0x49, 0x89, 0xfa});               // mov r10,rdi
+    out({0x49, 0x89, 0xf3});               // mov r11,rsi
+#endif
+    out({0x45, 0x8b, 0x03});               // mov r8d,[r11]
+    out({0x45, 0x8b, 0x4b, 0x04});         // mov r9d,[r11+4]
+
+    for (p2_LONG i = 0; i < count; i++) {
+        p2_opcode_u IR;
+        IR.opcode = code[addr + i];
+        out_instruction(IR.opcode);
+        switch (IR.op7.inst) {
+        case p2_CMP: case p2_CMPX: case p2_CMPR: case p2_TEST: case p2_TESTN:
+            break;
+        default:
+            if (!writes.contains(IR.op7.dst))
+                writes += IR.op7.dst;
+        }
+    }
+
+    // epilogue: store the flags
+    out({0x45, 0x89, 0x03});               // mov [r11],r8d
+    out({0x45, 0x89, 0x4b, 0x04});         // mov [r11+4],r9d
+    out({0xc3});                           // ret
+
+    if (m_used + m_code.count() > buffer_size) {
+        // out of code space: start over
+        flush();
+    }
+    memcpy(m_buffer + m_used, m_code.constData(), static_cast<size_t>(m_code.count()));
+    blk.code = reinterpret_cast<p2_JIT_code_t>(m_buffer + m_used);
+    blk.count = count;
+    blk.writes = writes;
+    m_used += m_code.count();
+    for (p2_LONG i = 0; i < count; i++)
+        m_cover[lut][addr + i]++;
+    m_translated++;
+    return true;
+}
+
+/**
+ * @brief Emit the host code for one instruction
+ *
+ * The semantics follow the op_xxx() functions of P2Cog exactly,
+ * because the interpreter is the reference.
+ *
+ * @param opcode instruction opcode
+ */
+void P2Jit::out_instruction(p2_LONG opcode)
+{
+    p2_opcode_u IR;
+    IR.opcode = opcode;
+    const p2_LONG cond = IR.op7.cond;
+    int skip = -1;
+
+    if (cc_always != cond) {
+        // execute if bit #(C*2+Z) of the condition code is set
+        out({0x43, 0x8d, 0x14, 0x41});     // lea edx,[r9+r8*2]
+        out({0xb8}); out32(cond);         // mov eax,cond
+        out({0x0f, 0xa3, 0xd0});           // bt eax,edx
+        out({0x0f, 0x83});                 // jnc skip
+        skip = m_code.count();
+        out32(0);
+    }
+
+    // eax = D, ecx = S
+    out({0x41, 0x8b, 0x82}); out32(IR.op7.dst * 4);   // mov eax,[r10+D*4]
+    if (IR.op7.im) {
+        out({0xb9}); out32(IR.op7.src);               // mov ecx,#S
+    } else {
+        out({0x41, 0x8b, 0x8a}); out32(IR.op7.src * 4); // mov ecx,[r10+S*4]
+    }
+
+    bool write = true;      // write result to D
+    bool zchain = false;    // Z = Z & (result == 0)
+    switch (IR.op7.inst) {
+    case p2_MOV:            // C = result[31]
+        out({0x89, 0xc8});                 // mov eax,ecx
+        out({0x89, 0xc2});                 // mov edx,eax
+        out({0xc1, 0xea, 0x1f});           // shr edx,31
+        break;
+    case p2_NOT:
+        out({0x89, 0xc8});                 // mov eax,ecx
+        out({0xf7, 0xd0});                 // not eax
+        out({0x89, 0xc2});                 // mov edx,eax
+        out({0xc1, 0xea, 0x1f});           // shr edx,31
+        break;
+    case p2_NEG:
+        out({0x89, 0xc8});                 // mov eax,ecx
+        out({0xf7, 0xd8});                 // neg eax
+        out({0x89, 0xc2});                 // mov edx,eax
+        out({0xc1, 0xea, 0x1f});           // shr edx,31
+        break;
+    case p2_ADD:            // C = carry
+        out({0x01, 0xc8});                 // add eax,ecx
+        out({0x0f, 0x92, 0xc2});           // setc dl
+        out({0x0f, 0xb6, 0xd2});           // movzx edx,dl
+        break;
+    case p2_ADDX:
+        out({0x41, 0x0f, 0xba, 0xe0, 0x00}); // bt r8d,0
+        out({0x11, 0xc8});                 // adc eax,ecx
+        out({0x0f, 0x92, 0xc2});           // setc dl
+        out({0x0f, 0xb6, 0xd2});           // movzx edx,dl
+        zchain = true;
+        break;
+    case p2_CMP:            // C = borrow
+        write = false;
+        // fall through
+    case p2_SUB:
+        out({0x29, 0xc8});                 // sub eax,ecx
+        out({0x0f, 0x92, 0xc2});           // setc dl
+        out({0x0f, 0xb6, 0xd2});           // movzx edx,dl
+        break;
+    case p2_CMPX:
+        write = false;
+        // fall through
+    case p2_SUBX:
+        out({0x41, 0x0f, 0xba, 0xe0, 0x00}); // bt r8d,0
+        out({0x19, 0xc8});                 // sbb eax,ecx
+        out({0x0f, 0x92, 0xc2});           // setc dl
+        out({0x0f, 0xb6, 0xd2});           // movzx edx,dl
+        zchain = true;
+        break;
+    case p2_CMPR:
+        write = false;
+        // fall through
+    case p2_SUBR:
+        out({0x89, 0xca});                 // mov edx,ecx
+        out({0x29, 0xc2});                 // sub edx,eax
+        out({0x89, 0xd0});                 // mov eax,edx
+        out({0x0f, 0x92, 0xc2});           // setc dl
+        out({0x0f, 0xb6, 0xd2});           // movzx edx,dl
+        break;
+    case p2_TEST:           // C = parity
+        write = false;
+        // fall through
+    case p2_AND:
+        out({0x21, 0xc8});                 // and eax,ecx
+        break;
+    case p2_TESTN:
+        write = false;
+        // fall through
+    case p2_ANDN:
+        out({0xf7, 0xd1});                 // not ecx
+        out({0x21, 0xc8});                 // and eax,ecx
+        break;
+    case p2_OR:
+        out({0x09, 0xc8});                 // or eax,ecx
+        break;
+    case p2_XOR:
+        out({0x31, 0xc8});                 // xor eax,ecx
+        break;
+    case p2_SHR:            // C = last bit shifted out, or D[0]
+    case p2_ROR:
+        out({0x83, 0xe1, 0x1f});           // and ecx,31
+        out({0x0f, 0xba, 0xe0, 0x00});     // bt eax,0
+        if (p2_SHR == IR.op7.inst)
+            out({0xd3, 0xe8});             // shr eax,cl (keeps CF if cl = 0)
+        else
+            out({0xd3, 0xc8});             // ror eax,cl (keeps CF if cl = 0)
+        out({0x0f, 0x92, 0xc2});           // setc dl
+        out({0x0f, 0xb6, 0xd2});           // movzx edx,dl
+        break;
+    case p2_SHL:            // C = last bit shifted out, or D[31]
+    case p2_ROL:
+        out({0x83, 0xe1, 0x1f});           // and ecx,31
+        out({0x0f, 0xba, 0xe0, 0x1f});     // bt eax,31
+        if (p2_SHL == IR.op7.inst)
+            out({0xd3, 0xe0});             // shl eax,cl (keeps CF if cl = 0)
+        else
+            out({0xd3, 0xc0});             // rol eax,cl (keeps CF if cl = 0)
+        out({0x0f, 0x92, 0xc2});           // setc dl
+        out({0x0f, 0xb6, 0xd2});           // movzx edx,dl
+        break;
+    default:
+        Q_ASSERT_X(false, "P2Jit", "instruction not translatable");
+    }
+
+    switch (IR.op7.inst) {
+    case p2_AND: case p2_ANDN: case p2_OR: case p2_XOR: case p2_TEST: case p2_TESTN:
+        // edx = parity of eax
+        out({0x89, 0xc2});                 // mov edx,eax
+        out({0xc1, 0xea, 0x10});           // shr edx,16
+        out({0x31, 0xc2});                 // xor edx,eax
+        out({0x30, 0xf2});                 // xor dl,dh
+        out({0x0f, 0x9b, 0xc2});           // setpo dl
+        out({0x0f, 0xb6, 0xd2});           // movzx edx,dl
+        break;
+    }
+
+    if (IR.op7.wc)
+        out({0x41, 0x89, 0xd0});           // mov r8d,edx
+    if (IR.op7.wz) {
+        out({0x85, 0xc0});                 // test eax,eax
+        if (zchain) {
+            out({0x0f, 0x94, 0xc1});       // setz cl
+            out({0x0f, 0xb6, 0xc9});       // movzx ecx,cl
+            out({0x41, 0x21, 0xc9});       // and r9d,ecx
+        } else {
+            out({0x41, 0x0f, 0x94, 0xc1}); // setz r9b
+            out({0x45, 0x0f, 0xb6, 0xc9}); // movzx r9d,r9b
+        }
+    }
+    if (write) {
+        out({0x41, 0x89, 0x82}); out32(IR.op7.dst * 4); // mov [r10+D*4],eax
+    }
+
+    if (skip >= 0) {
+        out({0xeb, 0x04});                 // jmp done
+        const p2_LONG rel = static_cast<p2_LONG>(m_code.count() - (skip + 4));
+        for (int i = 0; i < 4; i++)
+            m_code[skip + i] = static_cast<p2_BYTE>(rel >> (8 * i));
+        out({0x41, 0xff, 0x43, 0x08});     // skip: inc dword [r11+8]
+    }                                      // done:
+}
+
+/**
+ * @brief Append bytes to the code being generated
+ * @param bytes list of bytes
+ */
+void P2Jit::out(std::initializer_list<p2_BYTE> bytes)
+{
+    for (p2_BYTE b : bytes)
+        m_code += b;
+}
+
+/**
+ * @brief Append a 32 bit little endian value to the code being generated
+ * @param value value to append
+ */
+void P2Jit::out32(p2_LONG value)
+{
+    for (int i = 0; i < 4; i++)
+        m_code += static_cast<p2_BYTE>(value >> (8 * i));
+}
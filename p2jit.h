@@ -0,0 +1,144 @@
+/****************************************************************************
+ *
+ * P2 emulator x86-64 basic block translator
+ *
+ * Copyright (C) 2019 Jürgen Buchmüller <pullmoll@t-online.de>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ ****************************************************************************/
+#pragma once
+#include <initializer_list>
+#include <QVector>
+#include "p2defs.h"
+
+/**
+ * @file Dynamic translation of COG and LUT code to x86-64 host code.
+ *
+ * A block is a straight line run of simple ALU instructions (MOV, NOT,
+ * NEG, ADD, ADDX, SUB, SUBX, SUBR, CMP, CMPX, CMPR, AND, ANDN, OR, XOR,
+ * TEST, TESTN, SHL, SHR, ROL, ROR) with register or immediate S and
+ * any condition but _RET_. Any other instruction ends the block and is
+ * left to the interpreter, which stays the reference implementation.
+ * Hub operations, branches, WAITs, events, and augmented or ALTxx'ed
+ * instructions are therefore never translated.
+ *
+ * The generated code keeps the C and Z flags in host registers for the
+ * whole block and reads and writes the COG registers directly.
+ * P2Cog invalidates a block whenever one of its longs is written.
+ *
+ * P2_JIT is 1 on x86-64 hosts, where translation can be switched on
+ * at run time, and 0 everywhere else.
+ */
+
+#ifndef P2_JIT
+#if defined(__x86_64__) || defined(_M_X64)
+#define P2_JIT 1
+#else
+#define P2_JIT 0
+#endif
+#endif
+
+/**
+ * @brief Translator modes
+ */
+typedef enum {
+    p2_JIT_OFF,                 //!< interpret everything
+    p2_JIT_ON,                  //!< run translated blocks
+    p2_JIT_VERIFY,              //!< interpret, and compare with the result of translated blocks
+}   p2_JIT_mode_e;
+
+/**
+ * @brief Flags passed to and returned from a translated block
+ */
+typedef struct {
+    p2_LONG C;                  //!< carry flag (0 or 1)
+    p2_LONG Z;                  //!< zero flag (0 or 1)
+    p2_LONG failed;             //!< instructions whose condition was false
+}   p2_JIT_flags_t;
+
+//! Entry point of a translated block
+typedef void (*p2_JIT_code_t)(p2_LONG* cog, p2_JIT_flags_t* flags);
+
+/**
+ * @brief Translated block
+ */
+typedef struct {
+    p2_JIT_code_t code;         //!< host code entry point, or nullptr if not translated
+    p2_LONG count;              //!< number of instructions
+    QVector<p2_LONG> writes;    //!< COG addresses written by the block
+}   p2_JIT_block_t;
+
+class P2Jit
+{
+public:
+    P2Jit();
+    ~P2Jit();
+
+    static bool available();
+
+    const p2_JIT_block_t* block(bool lut, p2_LONG addr, const p2_LONG* code);
+    bool covers(bool lut, p2_LONG addr) const;
+
+    /**
+     * @brief Invalidate any state depending on the long at an address
+     * @param lut true for LUT, false for COG addresses
+     * @param addr long address (0 … $1ff)
+     */
+    inline void invalidate(bool lut, p2_LONG addr)
+    {
+        addr &= COG_MASK;
+        m_failed[lut][addr] = 0;
+        if (m_cover[lut][addr])
+            drop_covering(lut, addr);
+    }
+
+    void flush();
+    p2_QUAD translated() const;
+
+private:
+    //! maximum number of instructions per block
+    static constexpr p2_LONG max_count = 64;
+    //! size of the host code buffer
+    static constexpr int buffer_size = 256 * 1024;
+
+    p2_BYTE* m_buffer;          //!< executable host code buffer
+    int m_used;                 //!< bytes used in m_buffer
+    QVector<p2_BYTE> m_code;    //!< code being emitted
+    p2_JIT_block_t m_blocks[2][COG_SIZE];   //!< translated blocks for COG and LUT addresses
+    p2_BYTE m_failed[2][COG_SIZE];          //!< non-zero if the instruction can not start a block
+    p2_BYTE m_cover[2][COG_SIZE];           //!< number of blocks covering an address
+    p2_QUAD m_translated;       //!< number of blocks translated
+
+    static bool translatable(p2_LONG opcode, p2_LONG start, bool lut);
+    bool translate(p2_JIT_block_t& blk, bool lut, p2_LONG addr, const p2_LONG* code);
+    void out_instruction(p2_LONG opcode);
+    void out(std::initializer_list<p2_BYTE> bytes);
+    void out32(p2_LONG value);
+    void drop(bool lut, p2_LONG start);
+    void drop_covering(bool lut, p2_LONG addr);
+};
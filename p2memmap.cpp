@@ -0,0 +1,227 @@
+/****************************************************************************
+ *
+ * P2 emulator memory map
+ *
+ * Copyright (C) 2019 Jürgen Buchmüller <pullmoll@t-online.de>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ ****************************************************************************/
+#include "p2memmap.h"
+
+/**
+ * @brief Read handler for unmapped pages
+ * @return always 0
+ */
+static p2_LONG rd_unmapped(void*, p2_LONG, int)
+{
+    return 0;
+}
+
+/**
+ * @brief Write handler for unmapped pages: writes are ignored
+ */
+static void wr_unmapped(void*, p2_LONG, p2_LONG, int)
+{
+}
+
+P2MemMap::P2MemMap()
+{
+    unmap(0, MEM_SIZE);
+    PAGES[PAGE_COUNT] = PAGES[0];
+}
+
+/**
+ * @brief Map %size bytes of host memory at %host to address %addr
+ * @param addr first address (multiple of PAGE_SIZE)
+ * @param size size in bytes (multiple of PAGE_SIZE)
+ * @param host pointer to the host buffer
+ */
+void P2MemMap::map_ram(p2_LONG addr, p2_LONG size, p2_BYTE* host)
+{
+    Q_ASSERT(0 == (addr & PAGE_MASK) && 0 == (size & PAGE_MASK));
+    for (p2_LONG offs = 0; offs < size && addr + offs < MEM_SIZE; offs += PAGE_SIZE) {
+        p2_PAGE_t& p = PAGES[(addr + offs) >> PAGE_SHIFT];
+        p.rd = host + offs;
+        p.wr = host + offs;
+        p.rd_io = rd_unmapped;
+        p.wr_io = wr_unmapped;
+        p.ctx = nullptr;
+    }
+}
+
+/**
+ * @brief Map %size bytes of read only host memory at %host to address %addr
+ * @param addr first address (multiple of PAGE_SIZE)
+ * @param size size in bytes (multiple of PAGE_SIZE)
+ * @param host pointer to the host buffer
+ */
+void P2MemMap::map_rom(p2_LONG addr, p2_LONG size, const p2_BYTE* host)
+{
+    Q_ASSERT(0 == (addr & PAGE_MASK) && 0 == (size & PAGE_MASK));
+    for (p2_LONG offs = 0; offs < size && addr + offs < MEM_SIZE; offs += PAGE_SIZE) {
+        p2_PAGE_t& p = PAGES[(addr + offs) >> PAGE_SHIFT];
+        p.rd = const_cast<p2_BYTE*>(host + offs);
+        p.wr = nullptr;
+        p.rd_io = rd_unmapped;
+        p.wr_io = wr_unmapped;
+        p.ctx = nullptr;
+    }
+}
+
+/**
+ * @brief Map %size bytes of shared host memory at %host to address %addr
+ *
+ * Reads come from the host buffer, while writes call %wr, which is
+ * expected to map a private copy of the page and then repeat the write.
+ *
+ * @param addr first address (multiple of PAGE_SIZE)
+ * @param size size in bytes (multiple of PAGE_SIZE)
+ * @param host pointer to the host buffer
+ * @param wr write handler
+ * @param ctx context passed to the handler
+ */
+void P2MemMap::map_shared(p2_LONG addr, p2_LONG size, const p2_BYTE* host, p2_wr_io_t wr, void* ctx)
+{
+    Q_ASSERT(0 == (addr & PAGE_MASK) && 0 == (size & PAGE_MASK));
+    for (p2_LONG offs = 0; offs < size && addr + offs < MEM_SIZE; offs += PAGE_SIZE) {
+        p2_PAGE_t& p = PAGES[(addr + offs) >> PAGE_SHIFT];
+        p.rd = const_cast<p2_BYTE*>(host + offs);
+        p.wr = nullptr;
+        p.rd_io = rd_unmapped;
+        p.wr_io = wr ? wr : wr_unmapped;
+        p.ctx = ctx;
+    }
+}
+
+/**
+ * @brief Map I/O handlers %rd and %wr to %size bytes at address %addr
+ * @param addr first address (multiple of PAGE_SIZE)
+ * @param size size in bytes (multiple of PAGE_SIZE)
+ * @param rd read handler
+ * @param wr write handler
+ * @param ctx context passed to the handlers
+ */
+void P2MemMap::map_io(p2_LONG addr, p2_LONG size, p2_rd_io_t rd, p2_wr_io_t wr, void* ctx)
+{
+    Q_ASSERT(0 == (addr & PAGE_MASK) && 0 == (size & PAGE_MASK));
+    for (p2_LONG offs = 0; offs < size && addr + offs < MEM_SIZE; offs += PAGE_SIZE) {
+        p2_PAGE_t& p = PAGES[(addr + offs) >> PAGE_SHIFT];
+        p.rd = nullptr;
+        p.wr = nullptr;
+        p.rd_io = rd ? rd : rd_unmapped;
+        p.wr_io = wr ? wr : wr_unmapped;
+        p.ctx = ctx;
+    }
+}
+
+/**
+ * @brief Map the page containing address %addr like %page
+ *
+ * This is used to copy a page from another map, e.g. when the
+ * HUB changed the mapping of a page the COGs' maps refer to.
+ *
+ * @param addr address inside the page
+ * @param page page to copy
+ */
+void P2MemMap::map_page(p2_LONG addr, const p2_PAGE_t& page)
+{
+    const p2_LONG idx = addr >> PAGE_SHIFT;
+    if (idx < PAGE_COUNT)
+        PAGES[idx] = page;
+}
+
+/**
+ * @brief Unmap %size bytes at address %addr: reads return 0 and writes are ignored
+ * @param addr first address (multiple of PAGE_SIZE)
+ * @param size size in bytes (multiple of PAGE_SIZE)
+ */
+void P2MemMap::unmap(p2_LONG addr, p2_LONG size)
+{
+    map_io(addr, size, rd_unmapped, wr_unmapped, nullptr);
+}
+
+/**
+ * @brief Read %size bytes at address %addr into %dst
+ *
+ * Pages with a host buffer are copied with memcpy(), I/O pages are
+ * read byte by byte through their handler. The address wraps at 20 bits.
+ *
+ * @param addr first address
+ * @param dst destination buffer
+ * @param size number of bytes
+ */
+void P2MemMap::rd_block(p2_LONG addr, p2_BYTE* dst, p2_LONG size) const
+{
+    while (size > 0) {
+        addr &= A20MASK;
+        const p2_PAGE_t& p = page(addr);
+        const p2_LONG offs = addr & PAGE_MASK;
+        const p2_LONG n = qMin(size, PAGE_SIZE - offs);
+        if (p.rd) {
+            memcpy(dst, p.rd + offs, n);
+        } else {
+            for (p2_LONG i = 0; i < n; i++)
+                dst[i] = static_cast<p2_BYTE>(p.rd_io(p.ctx, addr + i, sz_BYTE));
+        }
+        addr += n;
+        dst += n;
+        size -= n;
+    }
+}
+
+/**
+ * @brief Write %size bytes from %src to address %addr
+ *
+ * Pages with a host buffer are copied with memcpy(), I/O pages are
+ * written byte by byte through their handler. The address wraps at 20 bits.
+ * A handler may map a buffer for the page, e.g. for shared pages, and
+ * then the rest of the page is copied with memcpy().
+ *
+ * @param addr first address
+ * @param src source buffer
+ * @param size number of bytes
+ */
+void P2MemMap::wr_block(p2_LONG addr, const p2_BYTE* src, p2_LONG size) const
+{
+    while (size > 0) {
+        addr &= A20MASK;
+        const p2_PAGE_t& p = page(addr);
+        const p2_LONG offs = addr & PAGE_MASK;
+        const p2_LONG n = qMin(size, PAGE_SIZE - offs);
+        p2_LONG i = 0;
+        while (i < n && !p.wr) {
+            p.wr_io(p.ctx, addr + i, src[i], sz_BYTE);
+            i++;
+        }
+        if (i < n)
+            memcpy(p.wr + offs + i, src + i, n - i);
+        addr += n;
+        src += n;
+        size -= n;
+    }
+}
@@ -0,0 +1,166 @@
+/****************************************************************************
+ *
+ * P2 emulator memory map
+ *
+ * Copyright (C) 2019 Jürgen Buchmüller <pullmoll@t-online.de>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ ****************************************************************************/
+#pragma once
+#include <cstring>
+#include "p2defs.h"
+
+/**
+ * @file Page table based memory map.
+ *
+ * The 20 bit address space is split into 4 KiB pages. Each page either
+ * points to a host buffer, which is read or written directly, or to a
+ * pair of I/O handlers. Read only pages (ROM) have a read buffer but
+ * no write buffer, and mirrored regions simply point at the same buffer.
+ * Shared pages are read from their buffer, too, but a write calls the
+ * write handler, which can then make a private copy of the page.
+ *
+ * An access looks up its page with one indexed load. Addresses beyond
+ * the mapped range all fall into a trailing page which is never mapped,
+ * so the accessors need no separate bounds check.
+ */
+
+//! Memory map page shift (4 KiB pages)
+static constexpr p2_LONG PAGE_SHIFT = 12;
+
+//! Size of a memory map page in BYTEs
+static constexpr p2_LONG PAGE_SIZE = 1u << PAGE_SHIFT;
+
+//! Mask for the offset into a memory map page
+static constexpr p2_LONG PAGE_MASK = PAGE_SIZE - 1;
+
+//! Number of memory map pages covering the HUB address range
+static constexpr p2_LONG PAGE_COUNT = MEM_SIZE >> PAGE_SHIFT;
+
+Q_STATIC_ASSERT(HUB_ADDR0 == PAGE_SIZE);
+
+//! Read handler for I/O pages: return %size bytes (1, 2, or 4) at %addr
+typedef p2_LONG (*p2_rd_io_t)(void* ctx, p2_LONG addr, int size);
+
+//! Write handler for I/O pages: write %size bytes (1, 2, or 4) of %val to %addr
+typedef void (*p2_wr_io_t)(void* ctx, p2_LONG addr, p2_LONG val, int size);
+
+//! Memory map page
+typedef struct {
+    p2_BYTE* rd;            //!< host buffer to read from, or nullptr to call rd_io
+    p2_BYTE* wr;            //!< host buffer to write to, or nullptr to call wr_io
+    p2_rd_io_t rd_io;       //!< read handler for pages without a read buffer
+    p2_wr_io_t wr_io;       //!< write handler for pages without a write buffer
+    void* ctx;              //!< context passed to the handlers
+}   p2_PAGE_t;
+
+class P2MemMap
+{
+public:
+    P2MemMap();
+
+    void map_ram(p2_LONG addr, p2_LONG size, p2_BYTE* host);
+    void map_rom(p2_LONG addr, p2_LONG size, const p2_BYTE* host);
+    void map_shared(p2_LONG addr, p2_LONG size, const p2_BYTE* host, p2_wr_io_t wr, void* ctx);
+    void map_io(p2_LONG addr, p2_LONG size, p2_rd_io_t rd, p2_wr_io_t wr, void* ctx);
+    void map_page(p2_LONG addr, const p2_PAGE_t& page);
+    void unmap(p2_LONG addr, p2_LONG size);
+
+    //! return the page for address %addr
+    const p2_PAGE_t& page(p2_LONG addr) const {
+        const p2_LONG idx = addr >> PAGE_SHIFT;
+        return PAGES[idx < PAGE_COUNT ? idx : PAGE_COUNT];
+    }
+
+    //! read a byte from address %addr
+    p2_BYTE rd_BYTE(p2_LONG addr) const {
+        const p2_PAGE_t& p = page(addr);
+        if (p.rd)
+            return p.rd[addr & PAGE_MASK];
+        return static_cast<p2_BYTE>(p.rd_io(p.ctx, addr, sz_BYTE));
+    }
+
+    //! write a byte to address %addr
+    void wr_BYTE(p2_LONG addr, p2_BYTE val) const {
+        const p2_PAGE_t& p = page(addr);
+        if (p.wr)
+            p.wr[addr & PAGE_MASK] = val;
+        else
+            p.wr_io(p.ctx, addr, val, sz_BYTE);
+    }
+
+    //! read a word from address %addr (bit 0 is ignored)
+    p2_WORD rd_WORD(p2_LONG addr) const {
+        const p2_PAGE_t& p = page(addr);
+        addr &= ~1u;
+        if (p.rd) {
+            p2_WORD val;
+            memcpy(&val, p.rd + (addr & PAGE_MASK), sizeof(val));
+            return val;
+        }
+        return static_cast<p2_WORD>(p.rd_io(p.ctx, addr, sz_WORD));
+    }
+
+    //! write a word to address %addr (bit 0 is ignored)
+    void wr_WORD(p2_LONG addr, p2_WORD val) const {
+        const p2_PAGE_t& p = page(addr);
+        addr &= ~1u;
+        if (p.wr)
+            memcpy(p.wr + (addr & PAGE_MASK), &val, sizeof(val));
+        else
+            p.wr_io(p.ctx, addr, val, sz_WORD);
+    }
+
+    //! read a long from address %addr (bits 0+1 are ignored)
+    p2_LONG rd_LONG(p2_LONG addr) const {
+        const p2_PAGE_t& p = page(addr);
+        addr &= ~3u;
+        if (p.rd) {
+            p2_LONG val;
+            memcpy(&val, p.rd + (addr & PAGE_MASK), sizeof(val));
+            return val;
+        }
+        return p.rd_io(p.ctx, addr, sz_LONG);
+    }
+
+    //! write a long to address %addr (bits 0+1 are ignored)
+    void wr_LONG(p2_LONG addr, p2_LONG val) const {
+        const p2_PAGE_t& p = page(addr);
+        addr &= ~3u;
+        if (p.wr)
+            memcpy(p.wr + (addr & PAGE_MASK), &val, sizeof(val));
+        else
+            p.wr_io(p.ctx, addr, val, sz_LONG);
+    }
+
+    void rd_block(p2_LONG addr, p2_BYTE* dst, p2_LONG size) const;
+    void wr_block(p2_LONG addr, const p2_BYTE* src, p2_LONG size) const;
+
+private:
+    p2_PAGE_t PAGES[PAGE_COUNT + 1];    //!< pages, plus one which is never mapped
+};
@@ -961,8 +961,8 @@ QString P2Opcode::format_opcode_hex(const P2Opcode& ir)
 QString P2Opcode::format_opcode_doc(const P2Opcode& ir)
 {
     return QString("[%1] %2")
-            .arg(Doc.pattern(ir.opcode()))
-            .arg(Doc.instr(ir.opcode()));
+            .arg(P2Doc::instance().pattern(ir.opcode()))
+            .arg(P2Doc::instance().instr(ir.opcode()));
 }
 
 P2Opcode P2Opcode::make_AUGD(const P2Opcode& ir)
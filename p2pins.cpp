@@ -0,0 +1,820 @@
+/****************************************************************************
+ *
+ * P2 emulator smart pins
+ *
+ * Copyright (C) 2019 Jürgen Buchmüller <pullmoll@t-online.de>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ ****************************************************************************/
+#include <QtAlgorithms>
+#include <string.h>
+#include "p2pins.h"
+#include "p2serial.h"
+#include "p2snapshot.h"
+
+//! Bit mask for pin %n
+static inline p2_QUAD pin_bit(int n)
+{
+    return Q_UINT64_C(1) << n;
+}
+
+//! Period of 1 … 65536 clocks from a 16 bit field (0 means 65536)
+static inline p2_LONG period16(p2_LONG val)
+{
+    return ((val - 1) & 0xffffu) + 1;
+}
+
+//! Rotate the bits of %val right by %n (1 … 63)
+static inline p2_QUAD rotr(p2_QUAD val, int n)
+{
+    return (val >> n) | (val << (64 - n));
+}
+
+//! Rotate the bits of %val left by %n (1 … 63)
+static inline p2_QUAD rotl(p2_QUAD val, int n)
+{
+    return (val << n) | (val >> (64 - n));
+}
+
+P2Pins::P2Pins()
+    : m_cnt(0)
+    , m_dir(0)
+    , m_in(0)
+    , m_out(0)
+    , m_busy(0)
+    , m_full(0)
+    , m_prevA(0)
+    , m_prevB(0)
+    , m_mode()
+    , m_X()
+    , m_Y()
+    , m_Z()
+    , m_acc()
+    , m_base()
+    , m_frame()
+    , m_buff()
+    , m_stepped(0)
+    , m_serial(nullptr)
+    , m_serial_tx(0)
+    , m_serial_rx(0)
+    , m_serial_line(0)
+{
+    update_masks();
+    update_groups();
+}
+
+/**
+ * @brief Run the smart pins up to CNT %cnt
+ *
+ * DIR changes since the last call take effect at the first clock:
+ * smart pins with DIR low are held in reset, and smart pins with DIR
+ * going high start from scratch.
+ *
+ * @param cnt current CNT
+ * @param dir DIR bits of all pins
+ * @param out OUT bits of all pins
+ */
+void P2Pins::run(p2_QUAD cnt, p2_QUAD dir, p2_QUAD out)
+{
+    if (dir != m_dir) {
+        const p2_QUAD fallen = m_dir & ~dir & m_smart;
+        const p2_QUAD risen = ~m_dir & dir & m_smart;
+        m_dir = dir;
+        update_groups();
+        reset(fallen);
+        start(risen);
+        // Edge detection starts with the current inputs
+        const p2_QUAD lvl = level(dir, out);
+        m_prevA = (m_prevA & ~risen) | (input(0, lvl, out) & risen);
+        m_prevB = (m_prevB & ~risen) | (input(1, lvl, out) & risen);
+    }
+
+    if (m_serial_tx | m_serial_rx)
+        run_serial(cnt);
+    if (!m_stepped) {
+        m_cnt = cnt;
+        return;
+    }
+    while (m_cnt < cnt) {
+        step(read_level(m_dir, out), out);
+        m_cnt++;
+    }
+}
+
+/**
+ * @brief Return the levels of the pins
+ *
+ * Normal pins are driven with OUT while DIR is high, smart pins with
+ * their smart output or OUT while DIR is high and the output is enabled.
+ * Pins which are not driven are pulled high, and so is the transmit pin
+ * of a serial bridge, which hands its words to the bridge directly.
+ *
+ * @param dir DIR bits of all pins
+ * @param out OUT bits of all pins
+ * @return pin levels
+ */
+p2_QUAD P2Pins::level(p2_QUAD dir, p2_QUAD out) const
+{
+    const p2_QUAD drive = dir & (~m_smart | m_drive);
+    const p2_QUAD value = (m_outsel & m_out) | (~m_outsel & out);
+    return (drive & value) | ~drive | m_serial_tx;
+}
+
+/**
+ * @brief Return the IN bits of the pins
+ *
+ * IN of a smart pin is its IN flag, IN of a normal pin is its level.
+ *
+ * @param dir DIR bits of all pins
+ * @param out OUT bits of all pins
+ * @return IN bits
+ */
+p2_QUAD P2Pins::in(p2_QUAD dir, p2_QUAD out) const
+{
+    return (m_smart & m_in) | (~m_smart & read_level(dir, out));
+}
+
+/**
+ * @brief Return the levels of the pins as read at the current clock
+ *
+ * This is level(), with the receive pin of a serial bridge following
+ * the bridge's frames.
+ *
+ * @param dir DIR bits of all pins
+ * @param out OUT bits of all pins
+ * @return pin levels
+ */
+p2_QUAD P2Pins::read_level(p2_QUAD dir, p2_QUAD out) const
+{
+    const p2_QUAD lvl = level(dir, out);
+    if (!m_serial_line || m_serial->rx_line(m_cnt))
+        return lvl;
+    return lvl & ~m_serial_line;
+}
+
+/**
+ * @brief Return the configuration of a pin
+ * @param pin pin number
+ * @return value written by WRPIN
+ */
+p2_LONG P2Pins::mode(p2_LONG pin) const
+{
+    return m_mode[pin & 63];
+}
+
+/**
+ * @brief Return the parameter X of a pin
+ * @param pin pin number
+ * @return value written by WXPIN
+ */
+p2_LONG P2Pins::X(p2_LONG pin) const
+{
+    return m_X[pin & 63];
+}
+
+/**
+ * @brief Return the parameter Y of a pin
+ * @param pin pin number
+ * @return value written by WYPIN
+ */
+p2_LONG P2Pins::Y(p2_LONG pin) const
+{
+    return m_Y[pin & 63];
+}
+
+/**
+ * @brief Attach or detach a serial bridge
+ * @param serial pointer to the bridge, or nullptr to detach
+ */
+void P2Pins::set_serial(P2Serial* serial)
+{
+    m_serial = serial;
+    update_groups();
+}
+
+/**
+ * @brief Write the configuration of a pin (WRPIN), and acknowledge it
+ * @param pin pin number
+ * @param val new configuration
+ */
+void P2Pins::wrpin(p2_LONG pin, p2_LONG val)
+{
+    const p2_QUAD bit = pin_bit(pin & 63);
+    m_mode[pin & 63] = val;
+    update_masks();
+    update_groups();
+    reset(bit);
+    start(bit & m_dir & m_smart);
+}
+
+/**
+ * @brief Write the parameter X of a pin (WXPIN), and acknowledge it
+ * @param pin pin number
+ * @param val new parameter X
+ */
+void P2Pins::wxpin(p2_LONG pin, p2_LONG val)
+{
+    m_X[pin & 63] = val;
+    akpin(pin);
+}
+
+/**
+ * @brief Write the parameter Y of a pin (WYPIN), and acknowledge it
+ *
+ * Depending on the mode this also starts output pulses or transitions,
+ * fills the transmit buffer, or stores Y as the result Z.
+ *
+ * @param pin pin number
+ * @param val new parameter Y
+ */
+void P2Pins::wypin(p2_LONG pin, p2_LONG val)
+{
+    pin &= 63;
+    const p2_QUAD bit = pin_bit(pin);
+    m_Y[pin] = val;
+    akpin(pin);
+    if (!(m_dir & m_smart & bit))
+        return;
+
+    switch (smart_mode(m_mode[pin])) {
+    case p2_SMART_REPOSITORY:
+        m_Z[pin] = val;
+        break;
+    case p2_SMART_PULSE:
+    case p2_SMART_TRANSITION:
+        m_acc[pin] = val;
+        m_base[pin] = 0;
+        break;
+    case p2_SMART_ASYNC_TX:
+        m_full |= bit;
+        if ((m_serial_tx & bit) && !(m_busy & bit))
+            serial_tx(pin);
+        break;
+    }
+}
+
+/**
+ * @brief Read the result Z of a pin (RDPIN/RQPIN)
+ * @param pin pin number
+ * @param c returns the modal C: transmitter busy in the serial transmit modes
+ * @return result Z
+ */
+p2_LONG P2Pins::rdpin(p2_LONG pin, bool& c) const
+{
+    pin &= 63;
+    c = p2_SMART_ASYNC_TX == smart_mode(m_mode[pin]) && ((m_busy | m_full) & pin_bit(pin));
+    return m_Z[pin];
+}
+
+/**
+ * @brief Acknowledge a pin, i.e. clear its IN flag
+ * @param pin pin number
+ */
+void P2Pins::akpin(p2_LONG pin)
+{
+    m_in &= ~pin_bit(pin & 63);
+}
+
+/**
+ * @brief Return the size of the smart pins' state in a snapshot
+ * @return number of bytes written by save_state()
+ */
+p2_LONG P2Pins::state_size() const
+{
+    return 0 P2_PINS_STATE(P2_STATE_SIZE);
+}
+
+/**
+ * @brief Save the smart pins' state
+ * @param dst buffer of state_size() bytes
+ */
+void P2Pins::save_state(p2_BYTE* dst) const
+{
+    P2_PINS_STATE(P2_STATE_SAVE)
+}
+
+/**
+ * @brief Restore the smart pins' state
+ * @param src buffer of state_size() bytes
+ */
+void P2Pins::restore_state(const p2_BYTE* src)
+{
+    P2_PINS_STATE(P2_STATE_LOAD)
+    update_masks();
+    update_groups();
+}
+
+/**
+ * @brief Return the smart pin mode of a configuration
+ * @param val configuration written by WRPIN
+ * @return one of p2_SMART_mode_e
+ */
+p2_LONG P2Pins::smart_mode(p2_LONG val)
+{
+    return (val >> 1) & 31;
+}
+
+/**
+ * @brief Recompute the masks derived from the pins' configurations
+ */
+void P2Pins::update_masks()
+{
+    m_smart = 0;
+    m_drive = 0;
+    m_outsel = 0;
+    memset(m_insel, 0, sizeof(m_insel));
+    memset(m_invert, 0, sizeof(m_invert));
+    for (int pin = 0; pin < PIN_COUNT; pin++) {
+        const p2_LONG val = m_mode[pin];
+        const p2_QUAD bit = pin_bit(pin);
+        switch (smart_mode(val)) {
+        case p2_SMART_OFF:
+            continue;
+        case p2_SMART_PULSE:
+        case p2_SMART_TRANSITION:
+        case p2_SMART_NCO_FREQ:
+        case p2_SMART_NCO_DUTY:
+        case p2_SMART_PWM_TRIANGLE:
+        case p2_SMART_PWM_SAWTOOTH:
+        case p2_SMART_PWM_SMPS:
+        case p2_SMART_SYNC_TX:
+        case p2_SMART_ASYNC_TX:
+            m_outsel |= bit;
+            break;
+        }
+        m_smart |= bit;
+        if (val & (1u << 6))
+            m_drive |= bit;
+        // A input selector in D[31:28], B input selector in D[27:24]
+        for (int ab = 0; ab < 2; ab++) {
+            const p2_LONG sel = (val >> (28 - 4 * ab)) & 15;
+            m_insel[ab][sel & 7] |= bit;
+            if (sel & 8)
+                m_invert[ab] |= bit;
+        }
+    }
+}
+
+/**
+ * @brief Recompute the masks of enabled smart pins per mode
+ */
+void P2Pins::update_groups()
+{
+    memset(m_group, 0, sizeof(m_group));
+    const p2_QUAD active = m_smart & m_dir;
+    for (p2_QUAD pins = active; pins; pins &= pins - 1) {
+        const int pin = static_cast<int>(qCountTrailingZeroBits(pins));
+        m_group[smart_mode(m_mode[pin])] |= pin_bit(pin);
+    }
+    m_serial_tx = 0;
+    m_serial_rx = 0;
+    m_serial_line = 0;
+    if (m_serial) {
+        m_serial_tx = m_group[p2_SMART_ASYNC_TX] & pin_bit(m_serial->tx_pin());
+        m_serial_rx = m_group[p2_SMART_ASYNC_RX] & pin_bit(m_serial->rx_pin());
+        m_serial_line = pin_bit(m_serial->rx_pin()) & ~m_serial_rx;
+        m_group[p2_SMART_ASYNC_TX] &= ~m_serial_tx;
+        m_group[p2_SMART_ASYNC_RX] &= ~m_serial_rx;
+    }
+    m_stepped = active & ~(m_serial_tx | m_serial_rx);
+    m_inputs = 0;
+    for (int mode = p2_SMART_QUADRATURE; mode <= p2_SMART_HIGH_TICKS; mode++)
+        m_inputs |= m_group[mode];
+    m_inputs |= m_group[p2_SMART_ASYNC_RX];
+}
+
+/**
+ * @brief Hold smart pins in reset
+ *
+ * Clears their IN flags, outputs, and working registers. The
+ * configuration, X, and Y are kept, and so is Z in repository mode.
+ *
+ * @param pins mask of pins
+ */
+void P2Pins::reset(p2_QUAD pins)
+{
+    for (p2_QUAD left = pins; left; left &= left - 1) {
+        const int pin = static_cast<int>(qCountTrailingZeroBits(left));
+        if (smart_mode(m_mode[pin]) != p2_SMART_REPOSITORY)
+            m_Z[pin] = 0;
+        m_acc[pin] = 0;
+        m_base[pin] = 0;
+        m_frame[pin] = 0;
+        m_buff[pin] = 0;
+    }
+    m_in &= ~pins;
+    m_out &= ~pins;
+    m_busy &= ~pins;
+    m_full &= ~pins;
+}
+
+/**
+ * @brief Start smart pins coming out of reset
+ * @param pins mask of pins
+ */
+void P2Pins::start(p2_QUAD pins)
+{
+    for (p2_QUAD left = pins; left; left &= left - 1) {
+        const int pin = static_cast<int>(qCountTrailingZeroBits(left));
+        switch (smart_mode(m_mode[pin])) {
+        case p2_SMART_PWM_TRIANGLE:
+        case p2_SMART_PWM_SAWTOOTH:
+        case p2_SMART_PWM_SMPS:
+            m_buff[pin] = m_Y[pin] & 0xffffu;
+            break;
+        case p2_SMART_ASYNC_TX:
+            m_out |= pin_bit(pin);  // idle high
+            break;
+        }
+    }
+}
+
+/**
+ * @brief Return the A or B inputs of all pins
+ *
+ * The selector %x000 is the pin itself, %x001 … %x011 are the pins
+ * +1 … +3, %x100 is the pin's OUT bit, and %x101 … %x111 are the
+ * pins -3 … -1. Selectors %1xxx invert the input.
+ *
+ * @param ab 0 for the A inputs, 1 for the B inputs
+ * @param level levels of all pins
+ * @param out OUT bits of all pins
+ * @return input bits
+ */
+p2_QUAD P2Pins::input(int ab, p2_QUAD level, p2_QUAD out) const
+{
+    p2_QUAD val = m_insel[ab][0] & level;
+    for (int sel = 1; sel < 8; sel++) {
+        const p2_QUAD pins = m_insel[ab][sel];
+        if (!pins)
+            continue;
+        if (sel < 4)
+            val |= pins & rotr(level, sel);
+        else if (sel == 4)
+            val |= pins & out;
+        else
+            val |= pins & rotl(level, 8 - sel);
+    }
+    return val ^ m_invert[ab];
+}
+
+/**
+ * @brief Advance all enabled smart pins by one clock
+ * @param level levels of all pins
+ * @param out OUT bits of all pins
+ */
+void P2Pins::step(p2_QUAD level, p2_QUAD out)
+{
+    const p2_QUAD A = m_inputs ? input(0, level, out) : 0;
+    const p2_QUAD B = m_inputs ? input(1, level, out) : 0;
+
+    if (m_group[p2_SMART_PULSE])
+        step_pulse(m_group[p2_SMART_PULSE], false);
+    if (m_group[p2_SMART_TRANSITION])
+        step_pulse(m_group[p2_SMART_TRANSITION], true);
+    if (m_group[p2_SMART_NCO_FREQ])
+        step_nco(m_group[p2_SMART_NCO_FREQ], false);
+    if (m_group[p2_SMART_NCO_DUTY])
+        step_nco(m_group[p2_SMART_NCO_DUTY], true);
+    if (m_group[p2_SMART_PWM_TRIANGLE])
+        step_pwm(m_group[p2_SMART_PWM_TRIANGLE], true);
+    if (m_group[p2_SMART_PWM_SAWTOOTH] | m_group[p2_SMART_PWM_SMPS])
+        step_pwm(m_group[p2_SMART_PWM_SAWTOOTH] | m_group[p2_SMART_PWM_SMPS], false);
+    if (m_inputs & ~m_group[p2_SMART_ASYNC_RX])
+        step_counter(A, B);
+    if (m_group[p2_SMART_ASYNC_TX])
+        step_async_tx(m_group[p2_SMART_ASYNC_TX]);
+    if (m_group[p2_SMART_ASYNC_RX])
+        step_async_rx(m_group[p2_SMART_ASYNC_RX], A);
+
+    m_prevA = A;
+    m_prevB = B;
+}
+
+/**
+ * @brief Pulse/cycle output and transition output
+ *
+ * X[15:0] is the base period. Each base period one of the Y pulses or
+ * transitions is output, and IN is raised after the last one. A pulse
+ * is high while the base period counter, counting down from X[15:0],
+ * is above X[31:16].
+ *
+ * @param pins mask of pins in the mode
+ * @param transition true for transition output
+ */
+void P2Pins::step_pulse(p2_QUAD pins, bool transition)
+{
+    p2_QUAD high = 0;
+    p2_QUAD done = 0;
+    for (int pin = 0; pin < PIN_COUNT; pin++) {
+        const p2_LONG lane = (pins >> pin) & 1;
+        const p2_LONG on = lane & (m_acc[pin] != 0);
+        const p2_LONG period = period16(m_X[pin]);
+        const p2_LONG base = m_base[pin];
+        const p2_LONG tick = on & (base + 1 >= period);
+        const p2_LONG pulse = on & (period - base > (m_X[pin] >> 16));
+        const p2_LONG toggle = static_cast<p2_LONG>((m_out >> pin) & 1) ^ tick;
+        m_base[pin] = tick ? 0 : base + on;
+        m_acc[pin] -= tick;
+        m_Z[pin] = lane ? m_acc[pin] : m_Z[pin];
+        high |= static_cast<p2_QUAD>(transition ? toggle : pulse) << pin;
+        done |= static_cast<p2_QUAD>(tick & (m_acc[pin] == 0)) << pin;
+    }
+    m_out = (m_out & ~pins) | (high & pins);
+    m_in |= done;
+}
+
+/**
+ * @brief NCO frequency and NCO duty
+ *
+ * Each base period of X[15:0] clocks Y is added to Z. The output is
+ * Z[31] for NCO frequency, or the carry of the addition for NCO duty.
+ * IN is raised on every carry.
+ *
+ * @param pins mask of pins in the mode
+ * @param duty true for NCO duty
+ */
+void P2Pins::step_nco(p2_QUAD pins, bool duty)
+{
+    p2_QUAD high = 0;
+    p2_QUAD carry = 0;
+    for (int pin = 0; pin < PIN_COUNT; pin++) {
+        const p2_LONG lane = (pins >> pin) & 1;
+        const p2_LONG base = m_base[pin] + lane;
+        const p2_LONG tick = lane & (base >= period16(m_X[pin]));
+        const p2_QUAD sum = static_cast<p2_QUAD>(m_Z[pin]) + (tick ? m_Y[pin] : 0);
+        const p2_LONG cy = static_cast<p2_LONG>(sum >> 32);
+        const p2_LONG held = static_cast<p2_LONG>((m_out >> pin) & 1);
+        m_base[pin] = tick ? 0 : base;
+        m_Z[pin] = static_cast<p2_LONG>(sum);
+        high |= static_cast<p2_QUAD>(duty ? (tick ? cy : held) : m_Z[pin] >> 31) << pin;
+        carry |= static_cast<p2_QUAD>(cy) << pin;
+    }
+    m_out = (m_out & ~pins) | (high & pins);
+    m_in |= carry & pins;
+}
+
+/**
+ * @brief PWM triangle, sawtooth, and switch-mode power supply
+ *
+ * A frame is X[31:16] base periods of X[15:0] clocks, counted up, or
+ * up and down again for triangle PWM. The output is high while the
+ * duty Y[15:0], latched at the start of the frame, is above the count.
+ * IN is raised at the start of each frame.
+ *
+ * @param pins mask of pins in the mode
+ * @param triangle true for triangle PWM
+ */
+void P2Pins::step_pwm(p2_QUAD pins, bool triangle)
+{
+    p2_QUAD high = 0;
+    p2_QUAD wrap = 0;
+    for (int pin = 0; pin < PIN_COUNT; pin++) {
+        const p2_LONG lane = (pins >> pin) & 1;
+        const p2_LONG base = m_base[pin] + lane;
+        const p2_LONG tick = lane & (base >= period16(m_X[pin]));
+        const p2_LONG frame = period16(m_X[pin] >> 16);
+        const p2_LONG frames = triangle ? 2 * frame : frame;
+        const p2_LONG pos = m_frame[pin] + tick;
+        const p2_LONG start = lane & (pos >= frames);
+        m_base[pin] = tick ? 0 : base;
+        m_frame[pin] = start ? 0 : pos;
+        m_buff[pin] = start ? m_Y[pin] & 0xffffu : m_buff[pin];
+        const p2_LONG count = (triangle && m_frame[pin] >= frame) ? frames - 1 - m_frame[pin] : m_frame[pin];
+        high |= static_cast<p2_QUAD>(m_buff[pin] > count) << pin;
+        wrap |= static_cast<p2_QUAD>(start) << pin;
+    }
+    m_out = (m_out & ~pins) | (high & pins);
+    m_in |= wrap & pins;
+}
+
+/**
+ * @brief Counter and timing modes reading the A and B inputs
+ *
+ * The counting modes accumulate their events for X clocks, then latch
+ * the count in Z and raise IN. With X = 0 they count continuously, and
+ * raise IN whenever the count changes. The timing modes count clocks,
+ * and latch the count when A changes, or falls, respectively.
+ *
+ * @param A A inputs of all pins
+ * @param B B inputs of all pins
+ */
+void P2Pins::step_counter(p2_QUAD A, p2_QUAD B)
+{
+    const p2_QUAD* g = m_group;
+    const p2_QUAD arise = A & ~m_prevA;
+    const p2_QUAD afall = ~A & m_prevA;
+    const p2_QUAD brise = B & ~m_prevB;
+    // Exactly one of the quadrature inputs changed, and the direction
+    const p2_QUAD single = (A ^ m_prevA) ^ (B ^ m_prevB);
+    const p2_QUAD back = m_prevA ^ B;
+
+    const p2_QUAD periodic = g[p2_SMART_QUADRATURE] | g[p2_SMART_REG_UP] | g[p2_SMART_REG_UP_DOWN]
+            | g[p2_SMART_COUNT_RISES] | g[p2_SMART_COUNT_HIGHS];
+    const p2_QUAD inc = (g[p2_SMART_QUADRATURE] & single & ~back)
+            | ((g[p2_SMART_REG_UP] | g[p2_SMART_REG_UP_DOWN]) & arise & B)
+            | (g[p2_SMART_COUNT_RISES] & arise)
+            | (g[p2_SMART_COUNT_HIGHS] & A)
+            | g[p2_SMART_STATE_TICKS]
+            | (g[p2_SMART_HIGH_TICKS] & A);
+    const p2_QUAD dec = (g[p2_SMART_QUADRATURE] & single & back)
+            | (g[p2_SMART_REG_UP_DOWN] & arise & ~B)
+            | (g[p2_SMART_COUNT_RISES] & brise)
+            | (g[p2_SMART_COUNT_HIGHS] & B);
+    const p2_QUAD latch = (g[p2_SMART_STATE_TICKS] & (A ^ m_prevA))
+            | (g[p2_SMART_HIGH_TICKS] & afall);
+
+    p2_QUAD raise = 0;
+    for (int pin = 0; pin < PIN_COUNT; pin++) {
+        const p2_LONG i = (inc >> pin) & 1;
+        const p2_LONG d = (dec >> pin) & 1;
+        const p2_LONG l = (latch >> pin) & 1;
+        const p2_LONG per = (periodic >> pin) & 1;
+        const p2_LONG acc = m_acc[pin] + i - d;
+        const p2_LONG timed = per & (m_X[pin] != 0);
+        const p2_LONG cont = per & (m_X[pin] == 0);
+        const p2_LONG frame = m_frame[pin] + timed;
+        const p2_LONG end = timed & (frame >= m_X[pin]);
+        m_frame[pin] = end ? 0 : frame;
+        m_Z[pin] = l ? m_acc[pin] : (end | cont) ? acc : m_Z[pin];
+        m_acc[pin] = l ? i : end ? 0 : acc;
+        raise |= static_cast<p2_QUAD>(l | end | (cont & (i ^ d))) << pin;
+    }
+    m_in |= raise;
+}
+
+/**
+ * @brief Asynchronous serial transmit
+ *
+ * X[31:16] is the bit period in clocks, X[4:0] + 1 the number of data
+ * bits. A word written with WYPIN waits in the buffer until the shifter
+ * is free, and IN is raised when it moves on to the shifter, i.e. when
+ * the buffer is free for the next one.
+ *
+ * @param pins mask of pins in the mode
+ */
+void P2Pins::step_async_tx(p2_QUAD pins)
+{
+    for (p2_QUAD left = pins; left; left &= left - 1) {
+        const int pin = static_cast<int>(qCountTrailingZeroBits(left));
+        const p2_QUAD bit = pin_bit(pin);
+        if (m_busy & bit) {
+            if (++m_base[pin] < period16(m_X[pin] >> 16))
+                continue;
+            m_base[pin] = 0;
+            if (m_frame[pin]) {
+                // next data bit, or the stop bit after the last one
+                const bool stop = 0 == --m_frame[pin];
+                const bool high = stop || (m_acc[pin] & 1);
+                m_acc[pin] >>= 1;
+                m_out = high ? m_out | bit : m_out & ~bit;
+                continue;
+            }
+            m_busy &= ~bit;
+        }
+        if (m_full & bit) {
+            // send the start bit
+            m_acc[pin] = m_Y[pin];
+            m_frame[pin] = (m_X[pin] & 31) + 2;
+            m_base[pin] = 0;
+            m_busy |= bit;
+            m_full &= ~bit;
+            m_in |= bit;
+            m_out &= ~bit;
+        }
+    }
+}
+
+/**
+ * @brief Asynchronous serial receive
+ *
+ * X[31:16] is the bit period in clocks, X[4:0] + 1 the number of data
+ * bits. A falling edge of A starts a word, and the bits are sampled in
+ * the middle of their periods. The received bits are shifted into Z
+ * from the top, so the word is left justified, and IN is raised.
+ *
+ * @param pins mask of pins in the mode
+ * @param A A inputs of all pins
+ */
+void P2Pins::step_async_rx(p2_QUAD pins, p2_QUAD A)
+{
+    for (p2_QUAD left = pins; left; left &= left - 1) {
+        const int pin = static_cast<int>(qCountTrailingZeroBits(left));
+        const p2_QUAD bit = pin_bit(pin);
+        const p2_LONG period = period16(m_X[pin] >> 16);
+        const p2_LONG bits = (m_X[pin] & 31) + 1;
+        const p2_LONG rx = static_cast<p2_LONG>((A >> pin) & 1);
+        if (!(m_busy & bit)) {
+            if (!(m_prevA & ~A & bit))
+                continue;
+            // start bit: sample in the middle of the bit periods
+            m_base[pin] = (period + 1) / 2;
+            m_frame[pin] = bits + 1;
+            m_busy |= bit;
+            continue;
+        }
+        if (--m_base[pin])
+            continue;
+        m_base[pin] = period;
+        if (m_frame[pin] > bits) {
+            // the start bit must still be low
+            if (rx)
+                m_busy &= ~bit;
+            m_frame[pin]--;
+            continue;
+        }
+        m_acc[pin] = (m_acc[pin] >> 1) | (rx << 31);
+        if (--m_frame[pin])
+            continue;
+        m_Z[pin] = m_acc[pin];
+        m_busy &= ~bit;
+        m_in |= bit;
+    }
+}
+
+/**
+ * @brief Advance the serial bridge's pins in async serial modes up to CNT %cnt
+ *
+ * The transmit pin is busy for a frame time (start bit, data bits, stop
+ * bit) after each word, and then moves the word waiting in the buffer on.
+ * The receive pin takes the next byte from the bridge once a frame time
+ * has passed and the previous byte was acknowledged, so no byte from the
+ * host is overrun.
+ *
+ * @param cnt current CNT
+ */
+void P2Pins::run_serial(p2_QUAD cnt)
+{
+    const p2_QUAD elapsed = cnt - m_cnt;
+    if (m_serial_tx) {
+        const int pin = m_serial->tx_pin();
+        const p2_QUAD bit = pin_bit(pin);
+        p2_QUAD left = elapsed;
+        while (m_busy & bit) {
+            if (m_base[pin] > left) {
+                m_base[pin] -= static_cast<p2_LONG>(left);
+                break;
+            }
+            left -= m_base[pin];
+            m_base[pin] = 0;
+            m_busy &= ~bit;
+            if (m_full & bit)
+                serial_tx(pin);
+        }
+    }
+    if (m_serial_rx) {
+        const int pin = m_serial->rx_pin();
+        const p2_QUAD bit = pin_bit(pin);
+        m_base[pin] = m_base[pin] > elapsed ? m_base[pin] - static_cast<p2_LONG>(elapsed) : 0;
+        p2_BYTE byte;
+        if (!m_base[pin] && !(m_in & bit) && m_serial->get(byte)) {
+            // the word is left justified, as shifted in from the top
+            const p2_LONG bits = (m_X[pin] & 31) + 1;
+            const p2_LONG data = byte;
+            m_acc[pin] = bits < 32 ? (m_acc[pin] >> bits) | (data << (32 - bits)) : data;
+            m_Z[pin] = m_acc[pin];
+            m_base[pin] = period16(m_X[pin] >> 16) * (bits + 2);
+            m_in |= bit;
+        }
+    }
+}
+
+/**
+ * @brief Move the word in the buffer of the serial bridge's transmit pin to the bridge
+ * @param pin pin number
+ */
+void P2Pins::serial_tx(int pin)
+{
+    const p2_QUAD bit = pin_bit(pin);
+    const p2_LONG bits = (m_X[pin] & 31) + 1;
+    m_serial->put(static_cast<p2_BYTE>(m_Y[pin]));
+    m_base[pin] = period16(m_X[pin] >> 16) * (bits + 2);
+    m_busy |= bit;
+    m_full &= ~bit;
+    m_in |= bit;
+}
@@ -0,0 +1,141 @@
+/****************************************************************************
+ *
+ * P2 emulator smart pins
+ *
+ * Copyright (C) 2019 Jürgen Buchmüller <pullmoll@t-online.de>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ ****************************************************************************/
+#pragma once
+#include "p2defs.h"
+
+class P2Serial;
+
+/**
+ * @file Smart pins of the HUB.
+ *
+ * The state of the 64 smart pins is kept as structure of arrays: one
+ * array of PIN_COUNT LONGs per register, and one p2_QUAD bit mask per
+ * one bit signal (IN, smart output, inputs A and B, ...), with bit n
+ * belonging to pin n.
+ *
+ * Each clock the one bit signals of all pins are computed at once with
+ * 64 bit logic, and every mode with at least one enabled pin advances
+ * all PIN_COUNT lanes of its registers in one branch free loop, which
+ * the compiler turns into SIMD code. Only the serial modes, which are
+ * state machines, run through their enabled pins one by one.
+ *
+ * The pins are stepped lazily: P2Hub calls run() with the current CNT
+ * before it accesses them or changes DIR or OUT, so the pins cost
+ * nothing while no smart pin is enabled, and the results are the same
+ * no matter how often run() is called.
+ *
+ * With a P2Serial attached, its transmit and receive pins skip the bit
+ * level in the async serial modes: whole words go to and come from the
+ * bridge, and the pins only advance their frame timers when run() is
+ * called, so they are not stepped every clock.
+ */
+
+//! Members of P2Pins saved in a snapshot, in file order
+#define P2_PINS_STATE(_) \
+    _(m_cnt) _(m_dir) _(m_in) _(m_out) _(m_busy) _(m_full) _(m_prevA) _(m_prevB) \
+    _(m_mode) _(m_X) _(m_Y) _(m_Z) _(m_acc) _(m_base) _(m_frame) _(m_buff)
+
+class P2Pins
+{
+public:
+    P2Pins();
+
+    void run(p2_QUAD cnt, p2_QUAD dir, p2_QUAD out);
+    p2_QUAD level(p2_QUAD dir, p2_QUAD out) const;
+    p2_QUAD in(p2_QUAD dir, p2_QUAD out) const;
+
+    p2_LONG mode(p2_LONG pin) const;
+    p2_LONG X(p2_LONG pin) const;
+    p2_LONG Y(p2_LONG pin) const;
+    void set_serial(P2Serial* serial);
+
+    void wrpin(p2_LONG pin, p2_LONG val);
+    void wxpin(p2_LONG pin, p2_LONG val);
+    void wypin(p2_LONG pin, p2_LONG val);
+    p2_LONG rdpin(p2_LONG pin, bool& c) const;
+    void akpin(p2_LONG pin);
+
+    p2_LONG state_size() const;
+    void save_state(p2_BYTE* dst) const;
+    void restore_state(const p2_BYTE* src);
+
+private:
+    p2_QUAD m_cnt;              //!< CNT up to which the pins have run
+    p2_QUAD m_dir;              //!< DIR bits the pins have run with
+    p2_QUAD m_in;               //!< IN flags of the smart pins
+    p2_QUAD m_out;              //!< smart outputs
+    p2_QUAD m_busy;             //!< serial shifter busy
+    p2_QUAD m_full;             //!< serial transmit buffer full
+    p2_QUAD m_prevA;            //!< A inputs of the previous clock
+    p2_QUAD m_prevB;            //!< B inputs of the previous clock
+    p2_LONG m_mode[PIN_COUNT];  //!< pin configuration (WRPIN)
+    p2_LONG m_X[PIN_COUNT];     //!< parameter X (WXPIN)
+    p2_LONG m_Y[PIN_COUNT];     //!< parameter Y (WYPIN)
+    p2_LONG m_Z[PIN_COUNT];     //!< result Z (RDPIN/RQPIN)
+    p2_LONG m_acc[PIN_COUNT];   //!< accumulator, counter, or shift register
+    p2_LONG m_base[PIN_COUNT];  //!< clocks into the base or bit period
+    p2_LONG m_frame[PIN_COUNT]; //!< position in the frame, or bits left
+    p2_LONG m_buff[PIN_COUNT];  //!< latched PWM duty
+
+    // Derived from m_mode and m_dir, and not saved in a snapshot
+    p2_QUAD m_smart;            //!< pins in a smart pin mode
+    p2_QUAD m_drive;            //!< smart pins with output enabled (TT = %x1)
+    p2_QUAD m_outsel;           //!< smart pins driving their smart output
+    p2_QUAD m_insel[2][8];      //!< pins selecting A or B input %x000 … %x111
+    p2_QUAD m_invert[2];        //!< pins inverting A or B input
+    p2_QUAD m_group[32];        //!< enabled smart pins per mode (p2_SMART_mode_e)
+    p2_QUAD m_inputs;           //!< enabled smart pins reading A or B
+    p2_QUAD m_stepped;          //!< enabled smart pins which are stepped every clock
+    P2Serial* m_serial;         //!< serial bridge, or nullptr
+    p2_QUAD m_serial_tx;        //!< the bridge's transmit pin, if enabled in async serial transmit mode
+    p2_QUAD m_serial_rx;        //!< the bridge's receive pin, if enabled in async serial receive mode
+    p2_QUAD m_serial_line;      //!< the bridge's receive pin, if its level comes from the bridge
+
+    static p2_LONG smart_mode(p2_LONG val);
+    void update_masks();
+    void update_groups();
+    void reset(p2_QUAD pins);
+    void start(p2_QUAD pins);
+    p2_QUAD read_level(p2_QUAD dir, p2_QUAD out) const;
+    p2_QUAD input(int ab, p2_QUAD level, p2_QUAD out) const;
+    void step(p2_QUAD level, p2_QUAD out);
+    void step_pulse(p2_QUAD pins, bool transition);
+    void step_nco(p2_QUAD pins, bool duty);
+    void step_pwm(p2_QUAD pins, bool triangle);
+    void step_counter(p2_QUAD A, p2_QUAD B);
+    void step_async_tx(p2_QUAD pins);
+    void step_async_rx(p2_QUAD pins, p2_QUAD A);
+    void run_serial(p2_QUAD cnt);
+    void serial_tx(int pin);
+};
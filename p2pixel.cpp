@@ -0,0 +1,358 @@
+/****************************************************************************
+ *
+ * P2 emulator pixel mixer
+ *
+ * Copyright (C) 2019 Jürgen Buchmüller <pullmoll@t-online.de>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ ****************************************************************************/
+#include <QtAlgorithms>
+#include "p2pixel.h"
+
+#if P2_PIXEL_SIMD
+#include <emmintrin.h>
+#if defined(__GNUC__)
+#include <immintrin.h>
+#define P2_PIXEL_AVX2 1
+#define P2_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+#ifndef P2_PIXEL_AVX2
+#define P2_PIXEL_AVX2 0
+#endif
+
+//! MIXPIX mode for MULPIX: DMIX = S, SMIX = 0
+static constexpr p2_BYTE mode_mul = (4 << 3) | 0;
+//! MIXPIX mode for BLNPIX: DMIX = !PIV, SMIX = PIV
+static constexpr p2_BYTE mode_bln = (3 << 3) | 2;
+
+/**
+ * @brief Return a MIXPIX factor for one byte
+ * @param sel selector DMIX or SMIX (bits 2 … 0)
+ * @param d byte of D
+ * @param s byte of S
+ * @param piv blend factor
+ * @return factor 0 … $FF
+ */
+static inline p2_LONG factor(p2_LONG sel, p2_LONG d, p2_LONG s, p2_LONG piv)
+{
+    switch (sel & 7) {
+    case 0: return 0x00;
+    case 1: return 0xff;
+    case 2: return piv;
+    case 3: return piv ^ 0xff;
+    case 4: return s;
+    case 5: return s ^ 0xff;
+    case 6: return d;
+    }
+    return d ^ 0xff;
+}
+
+/**
+ * @brief Compute a pixel operation byte by byte
+ * @param op pixel operation
+ * @param d value of D
+ * @param s value of S
+ * @param pix SETPIV and SETPIX values
+ * @return new value of D
+ */
+p2_LONG P2Pixel::reference(p2_PIX_op_e op, p2_LONG d, p2_LONG s, p2_PIX_t pix)
+{
+    p2_LONG result = 0;
+    for (int shift = 0; shift < 32; shift += 8) {
+        const p2_LONG db = (d >> shift) & 0xff;
+        const p2_LONG sb = (s >> shift) & 0xff;
+        p2_LONG rb = 0;
+        switch (op) {
+        case p2_PIX_ADD:
+            rb = db + sb;
+            break;
+        case p2_PIX_MUL:
+            rb = (db * sb + 0xff) >> 8;
+            break;
+        case p2_PIX_BLN:
+            rb = (db * (pix.piv ^ 0xffu) + sb * pix.piv + 0xff) >> 8;
+            break;
+        case p2_PIX_MIX:
+            rb = (db * factor(pix.mode >> 3, db, sb, pix.piv)
+                  + sb * factor(pix.mode, db, sb, pix.piv) + 0xff) >> 8;
+            break;
+        }
+        result |= qMin<p2_LONG>(rb, 0xff) << shift;
+    }
+    return result;
+}
+
+#if P2_PIXEL_SIMD
+/*
+ * The multiplying operations widen the bytes to 16 bit lanes. A product
+ * of two bytes is at most $FE01, so D * DMIX + S * SMIX + $FF only
+ * overflows 16 bits when the result is to be saturated anyway, and the
+ * unsigned saturating adds yield $FFFF, i.e. $FF after the shift.
+ */
+
+/**
+ * @brief Return the MIXPIX factors for 16 bit lanes
+ * @param sel selector DMIX or SMIX (bits 2 … 0)
+ * @param d lanes of D
+ * @param s lanes of S
+ * @param piv blend factor in all lanes
+ * @return factors 0 … $FF
+ */
+static inline __m128i factor16(p2_LONG sel, __m128i d, __m128i s, __m128i piv)
+{
+    __m128i f;
+    switch (sel & 6) {
+    case 0:  f = _mm_setzero_si128(); break;
+    case 2:  f = piv; break;
+    case 4:  f = s; break;
+    default: f = d; break;
+    }
+    return (sel & 1) ? _mm_xor_si128(f, _mm_set1_epi16(0xff)) : f;
+}
+
+/**
+ * @brief Mix 16 bit lanes of D and S
+ * @param mode MIXPIX mode
+ * @param d lanes of D
+ * @param s lanes of S
+ * @param piv blend factor in all lanes
+ * @return result lanes 0 … $FF
+ */
+static inline __m128i mix16(p2_LONG mode, __m128i d, __m128i s, __m128i piv)
+{
+    const __m128i dd = _mm_mullo_epi16(d, factor16(mode >> 3, d, s, piv));
+    const __m128i ss = _mm_mullo_epi16(s, factor16(mode, d, s, piv));
+    const __m128i sum = _mm_adds_epu16(_mm_adds_epu16(dd, ss), _mm_set1_epi16(0xff));
+    return _mm_srli_epi16(sum, 8);
+}
+
+/**
+ * @brief Mix the bytes of four LONGs of D and S
+ * @param mode MIXPIX mode
+ * @param d bytes of D
+ * @param s bytes of S
+ * @param piv blend factor in all 16 bit lanes
+ * @return result bytes
+ */
+static inline __m128i mix8(p2_LONG mode, __m128i d, __m128i s, __m128i piv)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i lo = mix16(mode, _mm_unpacklo_epi8(d, zero), _mm_unpacklo_epi8(s, zero), piv);
+    const __m128i hi = mix16(mode, _mm_unpackhi_epi8(d, zero), _mm_unpackhi_epi8(s, zero), piv);
+    return _mm_packus_epi16(lo, hi);
+}
+
+/**
+ * @brief Mix the bytes of one LONG of D and S
+ * @param mode MIXPIX mode
+ * @param d value of D
+ * @param s value of S
+ * @param piv blend factor
+ * @return result
+ */
+static inline p2_LONG mix32(p2_LONG mode, p2_LONG d, p2_LONG s, p2_LONG piv)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i d16 = _mm_unpacklo_epi8(_mm_cvtsi32_si128(static_cast<int>(d)), zero);
+    const __m128i s16 = _mm_unpacklo_epi8(_mm_cvtsi32_si128(static_cast<int>(s)), zero);
+    const __m128i r16 = mix16(mode, d16, s16, _mm_set1_epi16(static_cast<short>(piv)));
+    return static_cast<p2_LONG>(_mm_cvtsi128_si32(_mm_packus_epi16(r16, r16)));
+}
+#endif
+
+#if P2_PIXEL_AVX2
+/**
+ * @brief Return the MIXPIX factors for 16 bit lanes (AVX2)
+ */
+P2_AVX2 static inline __m256i factor16(p2_LONG sel, __m256i d, __m256i s, __m256i piv)
+{
+    __m256i f;
+    switch (sel & 6) {
+    case 0:  f = _mm256_setzero_si256(); break;
+    case 2:  f = piv; break;
+    case 4:  f = s; break;
+    default: f = d; break;
+    }
+    return (sel & 1) ? _mm256_xor_si256(f, _mm256_set1_epi16(0xff)) : f;
+}
+
+/**
+ * @brief Mix 16 bit lanes of D and S (AVX2)
+ */
+P2_AVX2 static inline __m256i mix16(p2_LONG mode, __m256i d, __m256i s, __m256i piv)
+{
+    const __m256i dd = _mm256_mullo_epi16(d, factor16(mode >> 3, d, s, piv));
+    const __m256i ss = _mm256_mullo_epi16(s, factor16(mode, d, s, piv));
+    const __m256i sum = _mm256_adds_epu16(_mm256_adds_epu16(dd, ss), _mm256_set1_epi16(0xff));
+    return _mm256_srli_epi16(sum, 8);
+}
+
+/**
+ * @brief Run a pixel operation across a buffer, 8 LONGs at a time (AVX2)
+ * @param op pixel operation
+ * @param dst buffer of D values, receives the results
+ * @param src buffer of S values
+ * @param count number of LONGs
+ * @param pix SETPIV and SETPIX values
+ * @return number of LONGs done
+ */
+P2_AVX2 static int pixels_avx2(p2_PIX_op_e op, p2_LONG* dst, const p2_LONG* src, int count, p2_PIX_t pix)
+{
+    const p2_LONG mode = p2_PIX_MUL == op ? mode_mul : p2_PIX_BLN == op ? mode_bln : pix.mode;
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i piv = _mm256_set1_epi16(pix.piv);
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dst + i));
+        const __m256i s = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+        __m256i r;
+        if (p2_PIX_ADD == op) {
+            r = _mm256_adds_epu8(d, s);
+        } else {
+            // unpack and pack work within 128 bit halves, so the order is kept
+            const __m256i lo = mix16(mode, _mm256_unpacklo_epi8(d, zero), _mm256_unpacklo_epi8(s, zero), piv);
+            const __m256i hi = mix16(mode, _mm256_unpackhi_epi8(d, zero), _mm256_unpackhi_epi8(s, zero), piv);
+            r = _mm256_packus_epi16(lo, hi);
+        }
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), r);
+    }
+    return i;
+}
+
+/**
+ * @brief Check if the host can execute AVX2 instructions
+ * @return true if it can
+ */
+static bool has_avx2()
+{
+    static const bool avx2 = __builtin_cpu_supports("avx2");
+    return avx2;
+}
+#endif
+
+/**
+ * @brief Add bytes of S into bytes of D, with $FF saturation
+ * @param d value of D
+ * @param s value of S
+ * @return result
+ */
+p2_LONG P2Pixel::addpix(p2_LONG d, p2_LONG s)
+{
+#if P2_PIXEL_SIMD
+    const __m128i r = _mm_adds_epu8(_mm_cvtsi32_si128(static_cast<int>(d)),
+                                    _mm_cvtsi32_si128(static_cast<int>(s)));
+    return static_cast<p2_LONG>(_mm_cvtsi128_si32(r));
+#else
+    return reference(p2_PIX_ADD, d, s, p2_PIX_t());
+#endif
+}
+
+/**
+ * @brief Multiply bytes of S into bytes of D, where $FF = 1.0
+ * @param d value of D
+ * @param s value of S
+ * @return result
+ */
+p2_LONG P2Pixel::mulpix(p2_LONG d, p2_LONG s)
+{
+#if P2_PIXEL_SIMD
+    return mix32(mode_mul, d, s, 0);
+#else
+    return reference(p2_PIX_MUL, d, s, p2_PIX_t());
+#endif
+}
+
+/**
+ * @brief Alpha-blend bytes of S into bytes of D, using the SETPIV value
+ * @param d value of D
+ * @param s value of S
+ * @param pix SETPIV and SETPIX values
+ * @return result
+ */
+p2_LONG P2Pixel::blnpix(p2_LONG d, p2_LONG s, p2_PIX_t pix)
+{
+#if P2_PIXEL_SIMD
+    return mix32(mode_bln, d, s, pix.piv);
+#else
+    return reference(p2_PIX_BLN, d, s, pix);
+#endif
+}
+
+/**
+ * @brief Mix bytes of S into bytes of D, using the SETPIX and SETPIV values
+ * @param d value of D
+ * @param s value of S
+ * @param pix SETPIV and SETPIX values
+ * @return result
+ */
+p2_LONG P2Pixel::mixpix(p2_LONG d, p2_LONG s, p2_PIX_t pix)
+{
+#if P2_PIXEL_SIMD
+    return mix32(pix.mode, d, s, pix.piv);
+#else
+    return reference(p2_PIX_MIX, d, s, pix);
+#endif
+}
+
+/**
+ * @brief Run a pixel operation across a buffer of LONGs
+ *
+ * Each dst[i] is replaced with the result of the operation
+ * with D = dst[i] and S = src[i].
+ *
+ * @param op pixel operation
+ * @param dst buffer of D values, receives the results
+ * @param src buffer of S values
+ * @param count number of LONGs
+ * @param pix SETPIV and SETPIX values
+ */
+void P2Pixel::pixels(p2_PIX_op_e op, p2_LONG* dst, const p2_LONG* src, int count, p2_PIX_t pix)
+{
+    int i = 0;
+#if P2_PIXEL_AVX2
+    if (has_avx2())
+        i = pixels_avx2(op, dst, src, count, pix);
+#endif
+#if P2_PIXEL_SIMD
+    const p2_LONG mode = p2_PIX_MUL == op ? mode_mul : p2_PIX_BLN == op ? mode_bln : pix.mode;
+    const __m128i piv = _mm_set1_epi16(pix.piv);
+    for (; i + 4 <= count; i += 4) {
+        const __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i));
+        const __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        const __m128i r = p2_PIX_ADD == op ? _mm_adds_epu8(d, s) : mix8(mode, d, s, piv);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), r);
+    }
+    for (; i < count; i++)
+        dst[i] = p2_PIX_ADD == op ? addpix(dst[i], src[i]) : mix32(mode, dst[i], src[i], pix.piv);
+#else
+    for (; i < count; i++)
+        dst[i] = reference(op, dst[i], src[i], pix);
+#endif
+}
@@ -0,0 +1,77 @@
+/****************************************************************************
+ *
+ * P2 emulator pixel mixer
+ *
+ * Copyright (C) 2019 Jürgen Buchmüller <pullmoll@t-online.de>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ ****************************************************************************/
+#pragma once
+#include "p2defs.h"
+
+/**
+ * @file Pixel mixer of the COGs.
+ *
+ * ADDPIX, MULPIX, BLNPIX and MIXPIX treat a LONG as four unsigned bytes
+ * and combine each byte of D with the same byte of S:
+ *<pre>
+ * ADDPIX   D = D + S, saturated to $FF
+ * MULPIX   D = (D * S + $FF) >> 8
+ * BLNPIX   D = (D * !PIV + S * PIV + $FF) >> 8
+ * MIXPIX   D = (D * DMIX + S * SMIX + $FF) >> 8, saturated to $FF
+ *</pre>
+ * DMIX and SMIX are selected by SETPIX D[5:3] and D[2:0]:
+ * %000 = 0, %001 = $FF, %010 = PIV, %011 = !PIV,
+ * %100 = S, %101 = !S, %110 = D, %111 = !D.
+ *
+ * reference() is the plain byte by byte version. The other functions
+ * compute the same results with SSE2 on x86 hosts, and pixels() runs
+ * an operation across a buffer of LONGs with AVX2 if the host has it,
+ * 8 LONGs at a time.
+ */
+
+#ifndef P2_PIXEL_SIMD
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define P2_PIXEL_SIMD 1
+#else
+#define P2_PIXEL_SIMD 0
+#endif
+#endif
+
+class P2Pixel
+{
+public:
+    static p2_LONG reference(p2_PIX_op_e op, p2_LONG d, p2_LONG s, p2_PIX_t pix);
+
+    static p2_LONG addpix(p2_LONG d, p2_LONG s);
+    static p2_LONG mulpix(p2_LONG d, p2_LONG s);
+    static p2_LONG blnpix(p2_LONG d, p2_LONG s, p2_PIX_t pix);
+    static p2_LONG mixpix(p2_LONG d, p2_LONG s, p2_PIX_t pix);
+
+    static void pixels(p2_PIX_op_e op, p2_LONG* dst, const p2_LONG* src, int count, p2_PIX_t pix);
+};
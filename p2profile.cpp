@@ -0,0 +1,245 @@
+/****************************************************************************
+ *
+ * P2 emulator execution profile
+ *
+ * Copyright (C) 2019 Jürgen Buchmüller <pullmoll@t-online.de>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ ****************************************************************************/
+#include <QFile>
+#include <QFileInfo>
+#include <QMap>
+#include "p2profile.h"
+#include "p2hub.h"
+#include "p2cog.h"
+#include "csv.h"
+
+P2Profile::P2Profile()
+    : m_cog()
+    , m_lut()
+    , m_hub(static_cast<int>(PAGE_COUNT))
+{
+}
+
+/**
+ * @brief Reset all counters to zero
+ */
+void P2Profile::clear()
+{
+    memset(m_cog, 0, sizeof(m_cog));
+    memset(m_lut, 0, sizeof(m_lut));
+    for (int page = 0; page < m_hub.count(); page++)
+        m_hub[page].clear();
+}
+
+/**
+ * @brief Return the addresses which spent any cycles
+ * @return vector of PCs in ascending order
+ */
+QVector<p2_LONG> P2Profile::addresses() const
+{
+    QVector<p2_LONG> result;
+    for (p2_LONG i = 0; i < COG_SIZE; i++)
+        if (m_cog[i].cycles)
+            result += COG_ADDR0 + i * sz_LONG;
+    for (p2_LONG i = 0; i < LUT_SIZE; i++)
+        if (m_lut[i].cycles)
+            result += LUT_ADDR0 + i * sz_LONG;
+    for (int page = 0; page < m_hub.count(); page++) {
+        const QVector<p2_PROFILE_t>& counters = m_hub[page];
+        for (int i = 0; i < counters.count(); i++)
+            if (counters[i].cycles)
+                result += (static_cast<p2_LONG>(page) << PAGE_SHIFT) + static_cast<p2_LONG>(i) * sz_LONG;
+    }
+    return result;
+}
+
+/**
+ * @brief Return the sum of the counters of all addresses
+ * @return counters
+ */
+p2_PROFILE_t P2Profile::total() const
+{
+    p2_PROFILE_t result = {0, 0, 0};
+    for (p2_LONG pc : addresses()) {
+        const p2_PROFILE_t counters = value(pc);
+        result.instructions += counters.instructions;
+        result.cycles += counters.cycles;
+        result.waits += counters.waits;
+    }
+    return result;
+}
+
+/**
+ * @brief Return the counters for %pc
+ * @param pc address
+ * @return counters, which are zero if %pc never executed
+ */
+p2_PROFILE_t P2Profile::value(p2_LONG pc) const
+{
+    if (pc < LUT_ADDR0)
+        return m_cog[(pc / sz_LONG) & COG_MASK];
+    if (pc < HUB_ADDR0)
+        return m_lut[(pc / sz_LONG) & LUT_MASK];
+    const QVector<p2_PROFILE_t>& page = m_hub[static_cast<int>((pc & A20MASK) >> PAGE_SHIFT)];
+    if (page.isEmpty())
+        return p2_PROFILE_t{0, 0, 0};
+    return page[static_cast<int>((pc & PAGE_MASK) / sz_LONG)];
+}
+
+/**
+ * @brief Return the name of the memory %pc executes from
+ * @param pc address
+ * @return "cog", "lut", or "hub"
+ */
+QString P2Profile::region(p2_LONG pc)
+{
+    if (pc < LUT_ADDR0)
+        return QStringLiteral("cog");
+    if (pc < HUB_ADDR0)
+        return QStringLiteral("lut");
+    return QStringLiteral("hub");
+}
+
+/**
+ * @brief Return the source line of %pc
+ * @param pc address
+ * @param source source lines per PC, or nullptr
+ * @return line number (0 based), or -1 if unknown
+ */
+int P2Profile::lineno(p2_LONG pc, const p2_PROFILE_source_t* source)
+{
+    if (!source)
+        return -1;
+    if (pc < HUB_ADDR0)
+        return source->cog.value(pc, -1);
+    return source->hub.value(pc, -1);
+}
+
+/**
+ * @brief Write the profiles of the COGs of %hub as comma separated values
+ *
+ * There is one row per COG and address which spent any cycles, with
+ * the source file, line number (1 based), and text if %source has them.
+ *
+ * @param filename name of the file to write
+ * @param hub HUB whose COGs to write; COGs without a profile are skipped
+ * @param source source lines per PC, or nullptr
+ * @return true on success, or false on error
+ */
+bool P2Profile::write_csv(const QString& filename, P2Hub* hub, const p2_PROFILE_source_t* source)
+{
+    QList<QStringList> records;
+    records += QStringList()
+               << QStringLiteral("cog")
+               << QStringLiteral("region")
+               << QStringLiteral("pc")
+               << QStringLiteral("instructions")
+               << QStringLiteral("cycles")
+               << QStringLiteral("waits")
+               << QStringLiteral("file")
+               << QStringLiteral("line")
+               << QStringLiteral("source");
+
+    for (int id = 0; id < hub->ncogs(); id++) {
+        const P2Profile* profile = hub->cog(id)->profile();
+        if (!profile)
+            continue;
+        for (p2_LONG pc : profile->addresses()) {
+            const p2_PROFILE_t counters = profile->value(pc);
+            const int line = lineno(pc, source);
+            QStringList row;
+            row << QString::number(id)
+                << region(pc)
+                << QStringLiteral("$%1").arg(pc, 5, 16, QChar('0'))
+                << QString::number(counters.instructions)
+                << QString::number(counters.cycles)
+                << QString::number(counters.waits);
+            if (line >= 0)
+                row << source->filename
+                    << QString::number(line + 1)
+                    << source->source.value(line).trimmed();
+            records += row;
+        }
+    }
+
+    CSV csv(filename);
+    return csv.write(records);
+}
+
+/**
+ * @brief Write the profiles of the COGs of %hub as collapsed stacks
+ *
+ * Each line is a stack of frames separated by semicolons and the number
+ * of cycles spent in it: the COG, the memory region, and the source line
+ * if %source has it, or the address otherwise. The cycles an address spent
+ * waiting are in an extra "wait" frame on top of it.
+ *
+ * @param filename name of the file to write
+ * @param hub HUB whose COGs to write; COGs without a profile are skipped
+ * @param source source lines per PC, or nullptr
+ * @return true on success, or false on error
+ */
+bool P2Profile::write_collapsed(const QString& filename, P2Hub* hub, const p2_PROFILE_source_t* source)
+{
+    // addresses of one source line, e.g. an instruction and its AUGS, add up
+    QMap<QString,p2_QUAD> stacks;
+    const QString file = source ? QFileInfo(source->filename).fileName() : QString();
+    for (int id = 0; id < hub->ncogs(); id++) {
+        const P2Profile* profile = hub->cog(id)->profile();
+        if (!profile)
+            continue;
+        for (p2_LONG pc : profile->addresses()) {
+            const p2_PROFILE_t counters = profile->value(pc);
+            const int line = lineno(pc, source);
+            QString frame;
+            if (line >= 0) {
+                // semicolons separate the frames
+                QString text = source->source.value(line).simplified();
+                text.replace(QChar(';'), QChar(','));
+                frame = QStringLiteral("%1:%2 %3").arg(file, QString::number(line + 1), text);
+            } else {
+                frame = QStringLiteral("$%1").arg(pc, 5, 16, QChar('0'));
+            }
+            const QString stack = QStringLiteral("cog%1;%2;%3").arg(QString::number(id), region(pc), frame);
+            if (counters.cycles > counters.waits)
+                stacks[stack] += counters.cycles - counters.waits;
+            if (counters.waits)
+                stacks[stack + QStringLiteral(";wait")] += counters.waits;
+        }
+    }
+
+    QByteArray data;
+    for (auto it = stacks.constBegin(); it != stacks.constEnd(); ++it)
+        data += QStringLiteral("%1 %2\n").arg(it.key()).arg(it.value()).toUtf8();
+
+    QFile out(filename);
+    if (!out.open(QIODevice::WriteOnly))
+        return false;
+    return out.write(data) == data.size();
+}
@@ -0,0 +1,110 @@
+/****************************************************************************
+ *
+ * P2 emulator execution profile
+ *
+ * Copyright (C) 2019 Jürgen Buchmüller <pullmoll@t-online.de>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ ****************************************************************************/
+#pragma once
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include "p2defs.h"
+#include "p2memmap.h"
+
+class P2Hub;
+
+/**
+ * @file Execution profile of a COG.
+ *
+ * A P2Cog with a P2Profile counts, per PC, the instructions it retired,
+ * the cycles it spent, and how many of these cycles it was waiting, e.g.
+ * for a HUB slot, a WAITX, or an event. Wait cycles are counted for the
+ * instruction which started the wait. COG, LUT, and HUB addresses are
+ * counted separately; the counters of a HUB page are allocated when an
+ * instruction there executes for the first time.
+ *
+ * The translator is not used while a COG is profiled, so the counts are
+ * exact per instruction.
+ *
+ * The profiles of all COGs of a P2Hub are written as CSV, or in the
+ * collapsed stack format of flame graph tools. With a p2_PROFILE_source_t,
+ * e.g. built from a P2Asm listing, the counts are attributed to source
+ * lines as well.
+ */
+
+//! Counters of one PC
+typedef struct {
+    p2_QUAD instructions;       //!< instructions retired
+    p2_QUAD cycles;             //!< cycles spent, including waits
+    p2_QUAD waits;              //!< cycles spent waiting
+}   p2_PROFILE_t;
+
+//! Source lines per PC, e.g. from a P2Asm listing
+typedef struct {
+    QString filename;           //!< name of the source file
+    QStringList source;         //!< source lines
+    QHash<p2_LONG,int> cog;     //!< line number (0 based) per COG or LUT address (bytes, as in PC)
+    QHash<p2_LONG,int> hub;     //!< line number (0 based) per HUB address
+}   p2_PROFILE_source_t;
+
+class P2Profile
+{
+public:
+    P2Profile();
+
+    void clear();
+    QVector<p2_LONG> addresses() const;
+    p2_PROFILE_t total() const;
+    p2_PROFILE_t value(p2_LONG pc) const;
+
+    //! return the counters for %pc
+    p2_PROFILE_t& counters(p2_LONG pc) {
+        if (pc < LUT_ADDR0)
+            return m_cog[(pc / sz_LONG) & COG_MASK];
+        if (pc < HUB_ADDR0)
+            return m_lut[(pc / sz_LONG) & LUT_MASK];
+        QVector<p2_PROFILE_t>& page = m_hub[static_cast<int>((pc & A20MASK) >> PAGE_SHIFT)];
+        if (page.isEmpty())
+            page.resize(PAGE_SIZE / sz_LONG);
+        return page[static_cast<int>((pc & PAGE_MASK) / sz_LONG)];
+    }
+
+    static QString region(p2_LONG pc);
+    static bool write_csv(const QString& filename, P2Hub* hub, const p2_PROFILE_source_t* source = nullptr);
+    static bool write_collapsed(const QString& filename, P2Hub* hub, const p2_PROFILE_source_t* source = nullptr);
+
+private:
+    p2_PROFILE_t m_cog[COG_SIZE];               //!< counters for COG addresses
+    p2_PROFILE_t m_lut[LUT_SIZE];               //!< counters for LUT addresses
+    QVector<QVector<p2_PROFILE_t>> m_hub;       //!< counters for HUB addresses per page, empty until used
+
+    static int lineno(p2_LONG pc, const p2_PROFILE_source_t* source);
+};
@@ -0,0 +1,318 @@
+/****************************************************************************
+ *
+ * P2 emulator reverse execution
+ *
+ * Copyright (C) 2019 Jürgen Buchmüller <pullmoll@t-online.de>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ ****************************************************************************/
+#include "p2rewind.h"
+#include "p2hub.h"
+#include "p2cog.h"
+#include "p2memmap.h"
+
+//! Default number of cycles between two checkpoints
+static constexpr p2_QUAD default_interval = Q_UINT64_C(1) << 20;
+
+//! Default maximum number of bytes used by the checkpoints
+static constexpr p2_QUAD default_limit = Q_UINT64_C(256) << 20;
+
+//! Number of CNT ticks to execute per P2Hub::execute() call when replaying
+static constexpr p2_QUAD replay_ticks = 1024;
+
+P2Rewind::P2Rewind(P2Hub* hub)
+    : m_hub(hub)
+    , m_interval(default_interval)
+    , m_limit(default_limit)
+    , m_used(0)
+    , m_checkpoints()
+{
+}
+
+/**
+ * @brief Return the number of cycles between two checkpoints
+ */
+p2_QUAD P2Rewind::interval() const
+{
+    return m_interval;
+}
+
+/**
+ * @brief Set the number of cycles between two checkpoints
+ *
+ * Shorter intervals make stepping back faster and use more memory.
+ *
+ * @param cycles number of CNT ticks (at least 1)
+ */
+void P2Rewind::set_interval(p2_QUAD cycles)
+{
+    m_interval = qMax<p2_QUAD>(cycles, 1);
+}
+
+/**
+ * @brief Return the maximum number of bytes used by the checkpoints
+ */
+p2_QUAD P2Rewind::limit() const
+{
+    return m_limit;
+}
+
+/**
+ * @brief Set the maximum number of bytes used by the checkpoints
+ * @param bytes number of bytes
+ */
+void P2Rewind::set_limit(p2_QUAD bytes)
+{
+    m_limit = bytes;
+    while (m_used > m_limit && m_checkpoints.count() > 1)
+        drop_oldest();
+}
+
+/**
+ * @brief Return the number of bytes used by the checkpoints
+ */
+p2_QUAD P2Rewind::used() const
+{
+    return m_used;
+}
+
+/**
+ * @brief Return the number of checkpoints
+ */
+int P2Rewind::checkpoints() const
+{
+    return m_checkpoints.count();
+}
+
+/**
+ * @brief Return the earliest cycle which can be reached
+ * @return CNT of the oldest checkpoint, or the current CNT if there is none
+ */
+p2_QUAD P2Rewind::earliest() const
+{
+    return m_checkpoints.isEmpty() ? m_hub->count() : m_checkpoints.first().cnt;
+}
+
+/**
+ * @brief Forget all checkpoints
+ *
+ * This must be called whenever the machine state is changed by other
+ * means than P2Hub::execute(), e.g. after loading a file.
+ */
+void P2Rewind::clear()
+{
+    m_checkpoints.clear();
+    m_used = 0;
+}
+
+/**
+ * @brief Take a checkpoint, if one is due
+ *
+ * Call this after every P2Hub::execute() slice.
+ */
+void P2Rewind::record()
+{
+    if (m_checkpoints.isEmpty() || m_hub->count() >= m_checkpoints.last().cnt + m_interval)
+        checkpoint();
+}
+
+/**
+ * @brief Go to the cycle %cycle
+ * @param cycle value of CNT to go to
+ * @return true on success, or false if it is before the oldest checkpoint
+ */
+bool P2Rewind::seek(p2_QUAD cycle)
+{
+    if (cycle < m_hub->count()) {
+        const int idx = find(cycle);
+        if (idx < 0)
+            return false;
+        restore(idx);
+    }
+    replay(cycle);
+    return true;
+}
+
+/**
+ * @brief Go back %cycles cycles
+ * @param cycles number of CNT ticks
+ * @return true on success, or false if it is before the oldest checkpoint
+ */
+bool P2Rewind::step_back(p2_QUAD cycles)
+{
+    const p2_QUAD now = m_hub->count();
+    if (cycles > now)
+        return false;
+    return seek(now - cycles);
+}
+
+/**
+ * @brief Go back to the last cycle at which COG %id was about to execute %pc
+ *
+ * The checkpoints are searched from the newest to the oldest, each one
+ * by replaying it up to the next one, or the current cycle.
+ *
+ * @param id COG number
+ * @param pc program counter to look for
+ * @return true if found, or false if not (the machine stays at the current cycle)
+ */
+bool P2Rewind::continue_back(int id, p2_LONG pc)
+{
+    P2Cog* cog = m_hub->cog(id);
+    const p2_QUAD now = m_hub->count();
+    if (!cog || m_checkpoints.isEmpty())
+        return false;
+
+    const bool armed = m_hub->breakpoints_armed();
+    p2_QUAD end = now;
+    for (int idx = find(now > 0 ? now - 1 : 0); idx >= 0; idx--) {
+        restore(idx);
+        bool found = false;
+        p2_QUAD last = 0;
+        m_hub->arm_breakpoints(false);
+        while (m_hub->count() < end) {
+            if (cog->rd_PC() == pc) {
+                found = true;
+                last = m_hub->count();
+            }
+            m_hub->execute(2 * m_hub->ncogs());
+        }
+        m_hub->arm_breakpoints(armed);
+        if (found) {
+            restore(idx);
+            replay(last);
+            return true;
+        }
+        end = m_checkpoints[idx].cnt;
+    }
+    seek(now);
+    return false;
+}
+
+/**
+ * @brief Return the number of bytes used by the checkpoint %cp
+ */
+p2_QUAD P2Rewind::size(const p2_CHECKPOINT_t& cp)
+{
+    return static_cast<p2_QUAD>(cp.state.size()) +
+            static_cast<p2_QUAD>(cp.own) * PAGE_SIZE;
+}
+
+/**
+ * @brief Take a checkpoint of the machine state now
+ */
+void P2Rewind::checkpoint()
+{
+    const int ncogs = m_hub->ncogs();
+    const p2_LONG hub_size = m_hub->state_size();
+    const p2_LONG cog_size = P2Cog::state_size();
+
+    p2_CHECKPOINT_t cp;
+    cp.cnt = m_hub->count();
+    cp.state.resize(static_cast<int>(hub_size + static_cast<p2_LONG>(ncogs) * cog_size));
+    p2_BYTE* dst = reinterpret_cast<p2_BYTE*>(cp.state.data());
+    m_hub->save_state(dst);
+    dst += hub_size;
+    for (int id = 0; id < ncogs; id++, dst += cog_size)
+        m_hub->cog(id)->save_state(dst);
+
+    cp.pages = m_hub->share_pages();
+    cp.own = PAGE_COUNT;
+    if (!m_checkpoints.isEmpty()) {
+        const QVector<QByteArray>& last = m_checkpoints.last().pages;
+        cp.own = 0;
+        for (int page = 0; page < cp.pages.count(); page++)
+            if (cp.pages.at(page).constData() != last.at(page).constData())
+                cp.own++;
+    }
+
+    m_used += size(cp);
+    m_checkpoints += cp;
+    while (m_used > m_limit && m_checkpoints.count() > 1)
+        drop_oldest();
+}
+
+/**
+ * @brief Drop the oldest checkpoint
+ *
+ * The next checkpoint then holds all of its pages on its own.
+ */
+void P2Rewind::drop_oldest()
+{
+    p2_CHECKPOINT_t& next = m_checkpoints[1];
+    m_used -= size(m_checkpoints.first());
+    m_used -= size(next);
+    next.own = PAGE_COUNT;
+    m_used += size(next);
+    m_checkpoints.removeFirst();
+}
+
+/**
+ * @brief Find the newest checkpoint at or before %cycle
+ * @param cycle value of CNT
+ * @return index of the checkpoint, or -1 if there is none
+ */
+int P2Rewind::find(p2_QUAD cycle) const
+{
+    for (int idx = m_checkpoints.count() - 1; idx >= 0; idx--)
+        if (m_checkpoints[idx].cnt <= cycle)
+            return idx;
+    return -1;
+}
+
+/**
+ * @brief Restore the machine state at checkpoint %idx
+ * @param idx index of the checkpoint
+ */
+void P2Rewind::restore(int idx)
+{
+    const p2_CHECKPOINT_t& cp = m_checkpoints[idx];
+    m_hub->set_pages(cp.pages);
+    const p2_BYTE* src = reinterpret_cast<const p2_BYTE*>(cp.state.constData());
+    m_hub->restore_state(src);
+    src += m_hub->state_size();
+    for (int id = 0; id < m_hub->ncogs(); id++, src += P2Cog::state_size())
+        m_hub->cog(id)->restore_state(src);
+}
+
+/**
+ * @brief Execute forward up to cycle %cycle
+ * @param cycle value of CNT to stop at
+ */
+void P2Rewind::replay(p2_QUAD cycle)
+{
+    // the history is replayed as it was recorded, without stopping at breakpoints
+    const bool armed = m_hub->breakpoints_armed();
+    m_hub->arm_breakpoints(false);
+    const int tick_cycles = 2 * m_hub->ncogs();
+    while (m_hub->count() < cycle) {
+        const p2_QUAD ticks = qMin(cycle - m_hub->count(), replay_ticks);
+        m_hub->execute(static_cast<int>(ticks) * tick_cycles);
+    }
+    m_hub->arm_breakpoints(armed);
+}
@@ -0,0 +1,96 @@
+/****************************************************************************
+ *
+ * P2 emulator reverse execution
+ *
+ * Copyright (C) 2019 Jürgen Buchmüller <pullmoll@t-online.de>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ ****************************************************************************/
+#pragma once
+#include <QByteArray>
+#include <QVector>
+#include "p2defs.h"
+
+class P2Hub;
+
+/**
+ * @file Reverse execution through checkpoints and replay.
+ *
+ * P2Rewind takes a checkpoint of the machine every interval() cycles.
+ * A checkpoint holds the HUB and COG states (registers, COG and LUT
+ * memory, …) and the HUB memory pages. The pages are shared with the
+ * HUB and the other checkpoints until written, so a checkpoint only
+ * costs the pages which changed since the previous one.
+ *
+ * Since the emulation is deterministic, any earlier cycle is reached by
+ * restoring the last checkpoint before it and executing forward. When
+ * the checkpoints use more than limit() bytes, the oldest one is folded
+ * into the next, so the history gets shorter, but never larger.
+ */
+
+class P2Rewind
+{
+public:
+    explicit P2Rewind(P2Hub* hub);
+
+    p2_QUAD interval() const;
+    void set_interval(p2_QUAD cycles);
+    p2_QUAD limit() const;
+    void set_limit(p2_QUAD bytes);
+    p2_QUAD used() const;
+    int checkpoints() const;
+    p2_QUAD earliest() const;
+
+    void clear();
+    void record();
+    bool seek(p2_QUAD cycle);
+    bool step_back(p2_QUAD cycles = 1);
+    bool continue_back(int id, p2_LONG pc);
+
+private:
+    //! Checkpoint of the machine state
+    typedef struct {
+        p2_QUAD cnt;                //!< HUB cycle counter at the checkpoint
+        QByteArray state;           //!< HUB and COG states
+        QVector<QByteArray> pages;  //!< HUB memory pages
+        p2_LONG own;                //!< number of pages not shared with the previous checkpoint
+    }   p2_CHECKPOINT_t;
+
+    P2Hub* m_hub;                   //!< HUB being recorded
+    p2_QUAD m_interval;             //!< cycles between two checkpoints
+    p2_QUAD m_limit;                //!< maximum number of bytes to use
+    p2_QUAD m_used;                 //!< number of bytes used
+    QVector<p2_CHECKPOINT_t> m_checkpoints; //!< checkpoints, oldest first
+
+    static p2_QUAD size(const p2_CHECKPOINT_t& cp);
+    void checkpoint();
+    void drop_oldest();
+    int find(p2_QUAD cycle) const;
+    void restore(int idx);
+    void replay(p2_QUAD cycle);
+};
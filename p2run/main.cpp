@@ -0,0 +1,857 @@
+/****************************************************************************
+ *
+ * Propeller2 headless emulator runner
+ *
+ * Copyright (C) 2019 Jürgen Buchmüller <pullmoll@t-online.de>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ ****************************************************************************/
+#include <algorithm>
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QPair>
+#include <QScopedPointer>
+#include <QTextStream>
+#include <QThread>
+#include <QVector>
+#include "p2hub.h"
+#include "p2cog.h"
+#include "p2farm.h"
+#include "p2gdb.h"
+#include "p2profile.h"
+#include "p2rewind.h"
+#include "p2serial.h"
+#include "p2trace.h"
+#include "p2util.h"
+#include "p2video.h"
+
+//! Default number of emulated cycles if no --cycles option is given
+static constexpr p2_QUAD default_cycles = Q_UINT64_C(100000000);
+
+//! Number of CNT ticks to run per P2Hub::execute() slice
+static constexpr int slice_ticks = 1024;
+
+//! Number of instruction classes to list in the statistics
+static constexpr int stats_classes = 16;
+
+/**
+ * @brief Print the instruction mix and wait cycles of the statistics
+ * @param out stream to print to
+ * @param stats statistics summed over all COGs
+ * @param cycles number of cycles of all COGs
+ */
+static void print_stats(QTextStream& out, const p2_STATS_t& stats, p2_QUAD cycles)
+{
+    static const char* const wait_names[p2_WAIT_HALTED + 1] = {
+        "WAITX", "CNT", "CORDIC", "PIN", "HUB", "CACHE", "FLAG", "STREAMER", "HALTED"
+    };
+    const auto percent = [cycles](p2_QUAD count) {
+        return cycles ? 100.0 * static_cast<double>(count) / static_cast<double>(cycles) : 0.0;
+    };
+
+    for (int mode = p2_WAIT_NONE; mode <= p2_WAIT_HALTED; mode++) {
+        if (!stats.waits[mode])
+            continue;
+        out << QStringLiteral("wait %1 %2 (%3 %)\n")
+               .arg(QString(QStringLiteral("%1:")).arg(QString::fromLatin1(wait_names[mode])), -9)
+               .arg(stats.waits[mode])
+               .arg(percent(stats.waits[mode]), 0, 'f', 2);
+    }
+    out << QStringLiteral("skipped:       %1 SKIP, %2 SKIPF\n").arg(stats.skipped).arg(stats.skipped_fast);
+    out << QStringLiteral("cond. failed:  %1\n").arg(stats.cond_failed);
+
+    // Instructions are listed by the op_xxx() function they are dispatched to;
+    // opcodes other than $00000000 which op_NOP() executes are not defined
+    QVector<QPair<p2_QUAD,QString>> classes;
+    if (stats.nops)
+        classes += qMakePair(stats.nops, QStringLiteral("NOP"));
+    for (int op = 0; op < p2_COG_OP_COUNT; op++) {
+        if (!stats.ops[op])
+            continue;
+        const QString name = QString::fromLatin1(P2Cog::opname(op));
+        classes += qMakePair(stats.ops[op], name == QStringLiteral("NOP") ? QStringLiteral("undefined") : name);
+    }
+    std::sort(classes.begin(), classes.end(), [](const QPair<p2_QUAD,QString>& a, const QPair<p2_QUAD,QString>& b) {
+        return a.first > b.first;
+    });
+    p2_QUAD executed = 0;
+    for (const QPair<p2_QUAD,QString>& entry : classes)
+        executed += entry.first;
+    for (int i = 0; i < classes.count() && i < stats_classes; i++)
+        out << QStringLiteral("mix %1 %2 %3 (%4 %)\n")
+               .arg(QString::number(i + 1) + QChar(':'), -10)
+               .arg(classes[i].second, -22)
+               .arg(classes[i].first)
+               .arg(executed ? 100.0 * static_cast<double>(classes[i].first) / static_cast<double>(executed) : 0.0, 0, 'f', 2);
+}
+
+/**
+ * @brief Parse a number in decimal, $hex, 0xhex, or %binary notation
+ * @param str string to parse
+ * @param val reference to the value to set
+ * @return true on success, or false on error
+ */
+static bool parse_number(const QString& str, p2_QUAD& val)
+{
+    bool ok = false;
+    if (str.startsWith(QChar('$'))) {
+        val = str.mid(1).toULongLong(&ok, 16);
+    } else if (str.startsWith(QStringLiteral("0x"))) {
+        val = str.mid(2).toULongLong(&ok, 16);
+    } else if (str.startsWith(QChar('%'))) {
+        val = str.mid(1).toULongLong(&ok, 2);
+    } else {
+        val = str.toULongLong(&ok, 10);
+    }
+    return ok;
+}
+
+/**
+ * @brief Parse a watchpoint address with an optional cog:, lut:, or hub: prefix
+ * @param str string to parse; without a prefix the address is in HUB memory
+ * @param space reference to the memory to set
+ * @param addr reference to the long index or byte address to set
+ * @return true on success, or false on error
+ */
+static bool parse_watch(const QString& str, p2_BREAK_space_e& space, p2_LONG& addr)
+{
+    QString number = str;
+    space = p2_BREAK_HUB;
+    if (str.startsWith(QStringLiteral("cog:"))) {
+        space = p2_BREAK_COG;
+        number = str.mid(4);
+    } else if (str.startsWith(QStringLiteral("lut:"))) {
+        space = p2_BREAK_LUT;
+        number = str.mid(4);
+    } else if (str.startsWith(QStringLiteral("hub:"))) {
+        number = str.mid(4);
+    }
+    p2_QUAD val = 0;
+    if (!parse_number(number, val) || val > (p2_BREAK_HUB == space ? A20MASK : COG_MASK))
+        return false;
+    addr = static_cast<p2_LONG>(val);
+    return true;
+}
+
+/**
+ * @brief Describe a breakpoint or watchpoint hit
+ * @param hit the hit
+ * @return text for the report
+ */
+static QString describe_hit(const p2_BREAK_hit_t& hit)
+{
+    static const char* const spaces[p2_BREAK_HUB + 1] = {"COG", "LUT", "HUB"};
+    if (p2_BREAK_EXEC == hit.kind)
+        return QStringLiteral("breakpoint at $%1 in COG #%2")
+                .arg(hit.pc, 5, 16, QChar('0'))
+                .arg(hit.cog);
+    return QStringLiteral("%1 watchpoint at %2 $%3 by COG #%4 at $%5")
+            .arg(p2_BREAK_READ == hit.kind ? QStringLiteral("read") : QStringLiteral("write"))
+            .arg(QString::fromLatin1(spaces[hit.space]))
+            .arg(hit.addr, p2_BREAK_HUB == hit.space ? 5 : 3, 16, QChar('0'))
+            .arg(hit.cog)
+            .arg(hit.pc, 5, 16, QChar('0'));
+}
+
+/**
+ * @brief Measure the cost of decoding opcodes with the dispatch table and with the switch
+ * @param out text stream to print the results to
+ * @param count number of pseudo random opcodes to decode
+ */
+static void bench_dispatch(QTextStream& out, int count)
+{
+    QVector<p2_LONG> opcodes(count);
+    p2_LONG x = 2463534242u;
+    for (int i = 0; i < count; i++) {
+        // xorshift32
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        opcodes[i] = x;
+    }
+
+    const bool was_table = P2Cog::dispatch_table();
+    for (int pass = 0; pass < 2; pass++) {
+        const bool table = pass > 0;
+        P2Cog::set_dispatch_table(table);
+        // the table is built on first use, which is not to be measured
+        P2Cog::opindex(0);
+        QElapsedTimer timer;
+        p2_LONG sum = 0;
+        timer.start();
+        for (int i = 0; i < count; i++)
+            sum += static_cast<p2_LONG>(P2Cog::opindex(opcodes[i]));
+        const qint64 nsecs = timer.nsecsElapsed();
+        out << QStringLiteral("dispatch %1: %2 ns/opcode (checksum %3)\n")
+               .arg(table ? QStringLiteral("table ") : QStringLiteral("switch"))
+               .arg(static_cast<double>(nsecs) / count, 0, 'f', 3)
+               .arg(sum, 8, 16, QChar('0'));
+    }
+    P2Cog::set_dispatch_table(was_table);
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+#if !defined(QT_NO_DEBUG)
+    P2Util::selftest();
+#endif
+
+    app.setApplicationName(QStringLiteral("p2run"));
+    app.setApplicationVersion(QString("%1.%2.%3").arg(VER_MAJ).arg(VER_MIN).arg(VER_PAT));
+    app.setOrganizationName(QStringLiteral("PullMoll"));
+    app.setOrganizationDomain(QStringLiteral("https://propeller2.voidlinux.de/"));
+
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("Run a Propeller2 object file without the GUI and report the emulation speed."));
+    parser.addHelpOption();
+    parser.addVersionOption();
+    parser.addPositionalArgument(QStringLiteral("file"),
+                                 QStringLiteral("Object (.obj) or binary (.bin) file to load; use :/bin/<name> for the built-in files. "
+                                                "With --farm, any number of files and directories of .obj files."));
+
+    const QCommandLineOption opt_cycles(QStringList() << QStringLiteral("c") << QStringLiteral("cycles"),
+                                        QStringLiteral("Stop after <n> emulated cycles (default %1).").arg(default_cycles),
+                                        QStringLiteral("n"));
+    const QCommandLineOption opt_stop_pc(QStringList() << QStringLiteral("p") << QStringLiteral("stop-pc"),
+                                         QStringLiteral("Stop when COG #0 is about to execute address <addr>."),
+                                         QStringLiteral("addr"));
+    const QCommandLineOption opt_timeout(QStringList() << QStringLiteral("t") << QStringLiteral("timeout"),
+                                         QStringLiteral("Stop after <msecs> milliseconds of host time."),
+                                         QStringLiteral("msecs"));
+    const QCommandLineOption opt_cogs(QStringList() << QStringLiteral("n") << QStringLiteral("cogs"),
+                                      QStringLiteral("Number of COGs to emulate (1, 2, 4, 8, or 16; default 8)."),
+                                      QStringLiteral("n"), QStringLiteral("8"));
+    const QCommandLineOption opt_trace(QStringList() << QStringLiteral("trace"),
+                                       QStringLiteral("Write the emulator trace to <file> (needs a build with P2_TRACE_LEVEL > 0)."),
+                                       QStringLiteral("file"));
+    const QCommandLineOption opt_dispatch(QStringList() << QStringLiteral("d") << QStringLiteral("dispatch"),
+                                          QStringLiteral("Decode instructions through the flat dispatch <table> (default) or the reference <switch>."),
+                                          QStringLiteral("mode"), QStringLiteral("table"));
+    const QCommandLineOption opt_jit(QStringList() << QStringLiteral("j") << QStringLiteral("jit"),
+                                     QStringLiteral("Translate COG/LUT code to host code: <off> (default), <on>, or <verify> against the interpreter."),
+                                     QStringLiteral("mode"), QStringLiteral("off"));
+    const QCommandLineOption opt_parallel(QStringList() << QStringLiteral("parallel"),
+                                          QStringLiteral("Run each COG on a worker thread of its own."));
+    const QCommandLineOption opt_no_fast_forward(QStringList() << QStringLiteral("no-fast-forward"),
+                                                 QStringLiteral("Execute every cycle, even when all COGs are waiting."));
+    const QCommandLineOption opt_hub_timing(QStringList() << QStringLiteral("hub-timing"),
+                                            QStringLiteral("HUB memory timing: <functional> (no stalls), <approximate> (default), or <latency> (approximate plus fixed read/write latencies)."),
+                                            QStringLiteral("mode"), QStringLiteral("approximate"));
+    const QCommandLineOption opt_restore(QStringList() << QStringLiteral("restore-snapshot"),
+                                         QStringLiteral("Start from the machine state in the snapshot <file> instead of booting."),
+                                         QStringLiteral("file"));
+    const QCommandLineOption opt_save(QStringList() << QStringLiteral("save-snapshot"),
+                                      QStringLiteral("Save the machine state to the snapshot <file> when the run stops."),
+                                      QStringLiteral("file"));
+    const QCommandLineOption opt_reverse(QStringList() << QStringLiteral("reverse"),
+                                         QStringLiteral("When the run stops, step back <n> cycles and report where the COGs were."),
+                                         QStringLiteral("n"));
+    const QCommandLineOption opt_reverse_pc(QStringList() << QStringLiteral("reverse-pc"),
+                                            QStringLiteral("When the run stops, go back to the last cycle at which COG #0 was about to execute <addr>."),
+                                            QStringLiteral("addr"));
+    const QCommandLineOption opt_checkpoint(QStringList() << QStringLiteral("checkpoint-interval"),
+                                            QStringLiteral("Take a checkpoint for --reverse and --reverse-pc every <n> cycles."),
+                                            QStringLiteral("n"));
+    const QCommandLineOption opt_rewind_limit(QStringList() << QStringLiteral("rewind-limit"),
+                                              QStringLiteral("Use at most <MiB> of memory for the checkpoints."),
+                                              QStringLiteral("MiB"));
+    const QCommandLineOption opt_bench_dispatch(QStringList() << QStringLiteral("bench-dispatch"),
+                                                QStringLiteral("Decode <n> random opcodes with both dispatch modes, print the cost, and exit."),
+                                                QStringLiteral("n"));
+    const QCommandLineOption opt_video(QStringList() << QStringLiteral("video"),
+                                       QStringLiteral("Capture the streamer output and save each frame to <prefix>NNNNN.png."),
+                                       QStringLiteral("prefix"));
+    const QCommandLineOption opt_video_cog(QStringList() << QStringLiteral("video-cog"),
+                                           QStringLiteral("Capture the streamer of COG #<n> (default 0)."),
+                                           QStringLiteral("n"), QStringLiteral("0"));
+    const QCommandLineOption opt_video_format(QStringList() << QStringLiteral("video-format"),
+                                              QStringLiteral("Save the frames as <png> (default) or <ppm>."),
+                                              QStringLiteral("format"), QStringLiteral("png"));
+    const QCommandLineOption opt_video_vsync(QStringList() << QStringLiteral("video-vsync"),
+                                             QStringLiteral("Take the vertical sync from the output of <pin> instead of long sync pulses."),
+                                             QStringLiteral("pin"));
+    const QCommandLineOption opt_video_frames(QStringList() << QStringLiteral("video-frames"),
+                                              QStringLiteral("Stop after <n> frames have been captured."),
+                                              QStringLiteral("n"));
+    const QCommandLineOption opt_profile(QStringList() << QStringLiteral("profile"),
+                                         QStringLiteral("Count instructions and cycles per PC and write them to <prefix>.csv and <prefix>.folded."),
+                                         QStringLiteral("prefix"));
+    const QCommandLineOption opt_stats(QStringList() << QStringLiteral("stats"),
+                                       QStringLiteral("Count the instruction mix and the cycles spent waiting, and report them."));
+    const QCommandLineOption opt_break(QStringList() << QStringLiteral("b") << QStringLiteral("break"),
+                                       QStringLiteral("Stop before a COG executes the instruction at <address> (may be repeated)."),
+                                       QStringLiteral("address"));
+    const QCommandLineOption opt_watch_read(QStringList() << QStringLiteral("watch-read"),
+                                            QStringLiteral("Stop after a COG reads <address>: a HUB byte address, or cog:<n> or lut:<n> for a long (may be repeated)."),
+                                            QStringLiteral("address"));
+    const QCommandLineOption opt_watch_write(QStringList() << QStringLiteral("watch-write"),
+                                             QStringLiteral("Stop after a COG writes <address>, as for --watch-read (may be repeated)."),
+                                             QStringLiteral("address"));
+    const QCommandLineOption opt_gdb(QStringList() << QStringLiteral("gdb"),
+                                     QStringLiteral("Wait for GDB on TCP <port> of the local host and let it debug the HUB, instead of running (0 picks a free port)."),
+                                     QStringLiteral("port"));
+    const QCommandLineOption opt_serial(QStringList() << QStringLiteral("serial"),
+                                        QStringLiteral("Bridge the serial pins to <target>: - for stdin/stdout, pty for a new pseudo terminal, or a file or FIFO for the output."),
+                                        QStringLiteral("target"));
+    const QCommandLineOption opt_serial_pins(QStringList() << QStringLiteral("serial-pins"),
+                                             QStringLiteral("Use <tx>,<rx> as the serial transmit and receive pins (default 62,63)."),
+                                             QStringLiteral("tx,rx"), QStringLiteral("62,63"));
+    const QCommandLineOption opt_serial_period(QStringList() << QStringLiteral("serial-period"),
+                                               QStringLiteral("Bit period in clocks of serial pins without a smart pin mode (default 694: 115200 baud at 80 MHz)."),
+                                               QStringLiteral("clocks"));
+    const QCommandLineOption opt_farm(QStringList() << QStringLiteral("farm"),
+                                      QStringLiteral("Run every file on an emulator of its own and write the results as JSON to <report> (- for stdout)."),
+                                      QStringLiteral("report"));
+    const QCommandLineOption opt_jobs(QStringList() << QStringLiteral("jobs"),
+                                      QStringLiteral("Run <n> files at a time with --farm (default: number of host CPUs)."),
+                                      QStringLiteral("n"));
+    const QCommandLineOption opt_quiet(QStringList() << QStringLiteral("q") << QStringLiteral("quiet"),
+                                       QStringLiteral("Print a single summary line instead of the report."));
+    parser.addOption(opt_cycles);
+    parser.addOption(opt_stop_pc);
+    parser.addOption(opt_timeout);
+    parser.addOption(opt_cogs);
+    parser.addOption(opt_trace);
+    parser.addOption(opt_dispatch);
+    parser.addOption(opt_jit);
+    parser.addOption(opt_parallel);
+    parser.addOption(opt_no_fast_forward);
+    parser.addOption(opt_hub_timing);
+    parser.addOption(opt_restore);
+    parser.addOption(opt_save);
+    parser.addOption(opt_reverse);
+    parser.addOption(opt_reverse_pc);
+    parser.addOption(opt_checkpoint);
+    parser.addOption(opt_rewind_limit);
+    parser.addOption(opt_bench_dispatch);
+    parser.addOption(opt_video);
+    parser.addOption(opt_video_cog);
+    parser.addOption(opt_video_format);
+    parser.addOption(opt_video_vsync);
+    parser.addOption(opt_video_frames);
+    parser.addOption(opt_profile);
+    parser.addOption(opt_stats);
+    parser.addOption(opt_break);
+    parser.addOption(opt_watch_read);
+    parser.addOption(opt_watch_write);
+    parser.addOption(opt_gdb);
+    parser.addOption(opt_serial);
+    parser.addOption(opt_serial_pins);
+    parser.addOption(opt_serial_period);
+    parser.addOption(opt_farm);
+    parser.addOption(opt_jobs);
+    parser.addOption(opt_quiet);
+    parser.process(app);
+
+    if (parser.isSet(opt_bench_dispatch)) {
+        p2_QUAD count = 0;
+        if (!parse_number(parser.value(opt_bench_dispatch), count) || count < 1 || count > (1u << 28)) {
+            err << QStringLiteral("%1: invalid opcode count: %2\n").arg(app.applicationName()).arg(parser.value(opt_bench_dispatch));
+            return 1;
+        }
+        bench_dispatch(out, static_cast<int>(count));
+        return 0;
+    }
+
+    const QStringList args = parser.positionalArguments();
+    const bool use_farm = parser.isSet(opt_farm);
+    if (use_farm ? args.isEmpty() : args.count() != 1) {
+        err << QStringLiteral("%1: expected %2 file name\n")
+               .arg(app.applicationName())
+               .arg(use_farm ? QStringLiteral("at least one") : QStringLiteral("exactly one"));
+        return 1;
+    }
+    const QString filename = args.first();
+
+    p2_QUAD max_cycles = default_cycles;
+    if (parser.isSet(opt_cycles) && !parse_number(parser.value(opt_cycles), max_cycles)) {
+        err << QStringLiteral("%1: invalid cycle count: %2\n").arg(app.applicationName()).arg(parser.value(opt_cycles));
+        return 1;
+    }
+
+    p2_QUAD stop_pc = 0;
+    const bool use_stop_pc = parser.isSet(opt_stop_pc);
+    if (use_stop_pc && !parse_number(parser.value(opt_stop_pc), stop_pc)) {
+        err << QStringLiteral("%1: invalid stop address: %2\n").arg(app.applicationName()).arg(parser.value(opt_stop_pc));
+        return 1;
+    }
+
+    p2_QUAD timeout = 0;
+    if (parser.isSet(opt_timeout) && !parse_number(parser.value(opt_timeout), timeout)) {
+        err << QStringLiteral("%1: invalid timeout: %2\n").arg(app.applicationName()).arg(parser.value(opt_timeout));
+        return 1;
+    }
+
+    p2_QUAD ncogs = 8;
+    if (!parse_number(parser.value(opt_cogs), ncogs) || ncogs < 1 || ncogs > 16 || (ncogs & (ncogs - 1))) {
+        err << QStringLiteral("%1: invalid number of COGs: %2\n").arg(app.applicationName()).arg(parser.value(opt_cogs));
+        return 1;
+    }
+
+    const QString dispatch = parser.value(opt_dispatch);
+    if (dispatch != QStringLiteral("table") && dispatch != QStringLiteral("switch")) {
+        err << QStringLiteral("%1: invalid dispatch mode: %2\n").arg(app.applicationName()).arg(dispatch);
+        return 1;
+    }
+    P2Cog::set_dispatch_table(dispatch == QStringLiteral("table"));
+
+    const QString jit = parser.value(opt_jit);
+    if (jit == QStringLiteral("off")) {
+        P2Cog::set_jit_mode(p2_JIT_OFF);
+    } else if (jit == QStringLiteral("on")) {
+        P2Cog::set_jit_mode(p2_JIT_ON);
+    } else if (jit == QStringLiteral("verify")) {
+        P2Cog::set_jit_mode(p2_JIT_VERIFY);
+    } else {
+        err << QStringLiteral("%1: invalid translator mode: %2\n").arg(app.applicationName()).arg(jit);
+        return 1;
+    }
+    if (jit != QStringLiteral("off") && !P2Jit::available())
+        err << QStringLiteral("%1: the translator is not available on this host\n").arg(app.applicationName());
+
+    const QString hub_timing = parser.value(opt_hub_timing);
+    p2_HUB_timing_e timing = p2_HUB_APPROXIMATE;
+    if (hub_timing == QStringLiteral("functional")) {
+        timing = p2_HUB_FUNCTIONAL;
+    } else if (hub_timing == QStringLiteral("approximate")) {
+        timing = p2_HUB_APPROXIMATE;
+    } else if (hub_timing == QStringLiteral("latency")) {
+        timing = p2_HUB_LATENCY;
+    } else {
+        err << QStringLiteral("%1: invalid HUB timing: %2\n").arg(app.applicationName()).arg(hub_timing);
+        return 1;
+    }
+
+    if (use_farm) {
+        static const QStringList single = QStringList()
+                << QStringLiteral("parallel") << QStringLiteral("trace")
+                << QStringLiteral("restore-snapshot") << QStringLiteral("save-snapshot")
+                << QStringLiteral("reverse") << QStringLiteral("reverse-pc")
+                << QStringLiteral("video") << QStringLiteral("video-frames")
+                << QStringLiteral("profile") << QStringLiteral("stats")
+                << QStringLiteral("break") << QStringLiteral("watch-read") << QStringLiteral("watch-write")
+                << QStringLiteral("gdb") << QStringLiteral("serial");
+        for (const QString& name : single) {
+            if (parser.isSet(name)) {
+                err << QStringLiteral("%1: --%2 cannot be used with --farm\n").arg(app.applicationName()).arg(name);
+                return 1;
+            }
+        }
+        p2_QUAD jobs = static_cast<p2_QUAD>(qMax(1, QThread::idealThreadCount()));
+        if (parser.isSet(opt_jobs) && (!parse_number(parser.value(opt_jobs), jobs) || jobs < 1 || jobs > 1024)) {
+            err << QStringLiteral("%1: invalid number of jobs: %2\n").arg(app.applicationName()).arg(parser.value(opt_jobs));
+            return 1;
+        }
+
+        P2Farm farm;
+        farm.set_workers(static_cast<int>(jobs));
+        farm.set_cogs(static_cast<int>(ncogs));
+        farm.set_cycles(max_cycles);
+        if (use_stop_pc)
+            farm.set_stop_pc(static_cast<p2_LONG>(stop_pc));
+        farm.set_timeout(timeout);
+        farm.set_timing(timing);
+        farm.set_fast_forward(!parser.isSet(opt_no_fast_forward));
+        for (const QString& arg : args) {
+            if (QFileInfo(arg).isDir()) {
+                const QDir dir(arg);
+                for (const QString& name : dir.entryList(QStringList() << QStringLiteral("*.obj"), QDir::Files, QDir::Name))
+                    farm.add(dir.filePath(name));
+            } else {
+                farm.add(arg);
+            }
+        }
+        if (!farm.count()) {
+            err << QStringLiteral("%1: no object files found\n").arg(app.applicationName());
+            return 1;
+        }
+
+        QElapsedTimer timer;
+        timer.start();
+        farm.run();
+        const double seconds = static_cast<double>(timer.nsecsElapsed()) / 1e9;
+
+        const QString report = parser.value(opt_farm);
+        if (report == QStringLiteral("-")) {
+            out << QString::fromUtf8(farm.report());
+        } else {
+            QFile file(report);
+            if (!file.open(QIODevice::WriteOnly) || file.write(farm.report()) < 0) {
+                err << QStringLiteral("%1: could not write %2\n").arg(app.applicationName()).arg(report);
+                return 1;
+            }
+            out << QStringLiteral("%1 jobs, %2 failed, %3 stolen, %4 s\n")
+                   .arg(farm.count())
+                   .arg(farm.failed())
+                   .arg(farm.stolen())
+                   .arg(seconds, 0, 'f', 6);
+        }
+        return farm.failed() ? 1 : 0;
+    }
+
+    p2_QUAD reverse = 0;
+    if (parser.isSet(opt_reverse) && !parse_number(parser.value(opt_reverse), reverse)) {
+        err << QStringLiteral("%1: invalid cycle count: %2\n").arg(app.applicationName()).arg(parser.value(opt_reverse));
+        return 1;
+    }
+    p2_QUAD reverse_pc = 0;
+    if (parser.isSet(opt_reverse_pc) && !parse_number(parser.value(opt_reverse_pc), reverse_pc)) {
+        err << QStringLiteral("%1: invalid address: %2\n").arg(app.applicationName()).arg(parser.value(opt_reverse_pc));
+        return 1;
+    }
+    p2_QUAD checkpoint_interval = 0;
+    if (parser.isSet(opt_checkpoint) && (!parse_number(parser.value(opt_checkpoint), checkpoint_interval) || !checkpoint_interval)) {
+        err << QStringLiteral("%1: invalid checkpoint interval: %2\n").arg(app.applicationName()).arg(parser.value(opt_checkpoint));
+        return 1;
+    }
+    p2_QUAD rewind_limit = 0;
+    if (parser.isSet(opt_rewind_limit) && !parse_number(parser.value(opt_rewind_limit), rewind_limit)) {
+        err << QStringLiteral("%1: invalid memory limit: %2\n").arg(app.applicationName()).arg(parser.value(opt_rewind_limit));
+        return 1;
+    }
+    const bool use_rewind = parser.isSet(opt_reverse) || parser.isSet(opt_reverse_pc);
+
+    p2_QUAD video_cog = 0;
+    if (!parse_number(parser.value(opt_video_cog), video_cog) || video_cog >= ncogs) {
+        err << QStringLiteral("%1: invalid video COG: %2\n").arg(app.applicationName()).arg(parser.value(opt_video_cog));
+        return 1;
+    }
+    const QString video_format = parser.value(opt_video_format);
+    if (video_format != QStringLiteral("png") && video_format != QStringLiteral("ppm")) {
+        err << QStringLiteral("%1: invalid video format: %2\n").arg(app.applicationName()).arg(video_format);
+        return 1;
+    }
+    p2_QUAD video_vsync = 0;
+    if (parser.isSet(opt_video_vsync) && (!parse_number(parser.value(opt_video_vsync), video_vsync) || video_vsync > 63)) {
+        err << QStringLiteral("%1: invalid vsync pin: %2\n").arg(app.applicationName()).arg(parser.value(opt_video_vsync));
+        return 1;
+    }
+    p2_QUAD video_frames = 0;
+    if (parser.isSet(opt_video_frames) && !parse_number(parser.value(opt_video_frames), video_frames)) {
+        err << QStringLiteral("%1: invalid frame count: %2\n").arg(app.applicationName()).arg(parser.value(opt_video_frames));
+        return 1;
+    }
+    const bool use_video = parser.isSet(opt_video) || parser.isSet(opt_video_frames);
+
+    P2Hub hub(static_cast<int>(ncogs));
+    P2Breakpoints* breakpoints = hub.breakpoints();
+    for (const QString& value : parser.values(opt_break)) {
+        p2_QUAD pc = 0;
+        if (!parse_number(value, pc) || pc > A20MASK) {
+            err << QStringLiteral("%1: invalid breakpoint address: %2\n").arg(app.applicationName()).arg(value);
+            return 1;
+        }
+        breakpoints->set_breakpoint(static_cast<p2_LONG>(pc));
+    }
+    const QPair<p2_BREAK_e,QStringList> watches[] = {
+        qMakePair(p2_BREAK_READ, parser.values(opt_watch_read)),
+        qMakePair(p2_BREAK_WRITE, parser.values(opt_watch_write))
+    };
+    for (const QPair<p2_BREAK_e,QStringList>& watch : watches) {
+        for (const QString& value : watch.second) {
+            p2_BREAK_space_e space = p2_BREAK_HUB;
+            p2_LONG addr = 0;
+            if (!parse_watch(value, space, addr)) {
+                err << QStringLiteral("%1: invalid watchpoint address: %2\n").arg(app.applicationName()).arg(value);
+                return 1;
+            }
+            breakpoints->set(watch.first, space, addr);
+        }
+    }
+    hub.set_parallel(parser.isSet(opt_parallel));
+    hub.set_fast_forward(!parser.isSet(opt_no_fast_forward));
+    hub.set_timing(timing);
+
+    QFile trace_file;
+    QScopedPointer<P2TraceConsumer> consumer;
+    if (parser.isSet(opt_trace)) {
+        if (0 == P2_TRACE_LEVEL)
+            err << QStringLiteral("%1: tracing is disabled in this build (P2_TRACE_LEVEL=0)\n").arg(app.applicationName());
+        trace_file.setFileName(parser.value(opt_trace));
+        if (!trace_file.open(QIODevice::WriteOnly)) {
+            err << QStringLiteral("%1: could not create %2\n").arg(app.applicationName()).arg(trace_file.fileName());
+            return 1;
+        }
+        consumer.reset(new P2TraceConsumer(hub.trace(), &trace_file));
+        consumer->start();
+    }
+
+    QFileInfo info(filename);
+    if (!info.path().startsWith(QChar(':')))
+        hub.set_pathname(info.path());
+    qint64 restore_nsecs = -1;
+    if (parser.isSet(opt_restore)) {
+        P2Snapshot snap;
+        if (!snap.open(parser.value(opt_restore))) {
+            err << QStringLiteral("%1: could not map snapshot %2\n").arg(app.applicationName()).arg(parser.value(opt_restore));
+            return 1;
+        }
+        QElapsedTimer restore_timer;
+        restore_timer.start();
+        if (!hub.restore_snapshot(snap)) {
+            err << QStringLiteral("%1: snapshot %2 does not match this machine\n").arg(app.applicationName()).arg(parser.value(opt_restore));
+            return 1;
+        }
+        restore_nsecs = restore_timer.nsecsElapsed();
+    } else {
+        if (!hub.load_obj(filename)) {
+            err << QStringLiteral("%1: could not load %2\n").arg(app.applicationName()).arg(filename);
+            return 1;
+        }
+        // Start COG #0 at $00000 like the booter does after loading an image
+        hub.coginit(0, 0, 0);
+    }
+
+    P2Rewind rewind(&hub);
+    if (checkpoint_interval)
+        rewind.set_interval(checkpoint_interval);
+    if (parser.isSet(opt_rewind_limit))
+        rewind.set_limit(rewind_limit << 20);
+
+    P2Video video;
+    if (use_video) {
+        video.set_output(parser.value(opt_video), video_format == QStringLiteral("ppm") ? p2_VIDEO_PPM : p2_VIDEO_PNG);
+        if (parser.isSet(opt_video_vsync))
+            video.set_vsync_pin(static_cast<int>(video_vsync));
+        hub.cog(static_cast<int>(video_cog))->set_video(&video);
+    }
+
+    const bool use_profile = parser.isSet(opt_profile);
+    if (use_profile)
+        for (int id = 0; id < static_cast<int>(ncogs); id++)
+            hub.cog(id)->set_profiling(true);
+    const bool use_stats = parser.isSet(opt_stats);
+    if (use_stats)
+        for (int id = 0; id < static_cast<int>(ncogs); id++)
+            hub.cog(id)->set_stats(true);
+
+    hub.arm_breakpoints(true);
+
+    if (parser.isSet(opt_gdb)) {
+        p2_QUAD port = 0;
+        if (!parse_number(parser.value(opt_gdb), port) || port > 65535) {
+            err << QStringLiteral("%1: invalid port: %2\n").arg(app.applicationName()).arg(parser.value(opt_gdb));
+            return 1;
+        }
+        P2GdbServer gdb(&hub);
+        if (!gdb.listen(static_cast<quint16>(port))) {
+            err << QStringLiteral("%1: could not listen on port %2: %3\n").arg(app.applicationName()).arg(port).arg(gdb.errorString());
+            return 1;
+        }
+        err << QStringLiteral("%1: waiting for GDB on port %2\n").arg(app.applicationName()).arg(gdb.port());
+        err.flush();
+        return gdb.serve() ? 0 : 1;
+    }
+
+    P2Serial serial;
+    const bool use_serial = parser.isSet(opt_serial);
+    if (use_serial) {
+        const QStringList pins = parser.value(opt_serial_pins).split(QChar(','));
+        p2_QUAD tx_pin = 0;
+        p2_QUAD rx_pin = 0;
+        if (pins.count() != 2 || !parse_number(pins[0], tx_pin) || !parse_number(pins[1], rx_pin) ||
+                tx_pin > 63 || rx_pin > 63) {
+            err << QStringLiteral("%1: invalid serial pins: %2\n").arg(app.applicationName()).arg(parser.value(opt_serial_pins));
+            return 1;
+        }
+        serial.set_pins(static_cast<int>(tx_pin), static_cast<int>(rx_pin));
+        if (parser.isSet(opt_serial_period)) {
+            p2_QUAD period = 0;
+            if (!parse_number(parser.value(opt_serial_period), period) || period < 1 || period > 0xffffffffu) {
+                err << QStringLiteral("%1: invalid serial bit period: %2\n").arg(app.applicationName()).arg(parser.value(opt_serial_period));
+                return 1;
+            }
+            serial.set_period(static_cast<p2_LONG>(period));
+        }
+        if (!serial.open(parser.value(opt_serial))) {
+            err << QStringLiteral("%1: could not open serial target %2\n").arg(app.applicationName()).arg(parser.value(opt_serial));
+            return 1;
+        }
+        if (!serial.pty_name().isEmpty()) {
+            err << QStringLiteral("%1: serial pins on %2\n").arg(app.applicationName()).arg(serial.pty_name());
+            err.flush();
+        }
+        hub.set_serial(&serial);
+    }
+
+    P2Cog* cog0 = hub.cog(0);
+    const int ticks = use_stop_pc ? 1 : slice_ticks;
+    QString reason = QStringLiteral("cycle limit");
+
+    QElapsedTimer timer;
+    timer.start();
+    while (hub.count() < max_cycles) {
+        if (use_stop_pc && cog0->rd_PC() == stop_pc) {
+            reason = QStringLiteral("stop address reached");
+            break;
+        }
+        if (timeout && static_cast<p2_QUAD>(timer.elapsed()) >= timeout) {
+            reason = QStringLiteral("timeout");
+            break;
+        }
+        if (video_frames && static_cast<p2_QUAD>(video.frames()) >= video_frames) {
+            reason = QStringLiteral("video frames");
+            break;
+        }
+        const p2_QUAD left = max_cycles - hub.count();
+        const int run = static_cast<int>(qMin<p2_QUAD>(left, static_cast<p2_QUAD>(ticks)));
+        if (use_rewind)
+            rewind.record();
+        hub.execute(run * static_cast<int>(ncogs) * 2);
+        if (use_serial)
+            serial.poll(hub.count());
+        if (p2_BREAK_NONE != breakpoints->hit().kind) {
+            reason = describe_hit(breakpoints->hit());
+            break;
+        }
+    }
+    const qint64 nsecs = timer.nsecsElapsed();
+
+    if (use_serial) {
+        // the output up to the last cycle, and nothing replayed by --reverse
+        hub.set_serial(nullptr);
+        serial.poll(hub.count());
+        serial.close();
+    }
+
+    if (consumer)
+        consumer->stop();
+
+    if (parser.isSet(opt_save) && !hub.save_snapshot(parser.value(opt_save))) {
+        err << QStringLiteral("%1: could not save snapshot %2\n").arg(app.applicationName()).arg(parser.value(opt_save));
+        return 1;
+    }
+
+    const QString profile_csv = parser.value(opt_profile) + QStringLiteral(".csv");
+    const QString profile_folded = parser.value(opt_profile) + QStringLiteral(".folded");
+    if (use_profile && !P2Profile::write_csv(profile_csv, &hub)) {
+        err << QStringLiteral("%1: could not write %2\n").arg(app.applicationName()).arg(profile_csv);
+        return 1;
+    }
+    if (use_profile && !P2Profile::write_collapsed(profile_folded, &hub)) {
+        err << QStringLiteral("%1: could not write %2\n").arg(app.applicationName()).arg(profile_folded);
+        return 1;
+    }
+
+    const p2_QUAD cycles = hub.count();
+    const p2_QUAD instructions = hub.retired();
+    const p2_STATS_t stats = hub.stats();
+    qint64 reverse_nsecs = -1;
+    bool reversed = true;
+    if (use_rewind) {
+        QElapsedTimer reverse_timer;
+        reverse_timer.start();
+        if (parser.isSet(opt_reverse_pc))
+            reversed = rewind.continue_back(0, static_cast<p2_LONG>(reverse_pc));
+        else
+            reversed = rewind.step_back(reverse);
+        reverse_nsecs = reverse_timer.nsecsElapsed();
+    }
+
+    const double seconds = static_cast<double>(nsecs) / 1e9;
+    const double mhz = seconds > 0.0 ? static_cast<double>(cycles) / seconds / 1e6 : 0.0;
+    const double mips = seconds > 0.0 ? static_cast<double>(instructions) / seconds / 1e6 : 0.0;
+    p2_QUAD jit_blocks = 0;
+    p2_QUAD jit_mismatches = 0;
+    for (int id = 0; id < static_cast<int>(ncogs); id++) {
+        jit_blocks += hub.cog(id)->rd_JIT_blocks();
+        jit_mismatches += hub.cog(id)->rd_JIT_mismatches();
+    }
+
+    if (parser.isSet(opt_quiet)) {
+        out << QStringLiteral("%1 %2 %3 %4 %5\n")
+               .arg(info.fileName())
+               .arg(seconds, 0, 'f', 6)
+               .arg(cycles)
+               .arg(instructions)
+               .arg(mhz, 0, 'f', 3);
+    } else {
+        out << QStringLiteral("file:          %1\n").arg(info.fileName());
+        out << QStringLiteral("stopped by:    %1\n").arg(reason);
+        out << QStringLiteral("COGs:          %1\n").arg(ncogs);
+        out << QStringLiteral("dispatch:      %1, %2\n")
+               .arg(dispatch)
+               .arg(P2_THREADED_DISPATCH ? QStringLiteral("threaded") : QStringLiteral("call"));
+        out << QStringLiteral("execution:     %1\n")
+               .arg(hub.parallel() ? QStringLiteral("parallel") : QStringLiteral("serial"));
+        out << QStringLiteral("HUB timing:    %1\n").arg(hub_timing);
+        out << QStringLiteral("host time:     %1 s\n").arg(seconds, 0, 'f', 6);
+        out << QStringLiteral("cycles:        %1\n").arg(cycles);
+        out << QStringLiteral("instructions:  %1\n").arg(instructions);
+        out << QStringLiteral("idle skipped:  %1\n").arg(hub.fast_forwarded());
+        out << QStringLiteral("emulated MHz:  %1\n").arg(mhz, 0, 'f', 3);
+        out << QStringLiteral("host MIPS:     %1\n").arg(mips, 0, 'f', 3);
+        if (P2Cog::jit_mode() != p2_JIT_OFF) {
+            out << QStringLiteral("JIT blocks:    %1\n").arg(jit_blocks);
+            if (P2Cog::jit_mode() == p2_JIT_VERIFY)
+                out << QStringLiteral("JIT mismatch:  %1\n").arg(jit_mismatches);
+        }
+        if (reverse_nsecs >= 0) {
+            out << QStringLiteral("checkpoints:   %1 (%2 KiB, from cycle %3)\n")
+                   .arg(rewind.checkpoints())
+                   .arg(rewind.used() / 1024)
+                   .arg(rewind.earliest());
+            if (reversed)
+                out << QStringLiteral("reversed to:   cycle %1, COG #0 PC $%2 (%3 s)\n")
+                       .arg(hub.count())
+                       .arg(cog0->rd_PC(), 5, 16, QChar('0'))
+                       .arg(static_cast<double>(reverse_nsecs) / 1e9, 0, 'f', 6);
+            else
+                out << QStringLiteral("reversed to:   not found\n");
+        }
+        if (use_video)
+            out << QStringLiteral("video frames:  %1 (%2 x %3, %4 saved)\n")
+                   .arg(video.frames())
+                   .arg(video.width())
+                   .arg(video.height())
+                   .arg(video.saved());
+        if (use_profile)
+            out << QStringLiteral("profile:       %1, %2\n").arg(profile_csv).arg(profile_folded);
+        if (use_serial)
+            out << QStringLiteral("serial:        %1 bytes sent, %2 received, %3 framing errors\n")
+                   .arg(serial.sent())
+                   .arg(serial.received())
+                   .arg(serial.errors());
+        if (use_stats)
+            print_stats(out, stats, cycles * ncogs);
+        if (restore_nsecs >= 0)
+            out << QStringLiteral("restore time:  %1 us\n").arg(static_cast<double>(restore_nsecs) / 1e3, 0, 'f', 1);
+        if (consumer)
+            out << QStringLiteral("trace dropped: %1\n").arg(hub.trace()->dropped());
+    }
+
+    return 0;
+}
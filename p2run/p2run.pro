@@ -0,0 +1,87 @@
+#-------------------------------------------------
+#
+# Headless Propeller2 emulator runner
+#
+#-------------------------------------------------
+
+QT += core gui network
+QT -= widgets
+TARGET = p2run
+TEMPLATE = app
+CONFIG += console
+CONFIG -= app_bundle
+VER_MAJ = 0
+VER_MIN = 4
+VER_PAT = 0
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+QMAKE_CXXFLAGS += -DVER_MAJ=$$VER_MAJ -DVER_MIN=$$VER_MIN -DVER_PAT=$$VER_PAT
+
+DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
+
+# Emulator trace level (see p2trace.h): 0 = off, 1 = HUB events,
+# 2 = COG instruction fetch/execute, 3 = HUB memory writes
+DEFINES += P2_TRACE_LEVEL=0
+
+# Dispatch the COG instructions through a table of labels (see p2cog.h);
+# needs GCC or Clang
+# DEFINES += P2_THREADED_DISPATCH=1
+
+SOURCES += \
+	main.cpp \
+	../csv.cpp \
+	../p2break.cpp \
+	../p2cog.cpp \
+	../p2cogthread.cpp \
+	../p2cordic.cpp \
+	../p2defs.cpp \
+	../p2farm.cpp \
+	../p2gdb.cpp \
+	../p2hub.cpp \
+	../p2jit.cpp \
+	../p2memmap.cpp \
+	../p2pins.cpp \
+	../p2pixel.cpp \
+	../p2profile.cpp \
+	../p2rewind.cpp \
+	../p2serial.cpp \
+	../p2snapshot.cpp \
+	../p2trace.cpp \
+	../p2video.cpp \
+	../util/p2util.cpp
+
+HEADERS += \
+	../csv.h \
+	../p2break.h \
+	../p2cog.h \
+	../p2cogops.h \
+	../p2cogthread.h \
+	../p2cordic.h \
+	../p2defs.h \
+	../p2farm.h \
+	../p2gdb.h \
+	../p2hub.h \
+	../p2jit.h \
+	../p2memmap.h \
+	../p2pins.h \
+	../p2pixel.h \
+	../p2profile.h \
+	../p2rewind.h \
+	../p2serial.h \
+	../p2snapshot.h \
+	../p2tokens.h \
+	../p2trace.h \
+	../p2video.h \
+	../util/p2util.h
+
+INCLUDEPATH += $$PWD/..
+INCLUDEPATH += $$PWD/../util
+
+# Default rules for deployment.
+qnx: target.path = /tmp/$${TARGET}/bin
+else: unix:!android: target.path = /opt/$${TARGET}/bin
+!isEmpty(target.path): INSTALLS += target
+
+RESOURCES += \
+	../p2emu.qrc
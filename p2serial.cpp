@@ -0,0 +1,372 @@
+/****************************************************************************
+ *
+ * P2 emulator serial bridge to the host
+ *
+ * Copyright (C) 2019 Jürgen Buchmüller <pullmoll@t-online.de>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ ****************************************************************************/
+#include <QtGlobal>
+#include <fcntl.h>
+#if defined(Q_OS_WIN)
+#include <io.h>
+#else
+#include <poll.h>
+#include <stdlib.h>
+#include <termios.h>
+#include <unistd.h>
+#endif
+#include "p2serial.h"
+
+//! Default bit period: 115200 baud at 80 MHz, as in the examples
+static constexpr p2_LONG default_period = 80000000 / 115200;
+
+//! Number of bytes read from the host at once
+static constexpr int read_size = 4096;
+
+P2Serial::P2Serial()
+    : m_in(-1)
+    , m_out(-1)
+    , m_own(false)
+    , m_pty_name()
+    , m_tx_pin(62)
+    , m_rx_pin(63)
+    , m_period(default_period)
+    , m_tx()
+    , m_rx()
+    , m_rx_pos(0)
+    , m_sent(0)
+    , m_received(0)
+    , m_errors(0)
+    , m_level(true)
+    , m_bit(-1)
+    , m_sample(0)
+    , m_shift(0)
+    , m_rx_start(0)
+    , m_rx_byte(0)
+    , m_rx_busy(false)
+{
+}
+
+P2Serial::~P2Serial()
+{
+    close();
+}
+
+/**
+ * @brief Connect the bridge to the host
+ * @param name "-" for standard input and output, "pty" for a new pseudo
+ * terminal, or the path of a file or FIFO to write the output to
+ * @return true on success, or false on error
+ */
+bool P2Serial::open(const QString& name)
+{
+    close();
+    if (name == QStringLiteral("-")) {
+        m_in = 0;
+        m_out = 1;
+        return true;
+    }
+
+    if (name == QStringLiteral("pty")) {
+#if defined(Q_OS_WIN)
+        return false;
+#else
+        const int fd = posix_openpt(O_RDWR | O_NOCTTY);
+        if (fd < 0)
+            return false;
+        if (grantpt(fd) < 0 || unlockpt(fd) < 0 || !ptsname(fd)) {
+            ::close(fd);
+            return false;
+        }
+        m_pty_name = QString::fromLocal8Bit(ptsname(fd));
+        // don't wait for a terminal program: what nobody reads is dropped
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+        // pass the bytes through unchanged
+        struct termios tio;
+        if (0 == tcgetattr(fd, &tio)) {
+            cfmakeraw(&tio);
+            tcsetattr(fd, TCSANOW, &tio);
+        }
+        m_in = fd;
+        m_out = fd;
+        m_own = true;
+        return true;
+#endif
+    }
+
+    const int fd = ::open(name.toLocal8Bit().constData(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+        return false;
+    m_out = fd;
+    m_own = true;
+    return true;
+}
+
+/**
+ * @brief Write the pending output and disconnect the bridge from the host
+ */
+void P2Serial::close()
+{
+    flush();
+    if (m_own) {
+        if (m_out >= 0)
+            ::close(m_out);
+        if (m_in >= 0 && m_in != m_out)
+            ::close(m_in);
+    }
+    m_in = -1;
+    m_out = -1;
+    m_own = false;
+    m_pty_name.clear();
+}
+
+/**
+ * @brief Return the name of the pseudo terminal to connect a terminal program to
+ * @return device name, or an empty string if not connected to a pseudo terminal
+ */
+QString P2Serial::pty_name() const
+{
+    return m_pty_name;
+}
+
+/**
+ * @brief Return the transmit pin
+ * @return pin number
+ */
+int P2Serial::tx_pin() const
+{
+    return m_tx_pin;
+}
+
+/**
+ * @brief Return the receive pin
+ * @return pin number
+ */
+int P2Serial::rx_pin() const
+{
+    return m_rx_pin;
+}
+
+/**
+ * @brief Set the transmit and receive pins
+ *
+ * The pins must be set before the bridge is attached to a P2Hub.
+ *
+ * @param tx transmit pin number (P2 to host)
+ * @param rx receive pin number (host to P2)
+ */
+void P2Serial::set_pins(int tx, int rx)
+{
+    m_tx_pin = tx & 63;
+    m_rx_pin = rx & 63;
+}
+
+/**
+ * @brief Return the bit period of pins without a smart pin mode
+ * @return clocks per bit
+ */
+p2_LONG P2Serial::period() const
+{
+    return m_period;
+}
+
+/**
+ * @brief Set the bit period of pins without a smart pin mode
+ * @param clocks clocks per bit (at least 1)
+ */
+void P2Serial::set_period(p2_LONG clocks)
+{
+    m_period = qMax<p2_LONG>(clocks, 1);
+}
+
+/**
+ * @brief Return the number of bytes sent by the transmit pin
+ * @return number of bytes
+ */
+p2_QUAD P2Serial::sent() const
+{
+    return m_sent;
+}
+
+/**
+ * @brief Return the number of bytes received by the receive pin
+ * @return number of bytes
+ */
+p2_QUAD P2Serial::received() const
+{
+    return m_received;
+}
+
+/**
+ * @brief Return the number of frames on the transmit pin without stop bit
+ * @return number of framing errors
+ */
+p2_QUAD P2Serial::errors() const
+{
+    return m_errors;
+}
+
+/**
+ * @brief Take the next byte from the host
+ * @param byte reference to the byte to set
+ * @return true if there was one, or false otherwise
+ */
+bool P2Serial::get(p2_BYTE& byte)
+{
+    if (m_rx_pos >= m_rx.size())
+        return false;
+    byte = static_cast<p2_BYTE>(m_rx.at(m_rx_pos++));
+    m_received++;
+    return true;
+}
+
+/**
+ * @brief Take a level change of the transmit pin
+ * @param cnt CNT of the change
+ * @param level new level
+ */
+void P2Serial::line(p2_QUAD cnt, bool level)
+{
+    if (level == m_level)
+        return;
+    // the samples before the change see the previous level
+    decode(cnt);
+    if (0 == m_bit && level && cnt < m_sample - m_period) {
+        // a glitch, e.g. DIR set before OUT: no start bit until its middle
+        m_bit = -1;
+    } else if (m_bit < 0 && !level) {
+        // start bit: sample the data bits in the middle of their periods
+        m_bit = 0;
+        m_shift = 0;
+        m_sample = cnt + m_period + m_period / 2;
+    }
+    m_level = level;
+}
+
+/**
+ * @brief Return the level of the receive pin
+ *
+ * The pin idles high. When it is looked at while a byte from the host is
+ * waiting, the frame of that byte starts: a start bit, eight data bits,
+ * and a stop bit, each one bit period long.
+ *
+ * @param cnt current CNT
+ * @return level of the pin
+ */
+bool P2Serial::rx_line(p2_QUAD cnt)
+{
+    if (!m_rx_busy) {
+        if (!get(m_rx_byte))
+            return true;
+        m_rx_start = cnt;
+        m_rx_busy = true;
+    }
+    const p2_QUAD bit = (cnt - m_rx_start) / m_period;
+    if (0 == bit)
+        return false;
+    if (bit <= 8)
+        return (m_rx_byte >> (bit - 1)) & 1;
+    if (bit >= 10)
+        m_rx_busy = false;
+    return true;
+}
+
+/**
+ * @brief Decode the samples of the transmit pin up to CNT %cnt
+ * @param cnt CNT up to which the level is known
+ */
+void P2Serial::decode(p2_QUAD cnt)
+{
+    while (m_bit >= 0 && m_sample < cnt) {
+        if (m_bit < 8) {
+            m_shift |= static_cast<p2_LONG>(m_level) << m_bit;
+            m_bit++;
+            m_sample += m_period;
+            continue;
+        }
+        if (m_level)
+            put(static_cast<p2_BYTE>(m_shift));
+        else
+            m_errors++;
+        m_bit = -1;
+    }
+}
+
+/**
+ * @brief Exchange the buffered bytes with the host
+ *
+ * Decodes the transmit pin up to %cnt, writes the output, and reads the
+ * input which is available without waiting.
+ *
+ * @param cnt current CNT
+ */
+void P2Serial::poll(p2_QUAD cnt)
+{
+    decode(cnt);
+    flush();
+    if (m_in < 0)
+        return;
+#if !defined(Q_OS_WIN)
+    if (m_rx_pos >= m_rx.size()) {
+        m_rx.clear();
+        m_rx_pos = 0;
+    }
+    struct pollfd pfd;
+    pfd.fd = m_in;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    if (::poll(&pfd, 1, 0) <= 0 || !(pfd.revents & (POLLIN | POLLHUP)))
+        return;
+    char buff[read_size];
+    const ssize_t done = ::read(m_in, buff, sizeof(buff));
+    if (done > 0) {
+        m_rx.append(buff, static_cast<int>(done));
+    } else if (0 == done && m_in != m_out) {
+        // end of the input
+        m_in = -1;
+    }
+#endif
+}
+
+/**
+ * @brief Write the bytes sent by the transmit pin to the host
+ */
+void P2Serial::flush()
+{
+    if (m_tx.isEmpty())
+        return;
+    int pos = 0;
+    while (m_out >= 0 && pos < m_tx.size()) {
+        const int done = static_cast<int>(::write(m_out, m_tx.constData() + pos, static_cast<size_t>(m_tx.size() - pos)));
+        if (done <= 0)
+            break;
+        pos += done;
+    }
+    m_tx.clear();
+}
@@ -0,0 +1,120 @@
+/****************************************************************************
+ *
+ * P2 emulator serial bridge to the host
+ *
+ * Copyright (C) 2019 Jürgen Buchmüller <pullmoll@t-online.de>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ ****************************************************************************/
+#pragma once
+#include <QByteArray>
+#include <QString>
+#include "p2defs.h"
+
+/**
+ * @file Serial bridge between two pins and the host.
+ *
+ * P2Serial connects a transmit and a receive pin (P62 and P63 by default)
+ * to the host's standard input and output, a pseudo terminal, or an
+ * output file or FIFO.
+ *
+ * A transmit pin in async serial transmit mode hands each word to the
+ * bridge when it moves to the shifter, and a receive pin in async serial
+ * receive mode gets each byte from the host as a whole, as soon as the
+ * previous one was acknowledged and a frame time has passed. The smart
+ * pins then do not shift single bits, so they do not make the HUB step
+ * the pins every clock.
+ *
+ * Programs which toggle the pins themselves are served, too: P2Hub
+ * reports the level changes of the transmit pin, which are decoded
+ * with the bit period set by set_period(), and the receive pin reads
+ * the frames of the bytes from the host, each starting when the pin is
+ * looked at while a byte is waiting.
+ *
+ * The emulator side only appends to and takes from buffers; poll() does
+ * the host I/O and is called by the host between slices of execution.
+ * A pseudo terminal never blocks the emulator: output written while no
+ * terminal program reads it is dropped.
+ */
+
+class P2Serial
+{
+public:
+    P2Serial();
+    ~P2Serial();
+
+    bool open(const QString& name);
+    void close();
+    QString pty_name() const;
+
+    int tx_pin() const;
+    int rx_pin() const;
+    void set_pins(int tx, int rx);
+    p2_LONG period() const;
+    void set_period(p2_LONG clocks);
+
+    p2_QUAD sent() const;
+    p2_QUAD received() const;
+    p2_QUAD errors() const;
+
+    //! take a byte sent by the transmit pin
+    void put(p2_BYTE byte) {
+        m_tx += static_cast<char>(byte);
+        m_sent++;
+    }
+    bool get(p2_BYTE& byte);
+    void line(p2_QUAD cnt, bool level);
+    bool rx_line(p2_QUAD cnt);
+
+    void poll(p2_QUAD cnt);
+    void flush();
+
+private:
+    int m_in;                   //!< file descriptor of the host input, or -1
+    int m_out;                  //!< file descriptor of the host output, or -1
+    bool m_own;                 //!< true if the descriptors were opened by open()
+    QString m_pty_name;         //!< name of the pseudo terminal's slave side
+    int m_tx_pin;               //!< transmit pin (P2 to host)
+    int m_rx_pin;               //!< receive pin (host to P2)
+    p2_LONG m_period;           //!< bit period in clocks of pins without a smart pin mode
+    QByteArray m_tx;            //!< bytes to write to the host
+    QByteArray m_rx;            //!< bytes read from the host
+    int m_rx_pos;               //!< next byte in m_rx
+    p2_QUAD m_sent;             //!< bytes sent to the host
+    p2_QUAD m_received;         //!< bytes received from the host
+    p2_QUAD m_errors;           //!< frames without stop bit on the transmit pin
+    bool m_level;               //!< level of the transmit pin
+    int m_bit;                  //!< next bit of the transmit pin's frame, or -1 while idle
+    p2_QUAD m_sample;           //!< CNT of the next sample of the transmit pin
+    p2_LONG m_shift;            //!< bits received on the transmit pin
+    p2_QUAD m_rx_start;         //!< CNT of the receive pin's frame start bit
+    p2_BYTE m_rx_byte;          //!< byte in the receive pin's frame
+    bool m_rx_busy;             //!< true while the receive pin sends a frame
+
+    void decode(p2_QUAD cnt);
+};
@@ -0,0 +1,168 @@
+/****************************************************************************
+ *
+ * P2 emulator machine snapshots
+ *
+ * Copyright (C) 2019 Jürgen Buchmüller <pullmoll@t-online.de>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ ****************************************************************************/
+#include "p2snapshot.h"
+
+/**
+ * @brief Round %size up to the next multiple of P2_SNAPSHOT_ALIGN
+ */
+static p2_LONG align(p2_LONG size)
+{
+    return (size + P2_SNAPSHOT_ALIGN - 1) & ~(P2_SNAPSHOT_ALIGN - 1);
+}
+
+P2Snapshot::P2Snapshot()
+    : m_file()
+    , m_data(nullptr)
+{
+}
+
+P2Snapshot::~P2Snapshot()
+{
+    close();
+}
+
+/**
+ * @brief Return the header for a snapshot with the given section sizes
+ * @param ncogs number of COGs
+ * @param hub_size size of the HUB state
+ * @param cog_size size of a COG's state
+ * @return header with all offsets filled in
+ */
+p2_SNAPSHOT_HEADER_t P2Snapshot::layout(int ncogs, p2_LONG hub_size, p2_LONG cog_size)
+{
+    p2_SNAPSHOT_HEADER_t hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, P2_SNAPSHOT_MAGIC, sizeof(hdr.magic));
+    hdr.version = P2_SNAPSHOT_VERSION;
+    hdr.ncogs = static_cast<p2_LONG>(ncogs);
+    hdr.mem_offset = align(sizeof(hdr));
+    hdr.mem_size = MEM_SIZE;
+    hdr.hub_offset = hdr.mem_offset + align(hdr.mem_size);
+    hdr.hub_size = hub_size;
+    hdr.cog_offset = hdr.hub_offset + align(hdr.hub_size);
+    hdr.cog_size = cog_size;
+    hdr.cog_stride = align(cog_size);
+    hdr.file_size = hdr.cog_offset + hdr.ncogs * hdr.cog_stride;
+    return hdr;
+}
+
+/**
+ * @brief Map the snapshot file %filename copy-on-write
+ * @param filename name of the file
+ * @return true on success, or false if it can not be mapped or is not a snapshot
+ */
+bool P2Snapshot::open(const QString& filename)
+{
+    close();
+    m_file.setFileName(filename);
+    if (!m_file.open(QIODevice::ReadOnly))
+        return false;
+    p2_SNAPSHOT_HEADER_t hdr;
+    if (m_file.size() < static_cast<qint64>(sizeof(hdr)) ||
+        m_file.read(reinterpret_cast<char*>(&hdr), sizeof(hdr)) != static_cast<qint64>(sizeof(hdr)) ||
+        hdr.ncogs < 1 || hdr.ncogs > 16 ||
+        hdr.hub_size > MEM_SIZE || hdr.cog_size > MEM_SIZE) {
+        m_file.close();
+        return false;
+    }
+    // every offset and size must be the one layout() gives for the section sizes
+    const p2_SNAPSHOT_HEADER_t expect = layout(static_cast<int>(hdr.ncogs), hdr.hub_size, hdr.cog_size);
+    if (memcmp(&hdr, &expect, sizeof(hdr)) ||
+        m_file.size() < static_cast<qint64>(hdr.file_size)) {
+        m_file.close();
+        return false;
+    }
+    m_data = m_file.map(0, hdr.file_size, QFile::MapPrivateOption);
+    if (!m_data) {
+        m_file.close();
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Unmap and close the snapshot file
+ */
+void P2Snapshot::close()
+{
+    if (m_data)
+        m_file.unmap(m_data);
+    m_data = nullptr;
+    if (m_file.isOpen())
+        m_file.close();
+}
+
+/**
+ * @brief Return true, if a snapshot file is mapped
+ */
+bool P2Snapshot::isOpen() const
+{
+    return nullptr != m_data;
+}
+
+/**
+ * @brief Return the snapshot's header
+ * @return pointer to the header, or nullptr if no file is mapped
+ */
+const p2_SNAPSHOT_HEADER_t* P2Snapshot::header() const
+{
+    return reinterpret_cast<const p2_SNAPSHOT_HEADER_t*>(m_data);
+}
+
+/**
+ * @brief Return the snapshot's HUB memory
+ */
+const p2_BYTE* P2Snapshot::mem() const
+{
+    return m_data ? m_data + header()->mem_offset : nullptr;
+}
+
+/**
+ * @brief Return the snapshot's HUB state
+ */
+const p2_BYTE* P2Snapshot::hub() const
+{
+    return m_data ? m_data + header()->hub_offset : nullptr;
+}
+
+/**
+ * @brief Return the snapshot's state of COG %id
+ * @param id COG number (0 … ncogs - 1)
+ */
+const p2_BYTE* P2Snapshot::cog(int id) const
+{
+    if (!m_data || id < 0 || static_cast<p2_LONG>(id) >= header()->ncogs)
+        return nullptr;
+    return m_data + header()->cog_offset + static_cast<p2_LONG>(id) * header()->cog_stride;
+}
@@ -0,0 +1,114 @@
+/****************************************************************************
+ *
+ * P2 emulator machine snapshots
+ *
+ * Copyright (C) 2019 Jürgen Buchmüller <pullmoll@t-online.de>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ ****************************************************************************/
+#pragma once
+#include <QFile>
+#include <QString>
+#include "p2defs.h"
+
+/**
+ * @file Whole machine snapshots.
+ *
+ * A snapshot file consists of page aligned sections:
+ *
+ *  - the header (p2_SNAPSHOT_HEADER_t), padded to a page
+ *  - the HUB memory (MEM_SIZE bytes)
+ *  - the HUB state (CNT, PRNG, pins, locks, …), padded to a page
+ *  - the state of each COG (registers, COG and LUT memory, FIFO, flags, …),
+ *    each padded to a page
+ *
+ * The state sections are the members named in P2_HUB_STATE and
+ * P2_COG_STATE, stored back to back in host byte order. The header
+ * records the format version and the size of every section, and a
+ * snapshot is only restored if they all match.
+ *
+ * P2Snapshot maps a file copy-on-write, so keeping one open and
+ * restoring it repeatedly costs no more than copying the sections.
+ */
+
+//! Magic bytes at the start of a snapshot file
+static constexpr char P2_SNAPSHOT_MAGIC[8] = {'P','2','S','N','A','P','\r','\n'};
+
+//! Current snapshot format version
+static constexpr p2_LONG P2_SNAPSHOT_VERSION = 1;
+
+//! Alignment of the snapshot sections
+static constexpr p2_LONG P2_SNAPSHOT_ALIGN = 4096;
+
+//! Append the member %m to the state buffer at %dst
+#define P2_STATE_SAVE(m) memcpy(dst, &(m), sizeof(m)); dst += sizeof(m);
+
+//! Fetch the member %m from the state buffer at %src
+#define P2_STATE_LOAD(m) memcpy(&(m), src, sizeof(m)); src += sizeof(m);
+
+//! Add the size of the member %m
+#define P2_STATE_SIZE(m) + sizeof(m)
+
+/**
+ * @brief Header of a snapshot file
+ */
+typedef struct {
+    char magic[8];              //!< P2_SNAPSHOT_MAGIC
+    p2_LONG version;            //!< P2_SNAPSHOT_VERSION
+    p2_LONG ncogs;              //!< number of COGs
+    p2_LONG mem_offset;         //!< file offset of the HUB memory
+    p2_LONG mem_size;           //!< size of the HUB memory
+    p2_LONG hub_offset;         //!< file offset of the HUB state
+    p2_LONG hub_size;           //!< size of the HUB state
+    p2_LONG cog_offset;         //!< file offset of COG #0's state
+    p2_LONG cog_size;           //!< size of a COG's state
+    p2_LONG cog_stride;         //!< distance between two COG states
+    p2_LONG file_size;          //!< total size of the file
+}   p2_SNAPSHOT_HEADER_t;
+
+class P2Snapshot
+{
+public:
+    P2Snapshot();
+    ~P2Snapshot();
+
+    static p2_SNAPSHOT_HEADER_t layout(int ncogs, p2_LONG hub_size, p2_LONG cog_size);
+
+    bool open(const QString& filename);
+    void close();
+    bool isOpen() const;
+
+    const p2_SNAPSHOT_HEADER_t* header() const;
+    const p2_BYTE* mem() const;
+    const p2_BYTE* hub() const;
+    const p2_BYTE* cog(int id) const;
+
+private:
+    QFile m_file;               //!< snapshot file
+    p2_BYTE* m_data;            //!< copy-on-write mapping of the file
+};
@@ -126,9 +126,6 @@ static const QString re_hex_const = QLatin1String("^\\$[_]*[0-9a-fA-F_]+");
  */
 static const QString re_str_const = QLatin1String("^\"([^\\\"]|\\\\.)*\"");
 
-//! Global static instance of the P2Token class
-P2Token Token;
-
 
 /**
  * @file Chip Gracey's comment from https://forums.parallax.com/discussion/170176/spin2-syntax
@@ -108,5 +108,3 @@ private:
     bool tt_chk(p2_TOKEN_e tok, p2_TOKMASK_t typemask) const;
     void tn_add(p2_TOKEN_e tok, const QString& enum_name, p2_TOKMASK_t typemask, const QString& string);
 };
-
-extern P2Token Token;
@@ -0,0 +1,152 @@
+/****************************************************************************
+ *
+ * P2 emulator trace ring buffer implementation
+ *
+ * Copyright (C) 2019 Jürgen Buchmüller <pullmoll@t-online.de>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ ****************************************************************************/
+#include <QIODevice>
+#include "p2trace.h"
+
+/**
+ * @brief P2Trace constructor
+ * @param order log2 of the number of records in the ring buffer
+ */
+P2Trace::P2Trace(int order)
+    : m_ring(1 << order)
+    , m_mask(static_cast<p2_LONG>((1 << order) - 1))
+    , m_head(0)
+    , m_tail(0)
+    , m_dropped(0)
+{
+    Q_ASSERT(order >= 0 && order < 31);
+}
+
+/**
+ * @brief Take up to %max records from the ring buffer (consumer side)
+ * @param recs pointer to an array of at least %max records
+ * @param max maximum number of records to take
+ * @return number of records taken
+ */
+int P2Trace::take(p2_TRACE_t* recs, int max)
+{
+    const p2_LONG tail = m_tail.loadRelaxed();
+    const p2_LONG avail = m_head.loadAcquire() - tail;
+    const int count = static_cast<int>(qMin<p2_LONG>(avail, static_cast<p2_LONG>(max)));
+    for (int i = 0; i < count; i++)
+        recs[i] = m_ring[static_cast<int>((tail + static_cast<p2_LONG>(i)) & m_mask)];
+    m_tail.storeRelease(tail + static_cast<p2_LONG>(count));
+    return count;
+}
+
+/**
+ * @brief Return true, if there are no records in the ring buffer
+ * @return true if empty
+ */
+bool P2Trace::isEmpty() const
+{
+    return m_head.loadAcquire() == m_tail.loadAcquire();
+}
+
+/**
+ * @brief Return the number of records dropped because the ring buffer was full
+ * @return number of dropped records
+ */
+p2_QUAD P2Trace::dropped() const
+{
+    return m_dropped.loadRelaxed();
+}
+
+/**
+ * @brief Format a trace record as a line of text
+ * @param rec const reference to the record
+ * @return QString with the formatted record
+ */
+QString P2Trace::format(const p2_TRACE_t& rec)
+{
+    static const char* names[] = {
+        "execute", "coginit", "gox", "get", "wrbyte", "wrword", "wrlong"
+    };
+    const char* name = rec.event < sizeof(names)/sizeof(names[0]) ? names[rec.event] : "?";
+    return QString("%1 COG #%2 %3 $%4 $%5\n")
+            .arg(rec.cnt, 16, 16, QChar('0'))
+            .arg(rec.cog, 0, 16)
+            .arg(QLatin1String(name), -7)
+            .arg(rec.pc, 5, 16, QChar('0'))
+            .arg(rec.arg, 8, 16, QChar('0'));
+}
+
+/**
+ * @brief P2TraceConsumer constructor
+ * @param trace ring buffer to drain
+ * @param dev device to write the formatted records to
+ * @param parent optional parent object
+ */
+P2TraceConsumer::P2TraceConsumer(P2Trace* trace, QIODevice* dev, QObject* parent)
+    : QThread(parent)
+    , m_trace(trace)
+    , m_dev(dev)
+    , m_stop(0)
+{
+}
+
+/**
+ * @brief Ask the consumer to drain the remaining records and stop
+ */
+void P2TraceConsumer::stop()
+{
+    m_stop.storeRelease(1);
+    wait();
+}
+
+/**
+ * @brief Drain the ring buffer until asked to stop
+ */
+void P2TraceConsumer::run()
+{
+    while (!m_stop.loadAcquire()) {
+        if (0 == drain())
+            msleep(1);
+    }
+    while (drain() > 0)
+        ;
+}
+
+/**
+ * @brief Take a batch of records and write them formatted to the device
+ * @return number of records written
+ */
+int P2TraceConsumer::drain()
+{
+    p2_TRACE_t recs[256];
+    const int count = m_trace->take(recs, 256);
+    for (int i = 0; i < count; i++)
+        m_dev->write(P2Trace::format(recs[i]).toLatin1());
+    return count;
+}
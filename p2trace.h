@@ -0,0 +1,169 @@
+/****************************************************************************
+ *
+ * P2 emulator trace ring buffer
+ *
+ * Copyright (C) 2019 Jürgen Buchmüller <pullmoll@t-online.de>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ ****************************************************************************/
+#pragma once
+#include <QAtomicInteger>
+#include <QThread>
+#include <QVector>
+#include "p2defs.h"
+
+/**
+ * @file Compile-time controlled tracing of the emulator core.
+ *
+ * Trace points are written with the P2_TRACE() macro. Every trace point
+ * has a level, and trace points with a level above P2_TRACE_LEVEL are
+ * removed by the compiler. With the default P2_TRACE_LEVEL=0 no trace
+ * point remains and its arguments are not even evaluated.
+ *
+ * Enabled trace points store fixed size binary records in a single
+ * producer, single consumer ring buffer (P2Trace) owned by the P2Hub.
+ * A P2TraceConsumer thread drains the buffer and formats the records
+ * as text, so the emulator thread never formats strings.
+ */
+
+#ifndef P2_TRACE_LEVEL
+#define P2_TRACE_LEVEL 0
+#endif
+
+/**
+ * @brief Trace levels
+ */
+typedef enum {
+    p2_TRACE_OFF,               //!< no tracing at all
+    p2_TRACE_HUB,               //!< HUB events (COGINIT, execute slices)
+    p2_TRACE_COG,               //!< COG instruction fetch and execution
+    p2_TRACE_MEM,               //!< HUB memory writes
+}   p2_TRACE_level_e;
+
+/**
+ * @brief Trace event types
+ */
+typedef enum {
+    p2_TRACE_EXECUTE,           //!< P2Hub::execute() slice (arg = cycles)
+    p2_TRACE_COGINIT,           //!< COG started (pc = PTRB, arg = PTRA)
+    p2_TRACE_GOX,               //!< instruction fetched (pc = PC, arg = cycles left)
+    p2_TRACE_GET,               //!< instruction executed (pc = PC, arg = opcode)
+    p2_TRACE_WR_BYTE,           //!< HUB byte written (pc = address, arg = value)
+    p2_TRACE_WR_WORD,           //!< HUB word written (pc = address, arg = value)
+    p2_TRACE_WR_LONG,           //!< HUB long written (pc = address, arg = value)
+}   p2_TRACE_event_e;
+
+/**
+ * @brief Binary trace record
+ */
+typedef struct {
+    p2_QUAD cnt;                //!< value of the HUB cycle counter
+    p2_LONG pc;                 //!< program counter or address
+    p2_LONG arg;                //!< event specific argument
+    p2_BYTE event;              //!< event type (p2_TRACE_event_e)
+    p2_BYTE cog;                //!< COG number
+    p2_WORD reserved;           //!< padding
+}   p2_TRACE_t;
+
+#if (P2_TRACE_LEVEL > 0)
+//! Write a trace record to %trace if %level is enabled at compile time
+#define P2_TRACE(level, trace, cnt, event, cog, pc, arg) \
+    do { \
+        if ((level) <= P2_TRACE_LEVEL) \
+            (trace).put((cnt), (event), (cog), (pc), (arg)); \
+    } while (0)
+#else
+//! Tracing is disabled: trace points compile to nothing
+#define P2_TRACE(level, trace, cnt, event, cog, pc, arg) do {} while (0)
+#endif
+
+class P2Trace
+{
+public:
+    explicit P2Trace(int order = 16);
+
+    /**
+     * @brief Append a record to the ring buffer (producer side)
+     * Records are dropped and counted if the buffer is full.
+     * @param cnt HUB cycle counter
+     * @param event trace event type
+     * @param cog COG number
+     * @param pc program counter or address
+     * @param arg event specific argument
+     */
+    inline void put(p2_QUAD cnt, p2_TRACE_event_e event, int cog, p2_LONG pc, p2_LONG arg)
+    {
+        const p2_LONG head = m_head.loadRelaxed();
+        if (head - m_tail.loadAcquire() > m_mask) {
+            m_dropped.fetchAndAddRelaxed(1);
+            return;
+        }
+        p2_TRACE_t& rec = m_ring[static_cast<int>(head & m_mask)];
+        rec.cnt = cnt;
+        rec.pc = pc;
+        rec.arg = arg;
+        rec.event = static_cast<p2_BYTE>(event);
+        rec.cog = static_cast<p2_BYTE>(cog);
+        rec.reserved = 0;
+        m_head.storeRelease(head + 1);
+    }
+
+    int take(p2_TRACE_t* recs, int max);
+    bool isEmpty() const;
+    p2_QUAD dropped() const;
+
+    static QString format(const p2_TRACE_t& rec);
+
+private:
+    QVector<p2_TRACE_t> m_ring;         //!< ring buffer of records
+    p2_LONG m_mask;                     //!< ring buffer index mask
+    QAtomicInteger<p2_LONG> m_head;     //!< next record to write (producer)
+    QAtomicInteger<p2_LONG> m_tail;     //!< next record to read (consumer)
+    QAtomicInteger<p2_QUAD> m_dropped;  //!< number of records dropped
+};
+
+class QIODevice;
+
+class P2TraceConsumer : public QThread
+{
+    Q_OBJECT
+public:
+    P2TraceConsumer(P2Trace* trace, QIODevice* dev, QObject* parent = nullptr);
+
+    void stop();
+
+protected:
+    void run() override;
+
+private:
+    P2Trace* m_trace;                   //!< ring buffer to drain
+    QIODevice* m_dev;                   //!< device to write the formatted records to
+    QAtomicInt m_stop;                  //!< non-zero when asked to stop
+
+    int drain();
+};
@@ -0,0 +1,300 @@
+/****************************************************************************
+ *
+ * P2 emulator streamer video capture
+ *
+ * Copyright (C) 2019 Jürgen Buchmüller <pullmoll@t-online.de>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ ****************************************************************************/
+#include <QFile>
+#include <QImage>
+#include <string.h>
+#include "p2video.h"
+
+P2Video::P2Video()
+    : m_vsync_pin(-1)
+    , m_vsync(false)
+    , m_prefix()
+    , m_format(p2_VIDEO_PNG)
+    , m_synced(false)
+    , m_sync(0)
+    , m_stride(0)
+    , m_col(0)
+    , m_row(0)
+    , m_cols(0)
+    , m_widest(0)
+    , m_buffer()
+    , m_frame()
+    , m_width(0)
+    , m_height(0)
+    , m_frames(0)
+    , m_saved(0)
+{
+}
+
+/**
+ * @brief Return the vsync pin
+ * @return pin number, or -1 if long sync pulses are detected
+ */
+int P2Video::vsync_pin() const
+{
+    return m_vsync_pin;
+}
+
+/**
+ * @brief Set the vsync pin
+ * @param pin pin number, or -1 to detect long sync pulses
+ */
+void P2Video::set_vsync_pin(int pin)
+{
+    m_vsync_pin = pin;
+}
+
+/**
+ * @brief Save every completed frame to a file
+ * @param prefix file name prefix; empty to not save frames
+ * @param format file format
+ */
+void P2Video::set_output(const QString& prefix, p2_VIDEO_format_e format)
+{
+    m_prefix = prefix;
+    m_format = format;
+}
+
+/**
+ * @brief Output a horizontal sync pulse
+ * @param count number of NCO rollovers
+ * @param vsync current level of the vsync pin
+ */
+void P2Video::hsync(p2_LONG count, bool vsync)
+{
+    if (!m_sync)
+        end_line();
+    const p2_QUAD before = m_sync;
+    m_sync += count;
+
+    if (m_vsync_pin >= 0) {
+        if (vsync != m_vsync)
+            this->vsync();
+        m_vsync = vsync;
+        return;
+    }
+
+    // a pulse becoming longer than a quarter of the widest scanline
+    const p2_QUAD limit = static_cast<p2_QUAD>(m_widest) / 4;
+    if (m_widest > 0 && before <= limit && m_sync > limit)
+        this->vsync();
+}
+
+/**
+ * @brief Output pixels
+ * @param values pixel values $RRGGBBxx
+ * @param count number of pixels
+ */
+void P2Video::pixels(const p2_LONG* values, p2_LONG count)
+{
+    m_sync = 0;
+    grow(m_col + static_cast<int>(count));
+    QRgb* dst = m_buffer.data() + m_row * m_stride + m_col;
+    for (p2_LONG i = 0; i < count; i++)
+        dst[i] = 0xff000000u | (values[i] >> 8);
+    m_col += static_cast<int>(count);
+}
+
+/**
+ * @brief Output a number of pixels of the same value
+ * @param value pixel value $RRGGBBxx
+ * @param count number of pixels
+ */
+void P2Video::fill(p2_LONG value, p2_LONG count)
+{
+    m_sync = 0;
+    grow(m_col + static_cast<int>(count));
+    QRgb* dst = m_buffer.data() + m_row * m_stride + m_col;
+    const QRgb rgb = 0xff000000u | (value >> 8);
+    for (p2_LONG i = 0; i < count; i++)
+        dst[i] = rgb;
+    m_col += static_cast<int>(count);
+}
+
+/**
+ * @brief Return the number of completed frames
+ * @return number of frames
+ */
+int P2Video::frames() const
+{
+    return m_frames;
+}
+
+/**
+ * @brief Return the number of frames saved to files
+ * @return number of frames
+ */
+int P2Video::saved() const
+{
+    return m_saved;
+}
+
+/**
+ * @brief Return the width of the last completed frame
+ * @return width in pixels
+ */
+int P2Video::width() const
+{
+    return m_width;
+}
+
+/**
+ * @brief Return the height of the last completed frame
+ * @return height in scanlines
+ */
+int P2Video::height() const
+{
+    return m_height;
+}
+
+/**
+ * @brief Return a pixel of the last completed frame
+ * @param x column
+ * @param y scanline
+ * @return pixel color
+ */
+QRgb P2Video::pixel(int x, int y) const
+{
+    if (x < 0 || x >= m_width || y < 0 || y >= m_height)
+        return 0;
+    return m_frame[y * m_width + x];
+}
+
+/**
+ * @brief Save the last completed frame to a file
+ * @param filename name of the file
+ * @param format file format
+ * @return true on success, or false on error
+ */
+bool P2Video::save(const QString& filename, p2_VIDEO_format_e format) const
+{
+    if (!m_width || !m_height)
+        return false;
+
+    if (p2_VIDEO_PNG == format) {
+        const QImage image(reinterpret_cast<const uchar*>(m_frame.constData()),
+                           m_width, m_height, m_width * static_cast<int>(sizeof(QRgb)),
+                           QImage::Format_RGB32);
+        return image.save(filename, "PNG");
+    }
+
+    QFile file(filename);
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+    QByteArray data = QString("P6\n%1 %2\n255\n").arg(m_width).arg(m_height).toLatin1();
+    const int header = data.size();
+    data.resize(header + m_width * m_height * 3);
+    char* dst = data.data() + header;
+    for (const QRgb rgb : m_frame) {
+        *dst++ = static_cast<char>(qRed(rgb));
+        *dst++ = static_cast<char>(qGreen(rgb));
+        *dst++ = static_cast<char>(qBlue(rgb));
+    }
+    return file.write(data) == data.size();
+}
+
+/**
+ * @brief Handle a vertical sync
+ *
+ * Completes the current frame, unless it has less than min_lines
+ * scanlines.
+ */
+void P2Video::vsync()
+{
+    if (m_synced && m_row < min_lines)
+        return;
+
+    if (m_synced && m_row > 0) {
+        m_width = m_cols;
+        m_height = m_row;
+        m_frame.resize(m_width * m_height);
+        for (int y = 0; y < m_height; y++)
+            memcpy(m_frame.data() + y * m_width, m_buffer.constData() + y * m_stride,
+                   static_cast<size_t>(m_width) * sizeof(QRgb));
+        if (!m_prefix.isEmpty()) {
+            const QString ext = p2_VIDEO_PNG == m_format ? QStringLiteral("png") : QStringLiteral("ppm");
+            const QString filename = QString("%1%2.%3").arg(m_prefix).arg(m_frames, 5, 10, QChar('0')).arg(ext);
+            if (save(filename, m_format))
+                m_saved++;
+        }
+        m_frames++;
+    }
+
+    m_synced = true;
+    m_row = 0;
+    m_col = 0;
+    m_cols = 0;
+}
+
+/**
+ * @brief End the current scanline
+ *
+ * Pixels not written in the scanline are black.
+ */
+void P2Video::end_line()
+{
+    if (!m_col)
+        return;
+    QRgb* dst = m_buffer.data() + m_row * m_stride;
+    for (int x = m_col; x < m_stride; x++)
+        dst[x] = 0xff000000u;
+    m_cols = qMax(m_cols, m_col);
+    m_widest = qMax(m_widest, m_col);
+    m_col = 0;
+    if (!m_synced)
+        return;
+    if (++m_row >= max_lines)
+        vsync();
+}
+
+/**
+ * @brief Make room for %cols pixels in the current scanline
+ *
+ * The frame buffer is laid out again if the scanline is wider than the
+ * buffer's stride.
+ *
+ * @param cols number of pixels
+ */
+void P2Video::grow(int cols)
+{
+    if (cols > m_stride) {
+        const int stride = qMax(cols, m_stride * 2);
+        QVector<QRgb> buffer(stride * max_lines);
+        for (int y = 0; y <= m_row && m_stride; y++)
+            memcpy(buffer.data() + y * stride, m_buffer.constData() + y * m_stride,
+                   static_cast<size_t>(m_stride) * sizeof(QRgb));
+        m_buffer.swap(buffer);
+        m_stride = stride;
+    }
+}
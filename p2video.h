@@ -0,0 +1,114 @@
+/****************************************************************************
+ *
+ * P2 emulator streamer video capture
+ *
+ * Copyright (C) 2019 Jürgen Buchmüller <pullmoll@t-online.de>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ ****************************************************************************/
+#pragma once
+#include <QRgb>
+#include <QString>
+#include <QVector>
+#include "p2defs.h"
+
+/**
+ * @file Offscreen capture of a COG's streamer output.
+ *
+ * The COG passes each finished streamer command to P2Video: the
+ * pixels of a data command, or the length of a horizontal sync pulse.
+ * A sync pulse ends the current scanline, which is then complete in the
+ * frame buffer. The pixels are the $RRGGBBxx values the streamer sends
+ * to the colorspace converter. The converter and the DACs are not
+ * emulated, so the frames show the colors the firmware meant to
+ * display, independent of the video standard.
+ *
+ * A frame ends at the vertical sync: a change of the vsync pin's OUT
+ * bit, if a pin is set, or else a sync pulse longer than a quarter of
+ * the widest scanline, as in composite video. Sync events less than
+ * min_lines scanlines after the start of a frame are ignored, so that
+ * both edges of a vsync pulse or a series of vertical sync pulses end
+ * only one frame. Scanlines before the first vertical sync are dropped.
+ *
+ * Each completed frame can be saved as PNG image or as raw RGB in
+ * a binary PPM file, as <prefix><frame number>.png or .ppm.
+ */
+
+typedef enum {
+    p2_VIDEO_PNG,               //!< save frames as PNG images
+    p2_VIDEO_PPM,               //!< save frames as binary PPM (raw RGB) files
+}   p2_VIDEO_format_e;
+
+class P2Video
+{
+public:
+    P2Video();
+
+    //! minimum number of scanlines in a frame
+    static constexpr int min_lines = 16;
+    //! maximum number of scanlines in a frame without vertical sync
+    static constexpr int max_lines = 2048;
+
+    int vsync_pin() const;
+    void set_vsync_pin(int pin);
+    void set_output(const QString& prefix, p2_VIDEO_format_e format);
+
+    void hsync(p2_LONG count, bool vsync);
+    void pixels(const p2_LONG* values, p2_LONG count);
+    void fill(p2_LONG value, p2_LONG count);
+
+    int frames() const;
+    int saved() const;
+    int width() const;
+    int height() const;
+    QRgb pixel(int x, int y) const;
+    bool save(const QString& filename, p2_VIDEO_format_e format) const;
+
+private:
+    int m_vsync_pin;            //!< vsync pin number, or -1 to detect long sync pulses
+    bool m_vsync;               //!< previous level of the vsync pin
+    QString m_prefix;           //!< prefix of the file names to save frames to
+    p2_VIDEO_format_e m_format; //!< format to save frames in
+    bool m_synced;              //!< true after the first vertical sync
+    p2_LONG m_sync;             //!< length of the current sync pulse, or 0 if none
+    int m_stride;               //!< number of pixels per scanline in m_buffer
+    int m_col;                  //!< next pixel in the current scanline
+    int m_row;                  //!< current scanline
+    int m_cols;                 //!< width of the widest scanline in the current frame
+    int m_widest;               //!< width of the widest scanline so far
+    QVector<QRgb> m_buffer;     //!< frame buffer of the current frame
+    QVector<QRgb> m_frame;      //!< last completed frame
+    int m_width;                //!< width of m_frame
+    int m_height;               //!< height of m_frame
+    int m_frames;               //!< number of completed frames
+    int m_saved;                //!< number of frames saved
+
+    void vsync();
+    void end_line();
+    void grow(int cols);
+};
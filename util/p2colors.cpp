@@ -64,7 +64,8 @@ static bool color_compare_hue_sat_lum(const p2_color_e& c1, const p2_color_e& c2
 }
 
 P2Colors::P2Colors()
-    : m_color_names()
+    : m_tokens()
+    , m_color_names()
     , m_color_index()
     , m_color_lexicographic()
     , m_color_hue_sat_lum()
@@ -304,7 +305,7 @@ void P2Colors::set_palette_color(p2_palette_e pal, const QString name)
  * @param tok token value to map
  * @return p2_palette_e value to use
  */
-p2_palette_e P2Colors::pal_for_token(const p2_TOKEN_e tok)
+p2_palette_e P2Colors::pal_for_token(const p2_TOKEN_e tok) const
 {
     p2_palette_e pal = p2_pal_source;
 
@@ -349,22 +350,22 @@ p2_palette_e P2Colors::pal_for_token(const p2_TOKEN_e tok)
         break;
 
     default:
-        if (Token.is_type(tok, tm_section))
+        if (m_tokens.is_type(tok, tm_section))
             pal = p2_pal_section;
 
-        if (Token.is_type(tok, tm_conditional))
+        if (m_tokens.is_type(tok, tm_conditional))
             pal = p2_pal_conditional;
 
-        if (Token.is_type(tok, tm_mnemonic))
+        if (m_tokens.is_type(tok, tm_mnemonic))
             pal = p2_pal_instruction;
 
-        if (Token.is_type(tok, tm_modcz_param))
+        if (m_tokens.is_type(tok, tm_modcz_param))
             pal = p2_pal_modcz_param;
 
-        if (Token.is_type(tok, tm_wcz_suffix))
+        if (m_tokens.is_type(tok, tm_wcz_suffix))
             pal = p2_pal_wcz_suffix;
 
-        if (Token.is_type(tok, tm_expression))
+        if (m_tokens.is_type(tok, tm_expression))
             pal = p2_pal_expression;
         break;
     }
@@ -235,7 +235,7 @@ public:
     QColor palette_color(p2_palette_e pal) const;
     QColor palette_color(p2_TOKEN_e tok) const;
 
-    static p2_palette_e pal_for_token(const p2_TOKEN_e tok);
+    p2_palette_e pal_for_token(const p2_TOKEN_e tok) const;
 
     void save_palette(QSettings& s) const;
     void restore_palette(QSettings& s);
@@ -247,6 +247,7 @@ public slots:
     void set_palette(const p2_palette_hash_t& palette_color);
 
 private:
+    P2Token m_tokens;
     QHash<p2_color_e,QString> m_color_names;
     QHash<QRgb,p2_color_e> m_color_index;
     QVector<p2_color_e> m_color_lexicographic;
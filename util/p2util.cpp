@@ -33,9 +33,12 @@
  ****************************************************************************/
 #include "p2util.h"
 
-P2Util Util;
-
-P2Util::P2Util()
+/**
+ * @brief Check a few results of msb(), encode(), ones(), and sqrt()
+ *
+ * The checks are Q_ASSERTs, so this does nothing in a release build.
+ */
+void P2Util::selftest()
 {
     Q_ASSERT(0x10000000u == msb(p2_LONG(0x11290023u)));
     Q_ASSERT(0x00020000u == msb(p2_LONG(0x0003f212u)));
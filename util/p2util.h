@@ -37,7 +37,7 @@
 class P2Util
 {
 public:
-    P2Util();
+    static void selftest();
 
     static bool skip_space(int& pos, const QString& str);
 
@@ -70,5 +70,3 @@ public:
 
     static const QString esc(const QString& src);
 };
-
-extern P2Util Util;